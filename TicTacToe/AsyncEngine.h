@@ -0,0 +1,387 @@
+/**
+ * @file AsyncEngine.h
+ * @brief Поиск хода в фоновом потоке с отменой и обдумыванием на ходу соперника.
+ */
+
+#pragma once
+#include "Game.h"
+#include "Solver.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * @brief Результат фонового поиска.
+ */
+struct EngineResult {
+    SolverResult result;        /**< Ход и оценка; при отмене неточные */
+    std::uint64_t ticket = 0;   /**< Номер запроса, выданный start() */
+    bool cancelled = false;     /**< Поиск отменён или вытеснен новым запросом */
+    bool ponderHit = false;     /**< Позиция была предсказана и посчитана заранее */
+    double seconds = 0.0;       /**< Время от запроса до результата */
+};
+
+/**
+ * @brief Движок, который ищет ход в собственном потоке и не блокирует вызывающий.
+ *
+ * Одновременно идёт один поиск: новый запрос start() отменяет текущий.
+ * Результат приходит через std::future и, если задан, через обратный
+ * вызов; обратный вызов всегда выполняется в потоке движка, даже если
+ * ответ готов ещё внутри start() или запрос отменён из вызывающего потока,
+ * поэтому интерфейс должен переправить его в свой поток (например,
+ * PostMessage). Отменённый запрос тоже получает результат с
+ * cancelled = true, так что future никогда не остаётся без значения.
+ *
+ * Обдумывание: ponder() в позиции, где ходит соперник, предсказывает его
+ * лучший ответ и заранее ищет ход движка после него. Если затем start()
+ * приходит именно с этой позицией, поиск не начинается заново: готовый
+ * результат отдаётся сразу, а незаконченный продолжается и отдаётся
+ * запросу. Все поиски используют одну таблицу транспозиций, поэтому и
+ * неугаданное обдумывание ускоряет следующие запросы.
+ *
+ * @tparam GameT Вариант игры
+ */
+template <class GameT>
+class AsyncEngine {
+public:
+    using Cell = GameBase::Cell;
+    using Callback = std::function<void(const EngineResult&)>;
+
+    /**
+     * @brief Запускает поток движка.
+     * @param ttMegabytes Бюджет памяти таблицы транспозиций
+     */
+    explicit AsyncEngine(std::size_t ttMegabytes = 16);
+
+    /**
+     * @brief Отменяет поиски и останавливает поток.
+     */
+    ~AsyncEngine();
+
+    AsyncEngine(const AsyncEngine&) = delete;
+    AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+    /**
+     * @brief Запрашивает лучший ход; текущий поиск отменяется.
+     * @param game Позиция (копируется)
+     * @param player Игрок, за которого ищется ход
+     * @param limits Ограничения поиска
+     * @param callback Вызывается с результатом, всегда в потоке движка
+     * @return Будущий результат; номер запроса — в EngineResult::ticket
+     */
+    std::future<EngineResult> start(const GameT& game, Cell player, const SolverLimits& limits = {},
+                                    Callback callback = {});
+
+    /**
+     * @brief Начинает обдумывание, пока ходит соперник.
+     * @param game Позиция, в которой ходит соперник
+     * @param player Игрок движка
+     * @param limits Ограничения каждого из двух поисков обдумывания
+     */
+    void ponder(const GameT& game, Cell player, const SolverLimits& limits = {});
+
+    /**
+     * @brief Отменяет текущий поиск и обдумывание; ожидающие запросы получают cancelled = true.
+     */
+    void cancel();
+
+    /**
+     * @brief true, пока идёт поиск или обдумывание.
+     */
+    bool busy() const;
+
+    /**
+     * @brief Предсказанный ответ соперника из последнего обдумывания либо -1.
+     */
+    int predictedMove() const;
+
+    /**
+     * @brief Номер последнего запроса start().
+     */
+    std::uint64_t lastTicket() const;
+
+private:
+    /**
+     * @brief Задача потока: поиск по запросу или обдумывание.
+     */
+    struct Job {
+        explicit Job(const GameT& position) : game(position) {}
+
+        GameT game;
+        Cell player = GameBase::X;
+        SolverLimits limits;
+        bool ponder = false;                    /**< Задача обдумывания, пока без запроса */
+        bool requested = false;                 /**< К задаче привязан запрос start() */
+        std::promise<EngineResult> promise;
+        Callback callback;
+        std::uint64_t ticket = 0;
+        std::chrono::steady_clock::time_point requestedAt;
+    };
+
+    /**
+     * @brief Готовый результат, который поток движка ещё не отдал.
+     */
+    struct Delivery {
+        std::unique_ptr<Job> job;
+        EngineResult result;
+    };
+
+    void run();
+    void think(Job& job);
+    static void deliver(Job& job, const EngineResult& result);
+    void postCancelled(std::unique_ptr<Job> job);
+    bool matchesPonder(const GameT& game, Cell player) const;
+
+    Solver<GameT> solver_;
+    std::atomic<bool> stop_{ false };
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::unique_ptr<Job> pending_;              /**< Следующая задача */
+    Job* current_ = nullptr;                    /**< Выполняемая задача */
+    std::deque<Delivery> outbox_;               /**< Результаты для отдачи из потока движка */
+    bool quit_ = false;
+    std::uint64_t nextTicket_ = 0;
+
+    // Состояние обдумывания: позиция после предсказанного ответа и, если поиск закончен, его результат
+    bool ponderKnown_ = false;
+    std::uint64_t ponderHash_ = 0;
+    int ponderMoves_ = 0;
+    Cell ponderPlayer_ = GameBase::X;
+    int predictedMove_ = -1;
+    bool ponderDone_ = false;
+    SolverResult ponderResult_;
+
+    std::thread thread_;
+};
+
+template <class GameT>
+AsyncEngine<GameT>::AsyncEngine(std::size_t ttMegabytes) : solver_(ttMegabytes) {
+    solver_.setStopFlag(&stop_);
+    thread_ = std::thread([this] { run(); });
+}
+
+template <class GameT>
+AsyncEngine<GameT>::~AsyncEngine() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+template <class GameT>
+bool AsyncEngine<GameT>::matchesPonder(const GameT& game, Cell player) const {
+    return ponderKnown_ && game.hash() == ponderHash_ && game.moveCount() == ponderMoves_ && player == ponderPlayer_;
+}
+
+template <class GameT>
+std::future<EngineResult> AsyncEngine<GameT>::start(const GameT& game, Cell player, const SolverLimits& limits,
+                                                    Callback callback) {
+    auto job = std::make_unique<Job>(game);
+    job->player = player;
+    job->limits = limits;
+    job->requested = true;
+    job->callback = std::move(callback);
+    job->requestedAt = std::chrono::steady_clock::now();
+    std::future<EngineResult> future = job->promise.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->ticket = ++nextTicket_;
+        if (matchesPonder(game, player)) {
+            ponderKnown_ = false;
+            if (ponderDone_) {
+                // Обдумывание уже закончено: поток движка отдаст результат без поиска
+                EngineResult ready;
+                ready.result = ponderResult_;
+                ready.ticket = job->ticket;
+                ready.ponderHit = true;
+                outbox_.push_back({ std::move(job), ready });
+            }
+            else if (current_ && current_->ponder) {
+                // Обдумывание ещё идёт: привязываем к нему запрос
+                current_->requested = true;
+                current_->promise = std::move(job->promise);
+                current_->callback = std::move(job->callback);
+                current_->ticket = job->ticket;
+                current_->requestedAt = job->requestedAt;
+                return future;
+            }
+        }
+        if (job) {
+            ponderKnown_ = false;
+            if (current_)
+                stop_ = true;
+            postCancelled(std::move(pending_));
+            pending_ = std::move(job);
+        }
+    }
+    wake_.notify_one();
+    return future;
+}
+
+template <class GameT>
+void AsyncEngine<GameT>::ponder(const GameT& game, Cell player, const SolverLimits& limits) {
+    auto job = std::make_unique<Job>(game);
+    job->player = player;
+    job->limits = limits;
+    job->ponder = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ponderKnown_ = false;
+        predictedMove_ = -1;
+        if (current_)
+            stop_ = true;
+        postCancelled(std::move(pending_));
+        pending_ = std::move(job);
+    }
+    wake_.notify_one();
+}
+
+template <class GameT>
+void AsyncEngine<GameT>::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ponderKnown_ = false;
+        if (current_)
+            stop_ = true;
+        postCancelled(std::move(pending_));
+    }
+    wake_.notify_one();
+}
+
+template <class GameT>
+bool AsyncEngine<GameT>::busy() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_ != nullptr || pending_ != nullptr;
+}
+
+template <class GameT>
+int AsyncEngine<GameT>::predictedMove() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return predictedMove_;
+}
+
+template <class GameT>
+std::uint64_t AsyncEngine<GameT>::lastTicket() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextTicket_;
+}
+
+/**
+ * @brief Цикл потока движка: отдаёт накопленные результаты, берёт задачу, ищет.
+ *
+ * При остановке ожидающий запрос отменяется здесь же, так что и его
+ * обратный вызов выполняется в потоке движка.
+ */
+template <class GameT>
+void AsyncEngine<GameT>::run() {
+    for (;;) {
+        std::unique_ptr<Job> job;
+        std::deque<Delivery> ready;
+        bool quit = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return quit_ || pending_ || !outbox_.empty(); });
+            quit = quit_;
+            if (quit)
+                postCancelled(std::move(pending_));
+            ready.swap(outbox_);
+            if (pending_) {
+                job = std::move(pending_);
+                current_ = job.get();
+                stop_ = false;
+            }
+        }
+        // Результаты отдаются без блокировки: обратный вызов может снова обратиться к движку
+        for (Delivery& delivery : ready)
+            deliver(*delivery.job, delivery.result);
+        if (quit)
+            return;
+        if (job)
+            think(*job);
+    }
+}
+
+template <class GameT>
+void AsyncEngine<GameT>::think(Job& job) {
+    SolverResult result;
+    if (job.ponder) {
+        // Сначала предсказываем ответ соперника, затем ищем наш ход после него
+        const Cell opponent = GameBase::opponent(job.player);
+        const SolverResult reply = solver_.solve(job.game, opponent, job.limits);
+        const int size = job.game.size();
+        const bool usable = !stop_ && reply.move >= 0 && job.game.makeMove(reply.move / size, reply.move % size, opponent) &&
+                            job.game.checkWinner() == GameBase::Empty && !job.game.isDraw();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (usable && !stop_) {
+                ponderKnown_ = true;
+                ponderDone_ = false;
+                ponderHash_ = job.game.hash();
+                ponderMoves_ = job.game.moveCount();
+                ponderPlayer_ = job.player;
+                predictedMove_ = reply.move;
+            }
+            else if (!job.requested) {
+                current_ = nullptr;
+                return;
+            }
+        }
+        result = solver_.solve(job.game, job.player, job.limits);
+    }
+    else {
+        result = solver_.solve(job.game, job.player, job.limits);
+    }
+
+    EngineResult delivered;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        current_ = nullptr;
+        delivered.cancelled = stop_.load();
+        if (job.ponder && ponderKnown_ && !delivered.cancelled) {
+            ponderDone_ = true;
+            ponderResult_ = result;
+        }
+        if (!job.requested)
+            return;
+    }
+    delivered.result = result;
+    delivered.ticket = job.ticket;
+    delivered.ponderHit = job.ponder;
+    deliver(job, delivered);
+}
+
+template <class GameT>
+void AsyncEngine<GameT>::deliver(Job& job, const EngineResult& result) {
+    EngineResult copy = result;
+    copy.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.requestedAt).count();
+    if (job.callback)
+        job.callback(copy);
+    job.promise.set_value(copy);
+}
+
+/**
+ * @brief Ставит отменённый запрос в очередь потока движка; вызывается под mutex_.
+ */
+template <class GameT>
+void AsyncEngine<GameT>::postCancelled(std::unique_ptr<Job> job) {
+    if (!job || !job->requested)
+        return;
+    EngineResult result;
+    result.ticket = job->ticket;
+    result.cancelled = true;
+    outbox_.push_back({ std::move(job), result });
+}
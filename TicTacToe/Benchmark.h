@@ -0,0 +1,224 @@
+/**
+ * @file Benchmark.h
+ * @brief Простой измерительный стенд для микро- и макробенчмарков.
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Не даёт компилятору выбросить вычисление значения.
+ */
+template <class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Параметры измерений.
+ */
+struct BenchmarkConfig {
+    int warmup = 3;                /**< Прогревочные замеры, не входящие в результат */
+    int repetitions = 30;          /**< Замеры, по которым считается статистика */
+    double sampleSeconds = 0.01;   /**< Минимальная длительность одного замера */
+    std::string filter;            /**< Запускать только бенчмарки, имя которых содержит подстроку */
+};
+
+/**
+ * @brief Результат одного бенчмарка. Время — наносекунды на операцию.
+ */
+struct BenchmarkResult {
+    std::string name;               /**< Имя бенчмарка */
+    std::uint64_t opsPerSample = 0; /**< Операций в одном замере */
+    int samples = 0;                /**< Число замеров */
+    double nsPerOp = 0.0;           /**< Среднее по замерам */
+    double opsPerSecond = 0.0;      /**< Операций в секунду по среднему */
+    double minNs = 0.0;             /**< Лучший замер */
+    double p50Ns = 0.0;             /**< Медиана */
+    double p90Ns = 0.0;             /**< 90-й перцентиль */
+    double p99Ns = 0.0;             /**< 99-й перцентиль */
+    double maxNs = 0.0;             /**< Худший замер */
+};
+
+/**
+ * @brief Запускает бенчмарки и собирает статистику.
+ *
+ * Тело бенчмарка вызывается пачками: число вызовов в пачке подбирается
+ * так, чтобы замер длился не меньше sampleSeconds, после чего выполняются
+ * прогревочные и основные замеры. Перцентили считаются по основным
+ * замерам методом ближайшего ранга.
+ */
+class BenchmarkRunner {
+public:
+    /**
+     * @brief Конструктор.
+     * @param config Параметры измерений
+     */
+    explicit BenchmarkRunner(const BenchmarkConfig& config) : config_(config) {}
+
+    /**
+     * @brief Измеряет тело бенчмарка.
+     * @param name Имя бенчмарка
+     * @param opsPerCall Сколько операций выполняет один вызов body()
+     * @param body Тело бенчмарка
+     * @return false, если бенчмарк пропущен фильтром
+     */
+    template <class Body>
+    bool run(const std::string& name, std::uint64_t opsPerCall, Body&& body);
+
+    /**
+     * @brief Результаты в порядке запуска.
+     */
+    const std::vector<BenchmarkResult>& results() const { return results_; }
+
+    /**
+     * @brief Печатает таблицу результатов.
+     */
+    void print(std::FILE* out) const;
+
+    /**
+     * @brief Сохраняет результаты в JSON для сравнения между коммитами.
+     * @param path Путь к файлу
+     * @return false, если файл не удалось записать
+     */
+    bool writeJson(const std::string& path) const;
+
+    /**
+     * @brief Читает медианы из файла, сохранённого writeJson().
+     * @param path Путь к файлу
+     * @param medians Медиана в наносекундах по имени бенчмарка
+     * @return false, если файл не удалось прочитать
+     */
+    static bool readJsonMedians(const std::string& path, std::unordered_map<std::string, double>& medians);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static double percentile(const std::vector<double>& sorted, double p) {
+        const std::size_t rank = static_cast<std::size_t>(p * sorted.size() + 0.999999);
+        return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+    }
+
+    BenchmarkConfig config_;
+    std::vector<BenchmarkResult> results_;
+};
+
+template <class Body>
+bool BenchmarkRunner::run(const std::string& name, std::uint64_t opsPerCall, Body&& body) {
+    if (!config_.filter.empty() && name.find(config_.filter) == std::string::npos)
+        return false;
+
+    auto sample = [&](std::uint64_t calls) {
+        const auto started = Clock::now();
+        for (std::uint64_t i = 0; i < calls; ++i)
+            body();
+        return std::chrono::duration<double>(Clock::now() - started).count();
+    };
+
+    // Подбор размера пачки
+    std::uint64_t calls = 1;
+    while (sample(calls) < config_.sampleSeconds && calls < (1ull << 40))
+        calls *= 2;
+
+    for (int i = 0; i < config_.warmup; ++i)
+        sample(calls);
+
+    const int repetitions = std::max(1, config_.repetitions);
+    std::vector<double> times(repetitions);
+    const double ops = static_cast<double>(calls * opsPerCall);
+    double total = 0.0;
+    for (double& time : times) {
+        time = sample(calls) * 1e9 / ops;
+        total += time;
+    }
+    std::sort(times.begin(), times.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.opsPerSample = calls * opsPerCall;
+    result.samples = repetitions;
+    result.nsPerOp = total / repetitions;
+    result.opsPerSecond = result.nsPerOp > 0.0 ? 1e9 / result.nsPerOp : 0.0;
+    result.minNs = times.front();
+    result.p50Ns = percentile(times, 0.50);
+    result.p90Ns = percentile(times, 0.90);
+    result.p99Ns = percentile(times, 0.99);
+    result.maxNs = times.back();
+    results_.push_back(result);
+    return true;
+}
+
+inline void BenchmarkRunner::print(std::FILE* out) const {
+    std::fprintf(out, "%-46s %14s %14s %12s %12s %12s\n", "benchmark", "ns/op", "ops/sec", "p50 ns", "p90 ns", "p99 ns");
+    for (const BenchmarkResult& r : results_)
+        std::fprintf(out, "%-46s %14.2f %14.0f %12.2f %12.2f %12.2f\n",
+                     r.name.c_str(), r.nsPerOp, r.opsPerSecond, r.p50Ns, r.p90Ns, r.p99Ns);
+}
+
+inline bool BenchmarkRunner::writeJson(const std::string& path) const {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    std::fprintf(out, "{\n  \"config\": {\"warmup\": %d, \"repetitions\": %d, \"sample_seconds\": %g},\n",
+                 config_.warmup, config_.repetitions, config_.sampleSeconds);
+    std::fprintf(out, "  \"benchmarks\": [");
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+        const BenchmarkResult& r = results_[i];
+        std::string name;
+        for (char c : r.name) {
+            if (c == '"' || c == '\\')
+                name += '\\';
+            name += c;
+        }
+        std::fprintf(out,
+                     "%s\n    {\"name\": \"%s\", \"ops_per_sample\": %llu, \"samples\": %d, "
+                     "\"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"min_ns\": %.3f, "
+                     "\"p50_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, \"max_ns\": %.3f}",
+                     i ? "," : "", name.c_str(), static_cast<unsigned long long>(r.opsPerSample), r.samples,
+                     r.nsPerOp, r.opsPerSecond, r.minNs, r.p50Ns, r.p90Ns, r.p99Ns, r.maxNs);
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+/**
+ * @brief Разбирает только формат writeJson(): по бенчмарку в строке.
+ */
+inline bool BenchmarkRunner::readJsonMedians(const std::string& path, std::unordered_map<std::string, double>& medians) {
+    std::FILE* in = std::fopen(path.c_str(), "r");
+    if (!in)
+        return false;
+    std::string text;
+    char chunk[4096];
+    for (std::size_t got; (got = std::fread(chunk, 1, sizeof(chunk), in)) > 0;)
+        text.append(chunk, got);
+    std::fclose(in);
+
+    const std::string nameKey = "{\"name\": \"", medianKey = "\"p50_ns\": ";
+    for (std::size_t at = text.find(nameKey); at != std::string::npos; at = text.find(nameKey, at)) {
+        std::string name;
+        for (at += nameKey.size(); at < text.size() && text[at] != '"'; ++at) {
+            if (text[at] == '\\' && at + 1 < text.size())
+                ++at;
+            name += text[at];
+        }
+        const std::size_t median = text.find(medianKey, at);
+        if (median == std::string::npos)
+            break;
+        medians[name] = std::strtod(text.c_str() + median + medianKey.size(), nullptr);
+        at = median;
+    }
+    return true;
+}
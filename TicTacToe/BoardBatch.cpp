@@ -0,0 +1,305 @@
+/**
+ * @file BoardBatch.cpp
+ * @brief Скалярные, SSE2- и AVX2-реализации пакетных операций над полями 3x3.
+ */
+
+#include "BoardBatch.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TICTACTOE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// AVX2-функции компилируются с атрибутом цели, остальной код остаётся совместимым с базовым x86-64
+#if defined(TICTACTOE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TICTACTOE_AVX2 __attribute__((target("avx2")))
+#else
+#define TICTACTOE_AVX2
+#endif
+
+namespace {
+
+using Bitboard = Game::Bitboard;
+
+// ---------------------------------------------------------------- скалярные
+
+void makeMoveScalar(Bitboard* bits, const std::int8_t* cells, std::size_t begin, std::size_t count) {
+    for (std::size_t i = begin; i < count; ++i)
+        if (cells[i] >= 0)
+            bits[i] = static_cast<Bitboard>(bits[i] | (1u << cells[i]));
+}
+
+void checkWinnerScalar(const Bitboard* x, const Bitboard* o, std::size_t count,
+                       std::uint64_t* xWins, std::uint64_t* oWins) {
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t xw = 0, ow = 0;
+        for (int bit = 0; bit < 64; ++bit) {
+            xw |= static_cast<std::uint64_t>(Game::hasLine(x[word * 64 + bit])) << bit;
+            ow |= static_cast<std::uint64_t>(Game::hasLine(o[word * 64 + bit])) << bit;
+        }
+        xWins[word] = xw;
+        oWins[word] = ow;
+    }
+}
+
+void isDrawScalar(const Bitboard* x, const Bitboard* o, std::size_t count, std::uint64_t* draws) {
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t dw = 0;
+        for (int bit = 0; bit < 64; ++bit) {
+            const std::size_t i = word * 64 + bit;
+            const bool draw = (x[i] | o[i]) == Game::FULL_BOARD && !Game::hasLine(x[i]) && !Game::hasLine(o[i]);
+            dw |= static_cast<std::uint64_t>(draw) << bit;
+        }
+        draws[word] = dw;
+    }
+}
+
+#ifdef TICTACTOE_X86
+
+// ---------------------------------------------------------------- SSE2
+
+/**
+ * @brief 0xFFFF в словах, где маска содержит хотя бы одну линию.
+ */
+inline __m128i hasLineSse2(__m128i bits) {
+    __m128i any = _mm_setzero_si128();
+    for (Bitboard mask : Game::WIN_MASKS) {
+        const __m128i m = _mm_set1_epi16(static_cast<short>(mask));
+        any = _mm_or_si128(any, _mm_cmpeq_epi16(_mm_and_si128(bits, m), m));
+    }
+    return any;
+}
+
+/**
+ * @brief Два регистра по 8 флагов 0/0xFFFF в 16-битную маску.
+ */
+inline std::uint64_t movemask16Sse2(__m128i low, __m128i high) {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(low, high)));
+}
+
+void makeMoveSse2(Bitboard* bits, const std::int8_t* cells, std::size_t count) {
+    // Переменного сдвига в SSE2 нет: бит клетки собирается сравнением с каждым из девяти номеров
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(cells + i));
+        const __m128i cell = _mm_unpacklo_epi8(bytes, _mm_cmpgt_epi8(_mm_setzero_si128(), bytes));
+        __m128i add = _mm_setzero_si128();
+        for (int c = 0; c < Game::CELL_COUNT; ++c)
+            add = _mm_or_si128(add, _mm_and_si128(_mm_cmpeq_epi16(cell, _mm_set1_epi16(static_cast<short>(c))),
+                                                  _mm_set1_epi16(static_cast<short>(1 << c))));
+        __m128i* target = reinterpret_cast<__m128i*>(bits + i);
+        _mm_storeu_si128(target, _mm_or_si128(_mm_loadu_si128(target), add));
+    }
+    makeMoveScalar(bits, cells, i, count);
+}
+
+void checkWinnerSse2(const Bitboard* x, const Bitboard* o, std::size_t count,
+                     std::uint64_t* xWins, std::uint64_t* oWins) {
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t xw = 0, ow = 0;
+        for (int part = 0; part < 4; ++part) {
+            const std::size_t i = word * 64 + part * 16;
+            const __m128i* xs = reinterpret_cast<const __m128i*>(x + i);
+            const __m128i* os = reinterpret_cast<const __m128i*>(o + i);
+            xw |= movemask16Sse2(hasLineSse2(_mm_loadu_si128(xs)), hasLineSse2(_mm_loadu_si128(xs + 1))) << (part * 16);
+            ow |= movemask16Sse2(hasLineSse2(_mm_loadu_si128(os)), hasLineSse2(_mm_loadu_si128(os + 1))) << (part * 16);
+        }
+        xWins[word] = xw;
+        oWins[word] = ow;
+    }
+}
+
+void isDrawSse2(const Bitboard* x, const Bitboard* o, std::size_t count, std::uint64_t* draws) {
+    const __m128i full = _mm_set1_epi16(Game::FULL_BOARD);
+    auto drawFlags = [&](std::size_t i) {
+        const __m128i xs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+        const __m128i os = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o + i));
+        const __m128i filled = _mm_cmpeq_epi16(_mm_or_si128(xs, os), full);
+        return _mm_andnot_si128(_mm_or_si128(hasLineSse2(xs), hasLineSse2(os)), filled);
+    };
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t dw = 0;
+        for (int part = 0; part < 4; ++part) {
+            const std::size_t i = word * 64 + part * 16;
+            dw |= movemask16Sse2(drawFlags(i), drawFlags(i + 8)) << (part * 16);
+        }
+        draws[word] = dw;
+    }
+}
+
+// ---------------------------------------------------------------- AVX2
+
+TICTACTOE_AVX2 inline __m256i hasLineAvx2(__m256i bits) {
+    __m256i any = _mm256_setzero_si256();
+    for (Bitboard mask : Game::WIN_MASKS) {
+        const __m256i m = _mm256_set1_epi16(static_cast<short>(mask));
+        any = _mm256_or_si256(any, _mm256_cmpeq_epi16(_mm256_and_si256(bits, m), m));
+    }
+    return any;
+}
+
+/**
+ * @brief Два регистра по 16 флагов 0/0xFFFF в 32-битную маску.
+ *
+ * packs работает внутри 128-битных половин, перестановка возвращает поля по порядку.
+ */
+TICTACTOE_AVX2 inline std::uint64_t movemask32Avx2(__m256i low, __m256i high) {
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0xD8);
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(packed));
+}
+
+TICTACTOE_AVX2 void makeMoveAvx2(Bitboard* bits, const std::int8_t* cells, std::size_t count) {
+    const __m256i one = _mm256_set1_epi32(1);
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i));
+        // Сдвиг на отрицательную клетку (как беззнаковое число не меньше 32) даёт ноль
+        const __m256i low = _mm256_sllv_epi32(one, _mm256_cvtepi8_epi32(bytes));
+        const __m256i high = _mm256_sllv_epi32(one, _mm256_cvtepi8_epi32(_mm_srli_si128(bytes, 8)));
+        const __m256i add = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+        __m256i* target = reinterpret_cast<__m256i*>(bits + i);
+        _mm256_storeu_si256(target, _mm256_or_si256(_mm256_loadu_si256(target), add));
+    }
+    makeMoveScalar(bits, cells, i, count);
+}
+
+TICTACTOE_AVX2 void checkWinnerAvx2(const Bitboard* x, const Bitboard* o, std::size_t count,
+                                    std::uint64_t* xWins, std::uint64_t* oWins) {
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t xw = 0, ow = 0;
+        for (int part = 0; part < 2; ++part) {
+            const std::size_t i = word * 64 + part * 32;
+            const __m256i* xs = reinterpret_cast<const __m256i*>(x + i);
+            const __m256i* os = reinterpret_cast<const __m256i*>(o + i);
+            xw |= movemask32Avx2(hasLineAvx2(_mm256_loadu_si256(xs)), hasLineAvx2(_mm256_loadu_si256(xs + 1))) << (part * 32);
+            ow |= movemask32Avx2(hasLineAvx2(_mm256_loadu_si256(os)), hasLineAvx2(_mm256_loadu_si256(os + 1))) << (part * 32);
+        }
+        xWins[word] = xw;
+        oWins[word] = ow;
+    }
+}
+
+TICTACTOE_AVX2 void isDrawAvx2(const Bitboard* x, const Bitboard* o, std::size_t count, std::uint64_t* draws) {
+    const __m256i full = _mm256_set1_epi16(Game::FULL_BOARD);
+    for (std::size_t word = 0; word < count / 64; ++word) {
+        std::uint64_t dw = 0;
+        for (int part = 0; part < 2; ++part) {
+            __m256i flags[2];
+            for (int half = 0; half < 2; ++half) {
+                const std::size_t i = word * 64 + part * 32 + half * 16;
+                const __m256i xs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+                const __m256i os = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(o + i));
+                const __m256i filled = _mm256_cmpeq_epi16(_mm256_or_si256(xs, os), full);
+                flags[half] = _mm256_andnot_si256(_mm256_or_si256(hasLineAvx2(xs), hasLineAvx2(os)), filled);
+            }
+            dw |= movemask32Avx2(flags[0], flags[1]) << (part * 32);
+        }
+        draws[word] = dw;
+    }
+}
+
+/**
+ * @brief Поддерживает ли процессор и ОС инструкции AVX2.
+ */
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    // Регистры YMM должны сохраняться операционной системой
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // TICTACTOE_X86
+
+} // namespace
+
+BoardBatch::BoardBatch(std::size_t count) : kernel_(bestKernel()) {
+    resize(count);
+}
+
+void BoardBatch::resize(std::size_t count) {
+    count_ = count;
+    const std::size_t padded = (count + 63) / 64 * 64;
+    x_.assign(padded, 0);
+    o_.assign(padded, 0);
+}
+
+void BoardBatch::reset() {
+    std::fill(x_.begin(), x_.end(), Bitboard(0));
+    std::fill(o_.begin(), o_.end(), Bitboard(0));
+}
+
+void BoardBatch::set(std::size_t index, const Game& game) {
+    x_[index] = game.getBits(GameBase::X);
+    o_[index] = game.getBits(GameBase::O);
+}
+
+void BoardBatch::makeMove(const std::int8_t* cells, Cell player) {
+    Bitboard* bits = player == GameBase::X ? x_.data() : o_.data();
+    switch (kernel_) {
+#ifdef TICTACTOE_X86
+    case Avx2: makeMoveAvx2(bits, cells, count_); break;
+    case Sse2: makeMoveSse2(bits, cells, count_); break;
+#endif
+    default: makeMoveScalar(bits, cells, 0, count_); break;
+    }
+}
+
+void BoardBatch::checkWinner(std::uint64_t* xWins, std::uint64_t* oWins) const {
+    switch (kernel_) {
+#ifdef TICTACTOE_X86
+    case Avx2: checkWinnerAvx2(x_.data(), o_.data(), x_.size(), xWins, oWins); break;
+    case Sse2: checkWinnerSse2(x_.data(), o_.data(), x_.size(), xWins, oWins); break;
+#endif
+    default: checkWinnerScalar(x_.data(), o_.data(), x_.size(), xWins, oWins); break;
+    }
+}
+
+void BoardBatch::isDraw(std::uint64_t* draws) const {
+    switch (kernel_) {
+#ifdef TICTACTOE_X86
+    case Avx2: isDrawAvx2(x_.data(), o_.data(), x_.size(), draws); break;
+    case Sse2: isDrawSse2(x_.data(), o_.data(), x_.size(), draws); break;
+#endif
+    default: isDrawScalar(x_.data(), o_.data(), x_.size(), draws); break;
+    }
+}
+
+BoardBatch::Kernel BoardBatch::setKernel(Kernel kernel) {
+    kernel_ = kernel > bestKernel() ? bestKernel() : kernel;
+    return kernel_;
+}
+
+BoardBatch::Kernel BoardBatch::bestKernel() {
+#ifdef TICTACTOE_X86
+    // SSE2 входит в базовый набор x86-64; на 32-битном x86 его наличие предполагается
+    static const Kernel best = cpuHasAvx2() ? Avx2 : Sse2;
+    return best;
+#else
+    return Scalar;
+#endif
+}
+
+const char* BoardBatch::kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Avx2: return "avx2";
+    case Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * @file BoardBatch.h
+ * @brief Пакет полей 3x3 в виде структуры массивов с векторными проверками.
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Много полей 3x3, хранящихся по столбцам: отдельный массив масок X и массив масок O.
+ *
+ * Пакетные операции обрабатывают все поля за один проход: AVX2 — 16 полей
+ * на регистр, SSE2 — 8, скалярный вариант — по одному. Реализация
+ * выбирается во время выполнения по возможностям процессора. Результаты
+ * проверок — битовые маски: бит i слова i / 64 относится к полю i.
+ * Массивы дополнены пустыми полями до кратного 64 размера, поэтому
+ * лишние биты масок всегда нулевые.
+ */
+class BoardBatch {
+public:
+    using Cell = GameBase::Cell;
+    using Bitboard = Game::Bitboard;
+
+    /**
+     * @brief Реализация пакетных операций.
+     */
+    enum Kernel {
+        Scalar,
+        Sse2,
+        Avx2
+    };
+
+    /**
+     * @brief Конструктор.
+     * @param count Число полей; все поля пустые
+     */
+    explicit BoardBatch(std::size_t count = 0);
+
+    /**
+     * @brief Меняет число полей; все поля становятся пустыми.
+     */
+    void resize(std::size_t count);
+
+    /**
+     * @brief Очищает все поля.
+     */
+    void reset();
+
+    /**
+     * @brief Число полей.
+     */
+    std::size_t size() const { return count_; }
+
+    /**
+     * @brief Число 64-битных слов в масках результатов.
+     */
+    std::size_t maskWords() const { return x_.size() / 64; }
+
+    /**
+     * @brief Копирует позицию в поле с номером index.
+     */
+    void set(std::size_t index, const Game& game);
+
+    /**
+     * @brief Маска клеток игрока на поле index.
+     */
+    Bitboard bits(std::size_t index, Cell player) const { return player == GameBase::X ? x_[index] : o_[index]; }
+
+    /**
+     * @brief Ставит символ игрока в клетку на каждом поле.
+     * @param cells Клетка для каждого поля (size() значений); отрицательная — поле пропускается.
+     *              Клетка должна быть свободна.
+     * @param player Игрок, который ходит на всех полях
+     */
+    void makeMove(const std::int8_t* cells, Cell player);
+
+    /**
+     * @brief Ищет собранные линии на всех полях.
+     * @param xWins Маска полей с линией X (maskWords() слов)
+     * @param oWins Маска полей с линией O (maskWords() слов)
+     */
+    void checkWinner(std::uint64_t* xWins, std::uint64_t* oWins) const;
+
+    /**
+     * @brief Ищет заполненные поля без собранных линий.
+     * @param draws Маска ничьих (maskWords() слов)
+     */
+    void isDraw(std::uint64_t* draws) const;
+
+    /**
+     * @brief Текущая реализация.
+     */
+    Kernel kernel() const { return kernel_; }
+
+    /**
+     * @brief Выбирает реализацию; неподдерживаемая процессором заменяется лучшей доступной.
+     * @return Выбранная реализация
+     */
+    Kernel setKernel(Kernel kernel);
+
+    /**
+     * @brief Лучшая реализация, которую поддерживает процессор.
+     */
+    static Kernel bestKernel();
+
+    /**
+     * @brief Название реализации для отчётов.
+     */
+    static const char* kernelName(Kernel kernel);
+
+private:
+    std::vector<Bitboard> x_;
+    std::vector<Bitboard> o_;
+    std::size_t count_ = 0;
+    Kernel kernel_;
+};
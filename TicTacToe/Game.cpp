@@ -1,90 +1,278 @@
 /**
  * @file Game.h
- * @brief    "-".
+ * @brief Реализация логики игры "Крестики-нолики".
  */
 
 #include "Game.h"
 
+#include <algorithm>
+
  /**
-  * @brief   Game.   reset()    .
+  * @brief Конструктор класса Game. Вызывает метод reset() для очистки игрового поля.
   */
-Game::Game() {
+Game::BasicGame() {
     reset();
 }
 
 /**
- * @brief     .
+ * @brief Ставит фигуру в клетку и записывает ход в историю.
  *
- * @param y   (02).
- * @param x   (02).
- * @param player   (X  O).
- * @return true,    (      ).
- * @return false,       .
+ * @param cell Индекс клетки y * BOARD_SIZE + x.
+ * @param player Символ игрока (X или O); для Empty ход ничего не меняет.
+ * @return false, если ячейка занята.
+ */
+bool Game::apply(int cell, Cell player) {
+    const Bitboard bit = static_cast<Bitboard>(1u << cell);
+    if ((xBits_ | oBits_) & bit)
+        return false;
+    if (player == X)
+        xBits_ |= bit;
+    else if (player == O)
+        oBits_ |= bit;
+    else
+        return true;
+    hash_ ^= ZOBRIST[2 * cell + (player == O)];
+    history_[count_++] = detail::MoveRecord{ static_cast<std::int16_t>(cell), static_cast<std::uint8_t>(player), 0 };
+    return true;
+}
+
+/**
+ * @brief Делает ход игрока на поле.
+ *
+ * @param y Координата строки (0–2).
+ * @param x Координата столбца (0–2).
+ * @param player Символ игрока (X или O).
+ * @return true, если ход успешен (ячейка была пуста и в пределах поля).
+ * @return false, если координаты вне поля или ячейка занята.
  */
 bool Game::makeMove(int y, int x, Cell player) {
     if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE)
         return false;
-    if (board_[y][x] != Empty)
+    if (!apply(y * BOARD_SIZE + x, player))
+        return false;
+    redoEnd_ = count_;
+    TICTACTOE_COUNT(MovesApplied);
+    return true;
+}
+
+/**
+ * @brief Снимает последний ход с поля; ход остаётся в истории для redo().
+ */
+bool Game::undo() {
+    if (count_ == 0)
+        return false;
+    const detail::MoveRecord& move = history_[--count_];
+    const Bitboard bit = static_cast<Bitboard>(1u << move.cell);
+    if (move.player == X)
+        xBits_ &= static_cast<Bitboard>(~bit);
+    else
+        oBits_ &= static_cast<Bitboard>(~bit);
+    hash_ ^= ZOBRIST[2 * move.cell + (move.player == O)];
+    return true;
+}
+
+/**
+ * @brief Снимает последний ход и забывает отменённые ходы.
+ */
+bool Game::unmakeMove() {
+    if (!undo())
         return false;
-    board_[y][x] = player;
+    redoEnd_ = count_;
     return true;
 }
 
 /**
- * @brief   .
+ * @brief Повторяет ход, снятый последним вызовом undo().
+ */
+bool Game::redo() {
+    if (count_ >= redoEnd_)
+        return false;
+    const detail::MoveRecord move = history_[count_];
+    return apply(move.cell, static_cast<Cell>(move.player));
+}
+
+/**
+ * @brief Проверяет наличие победителя.
  *
- * @return   (X  O),  Empty,   .
+ * Каждая линия проверяется одной операцией AND и сравнением с маской.
+ *
+ * @return Символ победителя (X или O), либо Empty, если победителя нет.
  */
 Game::Cell Game::checkWinner() const {
-    //    
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        if (board_[i][0] != Empty &&
-            board_[i][0] == board_[i][1] && board_[i][1] == board_[i][2])
-            return board_[i][0];
-        if (board_[0][i] != Empty &&
-            board_[0][i] == board_[1][i] && board_[1][i] == board_[2][i])
-            return board_[0][i];
-    }
-    //  
-    if (board_[0][0] != Empty &&
-        board_[0][0] == board_[1][1] && board_[1][1] == board_[2][2])
-        return board_[0][0];
-    if (board_[0][2] != Empty &&
-        board_[0][2] == board_[1][1] && board_[1][1] == board_[2][0])
-        return board_[0][2];
-
+    TICTACTOE_COUNT(WinnerChecks);
+    if (hasLine(xBits_))
+        return X;
+    if (hasLine(oBits_))
+        return O;
     return Empty;
 }
 
 /**
- * @brief ,    .
+ * @brief Проверяет, является ли игра ничьей.
  *
- * @return true,       .
- * @return false,       .
+ * @return true, если всё поле заполнено и победителя нет.
+ * @return false, если ещё есть ходы или есть победитель.
  */
 bool Game::isDraw() const {
-    if (checkWinner() != Empty) return false;
-    for (const auto& row : board_)
-        for (Cell c : row)
-            if (c == Empty)
-                return false;
-    return true;
+    return (xBits_ | oBits_) == FULL_BOARD && checkWinner() == Empty;
 }
 
 /**
- * @brief   ,    .
+ * @brief Сбрасывает игровое поле, делая все клетки пустыми.
  */
 void Game::reset() {
-    for (auto& row : board_)
-        for (auto& cell : row)
-            cell = Empty;
+    xBits_ = 0;
+    oBits_ = 0;
+    count_ = 0;
+    redoEnd_ = 0;
+    hash_ = 0;
+}
+
+/**
+ * @brief Строит двумерное представление игрового поля по битбордам.
+ *
+ * @return 2D-массив клеток игрового поля.
+ */
+Game::Board Game::getBoard() const {
+    Board board;
+    for (int y = 0; y < BOARD_SIZE; ++y)
+        for (int x = 0; x < BOARD_SIZE; ++x)
+            board[y][x] = getCell(y, x);
+    return board;
 }
 
 /**
- * @brief     .
+ * @brief Возвращает состояние клетки (y, x).
  *
- * @return    2D-  .
+ * @return Символ игрока либо Empty (в том числе для координат вне поля).
+ */
+Game::Cell Game::getCell(int y, int x) const {
+    if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE)
+        return Empty;
+    const Bitboard bit = static_cast<Bitboard>(1u << (y * BOARD_SIZE + x));
+    if (xBits_ & bit)
+        return X;
+    if (oBits_ & bit)
+        return O;
+    return Empty;
+}
+
+/**
+ * @brief Возвращает битовую маску клеток игрока.
+ *
+ * @return Маска клеток X или O; для Empty — маска свободных клеток.
+ */
+Game::Bitboard Game::getBits(Cell player) const {
+    if (player == X)
+        return xBits_;
+    if (player == O)
+        return oBits_;
+    return static_cast<Bitboard>(~(xBits_ | oBits_) & FULL_BOARD);
+}
+
+/**
+ * @brief Конструктор поля произвольного размера.
+ *
+ * Некорректные параметры приводятся к допустимым: сторона поля не меньше 1,
+ * длина линии в пределах [1, size]. Ключи Зобриста берутся из той же
+ * последовательности, что и у BasicGame.
+ */
+DynamicGame::DynamicGame(int size, int winLength)
+    : size_(std::max(size, 1)),
+      winLength_(std::clamp(winLength, 1, std::max(size, 1))),
+      cells_(static_cast<std::size_t>(size_) * size_, Empty),
+      history_(cells_.size()),
+      zobrist_(cells_.size() * 2) {
+    std::uint64_t state = detail::ZOBRIST_SEED;
+    for (auto& key : zobrist_)
+        key = detail::splitmix64(state);
+    reset();
+}
+
+/**
+ * @brief Ставит фигуру в клетку, обновляет победителя и записывает ход в историю.
+ */
+bool DynamicGame::apply(int cell, Cell player) {
+    std::uint8_t& target = cells_[cell];
+    if (target != Empty)
+        return false;
+    if (player == Empty)
+        return true;
+    target = static_cast<std::uint8_t>(player);
+    hash_ ^= zobrist_[2 * cell + (player == O)];
+    const bool setWinner = winner_ == Empty && detail::completesLine(cells_.data(), size_, winLength_, cell / size_, cell % size_);
+    if (setWinner)
+        winner_ = player;
+    history_[count_++] = detail::MoveRecord{ static_cast<std::int16_t>(cell), static_cast<std::uint8_t>(player),
+                                             static_cast<std::uint8_t>(setWinner) };
+    return true;
+}
+
+/**
+ * @brief Делает ход игрока и инкрементально обновляет победителя.
+ *
+ * @return false, если координаты вне поля или ячейка занята.
+ */
+bool DynamicGame::makeMove(int y, int x, Cell player) {
+    if (x < 0 || x >= size_ || y < 0 || y >= size_)
+        return false;
+    if (!apply(y * size_ + x, player))
+        return false;
+    redoEnd_ = count_;
+    TICTACTOE_COUNT(MovesApplied);
+    return true;
+}
+
+/**
+ * @brief Снимает последний ход с поля; ход остаётся в истории для redo().
+ */
+bool DynamicGame::undo() {
+    if (count_ == 0)
+        return false;
+    const detail::MoveRecord& move = history_[--count_];
+    cells_[move.cell] = Empty;
+    hash_ ^= zobrist_[2 * move.cell + (move.player == O)];
+    if (move.setWinner)
+        winner_ = Empty;
+    return true;
+}
+
+/**
+ * @brief Снимает последний ход и забывает отменённые ходы.
+ */
+bool DynamicGame::unmakeMove() {
+    if (!undo())
+        return false;
+    redoEnd_ = count_;
+    return true;
+}
+
+/**
+ * @brief Повторяет ход, снятый последним вызовом undo().
+ */
+bool DynamicGame::redo() {
+    if (count_ >= redoEnd_)
+        return false;
+    const detail::MoveRecord move = history_[count_];
+    return apply(move.cell, static_cast<Cell>(move.player));
+}
+
+/**
+ * @brief Сбрасывает игровое поле, делая все клетки пустыми.
+ */
+void DynamicGame::reset() {
+    std::fill(cells_.begin(), cells_.end(), static_cast<std::uint8_t>(Empty));
+    hash_ = 0;
+    count_ = 0;
+    redoEnd_ = 0;
+    winner_ = Empty;
+}
+
+/**
+ * @brief Возвращает состояние клетки (y, x) либо Empty для координат вне поля.
  */
-const std::array<std::array<Game::Cell, Game::BOARD_SIZE>, Game::BOARD_SIZE>& Game::getBoard() const {
-    return board_;
+DynamicGame::Cell DynamicGame::getCell(int y, int x) const {
+    if (x < 0 || x >= size_ || y < 0 || y >= size_)
+        return Empty;
+    return static_cast<Cell>(cells_[y * size_ + x]);
 }
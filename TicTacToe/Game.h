@@ -1,18 +1,19 @@
 #pragma once
+#include "Instrumentation.h"
+
 #include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 /**
- * @brief ,    -.
+ * @brief Общие для всех вариантов поля типы.
  */
-class Game {
+class GameBase {
 public:
     /**
-     * @brief    (3x3).
-     */
-    static const int BOARD_SIZE = 3;
-
-    /**
-     * @brief    .
+     * @brief Перечисление возможных состояний клетки.
      */
     enum Cell {
         Empty,
@@ -21,42 +22,739 @@ public:
     };
 
     /**
-     * @brief .   .
+     * @brief Количество симметрий квадратного поля (повороты и отражения).
      */
-    Game();
+    static constexpr int SYMMETRY_COUNT = 8;
 
     /**
-     * @brief      .
-     * @param y 
-     * @param x 
-     * @param player   (X  O)
-     * @return true,    ; false       
+     * @brief Возвращает соперника игрока.
+     * @param player Символ игрока (X или O)
+     * @return O для X и X для O
+     */
+    static constexpr Cell opponent(Cell player) {
+        return player == X ? O : X;
+    }
+
+    /**
+     * @brief Переводит клетку при симметрии поля.
+     *
+     * Симметрии: 0 — тождественная, 1–3 — повороты на 90, 180 и 270 градусов,
+     * 4 — отражение слева направо, 5 — сверху вниз, 6 — относительно главной
+     * диагонали, 7 — относительно побочной диагонали.
+     *
+     * @param cell Индекс клетки y * size + x
+     * @param size Размер стороны поля
+     * @param symmetry Номер симметрии в диапазоне [0, SYMMETRY_COUNT)
+     * @return Индекс клетки-образа
+     */
+    static constexpr int transformCell(int cell, int size, int symmetry) {
+        const int y = cell / size, x = cell % size, last = size - 1;
+        switch (symmetry) {
+        case 1: return x * size + (last - y);
+        case 2: return (last - y) * size + (last - x);
+        case 3: return (last - x) * size + y;
+        case 4: return y * size + (last - x);
+        case 5: return (last - y) * size + x;
+        case 6: return x * size + y;
+        case 7: return (last - x) * size + (last - y);
+        default: return cell;
+        }
+    }
+
+    /**
+     * @brief Возвращает симметрию, обратную данной.
+     */
+    static constexpr int inverseSymmetry(int symmetry) {
+        return symmetry == 1 ? 3 : (symmetry == 3 ? 1 : symmetry);
+    }
+};
+
+namespace detail {
+
+/**
+ * @brief Генератор splitmix64: детерминированная последовательность 64-битных чисел.
+ * @param state Состояние генератора (изменяется)
+ * @return Очередное псевдослучайное число
+ */
+constexpr std::uint64_t splitmix64(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Начальное состояние генератора ключей Зобриста.
+ */
+constexpr std::uint64_t ZOBRIST_SEED = 0x2545F4914F6CDD1Dull;
+
+/**
+ * @brief Ключи Зобриста: ключ клетки c для игрока p имеет индекс 2 * c + (p == O).
+ *
+ * Ключи зависят только от индекса клетки, поэтому одинаковые позиции
+ * в BasicGame<N, K> и DynamicGame(N, K) имеют одинаковый хеш.
+ */
+template <int Count>
+constexpr std::array<std::uint64_t, Count> makeZobristKeys() {
+    std::array<std::uint64_t, Count> keys{};
+    std::uint64_t state = ZOBRIST_SEED;
+    for (int i = 0; i < Count; ++i)
+        keys[i] = splitmix64(state);
+    return keys;
+}
+
+/**
+ * @brief Запись истории ходов.
+ */
+struct MoveRecord {
+    std::int16_t cell;       /**< Индекс клетки */
+    std::uint8_t player;     /**< Символ игрока */
+    std::uint8_t setWinner;  /**< 1, если ход собрал первую линию */
+};
+
+/**
+ * @brief Хеш позиции при симметрии, посчитанный по истории ходов.
+ * @param moves Ходы
+ * @param count Число ходов
+ * @param keys Ключи Зобриста
+ * @param size Размер стороны поля
+ * @param symmetry Номер симметрии
+ */
+inline std::uint64_t symmetricHash(const MoveRecord* moves, int count, const std::uint64_t* keys, int size, int symmetry) {
+    std::uint64_t hash = 0;
+    for (int i = 0; i < count; ++i)
+        hash ^= keys[2 * GameBase::transformCell(moves[i].cell, size, symmetry) + (moves[i].player == GameBase::O)];
+    return hash;
+}
+
+/**
+ * @brief Минимальный по всем симметриям хеш позиции.
+ * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в каноническую
+ */
+inline std::uint64_t canonicalHash(const MoveRecord* moves, int count, const std::uint64_t* keys, int size, int* symmetry) {
+    std::uint64_t best = symmetricHash(moves, count, keys, size, 0);
+    int bestSymmetry = 0;
+    for (int s = 1; s < GameBase::SYMMETRY_COUNT; ++s) {
+        const std::uint64_t hash = symmetricHash(moves, count, keys, size, s);
+        if (hash < best) {
+            best = hash;
+            bestSymmetry = s;
+        }
+    }
+    if (symmetry)
+        *symmetry = bestSymmetry;
+    return best;
+}
+
+/**
+ * @brief Проверяет, собрал ли последний ход в клетке (y, x) линию из k камней.
+ *
+ * Просматриваются только четыре линии через клетку, поэтому стоимость
+ * проверки O(k) и не зависит от площади поля.
+ *
+ * @param cells Клетки поля построчно
+ * @param n Размер стороны поля
+ * @param k Длина выигрышной линии
+ * @param y Строка последнего хода
+ * @param x Столбец последнего хода
+ * @return true, если через клетку проходит линия не короче k
+ */
+inline bool completesLine(const std::uint8_t* cells, int n, int k, int y, int x) {
+    static constexpr int DIRECTIONS[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    const std::uint8_t player = cells[y * n + x];
+    for (const auto& d : DIRECTIONS) {
+        int count = 1;
+        for (int i = 1; i < k; ++i) {
+            const int yy = y + d[0] * i, xx = x + d[1] * i;
+            if (yy < 0 || yy >= n || xx < 0 || xx >= n || cells[yy * n + xx] != player)
+                break;
+            ++count;
+        }
+        for (int i = 1; i < k; ++i) {
+            const int yy = y - d[0] * i, xx = x - d[1] * i;
+            if (yy < 0 || yy >= n || xx < 0 || xx >= n || cells[yy * n + xx] != player)
+                break;
+            ++count;
+        }
+        if (count >= k)
+            return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+/**
+ * @brief Игра "k в ряд" на поле N x N с размерами, известными при компиляции.
+ *
+ * Победитель определяется инкрементально: после каждого хода проверяются
+ * только линии, проходящие через сыгранную клетку. Ходы записываются в
+ * историю фиксированной ёмкости, что даёт unmakeMove() для поиска и
+ * undo()/redo() для интерфейса; хеш Зобриста обновляется при каждом ходе.
+ *
+ * @tparam N Размер стороны поля
+ * @tparam K Длина выигрышной линии
+ */
+template <int N, int K>
+class BasicGame : public GameBase {
+    static_assert(N > 0 && K > 0 && K <= N, "win length must fit the board");
+
+public:
+    /**
+     * @brief Размер стороны игрового поля.
+     */
+    static constexpr int BOARD_SIZE = N;
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    static constexpr int WIN_LENGTH = K;
+
+    /**
+     * @brief Количество клеток поля.
+     */
+    static constexpr int CELL_COUNT = N * N;
+
+    /**
+     * @brief Ключи Зобриста для всех клеток поля.
+     */
+    static constexpr std::array<std::uint64_t, 2 * CELL_COUNT> ZOBRIST = detail::makeZobristKeys<2 * CELL_COUNT>();
+
+    /**
+     * @brief Двумерное представление поля (строится по запросу).
+     */
+    using Board = std::array<std::array<Cell, N>, N>;
+
+    /**
+     * @brief Конструктор. Инициализирует пустое поле.
+     */
+    BasicGame() { reset(); }
+
+    /**
+     * @brief Сделать ход игроком в указанную клетку. Отменённые ходы для redo() забываются.
+     * @param y Строка
+     * @param x Столбец
+     * @param player Символ игрока (X или O)
+     * @return true, если ход был сделан; false — если клетка занята или координаты некорректны
      */
     bool makeMove(int y, int x, Cell player);
 
     /**
-     * @brief  .
-     * @return    (X  O),  Empty   
+     * @brief Отменить последний ход без возможности повтора (для поиска).
+     * @return false, если ходов нет
+     */
+    bool unmakeMove();
+
+    /**
+     * @brief Отменить последний ход с возможностью повторить его через redo().
+     * @return false, если ходов нет
+     */
+    bool undo();
+
+    /**
+     * @brief Повторить последний отменённый ход.
+     * @return false, если отменённых ходов нет
+     */
+    bool redo();
+
+    /**
+     * @brief Проверка победителя.
+     * @return Символ игрока, первым собравшего линию, либо Empty
+     */
+    Cell checkWinner() const {
+        TICTACTOE_COUNT(WinnerChecks);
+        return winner_;
+    }
+
+    /**
+     * @brief Проверка на ничью.
+     * @return true, если поле заполнено и победителя нет
+     */
+    bool isDraw() const { return count_ == CELL_COUNT && winner_ == Empty; }
+
+    /**
+     * @brief Сброс игры. Очищает игровое поле и историю.
+     */
+    void reset();
+
+    /**
+     * @brief Получить текущее состояние игрового поля.
+     * @return Двумерный массив клеток
+     */
+    Board getBoard() const;
+
+    /**
+     * @brief Получить состояние одной клетки.
+     * @param y Строка
+     * @param x Столбец
+     * @return Символ в клетке либо Empty
+     */
+    Cell getCell(int y, int x) const;
+
+    /**
+     * @brief Хеш Зобриста текущей позиции.
+     */
+    std::uint64_t hash() const { return hash_; }
+
+    /**
+     * @brief Хеш, одинаковый для всех симметричных позиций (минимум по 8 симметриям).
+     * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в каноническую
+     */
+    std::uint64_t canonicalHash(int* symmetry = nullptr) const {
+        return detail::canonicalHash(history_.data(), count_, ZOBRIST.data(), N, symmetry);
+    }
+
+    /**
+     * @brief Число сделанных ходов.
+     */
+    int moveCount() const { return count_; }
+
+    /**
+     * @brief Клетка хода с номером ply (с нуля) либо -1.
+     */
+    int moveAt(int ply) const { return ply >= 0 && ply < count_ ? history_[ply].cell : -1; }
+
+    /**
+     * @brief Размер стороны поля.
+     */
+    int size() const { return N; }
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    int winLength() const { return K; }
+
+private:
+    bool apply(int cell, Cell player);
+
+    std::array<std::uint8_t, CELL_COUNT> cells_;
+    std::array<detail::MoveRecord, CELL_COUNT> history_;
+    std::uint64_t hash_;
+    int count_;
+    int redoEnd_;
+    Cell winner_;
+};
+
+/**
+ * @brief Классические крестики-нолики 3x3.
+ *
+ * Специализация хранит поле в виде битбордов: по одной 9-битной маске
+ * на игрока, бит с номером y * BOARD_SIZE + x соответствует клетке (y, x).
+ * Проверка победителя сводится к нескольким операциям AND с таблицей масок.
+ */
+template <>
+class BasicGame<3, 3> : public GameBase {
+public:
+    /**
+     * @brief Размер игрового поля (3x3).
+     */
+    static constexpr int BOARD_SIZE = 3;
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    static constexpr int WIN_LENGTH = 3;
+
+    /**
+     * @brief Количество клеток поля.
+     */
+    static constexpr int CELL_COUNT = 9;
+
+    /**
+     * @brief Ключи Зобриста для всех клеток поля.
+     */
+    static constexpr std::array<std::uint64_t, 2 * CELL_COUNT> ZOBRIST = detail::makeZobristKeys<2 * CELL_COUNT>();
+
+    /**
+     * @brief Двумерное представление поля (строится по запросу).
+     */
+    using Board = std::array<std::array<Cell, BOARD_SIZE>, BOARD_SIZE>;
+
+    /**
+     * @brief Битовая маска клеток одного игрока.
+     */
+    using Bitboard = std::uint16_t;
+
+    /**
+     * @brief Маска полностью заполненного поля.
+     */
+    static constexpr Bitboard FULL_BOARD = 0x1FF;
+
+    /**
+     * @brief Заранее вычисленные маски восьми выигрышных линий.
+     */
+    static constexpr std::array<Bitboard, 8> WIN_MASKS = {
+        0x007, 0x038, 0x1C0,    // строки
+        0x049, 0x092, 0x124,    // столбцы
+        0x111, 0x054            // диагонали
+    };
+
+    /**
+     * @brief Проверяет, содержит ли маска игрока хотя бы одну полную линию.
+     * @param bits Маска клеток игрока
+     * @return true, если линия собрана
+     */
+    static constexpr bool hasLine(Bitboard bits) {
+        for (Bitboard mask : WIN_MASKS)
+            if ((bits & mask) == mask)
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Конструктор. Инициализирует пустое поле.
+     */
+    BasicGame();
+
+    /**
+     * @brief Сделать ход игроком в указанную клетку. Отменённые ходы для redo() забываются.
+     * @param y Строка
+     * @param x Столбец
+     * @param player Символ игрока (X или O)
+     * @return true, если ход был сделан; false — если клетка занята или координаты некорректны
+     */
+    bool makeMove(int y, int x, Cell player);
+
+    /**
+     * @brief Отменить последний ход без возможности повтора (для поиска).
+     * @return false, если ходов нет
+     */
+    bool unmakeMove();
+
+    /**
+     * @brief Отменить последний ход с возможностью повторить его через redo().
+     * @return false, если ходов нет
+     */
+    bool undo();
+
+    /**
+     * @brief Повторить последний отменённый ход.
+     * @return false, если отменённых ходов нет
+     */
+    bool redo();
+
+    /**
+     * @brief Проверка победителя.
+     * @return Символ победившего игрока (X или O), либо Empty если победителя нет
      */
     Cell checkWinner() const;
 
     /**
-     * @brief   .
-     * @return true,  ; false        
+     * @brief Проверка на ничью.
+     * @return true, если ничья; false — если поле не заполнено или есть победитель
      */
     bool isDraw() const;
 
     /**
-     * @brief  .   .
+     * @brief Сброс игры. Очищает игровое поле и историю.
+     */
+    void reset();
+
+    /**
+     * @brief Получить текущее состояние игрового поля.
+     * @return Двумерный массив клеток, построенный по битбордам
+     */
+    Board getBoard() const;
+
+    /**
+     * @brief Получить состояние одной клетки.
+     * @param y Строка
+     * @param x Столбец
+     * @return Символ в клетке либо Empty
+     */
+    Cell getCell(int y, int x) const;
+
+    /**
+     * @brief Получить битовую маску клеток игрока.
+     * @param player Символ игрока (X или O)
+     * @return Маска занятых игроком клеток
+     */
+    Bitboard getBits(Cell player) const;
+
+    /**
+     * @brief Хеш Зобриста текущей позиции.
+     */
+    std::uint64_t hash() const { return hash_; }
+
+    /**
+     * @brief Хеш, одинаковый для всех симметричных позиций (минимум по 8 симметриям).
+     * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в каноническую
+     */
+    std::uint64_t canonicalHash(int* symmetry = nullptr) const {
+        return detail::canonicalHash(history_.data(), count_, ZOBRIST.data(), BOARD_SIZE, symmetry);
+    }
+
+    /**
+     * @brief Число сделанных ходов.
+     */
+    int moveCount() const { return count_; }
+
+    /**
+     * @brief Клетка хода с номером ply (с нуля) либо -1.
+     */
+    int moveAt(int ply) const { return ply >= 0 && ply < count_ ? history_[ply].cell : -1; }
+
+    /**
+     * @brief Размер стороны поля.
+     */
+    int size() const { return BOARD_SIZE; }
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    int winLength() const { return WIN_LENGTH; }
+
+private:
+    bool apply(int cell, Cell player);
+
+    Bitboard xBits_;
+    Bitboard oBits_;
+    std::uint8_t count_;
+    std::uint8_t redoEnd_;
+    std::uint64_t hash_;
+    std::array<detail::MoveRecord, CELL_COUNT> history_;
+};
+
+/**
+ * @brief Классическая игра 3x3, используемая интерфейсом.
+ */
+using Game = BasicGame<3, 3>;
+
+/**
+ * @brief Игра "k в ряд" на поле, размер которого задаётся во время выполнения.
+ *
+ * Используется для вариантов, не инстанцированных как BasicGame<N, K>.
+ * Правила, история ходов и хеш совпадают с BasicGame.
+ */
+class DynamicGame : public GameBase {
+public:
+    /**
+     * @brief Конструктор. Создаёт пустое поле.
+     * @param size Размер стороны поля
+     * @param winLength Длина выигрышной линии (не больше size)
+     */
+    DynamicGame(int size, int winLength);
+
+    /**
+     * @brief Сделать ход игроком в указанную клетку. Отменённые ходы для redo() забываются.
+     * @return true, если ход был сделан; false — если клетка занята или координаты некорректны
+     */
+    bool makeMove(int y, int x, Cell player);
+
+    /**
+     * @brief Отменить последний ход без возможности повтора (для поиска).
+     * @return false, если ходов нет
+     */
+    bool unmakeMove();
+
+    /**
+     * @brief Отменить последний ход с возможностью повторить его через redo().
+     * @return false, если ходов нет
+     */
+    bool undo();
+
+    /**
+     * @brief Повторить последний отменённый ход.
+     * @return false, если отменённых ходов нет
+     */
+    bool redo();
+
+    /**
+     * @brief Проверка победителя.
+     * @return Символ игрока, первым собравшего линию, либо Empty
+     */
+    Cell checkWinner() const {
+        TICTACTOE_COUNT(WinnerChecks);
+        return winner_;
+    }
+
+    /**
+     * @brief Проверка на ничью.
+     * @return true, если поле заполнено и победителя нет
+     */
+    bool isDraw() const { return count_ == size_ * size_ && winner_ == Empty; }
+
+    /**
+     * @brief Сброс игры. Очищает игровое поле и историю.
      */
     void reset();
 
     /**
-     * @brief     .
-     * @return     
+     * @brief Получить состояние одной клетки.
+     * @return Символ в клетке либо Empty
+     */
+    Cell getCell(int y, int x) const;
+
+    /**
+     * @brief Хеш Зобриста текущей позиции.
+     */
+    std::uint64_t hash() const { return hash_; }
+
+    /**
+     * @brief Хеш, одинаковый для всех симметричных позиций (минимум по 8 симметриям).
+     * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в каноническую
+     */
+    std::uint64_t canonicalHash(int* symmetry = nullptr) const {
+        return detail::canonicalHash(history_.data(), count_, zobrist_.data(), size_, symmetry);
+    }
+
+    /**
+     * @brief Число сделанных ходов.
+     */
+    int moveCount() const { return count_; }
+
+    /**
+     * @brief Клетка хода с номером ply (с нуля) либо -1.
      */
-    const std::array<std::array<Cell, BOARD_SIZE>, BOARD_SIZE>& getBoard() const;
+    int moveAt(int ply) const { return ply >= 0 && ply < count_ ? history_[ply].cell : -1; }
+
+    /**
+     * @brief Размер стороны поля.
+     */
+    int size() const { return size_; }
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    int winLength() const { return winLength_; }
 
 private:
-    std::array<std::array<Cell, BOARD_SIZE>, BOARD_SIZE> board_;
-};
\ No newline at end of file
+    bool apply(int cell, Cell player);
+
+    int size_;
+    int winLength_;
+    std::vector<std::uint8_t> cells_;
+    std::vector<detail::MoveRecord> history_;   // ёмкость фиксирована: size * size
+    std::vector<std::uint64_t> zobrist_;
+    std::uint64_t hash_;
+    int count_;
+    int redoEnd_;
+    Cell winner_;
+};
+
+/**
+ * @brief Ставит фигуру в клетку и записывает ход в историю.
+ */
+template <int N, int K>
+bool BasicGame<N, K>::apply(int cell, Cell player) {
+    std::uint8_t& target = cells_[cell];
+    if (target != Empty)
+        return false;
+    if (player == Empty)
+        return true;
+    target = static_cast<std::uint8_t>(player);
+    hash_ ^= ZOBRIST[2 * cell + (player == O)];
+    const bool setWinner = winner_ == Empty && detail::completesLine(cells_.data(), N, K, cell / N, cell % N);
+    if (setWinner)
+        winner_ = player;
+    history_[count_++] = detail::MoveRecord{ static_cast<std::int16_t>(cell), static_cast<std::uint8_t>(player),
+                                             static_cast<std::uint8_t>(setWinner) };
+    return true;
+}
+
+/**
+ * @brief Делает ход игрока и инкрементально обновляет победителя и хеш.
+ */
+template <int N, int K>
+bool BasicGame<N, K>::makeMove(int y, int x, Cell player) {
+    if (x < 0 || x >= N || y < 0 || y >= N)
+        return false;
+    if (!apply(y * N + x, player))
+        return false;
+    redoEnd_ = count_;
+    TICTACTOE_COUNT(MovesApplied);
+    return true;
+}
+
+template <int N, int K>
+bool BasicGame<N, K>::undo() {
+    // Проверка <= 0 доказывает компилятору неотрицательность индекса: с == 0 GCC в Release
+    // допускал отрицательный count_ после циклов по moveCount() > 0 и давал -Warray-bounds
+    if (count_ <= 0)
+        return false;
+    const int last = count_ - 1;
+    const detail::MoveRecord& move = history_[last];
+    count_ = last;
+    cells_[move.cell] = Empty;
+    hash_ ^= ZOBRIST[2 * move.cell + (move.player == O)];
+    if (move.setWinner)
+        winner_ = Empty;
+    return true;
+}
+
+template <int N, int K>
+bool BasicGame<N, K>::unmakeMove() {
+    if (!undo())
+        return false;
+    redoEnd_ = count_;
+    return true;
+}
+
+template <int N, int K>
+bool BasicGame<N, K>::redo() {
+    if (count_ >= redoEnd_)
+        return false;
+    const detail::MoveRecord move = history_[count_];
+    return apply(move.cell, static_cast<Cell>(move.player));
+}
+
+/**
+ * @brief Сбрасывает игровое поле, делая все клетки пустыми.
+ */
+template <int N, int K>
+void BasicGame<N, K>::reset() {
+    cells_.fill(Empty);
+    hash_ = 0;
+    count_ = 0;
+    redoEnd_ = 0;
+    winner_ = Empty;
+}
+
+/**
+ * @brief Строит двумерное представление игрового поля.
+ */
+template <int N, int K>
+typename BasicGame<N, K>::Board BasicGame<N, K>::getBoard() const {
+    Board board;
+    for (int y = 0; y < N; ++y)
+        for (int x = 0; x < N; ++x)
+            board[y][x] = static_cast<Cell>(cells_[y * N + x]);
+    return board;
+}
+
+/**
+ * @brief Возвращает состояние клетки (y, x) либо Empty для координат вне поля.
+ */
+template <int N, int K>
+GameBase::Cell BasicGame<N, K>::getCell(int y, int x) const {
+    if (x < 0 || x >= N || y < 0 || y >= N)
+        return Empty;
+    return static_cast<Cell>(cells_[y * N + x]);
+}
+
+/**
+ * @brief Признак игр с собственными правилами ходов (UltimateGame).
+ *
+ * Такие игры допускают не все свободные клетки: ходы перечисляет
+ * legalMoves(), проверяет isLegal(), а вместо оценки открытых линий
+ * решатель берёт evaluate(), и случайную доигровку — playRandom().
+ * Остальным вариантам доступна любая свободная клетка.
+ */
+template <class GameT, class = void>
+struct HasMoveGenerator : std::false_type {};
+
+template <class GameT>
+struct HasMoveGenerator<GameT, std::void_t<decltype(std::declval<const GameT&>().legalMoves(nullptr))>>
+    : std::true_type {};
+
+/**
+ * @brief Допустим ли ход в клетку.
+ * @param cell Индекс клетки y * size + x
+ */
+template <class GameT>
+bool isLegalMove(const GameT& game, int cell) {
+    if constexpr (HasMoveGenerator<GameT>::value)
+        return game.isLegal(cell);
+    else
+        return game.getCell(cell / game.size(), cell % game.size()) == GameBase::Empty;
+}
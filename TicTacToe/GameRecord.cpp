@@ -0,0 +1,314 @@
+/**
+ * @file GameRecord.cpp
+ * @brief Кодирование партий и файлы записей.
+ */
+
+#include "GameRecord.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+namespace {
+
+constexpr int FACTORIAL[Game::CELL_COUNT] = { 40320, 5040, 720, 120, 24, 6, 2, 1, 1 };   // (8 - i)!
+
+const char* OUTCOME_NAMES[] = { "OPEN", "XWIN", "OWIN", "DRAW" };
+
+/**
+ * @brief Таблица CRC-32 для полинома 0xEDB88320, построенная при компиляции.
+ */
+constexpr std::array<std::uint32_t, 256> makeCrcTable() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}
+
+constexpr std::array<std::uint32_t, 256> CRC_TABLE = makeCrcTable();
+
+} // namespace
+
+std::uint32_t recordfile::crc32(const void* data, std::size_t size, std::uint32_t crc) {
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i)
+        crc = CRC_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+GameRecord::Outcome GameRecord::outcomeOf(const Game& game) {
+    const Game::Cell winner = game.checkWinner();
+    if (winner == Game::X)
+        return XWin;
+    if (winner == Game::O)
+        return OWin;
+    return game.isDraw() ? Draw : Unfinished;
+}
+
+std::uint32_t GameRecord::encode(const Game& game) {
+    std::int8_t cells[Game::CELL_COUNT];
+    const int count = game.moveCount();
+    for (int i = 0; i < count; ++i)
+        cells[i] = static_cast<std::int8_t>(game.moveAt(i));
+    return encode(cells, count, outcomeOf(game));
+}
+
+/**
+ * @brief Номер Лемера: для каждого хода — число ещё свободных клеток с меньшим номером.
+ *
+ * Клетки, не сыгранные в партии, идут в конце по возрастанию и дают нулевые разряды.
+ */
+std::uint32_t GameRecord::encode(const std::int8_t* cells, int count, Outcome outcome) {
+    std::uint32_t code = 0;
+    std::uint32_t used = 0;
+    for (int i = 0; i < count; ++i) {
+        const std::uint32_t below = (1u << cells[i]) - 1;
+        const int rank = cells[i] - static_cast<int>(std::bitset<Game::CELL_COUNT>(used & below).count());
+        code += rank * FACTORIAL[i];
+        used |= 1u << cells[i];
+    }
+    return code | static_cast<std::uint32_t>(count) << 19 | static_cast<std::uint32_t>(outcome) << 23;
+}
+
+GameRecord::Moves GameRecord::decode(std::uint32_t record) {
+    Moves moves;
+    moves.count = length(record);
+    moves.outcome = outcome(record);
+    std::uint32_t code = record & 0x7FFFF;
+    std::uint32_t used = 0;
+    for (int i = 0; i < moves.count; ++i) {
+        int rank = static_cast<int>(code / FACTORIAL[i]);
+        code %= FACTORIAL[i];
+        // rank-я по счёту свободная клетка
+        int cell = 0;
+        for (;; ++cell) {
+            if (used & (1u << cell))
+                continue;
+            if (rank-- == 0)
+                break;
+        }
+        used |= 1u << cell;
+        moves.cells[i] = static_cast<std::int8_t>(cell);
+    }
+    return moves;
+}
+
+Game GameRecord::replay(std::uint32_t record) {
+    const Moves moves = decode(record);
+    Game game;
+    Game::Cell player = Game::X;
+    for (int i = 0; i < moves.count; ++i) {
+        game.makeMove(moves.cells[i] / Game::BOARD_SIZE, moves.cells[i] % Game::BOARD_SIZE, player);
+        player = Game::opponent(player);
+    }
+    return game;
+}
+
+std::string GameRecord::toText(std::uint32_t record) {
+    const Moves moves = decode(record);
+    std::string text;
+    for (int i = 0; i < moves.count; ++i) {
+        text += static_cast<char>('0' + moves.cells[i]);
+        text += ' ';
+    }
+    return text + OUTCOME_NAMES[moves.outcome];
+}
+
+bool GameRecord::fromText(const std::string& text, std::uint32_t& record) {
+    std::istringstream in(text);
+    std::string token;
+    std::int8_t cells[Game::CELL_COUNT];
+    int count = 0;
+    std::uint32_t used = 0;
+    while (in >> token) {
+        for (int o = 0; o < 4; ++o) {
+            if (token == OUTCOME_NAMES[o]) {
+                std::string extra;
+                if (in >> extra)
+                    return false;
+                record = encode(cells, count, static_cast<Outcome>(o));
+                return true;
+            }
+        }
+        if (token.size() != 1 || token[0] < '0' || token[0] > '8' || count == Game::CELL_COUNT)
+            return false;
+        const int cell = token[0] - '0';
+        if (used & (1u << cell))
+            return false;
+        used |= 1u << cell;
+        cells[count++] = static_cast<std::int8_t>(cell);
+    }
+    return false;
+}
+
+/**
+ * @brief Длина целой части файла записей: заголовок и блоки до первого
+ *        оборванного или испорченного.
+ * @return false, если заголовок файла некорректен
+ */
+bool GameRecordWriter::validLength(std::FILE* file, long& length) {
+    recordfile::FileHeader header{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+        std::memcmp(header.magic, recordfile::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != recordfile::VERSION || header.recordBytes != sizeof(std::uint32_t))
+        return false;
+    length = static_cast<long>(sizeof(header));
+    std::vector<std::uint32_t> records;
+    recordfile::BlockHeader block{};
+    while (std::fread(&block, sizeof(block), 1, file) == 1) {
+        if (block.magic != recordfile::BLOCK_MAGIC || block.count == 0 || block.count > header.blockRecords)
+            break;
+        records.resize(block.count);
+        if (std::fread(records.data(), sizeof(std::uint32_t), block.count, file) != block.count ||
+            recordfile::crc32(records.data(), block.count * sizeof(std::uint32_t)) != block.crc)
+            break;
+        length += static_cast<long>(sizeof(block) + block.count * sizeof(std::uint32_t));
+    }
+    return true;
+}
+
+bool GameRecordWriter::open(const std::string& path, std::string* error) {
+    close();
+    auto fail = [&](const std::string& what) {
+        if (file_)
+            std::fclose(file_);
+        file_ = nullptr;
+        if (error)
+            *error = what;
+        return false;
+    };
+
+    // Блок, оборванный прошлым запуском, скрыл бы от читателя всё дописанное после него
+    long length = 0;
+    if (std::FILE* existing = std::fopen(path.c_str(), "rb")) {
+        std::fseek(existing, 0, SEEK_END);
+        const long size = std::ftell(existing);
+        std::fseek(existing, 0, SEEK_SET);
+        const bool valid = size == 0 || validLength(existing, length);
+        std::fclose(existing);
+        if (!valid)
+            return fail(path + " is not a game record file");
+        std::error_code code;
+        if (length < size)
+            std::filesystem::resize_file(path, static_cast<std::uintmax_t>(length), code);
+        if (code)
+            return fail("cannot truncate " + path + ": " + code.message());
+    }
+
+    file_ = std::fopen(path.c_str(), "ab");
+    if (!file_)
+        return fail("cannot open " + path);
+    if (length == 0) {
+        recordfile::FileHeader header{};
+        std::memcpy(header.magic, recordfile::MAGIC, sizeof(header.magic));
+        header.version = recordfile::VERSION;
+        header.recordBytes = sizeof(std::uint32_t);
+        header.blockRecords = recordfile::BLOCK_RECORDS;
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1 || std::fflush(file_) != 0)
+            return fail("cannot write " + path);
+    }
+    buffer_.reserve(recordfile::BLOCK_RECORDS);
+    return true;
+}
+
+void GameRecordWriter::append(std::uint32_t record) {
+    buffer_.push_back(record);
+    if (buffer_.size() == recordfile::BLOCK_RECORDS)
+        writeBlock();
+}
+
+void GameRecordWriter::append(const std::uint32_t* records, std::size_t count) {
+    while (count > 0) {
+        const std::size_t take = std::min<std::size_t>(count, recordfile::BLOCK_RECORDS - buffer_.size());
+        buffer_.insert(buffer_.end(), records, records + take);
+        records += take;
+        count -= take;
+        if (buffer_.size() == recordfile::BLOCK_RECORDS)
+            writeBlock();
+    }
+}
+
+bool GameRecordWriter::writeBlock() {
+    if (!file_ || buffer_.empty())
+        return true;
+    recordfile::BlockHeader header{};
+    header.magic = recordfile::BLOCK_MAGIC;
+    header.count = static_cast<std::uint32_t>(buffer_.size());
+    header.crc = recordfile::crc32(buffer_.data(), buffer_.size() * sizeof(std::uint32_t));
+    const bool ok = std::fwrite(&header, sizeof(header), 1, file_) == 1 &&
+                    std::fwrite(buffer_.data(), sizeof(std::uint32_t), buffer_.size(), file_) == buffer_.size();
+    buffer_.clear();
+    return ok;
+}
+
+bool GameRecordWriter::flush() {
+    const bool ok = writeBlock();
+    return file_ && std::fflush(file_) == 0 && ok;
+}
+
+void GameRecordWriter::close() {
+    if (!file_)
+        return;
+    writeBlock();
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+bool GameRecordReader::open(const std::string& path, std::string* error) {
+    blocks_.clear();
+    records_ = 0;
+    truncated_ = false;
+    if (!file_.open(path, error))
+        return false;
+
+    const std::uint8_t* data = file_.data();
+    const std::size_t size = file_.size();
+    recordfile::FileHeader header;
+    if (size < sizeof(header) || (std::memcpy(&header, data, sizeof(header)),
+                                  std::memcmp(header.magic, recordfile::MAGIC, sizeof(header.magic)) != 0) ||
+        header.version != recordfile::VERSION || header.recordBytes != sizeof(std::uint32_t)) {
+        if (error)
+            *error = path + " is not a game record file";
+        file_.close();
+        return false;
+    }
+
+    std::size_t offset = sizeof(header);
+    while (offset < size) {
+        recordfile::BlockHeader block;
+        if (size - offset < sizeof(block)) {
+            truncated_ = true;
+            break;
+        }
+        std::memcpy(&block, data + offset, sizeof(block));
+        const std::size_t bytes = static_cast<std::size_t>(block.count) * sizeof(std::uint32_t);
+        if (block.magic != recordfile::BLOCK_MAGIC || block.count > header.blockRecords ||
+            size - offset - sizeof(block) < bytes) {
+            truncated_ = true;
+            break;
+        }
+        // Смещения кратны 4, а отображение выровнено по странице — записи читаются напрямую
+        blocks_.push_back(Block{ reinterpret_cast<const std::uint32_t*>(data + offset + sizeof(block)), block.count, block.crc });
+        records_ += block.count;
+        offset += sizeof(block) + bytes;
+    }
+    return true;
+}
+
+bool GameRecordReader::verify(std::size_t* badBlock) const {
+    for (std::size_t i = 0; i < blocks_.size(); ++i) {
+        if (recordfile::crc32(blocks_[i].records, blocks_[i].count * sizeof(std::uint32_t)) != blocks_[i].crc) {
+            if (badBlock)
+                *badBlock = i;
+            return false;
+        }
+    }
+    return true;
+}
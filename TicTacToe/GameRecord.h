@@ -0,0 +1,259 @@
+/**
+ * @file GameRecord.h
+ * @brief Компактная запись партий 3x3 и файлы записей с блоками и контрольными суммами.
+ */
+
+#pragma once
+#include "Game.h"
+#include "MappedFile.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Партия 3x3 в 32 битах.
+ *
+ * Последовательность ходов — начало перестановки клеток 0..8; оставшиеся
+ * клетки дописываются по возрастанию, и перестановка кодируется номером
+ * Лемера (9! = 362880 < 2^19). Раскладка слова:
+ * биты 0–18 — номер перестановки, 19–22 — число ходов, 23–24 — исход.
+ * Крестики всегда ходят первыми.
+ */
+class GameRecord {
+public:
+    /**
+     * @brief Исход партии.
+     */
+    enum Outcome : std::uint8_t {
+        Unfinished,
+        XWin,
+        OWin,
+        Draw
+    };
+
+    /**
+     * @brief Разобранная запись.
+     */
+    struct Moves {
+        std::array<std::int8_t, Game::CELL_COUNT> cells{};  /**< Клетки ходов по порядку */
+        int count = 0;                                      /**< Число ходов */
+        Outcome outcome = Unfinished;                       /**< Исход */
+    };
+
+    /**
+     * @brief Кодирует партию по истории ходов.
+     */
+    static std::uint32_t encode(const Game& game);
+
+    /**
+     * @brief Кодирует последовательность различных клеток.
+     * @param cells Клетки ходов
+     * @param count Число ходов (не больше 9)
+     * @param outcome Исход
+     */
+    static std::uint32_t encode(const std::int8_t* cells, int count, Outcome outcome);
+
+    /**
+     * @brief Восстанавливает последовательность ходов.
+     */
+    static Moves decode(std::uint32_t record);
+
+    /**
+     * @brief Число ходов без разбора перестановки.
+     */
+    static int length(std::uint32_t record) { return static_cast<int>((record >> 19) & 0xF); }
+
+    /**
+     * @brief Исход без разбора перестановки.
+     */
+    static Outcome outcome(std::uint32_t record) { return static_cast<Outcome>((record >> 23) & 0x3); }
+
+    /**
+     * @brief Исход позиции.
+     */
+    static Outcome outcomeOf(const Game& game);
+
+    /**
+     * @brief Воспроизводит партию.
+     */
+    static Game replay(std::uint32_t record);
+
+    /**
+     * @brief Текстовая форма: клетки ходов через пробел и исход, например "4 0 8 2 6 XWIN".
+     */
+    static std::string toText(std::uint32_t record);
+
+    /**
+     * @brief Разбирает текстовую форму.
+     * @return false, если строка некорректна или ходы повторяются
+     */
+    static bool fromText(const std::string& text, std::uint32_t& record);
+};
+
+/**
+ * @brief Формат файла записей (little-endian).
+ *
+ * Файл начинается с заголовка, за ним идут блоки: заголовок блока и
+ * count записей по 4 байта. Контрольная сумма CRC-32 покрывает записи
+ * блока. Файл только дополняется; недописанный последний блок при
+ * чтении отбрасывается.
+ */
+namespace recordfile {
+
+constexpr char MAGIC[8] = { 'T', 'T', 'T', 'R', 'E', 'C', '\0', '\1' };
+constexpr std::uint32_t VERSION = 1;
+constexpr std::uint32_t BLOCK_MAGIC = 0x4B4C4254;   // "TBLK"
+constexpr std::uint32_t BLOCK_RECORDS = 16384;      // записей в полном блоке (64 КБ)
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordBytes;
+    std::uint32_t blockRecords;
+    std::uint32_t reserved[3];
+};
+
+struct BlockHeader {
+    std::uint32_t magic;
+    std::uint32_t count;
+    std::uint32_t crc;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 32 && sizeof(BlockHeader) == 16, "record file layout");
+
+/**
+ * @brief CRC-32 (IEEE 802.3).
+ */
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+} // namespace recordfile
+
+/**
+ * @brief Дописывает записи в файл блоками.
+ *
+ * Записи копятся в памяти и сбрасываются полным блоком; flush() и close()
+ * записывают неполный блок.
+ */
+class GameRecordWriter {
+public:
+    GameRecordWriter() = default;
+    ~GameRecordWriter() { close(); }
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    /**
+     * @brief Открывает файл для дополнения; новый файл получает заголовок.
+     *
+     * Оборванный или испорченный хвост, оставленный прошлым запуском,
+     * отрезается до конца последнего целого блока.
+     * @param path Путь к файлу
+     * @param error Описание ошибки
+     * @return false, если файл не открылся или это не файл записей
+     */
+    bool open(const std::string& path, std::string* error = nullptr);
+
+    /**
+     * @brief true, если файл открыт.
+     */
+    bool isOpen() const { return file_ != nullptr; }
+
+    /**
+     * @brief Добавляет запись.
+     */
+    void append(std::uint32_t record);
+
+    /**
+     * @brief Добавляет несколько записей.
+     */
+    void append(const std::uint32_t* records, std::size_t count);
+
+    /**
+     * @brief Добавляет завершённую партию.
+     */
+    void append(const Game& game) { append(GameRecord::encode(game)); }
+
+    /**
+     * @brief Записывает накопленные записи и сбрасывает буферы файла.
+     * @return false при ошибке записи
+     */
+    bool flush();
+
+    /**
+     * @brief Сбрасывает записи и закрывает файл.
+     */
+    void close();
+
+private:
+    bool writeBlock();
+    static bool validLength(std::FILE* file, long& length);
+
+    std::FILE* file_ = nullptr;
+    std::vector<std::uint32_t> buffer_;
+};
+
+/**
+ * @brief Читает файл записей через отображение в память без копирования.
+ *
+ * open() проходит только по заголовкам блоков; записи читаются прямо из
+ * отображённых страниц.
+ */
+class GameRecordReader {
+public:
+    /**
+     * @brief Блок записей внутри отображения.
+     */
+    struct Block {
+        const std::uint32_t* records;   /**< Записи блока */
+        std::uint32_t count;            /**< Число записей */
+        std::uint32_t crc;              /**< Сохранённая контрольная сумма */
+    };
+
+    /**
+     * @brief Отображает файл и находит блоки.
+     * @return false, если файл не открылся или заголовок некорректен
+     */
+    bool open(const std::string& path, std::string* error = nullptr);
+
+    /**
+     * @brief Блоки файла.
+     */
+    const std::vector<Block>& blocks() const { return blocks_; }
+
+    /**
+     * @brief Всего записей.
+     */
+    std::uint64_t recordCount() const { return records_; }
+
+    /**
+     * @brief true, если в конце файла был недописанный блок.
+     */
+    bool truncated() const { return truncated_; }
+
+    /**
+     * @brief Проверяет контрольные суммы всех блоков.
+     * @param badBlock Номер первого повреждённого блока
+     * @return true, если все блоки целы
+     */
+    bool verify(std::size_t* badBlock = nullptr) const;
+
+    /**
+     * @brief Вызывает f(record) для каждой записи.
+     */
+    template <class F>
+    void forEach(F&& f) const {
+        for (const Block& block : blocks_)
+            for (std::uint32_t i = 0; i < block.count; ++i)
+                f(block.records[i]);
+    }
+
+private:
+    MappedFile file_;
+    std::vector<Block> blocks_;
+    std::uint64_t records_ = 0;
+    bool truncated_ = false;
+};
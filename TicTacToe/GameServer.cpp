@@ -0,0 +1,508 @@
+/**
+ * @file GameServer.cpp
+ * @brief Реализация сервера партий на epoll.
+ */
+
+#include "GameServer.h"
+#include "Tablebase.h"
+
+#include <array>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Метки событий epoll, не совпадающие с номерами подключений
+constexpr std::uint64_t WAKE_TAG = ~0ull;
+constexpr std::uint64_t LISTEN_TAG = ~0ull - 1;
+
+constexpr std::size_t INPUT_CAPACITY = 4096;
+
+const char* statusOf(const Game& game) {
+    const GameBase::Cell winner = game.checkWinner();
+    if (winner == GameBase::X)
+        return "XWIN";
+    if (winner == GameBase::O)
+        return "OWIN";
+    return game.isDraw() ? "DRAW" : "PLAY";
+}
+
+bool finished(const Game& game) {
+    return game.checkWinner() != GameBase::Empty || game.isDraw();
+}
+
+bool failWith(std::string* error, const char* what) {
+    if (error)
+        *error = std::string(what) + ": " + std::strerror(errno);
+    return false;
+}
+
+} // namespace
+
+GameServer::GameServer(const ServerConfig& config)
+    : config_(config),
+      sessions_(config.sessionCapacity),
+      connections_(config.connectionCapacity) {
+    freeSessions_.reserve(sessions_.size());
+    for (std::uint32_t i = static_cast<std::uint32_t>(sessions_.size()); i-- > 0;)
+        freeSessions_.push_back(i);
+    freeConnections_.reserve(connections_.size());
+    for (std::uint32_t i = static_cast<std::uint32_t>(connections_.size()); i-- > 0;)
+        freeConnections_.push_back(i);
+    dirtyConnections_.reserve(connections_.size());
+    // У слота партии не больше одного задания: закрытая во время хода компьютера
+    // партия возвращает слот только с ответом на него, поэтому кольца не переполняются
+    jobs_.items.resize(sessions_.size());
+    completions_.items.resize(sessions_.size());
+}
+
+GameServer::~GameServer() {
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        workersStopping_ = true;
+    }
+    jobReady_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+    for (std::uint32_t i = 0; i < connections_.size(); ++i)
+        if (connections_[i].fd >= 0)
+            ::close(connections_[i].fd);
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        if (!config_.unixPath.empty())
+            ::unlink(config_.unixPath.c_str());
+    }
+    if (wakeFd_ >= 0)
+        ::close(wakeFd_);
+    if (epollFd_ >= 0)
+        ::close(epollFd_);
+}
+
+bool GameServer::start(std::string* error) {
+    if (config_.unixPath.empty()) {
+        listenFd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0)
+            return failWith(error, "socket");
+        const int one = 1;
+        ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(config_.port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+            return failWith(error, "bind");
+        socklen_t length = sizeof(address);
+        ::getsockname(listenFd_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+    }
+    else {
+        listenFd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd_ < 0)
+            return failWith(error, "socket");
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, config_.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        ::unlink(address.sun_path);
+        if (::bind(listenFd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+            return failWith(error, "bind");
+    }
+    if (::listen(listenFd_, SOMAXCONN) < 0)
+        return failWith(error, "listen");
+
+    epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd_ < 0 || wakeFd_ < 0)
+        return failWith(error, "epoll");
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTEN_TAG;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event);
+    event.data.u64 = WAKE_TAG;
+    ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+    for (int i = 0; i < std::max(1, config_.workers); ++i)
+        workers_.emplace_back(&GameServer::workerLoop, this);
+    return true;
+}
+
+void GameServer::stop() {
+    stopping_.store(true);
+    if (wakeFd_ >= 0) {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void GameServer::run() {
+    std::array<epoll_event, 256> events;
+    while (!stopping_.load()) {
+        const int count = ::epoll_wait(epollFd_, events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            const std::uint64_t tag = events[i].data.u64;
+            if (tag == LISTEN_TAG) {
+                acceptConnections();
+                continue;
+            }
+            if (tag == WAKE_TAG) {
+                std::uint64_t value;
+                [[maybe_unused]] const ssize_t got = ::read(wakeFd_, &value, sizeof(value));
+                drainCompletions();
+                continue;
+            }
+            // Подключение могло закрыться раньше в этой же пачке событий
+            const std::uint32_t index = static_cast<std::uint32_t>(tag);
+            if (connections_[index].fd < 0 || connections_[index].generation != static_cast<std::uint32_t>(tag >> 32))
+                continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(index);
+                continue;
+            }
+            if (events[i].events & EPOLLIN)
+                readConnection(index);
+            if (connections_[index].fd >= 0 && (events[i].events & EPOLLOUT))
+                flushConnection(index);
+        }
+    }
+}
+
+void GameServer::acceptConnections() {
+    for (;;) {
+        const int fd = ::accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return;
+        if (freeConnections_.empty()) {
+            ::close(fd);
+            continue;
+        }
+        const int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        const std::uint32_t index = freeConnections_.back();
+        freeConnections_.pop_back();
+        Connection& connection = connections_[index];
+        connection.fd = fd;
+        connection.sessions = NONE;
+        connection.input.resize(INPUT_CAPACITY);
+        connection.inputSize = 0;
+        connection.output.clear();
+        connection.outputSent = 0;
+        connection.writing = false;
+        connection.dirty = false;
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = (static_cast<std::uint64_t>(connection.generation) << 32) | index;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event);
+        ++stats_.connections;
+    }
+}
+
+/**
+ * @brief Закрывает подключение и все его партии; буферы остаются для следующего подключения.
+ */
+void GameServer::closeConnection(std::uint32_t index) {
+    Connection& connection = connections_[index];
+    ::epoll_ctl(epollFd_, EPOLL_CTL_DEL, connection.fd, nullptr);
+    ::close(connection.fd);
+    connection.fd = -1;
+    ++connection.generation;
+    while (connection.sessions != NONE)
+        closeSession(connection.sessions);
+    freeConnections_.push_back(index);
+}
+
+void GameServer::readConnection(std::uint32_t index) {
+    Connection& connection = connections_[index];
+    for (;;) {
+        if (connection.inputSize == connection.input.size()) {
+            // Строка длиннее буфера — протокол нарушен
+            closeConnection(index);
+            return;
+        }
+        const ssize_t got = ::read(connection.fd, connection.input.data() + connection.inputSize,
+                                   connection.input.size() - connection.inputSize);
+        if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+            closeConnection(index);
+            return;
+        }
+        if (got < 0)
+            break;
+
+        const std::size_t scanFrom = connection.inputSize;
+        connection.inputSize += static_cast<std::size_t>(got);
+        char* data = connection.input.data();
+        std::size_t lineStart = 0;
+        for (std::size_t i = scanFrom; i < connection.inputSize; ++i) {
+            if (data[i] != '\n')
+                continue;
+            data[i] = '\0';
+            if (i > lineStart && data[i - 1] == '\r')
+                data[i - 1] = '\0';
+            handleLine(index, data + lineStart);
+            lineStart = i + 1;
+        }
+        if (lineStart > 0) {
+            std::memmove(data, data + lineStart, connection.inputSize - lineStart);
+            connection.inputSize -= lineStart;
+        }
+    }
+    flushConnection(index);
+}
+
+void GameServer::flushConnection(std::uint32_t index) {
+    Connection& connection = connections_[index];
+    while (connection.outputSent < connection.output.size()) {
+        const ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent,
+                                    connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EINTR)
+                break;
+            closeConnection(index);
+            return;
+        }
+        connection.outputSent += static_cast<std::size_t>(sent);
+    }
+    const bool pending = connection.outputSent < connection.output.size();
+    if (!pending) {
+        connection.output.clear();      // ёмкость сохраняется
+        connection.outputSent = 0;
+    }
+    if (pending != connection.writing) {
+        connection.writing = pending;
+        epoll_event event{};
+        event.events = EPOLLIN | (pending ? EPOLLOUT : 0u);
+        event.data.u64 = (static_cast<std::uint64_t>(connection.generation) << 32) | index;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_MOD, connection.fd, &event);
+    }
+}
+
+void GameServer::reply(std::uint32_t connection, const char* format, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, format);
+    const int length = std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    connections_[connection].output.append(line, static_cast<std::size_t>(std::min<int>(length, sizeof(line) - 1)));
+}
+
+void GameServer::replyMove(std::uint32_t connection, std::uint32_t session, int aiMove) {
+    const Session& s = sessions_[session];
+    reply(connection, "MOVE %llu %d %s\n", static_cast<unsigned long long>(sessionId(session, s.generation)),
+          aiMove, statusOf(s.game));
+}
+
+void GameServer::handleLine(std::uint32_t index, char* line) {
+    char* rest = line;
+    const char* command = rest;
+    while (*rest && *rest != ' ')
+        ++rest;
+    if (*rest)
+        *rest++ = '\0';
+
+    if (!std::strcmp(command, "PING")) {
+        reply(index, "PONG\n");
+        return;
+    }
+    if (!std::strcmp(command, "NEW")) {
+        const GameBase::Cell human = (*rest == 'o' || *rest == 'O') ? GameBase::O : GameBase::X;
+        const std::uint32_t session = openSession(index, human);
+        if (session == NONE) {
+            ++stats_.errors;
+            reply(index, "ERR full\n");
+            return;
+        }
+        reply(index, "NEW %llu\n", static_cast<unsigned long long>(sessionId(session, sessions_[session].generation)));
+        if (human == GameBase::O)
+            submitJob(session);
+        return;
+    }
+
+    const bool isMove = !std::strcmp(command, "MOVE");
+    const bool isEnd = !std::strcmp(command, "END");
+    if (!isMove && !isEnd) {
+        ++stats_.errors;
+        reply(index, "ERR unknown\n");
+        return;
+    }
+    char* end = rest;
+    const unsigned long long id = std::strtoull(rest, &end, 10);
+    Session* session = end != rest ? findSession(index, id) : nullptr;
+    if (!session) {
+        ++stats_.errors;
+        reply(index, "ERR %llu nosession\n", id);
+        return;
+    }
+    const std::uint32_t slot = static_cast<std::uint32_t>(session - sessions_.data());
+    if (isEnd) {
+        closeSession(slot);
+        reply(index, "END %llu\n", id);
+        return;
+    }
+
+    char* cellEnd = end;
+    const long cell = std::strtol(end, &cellEnd, 10);
+    if (session->busy || finished(session->game)) {
+        ++stats_.errors;
+        reply(index, "ERR %llu %s\n", id, session->busy ? "busy" : "over");
+        return;
+    }
+    if (cellEnd == end || cell < 0 || cell >= Game::CELL_COUNT ||
+        !session->game.makeMove(static_cast<int>(cell) / Game::BOARD_SIZE, static_cast<int>(cell) % Game::BOARD_SIZE,
+                                session->human)) {
+        ++stats_.errors;
+        reply(index, "ERR %llu illegal\n", id);
+        return;
+    }
+    ++stats_.moves;
+    if (finished(session->game))
+        replyMove(index, slot, -1);
+    else
+        submitJob(slot);
+}
+
+std::uint32_t GameServer::openSession(std::uint32_t connection, GameBase::Cell human) {
+    if (freeSessions_.empty())
+        return NONE;
+    const std::uint32_t index = freeSessions_.back();
+    freeSessions_.pop_back();
+    Session& session = sessions_[index];
+    session.game.reset();
+    session.human = human;
+    session.active = true;
+    session.busy = false;
+    session.connection = connection;
+    session.prev = NONE;
+    session.next = connections_[connection].sessions;
+    if (session.next != NONE)
+        sessions_[session.next].prev = index;
+    connections_[connection].sessions = index;
+    ++stats_.sessionsOpened;
+    return index;
+}
+
+/**
+ * @brief Закрывает партию; смена поколения делает недействительным ожидаемый ответ компьютера.
+ *
+ * Если задание партии ещё не вернулось, слот освобождается в drainCompletions().
+ */
+void GameServer::closeSession(std::uint32_t index) {
+    Session& session = sessions_[index];
+    if (session.prev != NONE)
+        sessions_[session.prev].next = session.next;
+    else
+        connections_[session.connection].sessions = session.next;
+    if (session.next != NONE)
+        sessions_[session.next].prev = session.prev;
+    session.active = false;
+    session.releasing = session.busy;
+    session.busy = false;
+    session.connection = NONE;
+    ++session.generation;
+    if (!session.releasing)
+        freeSessions_.push_back(index);
+    ++stats_.sessionsClosed;
+}
+
+GameServer::Session* GameServer::findSession(std::uint32_t connection, std::uint64_t id) {
+    const std::uint32_t index = static_cast<std::uint32_t>(id);
+    if (index >= sessions_.size())
+        return nullptr;
+    Session& session = sessions_[index];
+    if (!session.active || session.connection != connection || session.generation != static_cast<std::uint32_t>(id >> 32))
+        return nullptr;
+    return &session;
+}
+
+void GameServer::submitJob(std::uint32_t index) {
+    Session& session = sessions_[index];
+    session.busy = true;
+    {
+        std::lock_guard<std::mutex> lock(jobMutex_);
+        jobs_.push(Job{ index, session.generation, session.game });
+    }
+    jobReady_.notify_one();
+}
+
+void GameServer::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobMutex_);
+            jobReady_.wait(lock, [&] { return workersStopping_ || jobs_.size > 0; });
+            if (!jobs_.pop(job))
+                return;
+        }
+        const Completion completion{ job.session, job.generation, Tablebase::bestMove(job.game) };
+        bool wasEmpty;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            wasEmpty = completions_.size == 0;
+            completions_.push(completion);
+        }
+        // Цикл событий забирает все готовые ответы сразу, поэтому будим его только для первого
+        if (wasEmpty) {
+            const std::uint64_t one = 1;
+            [[maybe_unused]] const ssize_t written = ::write(wakeFd_, &one, sizeof(one));
+        }
+    }
+}
+
+void GameServer::drainCompletions() {
+    std::array<Completion, 256> batch;
+    for (;;) {
+        std::size_t count = 0;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex_);
+            while (count < batch.size() && completions_.pop(batch[count]))
+                ++count;
+        }
+        if (count == 0)
+            break;
+        for (std::size_t i = 0; i < count; ++i) {
+            const Completion& completion = batch[i];
+            Session& session = sessions_[completion.session];
+            if (session.releasing) {
+                session.releasing = false;
+                freeSessions_.push_back(completion.session);
+                continue;
+            }
+            if (!session.active || !session.busy || session.generation != completion.generation)
+                continue;   // партия закрыта, пока компьютер думал
+            session.busy = false;
+            if (completion.move >= 0) {
+                session.game.makeMove(completion.move / Game::BOARD_SIZE, completion.move % Game::BOARD_SIZE,
+                                      GameBase::opponent(session.human));
+                ++stats_.aiMoves;
+            }
+            replyMove(session.connection, completion.session, completion.move);
+            Connection& connection = connections_[session.connection];
+            if (!connection.dirty) {
+                connection.dirty = true;
+                dirtyConnections_.push_back(session.connection);
+            }
+        }
+    }
+    for (std::uint32_t index : dirtyConnections_) {
+        connections_[index].dirty = false;
+        if (connections_[index].fd >= 0)
+            flushConnection(index);
+    }
+    dirtyConnections_.clear();
+}
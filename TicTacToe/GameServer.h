@@ -0,0 +1,208 @@
+/**
+ * @file GameServer.h
+ * @brief Сервер множества партий без интерфейса на цикле событий epoll (только Linux).
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Параметры сервера.
+ */
+struct ServerConfig {
+    std::uint16_t port = 7777;           /**< TCP-порт на 127.0.0.1; 0 — выбрать свободный */
+    std::string unixPath;                /**< Путь Unix-сокета; если задан, TCP не используется */
+    int workers = 2;                     /**< Потоки, вычисляющие ответы компьютера */
+    std::uint32_t sessionCapacity = 1 << 16;   /**< Максимум одновременных партий */
+    std::uint32_t connectionCapacity = 4096;   /**< Максимум одновременных подключений */
+};
+
+/**
+ * @brief Счётчики сервера.
+ */
+struct ServerStats {
+    std::uint64_t connections = 0;      /**< Принятые подключения */
+    std::uint64_t sessionsOpened = 0;   /**< Начатые партии */
+    std::uint64_t sessionsClosed = 0;   /**< Закрытые партии */
+    std::uint64_t moves = 0;            /**< Ходы игроков */
+    std::uint64_t aiMoves = 0;          /**< Ходы компьютера */
+    std::uint64_t errors = 0;           /**< Отклонённые команды */
+};
+
+/**
+ * @brief Сервер партий 3x3 против компьютера.
+ *
+ * Протокол строковый, одна команда на строку:
+ *  - "NEW [x|o]" — начать партию за крестики (по умолчанию) или нолики;
+ *    ответ "NEW <id>". Если игрок выбрал нолики, следом приходит ход компьютера.
+ *  - "MOVE <id> <клетка>" — ход игрока в клетку y * 3 + x; ответ
+ *    "MOVE <id> <ход компьютера | -1> <PLAY | XWIN | OWIN | DRAW>".
+ *  - "END <id>" — закрыть партию; ответ "END <id>".
+ *  - "PING" — ответ "PONG".
+ * Ошибки: "ERR [<id>] <причина>".
+ *
+ * Все подключения обслуживает один цикл epoll. Партии и подключения
+ * хранятся в пулах фиксированной ёмкости со списками свободных мест,
+ * буферы подключений переиспользуются, поэтому в установившемся режиме
+ * ход не выделяет память. Ответы компьютера (Tablebase) считают потоки
+ * рабочего пула: задания и результаты передаются через кольцевые буферы
+ * с ёмкостью, равной числу партий, а о готовых результатах цикл узнаёт
+ * через eventfd. Идентификатор партии содержит поколение слота, поэтому
+ * запоздавший ответ для уже закрытой партии отбрасывается.
+ */
+class GameServer {
+public:
+    /**
+     * @brief Конструктор. Выделяет пулы; сокеты открывает start().
+     * @param config Параметры сервера
+     */
+    explicit GameServer(const ServerConfig& config);
+
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    /**
+     * @brief Открывает сокет и запускает рабочие потоки.
+     * @param error Описание ошибки, если запуск не удался
+     * @return true при успехе
+     */
+    bool start(std::string* error = nullptr);
+
+    /**
+     * @brief Обслуживает подключения до вызова stop().
+     */
+    void run();
+
+    /**
+     * @brief Останавливает run(). Можно вызывать из другого потока и из обработчика сигнала.
+     */
+    void stop();
+
+    /**
+     * @brief Фактический TCP-порт (после start()).
+     */
+    std::uint16_t port() const { return port_; }
+
+    /**
+     * @brief Счётчики (читать после остановки либо из потока run()).
+     */
+    const ServerStats& stats() const { return stats_; }
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+    struct Session {
+        Game game;
+        std::uint32_t generation = 0;
+        std::uint32_t connection = NONE;
+        std::uint32_t prev = NONE;      // соседи в списке партий подключения
+        std::uint32_t next = NONE;
+        GameBase::Cell human = GameBase::X;
+        bool active = false;
+        bool busy = false;              // ждёт ответа компьютера
+        bool releasing = false;         // закрыта, слот освободится с ответом на её задание
+    };
+
+    struct Connection {
+        int fd = -1;
+        std::uint32_t generation = 0;
+        std::uint32_t sessions = NONE;  // голова списка партий
+        std::vector<char> input;
+        std::size_t inputSize = 0;
+        std::string output;
+        std::size_t outputSent = 0;
+        bool writing = false;           // подписан на EPOLLOUT
+        bool dirty = false;             // получил ответы компьютера, ждёт отправки
+    };
+
+    struct Job {
+        std::uint32_t session;
+        std::uint32_t generation;
+        Game game;
+    };
+
+    struct Completion {
+        std::uint32_t session;
+        std::uint32_t generation;
+        int move;
+    };
+
+    /**
+     * @brief Кольцевой буфер фиксированной ёмкости под мьютексом.
+     */
+    template <class T>
+    struct Ring {
+        std::vector<T> items;
+        std::size_t head = 0;
+        std::size_t size = 0;
+
+        bool push(const T& item) {
+            if (size == items.size())
+                return false;
+            items[(head + size++) % items.size()] = item;
+            return true;
+        }
+
+        bool pop(T& item) {
+            if (size == 0)
+                return false;
+            item = items[head];
+            head = (head + 1) % items.size();
+            --size;
+            return true;
+        }
+    };
+
+    void acceptConnections();
+    void closeConnection(std::uint32_t index);
+    void readConnection(std::uint32_t index);
+    void flushConnection(std::uint32_t index);
+    void handleLine(std::uint32_t index, char* line);
+    void drainCompletions();
+    void workerLoop();
+
+    std::uint32_t openSession(std::uint32_t connection, GameBase::Cell human);
+    void closeSession(std::uint32_t index);
+    Session* findSession(std::uint32_t connection, std::uint64_t id);
+    void submitJob(std::uint32_t index);
+    void reply(std::uint32_t connection, const char* format, ...);
+    void replyMove(std::uint32_t connection, std::uint32_t session, int aiMove);
+
+    static std::uint64_t sessionId(std::uint32_t index, std::uint32_t generation) {
+        return (static_cast<std::uint64_t>(generation) << 32) | index;
+    }
+
+    ServerConfig config_;
+    std::uint16_t port_ = 0;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;       // eventfd: готовые ответы компьютера и остановка
+    std::atomic<bool> stopping_{ false };
+
+    std::vector<Session> sessions_;
+    std::vector<std::uint32_t> freeSessions_;
+    std::vector<Connection> connections_;
+    std::vector<std::uint32_t> freeConnections_;
+    std::vector<std::uint32_t> dirtyConnections_;
+
+    std::mutex jobMutex_;
+    std::condition_variable jobReady_;
+    Ring<Job> jobs_;
+    bool workersStopping_ = false;
+
+    std::mutex completionMutex_;
+    Ring<Completion> completions_;
+
+    std::vector<std::thread> workers_;
+    ServerStats stats_;
+};
@@ -0,0 +1,354 @@
+/**
+ * @file Instrumentation.cpp
+ * @brief Реестр потоков, снимки измерений и выгрузка в JSON и Chrome trace.
+ */
+
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+namespace instrumentation {
+
+std::atomic<bool> activeFlag{ true };
+std::atomic<bool> tracingFlag{ false };
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point processStart = Clock::now();
+
+/**
+ * @brief Все выданные потокам данные. Не уничтожается: потоки могут завершаться после статических объектов.
+ */
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadState>> states;
+    std::vector<ThreadState*> free;         /**< Данные завершившихся потоков */
+    std::uint32_t nextThread = 0;
+    std::uint64_t resetNs = 0;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+/**
+ * @brief Возвращает данные в реестр при завершении потока.
+ */
+struct ThreadHolder {
+    ThreadState* state = nullptr;
+    ~ThreadHolder() {
+        if (!state)
+            return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.free.push_back(state);
+    }
+};
+
+int highestBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1)
+        ++bit;
+    return bit;
+#endif
+}
+
+std::string escape(const char* text) {
+    std::string escaped;
+    for (; *text; ++text) {
+        if (*text == '"' || *text == '\\')
+            escaped += '\\';
+        escaped += *text;
+    }
+    return escaped;
+}
+
+} // namespace
+
+const char* counterName(Counter counter) {
+    static const char* const NAMES[COUNTER_COUNT] = { "moves_applied", "winner_checks", "nodes_searched",
+                                                      "tt_hits", "cache_hits" };
+    return NAMES[counter];
+}
+
+const char* histogramName(Histogram histogram) {
+    static const char* const NAMES[HISTOGRAM_COUNT] = { "move_selection" };
+    return NAMES[histogram];
+}
+
+// ---------------------------------------------------------------- гистограмма
+
+int LatencyHistogram::bucketOf(std::uint64_t value) {
+    if (value < SUB_BUCKETS)
+        return static_cast<int>(value);
+    // Старшие SUB_BUCKET_BITS битов значения: степень двойки и положение внутри неё
+    const int bit = highestBit(value);
+    const int shift = bit - (SUB_BUCKET_BITS - 1);
+    return SUB_BUCKETS + (bit - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2) +
+           static_cast<int>((value >> shift) - SUB_BUCKETS / 2);
+}
+
+std::uint64_t LatencyHistogram::bucketLow(int bucket) {
+    if (bucket < SUB_BUCKETS)
+        return static_cast<std::uint64_t>(bucket);
+    const int bit = (bucket - SUB_BUCKETS) / (SUB_BUCKETS / 2) + SUB_BUCKET_BITS;
+    const std::uint64_t mantissa = (bucket - SUB_BUCKETS) % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+    return mantissa << (bit - (SUB_BUCKET_BITS - 1));
+}
+
+std::uint64_t LatencyHistogram::bucketHigh(int bucket) {
+    if (bucket < SUB_BUCKETS)
+        return static_cast<std::uint64_t>(bucket);
+    const int bit = (bucket - SUB_BUCKETS) / (SUB_BUCKETS / 2) + SUB_BUCKET_BITS;
+    return bucketLow(bucket) + ((std::uint64_t(1) << (bit - (SUB_BUCKET_BITS - 1))) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t value, std::uint64_t count) {
+    buckets_[bucketOf(value)] += count;
+    count_ += count;
+    sum_ += value * count;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKET_COUNT; ++i)
+        buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+void LatencyHistogram::addBucket(int bucket, std::uint64_t count) {
+    if (!count)
+        return;
+    buckets_[bucket] += count;
+    count_ += count;
+    sum_ += bucketLow(bucket) * count;
+    min_ = std::min(min_, bucketLow(bucket));
+    max_ = std::max(max_, bucketHigh(bucket));
+}
+
+void LatencyHistogram::setExact(std::uint64_t sum, std::uint64_t min, std::uint64_t max) {
+    sum_ = sum;
+    min_ = min;
+    max_ = max;
+}
+
+void LatencyHistogram::clear() {
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    sum_ = 0;
+    min_ = ~std::uint64_t(0);
+    max_ = 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double p) const {
+    if (!count_)
+        return 0;
+    const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(p * count_ + 0.999999));
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank)
+            return std::min(bucketHigh(i), max_);
+    }
+    return max_;
+}
+
+// ---------------------------------------------------------------- потоки
+
+ThreadState* registerThread() {
+    static thread_local ThreadHolder holder;
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!r.free.empty()) {
+        holder.state = r.free.back();
+        r.free.pop_back();
+    }
+    else {
+        r.states.push_back(std::make_unique<ThreadState>());
+        holder.state = r.states.back().get();
+    }
+    holder.state->thread = r.nextThread++;
+    return holder.state;
+}
+
+std::uint64_t nowNs() {
+    // Ноль означает "замер не начат" в ScopedLatency и ScopedSpan
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - processStart).count()) + 1;
+}
+
+void recordLatency(Histogram histogram, std::uint64_t ns) {
+    ThreadState::Latency& latency = threadState().latencies[histogram];
+    auto bump = [](std::atomic<std::uint64_t>& slot, std::uint64_t value) {
+        slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    };
+    bump(latency.buckets[LatencyHistogram::bucketOf(ns)], 1);
+    bump(latency.sum, ns);
+    if (ns < latency.min.load(std::memory_order_relaxed))
+        latency.min.store(ns, std::memory_order_relaxed);
+    if (ns > latency.max.load(std::memory_order_relaxed))
+        latency.max.store(ns, std::memory_order_relaxed);
+}
+
+void recordSpan(const char* name, std::uint64_t startNs, std::uint64_t endNs) {
+    ThreadState& state = threadState();
+    std::lock_guard<std::mutex> lock(state.eventsMutex);
+    if (state.events.size() < MAX_TRACE_EVENTS)
+        state.events.push_back({ name, startNs, endNs - startNs, state.thread });
+}
+
+Snapshot snapshot() {
+    Snapshot result;
+    std::array<std::uint64_t, HISTOGRAM_COUNT> sums{}, maxima{};
+    std::array<std::uint64_t, HISTOGRAM_COUNT> minima;
+    minima.fill(~std::uint64_t(0));
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& state : r.states) {
+        for (int c = 0; c < COUNTER_COUNT; ++c)
+            result.counters[c] += state->counters[c].load(std::memory_order_relaxed);
+        for (int h = 0; h < HISTOGRAM_COUNT; ++h) {
+            const ThreadState::Latency& latency = state->latencies[h];
+            for (int b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b)
+                result.histograms[h].addBucket(b, latency.buckets[b].load(std::memory_order_relaxed));
+            sums[h] += latency.sum.load(std::memory_order_relaxed);
+            minima[h] = std::min(minima[h], latency.min.load(std::memory_order_relaxed));
+            maxima[h] = std::max(maxima[h], latency.max.load(std::memory_order_relaxed));
+        }
+    }
+    for (int h = 0; h < HISTOGRAM_COUNT; ++h)
+        if (result.histograms[h].count())
+            result.histograms[h].setExact(sums[h], minima[h], maxima[h]);
+    result.threads = r.nextThread;
+    result.seconds = (nowNs() - r.resetNs) / 1e9;
+    return result;
+}
+
+void reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& state : r.states) {
+        for (auto& counter : state->counters)
+            counter.store(0, std::memory_order_relaxed);
+        for (auto& latency : state->latencies) {
+            for (auto& bucket : latency.buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            latency.sum.store(0, std::memory_order_relaxed);
+            latency.min.store(~std::uint64_t(0), std::memory_order_relaxed);
+            latency.max.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> eventsLock(state->eventsMutex);
+        state->events.clear();
+    }
+    r.resetNs = nowNs();
+}
+
+std::vector<TraceEvent> traceEvents() {
+    std::vector<TraceEvent> events;
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (const auto& state : r.states) {
+            std::lock_guard<std::mutex> eventsLock(state->eventsMutex);
+            events.insert(events.end(), state->events.begin(), state->events.end());
+        }
+    }
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent& a, const TraceEvent& b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+// ---------------------------------------------------------------- выгрузка
+
+std::string Snapshot::toJson() const {
+    std::string json;
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "{\n  \"enabled\": %s,\n  \"seconds\": %.6f,\n  \"threads\": %u,\n  \"counters\": {",
+                  ENABLED ? "true" : "false", seconds, threads);
+    json += buffer;
+    for (int c = 0; c < COUNTER_COUNT; ++c) {
+        std::snprintf(buffer, sizeof(buffer), "%s\"%s\": %llu", c ? ", " : "", counterName(static_cast<Counter>(c)),
+                      static_cast<unsigned long long>(counters[c]));
+        json += buffer;
+    }
+    json += "},\n  \"histograms\": {";
+    for (int h = 0; h < HISTOGRAM_COUNT; ++h) {
+        const LatencyHistogram& histogram = histograms[h];
+        std::snprintf(buffer, sizeof(buffer),
+                      "%s\n    \"%s\": {\"count\": %llu, \"min_ns\": %llu, \"mean_ns\": %.1f, \"p50_ns\": %llu, "
+                      "\"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu, \"buckets\": [",
+                      h ? "," : "", histogramName(static_cast<Histogram>(h)),
+                      static_cast<unsigned long long>(histogram.count()), static_cast<unsigned long long>(histogram.min()),
+                      histogram.mean(), static_cast<unsigned long long>(histogram.percentile(0.5)),
+                      static_cast<unsigned long long>(histogram.percentile(0.9)),
+                      static_cast<unsigned long long>(histogram.percentile(0.99)),
+                      static_cast<unsigned long long>(histogram.percentile(0.999)),
+                      static_cast<unsigned long long>(histogram.max()));
+        json += buffer;
+        // Только непустые корзины: [нижняя граница, верхняя граница, число значений]
+        bool first = true;
+        for (int b = 0; b < LatencyHistogram::BUCKET_COUNT; ++b) {
+            if (!histogram.bucket(b))
+                continue;
+            std::snprintf(buffer, sizeof(buffer), "%s[%llu, %llu, %llu]", first ? "" : ", ",
+                          static_cast<unsigned long long>(LatencyHistogram::bucketLow(b)),
+                          static_cast<unsigned long long>(LatencyHistogram::bucketHigh(b)),
+                          static_cast<unsigned long long>(histogram.bucket(b)));
+            json += buffer;
+            first = false;
+        }
+        json += "]}";
+    }
+    json += "\n  }\n}\n";
+    return json;
+}
+
+bool writeJson(const std::string& path, const Snapshot& snapshot) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    const std::string json = snapshot.toJson();
+    const bool ok = std::fwrite(json.data(), 1, json.size(), out) == json.size();
+    return std::fclose(out) == 0 && ok;
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::FILE* out = std::fopen(path.c_str(), "w");
+    if (!out)
+        return false;
+    const std::vector<TraceEvent> events = traceEvents();
+    std::fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    bool first = true;
+    for (const TraceEvent& event : events) {
+        // Формат Chrome: время в микросекундах, "X" — завершённый участок
+        std::fprintf(out, "%s\n  {\"name\": \"%s\", \"cat\": \"tictactoe\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                          "\"pid\": 1, \"tid\": %u}",
+                     first ? "" : ",", escape(event.name).c_str(), event.startNs / 1000.0, event.durationNs / 1000.0,
+                     event.thread);
+        first = false;
+    }
+    // Итоговые значения счётчиков — отдельным событием "C" в конце трассы
+    const Snapshot totals = snapshot();
+    std::fprintf(out, "%s\n  {\"name\": \"counters\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {",
+                 first ? "" : ",", nowNs() / 1000.0);
+    for (int c = 0; c < COUNTER_COUNT; ++c)
+        std::fprintf(out, "%s\"%s\": %llu", c ? ", " : "", counterName(static_cast<Counter>(c)),
+                     static_cast<unsigned long long>(totals.counters[c]));
+    std::fprintf(out, "}}\n]}\n");
+    return std::fclose(out) == 0;
+}
+
+} // namespace instrumentation
@@ -0,0 +1,318 @@
+/**
+ * @file Instrumentation.h
+ * @brief Счётчики, гистограммы задержек и трассировка работы движков.
+ *
+ * Точки измерения расставляются макросами TICTACTOE_COUNT,
+ * TICTACTOE_LATENCY_SCOPE и TICTACTOE_TRACE_SCOPE. Без опции сборки
+ * TICTACTOE_INSTRUMENTATION макросы пустые и в код не попадают; функции
+ * снимков и выгрузки остаются доступны и возвращают нули.
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace instrumentation {
+
+#ifdef TICTACTOE_INSTRUMENTATION
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+/**
+ * @brief Счётчики событий.
+ */
+enum Counter {
+    MovesApplied,       /**< Сделанные ходы */
+    WinnerChecks,       /**< Проверки победителя */
+    NodesSearched,      /**< Узлы поиска решателя и итерации MCTS */
+    TtHits,             /**< Найденные в таблице транспозиций позиции */
+    CacheHits,          /**< Позиции из кэша решённых позиций */
+    COUNTER_COUNT
+};
+
+/**
+ * @brief Гистограммы задержек.
+ */
+enum Histogram {
+    MoveSelection,      /**< Выбор хода решателем или MCTS */
+    HISTOGRAM_COUNT
+};
+
+/**
+ * @brief Имя счётчика для отчётов.
+ */
+const char* counterName(Counter counter);
+
+/**
+ * @brief Имя гистограммы для отчётов.
+ */
+const char* histogramName(Histogram histogram);
+
+/**
+ * @brief Гистограмма с логарифмически-линейными корзинами в духе HDR Histogram.
+ *
+ * Значения до 2^SUB_BUCKET_BITS хранятся точно, дальше каждая степень двойки
+ * делится на 2^(SUB_BUCKET_BITS - 1) равных корзин: относительная ошибка
+ * перцентилей не больше 1/16 при любом масштабе, а вся гистограмма занимает
+ * BUCKET_COUNT счётчиков.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2);
+
+    /**
+     * @brief Корзина значения.
+     */
+    static int bucketOf(std::uint64_t value);
+
+    /**
+     * @brief Наименьшее значение корзины.
+     */
+    static std::uint64_t bucketLow(int bucket);
+
+    /**
+     * @brief Наибольшее значение корзины.
+     */
+    static std::uint64_t bucketHigh(int bucket);
+
+    LatencyHistogram() : buckets_(BUCKET_COUNT, 0) {}
+
+    /**
+     * @brief Добавляет значение.
+     */
+    void record(std::uint64_t value, std::uint64_t count = 1);
+
+    /**
+     * @brief Прибавляет другую гистограмму.
+     */
+    void merge(const LatencyHistogram& other);
+
+    /**
+     * @brief Прибавляет значения корзины (сборка снимка); сумма и крайние значения оцениваются по границам.
+     */
+    void addBucket(int bucket, std::uint64_t count);
+
+    /**
+     * @brief Уточняет сумму и крайние значения после addBucket().
+     */
+    void setExact(std::uint64_t sum, std::uint64_t min, std::uint64_t max);
+
+    void clear();
+
+    std::uint64_t count() const { return count_; }
+    std::uint64_t min() const { return count_ ? min_ : 0; }
+    std::uint64_t max() const { return max_; }
+    double mean() const { return count_ ? static_cast<double>(sum_) / count_ : 0.0; }
+
+    /**
+     * @brief Перцентиль методом ближайшего ранга; значение — верхняя граница корзины, не больше max().
+     * @param p Доля от 0 до 1
+     */
+    std::uint64_t percentile(double p) const;
+
+    /**
+     * @brief Число значений в корзине.
+     */
+    std::uint64_t bucket(int index) const { return buckets_[index]; }
+
+private:
+    std::vector<std::uint64_t> buckets_;
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t min_ = ~std::uint64_t(0);
+    std::uint64_t max_ = 0;
+};
+
+/**
+ * @brief Завершённый участок трассы.
+ */
+struct TraceEvent {
+    const char* name;           /**< Строковый литерал из TICTACTOE_TRACE_SCOPE */
+    std::uint64_t startNs;      /**< Начало от запуска процесса */
+    std::uint64_t durationNs;   /**< Длительность */
+    std::uint32_t thread;       /**< Номер потока в порядке первого измерения */
+};
+
+/**
+ * @brief Сумма измерений всех потоков на момент снимка.
+ */
+struct Snapshot {
+    std::array<std::uint64_t, COUNTER_COUNT> counters{};
+    std::array<LatencyHistogram, HISTOGRAM_COUNT> histograms;
+    double seconds = 0.0;       /**< Время от запуска процесса или последнего reset() */
+    std::uint32_t threads = 0;  /**< Потоки, делавшие измерения */
+
+    /**
+     * @brief Снимок в формате JSON.
+     */
+    std::string toJson() const;
+};
+
+/**
+ * @brief Данные одного потока. Пишет только владелец, поэтому атомарные
+ *        значения обновляются без блокирующих операций, а снимок читает их
+ *        из другого потока без гонок.
+ */
+struct ThreadState {
+    std::array<std::atomic<std::uint64_t>, COUNTER_COUNT> counters{};
+    struct Latency {
+        std::array<std::atomic<std::uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets{};
+        std::atomic<std::uint64_t> sum{ 0 };
+        std::atomic<std::uint64_t> min{ ~std::uint64_t(0) };
+        std::atomic<std::uint64_t> max{ 0 };
+    };
+    std::array<Latency, HISTOGRAM_COUNT> latencies;
+    std::uint32_t thread = 0;
+    std::mutex eventsMutex;                 /**< Участки трассы читает снимок из другого потока */
+    std::vector<TraceEvent> events;
+};
+
+/**
+ * @brief Наибольшее число участков трассы одного потока; следующие отбрасываются.
+ */
+constexpr std::size_t MAX_TRACE_EVENTS = std::size_t(1) << 20;
+
+/**
+ * @brief Выдаёт потоку данные. Данные завершившегося потока достаются
+ *        следующему новому потоку и продолжают входить в снимки, поэтому
+ *        итоги не теряются, а память не растёт с числом созданных потоков.
+ */
+ThreadState* registerThread();
+
+/**
+ * @brief Данные текущего потока.
+ */
+inline ThreadState& threadState() {
+    thread_local ThreadState* state = registerThread();
+    return *state;
+}
+
+extern std::atomic<bool> activeFlag;
+extern std::atomic<bool> tracingFlag;
+
+/**
+ * @brief Включает и выключает сбор во время выполнения (по умолчанию включён).
+ */
+inline void setActive(bool active) { activeFlag.store(active, std::memory_order_relaxed); }
+inline bool active() { return activeFlag.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Включает запись участков трассы (по умолчанию выключена: трасса растёт с каждым участком).
+ */
+inline void setTracing(bool tracing) { tracingFlag.store(tracing, std::memory_order_relaxed); }
+inline bool tracing() { return tracingFlag.load(std::memory_order_relaxed); }
+
+/**
+ * @brief Время в наносекундах от запуска процесса.
+ */
+std::uint64_t nowNs();
+
+/**
+ * @brief Прибавляет к счётчику текущего потока.
+ */
+inline void add(Counter counter, std::uint64_t value = 1) {
+    if (!active())
+        return;
+    std::atomic<std::uint64_t>& slot = threadState().counters[counter];
+    slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Добавляет задержку в гистограмму текущего потока.
+ */
+void recordLatency(Histogram histogram, std::uint64_t ns);
+
+/**
+ * @brief Добавляет участок трассы текущего потока.
+ */
+void recordSpan(const char* name, std::uint64_t startNs, std::uint64_t endNs);
+
+/**
+ * @brief Суммирует измерения всех потоков.
+ */
+Snapshot snapshot();
+
+/**
+ * @brief Обнуляет счётчики, гистограммы и трассу всех потоков.
+ *
+ * Вызывать, когда измеряемые потоки не работают: значения, которые поток
+ * дописывает во время сброса, могут сохраниться.
+ */
+void reset();
+
+/**
+ * @brief Участки трассы всех потоков в порядке начала.
+ */
+std::vector<TraceEvent> traceEvents();
+
+/**
+ * @brief Записывает снимок в JSON-файл.
+ */
+bool writeJson(const std::string& path, const Snapshot& snapshot);
+
+/**
+ * @brief Записывает трассу в формате Chrome trace events (chrome://tracing, Perfetto).
+ */
+bool writeChromeTrace(const std::string& path);
+
+/**
+ * @brief Замер задержки области видимости.
+ */
+class ScopedLatency {
+public:
+    explicit ScopedLatency(Histogram histogram) : histogram_(histogram), start_(active() ? nowNs() : 0) {}
+    ~ScopedLatency() {
+        if (start_)
+            recordLatency(histogram_, nowNs() - start_);
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    Histogram histogram_;
+    std::uint64_t start_;
+};
+
+/**
+ * @brief Участок трассы на время области видимости.
+ */
+class ScopedSpan {
+public:
+    explicit ScopedSpan(const char* name) : name_(name), start_(tracing() && active() ? nowNs() : 0) {}
+    ~ScopedSpan() {
+        if (start_)
+            recordSpan(name_, start_, nowNs());
+    }
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    const char* name_;
+    std::uint64_t start_;
+};
+
+} // namespace instrumentation
+
+#define TICTACTOE_CONCAT_IMPL(a, b) a##b
+#define TICTACTOE_CONCAT(a, b) TICTACTOE_CONCAT_IMPL(a, b)
+
+#ifdef TICTACTOE_INSTRUMENTATION
+#define TICTACTOE_COUNT(counter) ::instrumentation::add(::instrumentation::counter)
+#define TICTACTOE_COUNT_N(counter, value) ::instrumentation::add(::instrumentation::counter, value)
+#define TICTACTOE_LATENCY_SCOPE(histogram) \
+    ::instrumentation::ScopedLatency TICTACTOE_CONCAT(tictactoeLatency, __LINE__)(::instrumentation::histogram)
+#define TICTACTOE_TRACE_SCOPE(name) ::instrumentation::ScopedSpan TICTACTOE_CONCAT(tictactoeSpan, __LINE__)(name)
+#else
+#define TICTACTOE_COUNT(counter) ((void)0)
+#define TICTACTOE_COUNT_N(counter, value) ((void)0)
+#define TICTACTOE_LATENCY_SCOPE(histogram) ((void)0)
+#define TICTACTOE_TRACE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,193 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Реализация отображения файла для POSIX и Win32.
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, std::string* error, Access access) {
+    close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | (access == Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN), nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        if (error)
+            *error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size)) {
+        close();
+        if (error)
+            *error = "cannot stat " + path;
+        return false;
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0)
+        return true;
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        close();
+        if (error)
+            *error = "cannot map " + path;
+        return false;
+    }
+    data_ = static_cast<const std::uint8_t*>(view);
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t size, std::string* error, Access access) {
+    close();
+    file_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL | (access == Random ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN), nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        if (error)
+            *error = "cannot create " + path;
+        return false;
+    }
+    writable_ = true;
+    size_ = size;
+    if (size_ == 0)
+        return true;
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(size);
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(length.HighPart),
+                                  length.LowPart, nullptr);
+    void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+    if (!view) {
+        close();
+        if (error)
+            *error = "cannot map " + path;
+        return false;
+    }
+    data_ = static_cast<const std::uint8_t*>(view);
+    return true;
+}
+
+bool MappedFile::flush(std::string* error) {
+    if (!writable_ || !data_)
+        return true;
+    if (!FlushViewOfFile(data_, 0) || !FlushFileBuffers(file_)) {
+        if (error)
+            *error = "cannot flush mapped file";
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_)
+        CloseHandle(file_);
+    data_ = nullptr;
+    mapping_ = nullptr;
+    file_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, std::string* error, Access access) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (error)
+            *error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) < 0) {
+        if (error)
+            *error = path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0) {
+        void* view = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            if (error)
+                *error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            size_ = 0;
+            return false;
+        }
+        // При последовательном чтении ядро читает с опережением, при точечном — только нужные страницы
+        ::madvise(view, size_, access == Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+        data_ = static_cast<const std::uint8_t*>(view);
+    }
+    ::close(fd);
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t size, std::string* error, Access access) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (error)
+            *error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    // Файл растёт без записи нулей: страницы выделяются при первом изменении
+    if (::ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        if (error)
+            *error = path + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    if (size > 0) {
+        void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            if (error)
+                *error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        ::madvise(view, size, access == Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+        data_ = static_cast<const std::uint8_t*>(view);
+    }
+    size_ = size;
+    writable_ = true;
+    ::close(fd);
+    return true;
+}
+
+bool MappedFile::flush(std::string* error) {
+    if (!writable_ || !data_)
+        return true;
+    if (::msync(const_cast<std::uint8_t*>(data_), size_, MS_SYNC) < 0) {
+        if (error)
+            *error = std::string("msync: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_)
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+    writable_ = false;
+}
+
+#endif
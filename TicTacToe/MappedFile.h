@@ -0,0 +1,88 @@
+/**
+ * @file MappedFile.h
+ * @brief Отображение файла в память для чтения и для записи (POSIX и Win32).
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Файл, отображённый в память целиком.
+ *
+ * Данные читаются напрямую из страничного кэша без копирования.
+ * Пустой файл открывается успешно и имеет size() == 0. Файл, созданный
+ * create(), отображается для записи: изменённые страницы ядро само
+ * записывает в файл, поэтому данные могут быть больше оперативной памяти.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Ожидаемый порядок чтения — подсказка ядру для упреждающего чтения.
+     */
+    enum Access {
+        Sequential,   /**< Проход от начала к концу */
+        Random        /**< Точечные обращения, например двоичный поиск */
+    };
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Отображает файл.
+     * @param path Путь к файлу
+     * @param error Описание ошибки, если открыть не удалось
+     * @param access Ожидаемый порядок чтения
+     * @return true при успехе
+     */
+    bool open(const std::string& path, std::string* error = nullptr, Access access = Sequential);
+
+    /**
+     * @brief Создаёт (или усекает) файл заданного размера, заполненный нулями, и отображает его для записи.
+     * @param path Путь к файлу
+     * @param size Размер файла в байтах
+     * @param error Описание ошибки, если создать не удалось
+     * @param access Ожидаемый порядок обращений
+     * @return true при успехе
+     */
+    bool create(const std::string& path, std::size_t size, std::string* error = nullptr, Access access = Sequential);
+
+    /**
+     * @brief Записывает изменённые страницы в файл и ждёт завершения записи.
+     * @return false, если запись не удалась
+     */
+    bool flush(std::string* error = nullptr);
+
+    /**
+     * @brief Снимает отображение.
+     */
+    void close();
+
+    /**
+     * @brief Начало данных (nullptr для пустого или закрытого файла).
+     */
+    const std::uint8_t* data() const { return data_; }
+
+    /**
+     * @brief Начало данных для записи (nullptr, если файл открыт только для чтения).
+     */
+    std::uint8_t* writableData() { return writable_ ? const_cast<std::uint8_t*>(data_) : nullptr; }
+
+    /**
+     * @brief Размер файла в байтах.
+     */
+    std::size_t size() const { return size_; }
+
+private:
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool writable_ = false;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
@@ -0,0 +1,485 @@
+/**
+ * @file Mcts.h
+ * @brief Параллельный поиск Монте-Карло по дереву (UCT) для больших полей.
+ */
+
+#pragma once
+#include "Game.h"
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Бюджет поиска. Нулевое значение означает отсутствие ограничения;
+ * если не задано ни одно ограничение, выполняется 10000 симуляций.
+ */
+struct MctsLimits {
+    double seconds = 0.0;          /**< Время поиска в секундах */
+    std::uint64_t playouts = 0;    /**< Число симуляций */
+    int threads = 1;               /**< Число потоков; 0 — по числу ядер */
+};
+
+/**
+ * @brief Результат поиска.
+ */
+struct MctsResult {
+    int move = -1;                              /**< Ход с наибольшим числом посещений */
+    double winRate = 0.0;                       /**< Доля очков хода (выигрыш — 1, ничья — 0.5) */
+    std::uint64_t playouts = 0;                 /**< Выполненные симуляции */
+    double seconds = 0.0;                       /**< Время поиска */
+    std::vector<std::uint64_t> threadPlayouts;  /**< Симуляции по потокам */
+    std::size_t nodesUsed = 0;                  /**< Занятые узлы пула */
+    bool reused = false;                        /**< Поиск продолжил дерево предыдущего хода */
+
+    /**
+     * @brief Симуляций в секунду.
+     */
+    double playoutsPerSecond() const { return seconds > 0.0 ? playouts / seconds : 0.0; }
+};
+
+/**
+ * @brief Поиск Монте-Карло по дереву с параллелизмом на уровне дерева.
+ *
+ * Потоки разделяют одно дерево: счётчики посещений и очков атомарны,
+ * а виртуальная потеря на время спуска уводит другие потоки в соседние
+ * ветви. Узлы берутся из заранее выделенного пула (арены) сдвигом
+ * атомарного указателя; дети узла лежат в пуле подряд. Пулов два:
+ * при переходе к следующей позиции сохраняемое поддерево копируется
+ * в свободный пул, а старый пул очищается сбросом указателя.
+ *
+ * @tparam GameT Вариант игры
+ */
+template <class GameT>
+class Mcts {
+public:
+    using Cell = GameBase::Cell;
+
+    /**
+     * @brief Конструктор.
+     * @param nodeCapacity Ёмкость каждого из двух пулов узлов
+     * @param exploration Коэффициент исследования UCT
+     */
+    explicit Mcts(std::size_t nodeCapacity = 1 << 20, double exploration = 1.4);
+
+    /**
+     * @brief Ищет лучший ход.
+     *
+     * Если позиция получается из корня предыдущего поиска одним или двумя
+     * ходами, которые уже есть в дереве, поиск продолжает это поддерево.
+     *
+     * @param game Позиция
+     * @param player Игрок, который ходит
+     * @param limits Бюджет времени или симуляций
+     * @return Лучший ход и статистика производительности
+     */
+    MctsResult search(const GameT& game, Cell player, const MctsLimits& limits = {});
+
+    /**
+     * @brief Переносит корень дерева в позицию после хода.
+     * @param move Сыгранный ход (индекс клетки)
+     * @return true, если поддерево хода сохранено; false — дерево начато заново
+     */
+    bool advance(int move);
+
+    /**
+     * @brief Очищает дерево.
+     */
+    void reset();
+
+private:
+    static constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr int VIRTUAL_LOSS = 3;
+
+    enum State : std::uint8_t { Leaf, Expanding, Expanded };
+
+    struct Node {
+        std::atomic<std::int32_t> visits{ 0 };
+        std::atomic<std::int64_t> score{ 0 };   // очки игрока, сделавшего ход в узел: 2 — выигрыш, 1 — ничья
+        std::atomic<std::uint8_t> state{ Leaf };
+        std::uint32_t firstChild = NONE;
+        std::uint16_t childCount = 0;
+        std::int16_t move = -1;
+    };
+
+    struct Arena {
+        std::unique_ptr<Node[]> nodes;
+        std::atomic<std::size_t> used{ 0 };
+        std::size_t capacity = 0;
+
+        std::uint32_t allocate(std::size_t count);
+    };
+
+    void newRoot(const GameT& game, Cell player);
+    bool matchesRoot(const GameT& game, Cell player, std::vector<int>& path) const;
+    void reroot(std::uint32_t node);
+    void playout(std::mt19937_64& rng, std::vector<std::uint32_t>& path, std::vector<int>& empties);
+    std::uint32_t select(const Node& node) const;
+    bool expand(Node& node, const GameT& game);
+
+    Arena arenas_[2];
+    int active_ = 0;
+    double exploration_;
+    std::optional<GameT> rootGame_;
+    Cell rootPlayer_ = GameBase::X;
+    bool hasRoot_ = false;
+    std::uint64_t searches_ = 0;
+};
+
+template <class GameT>
+std::uint32_t Mcts<GameT>::Arena::allocate(std::size_t count) {
+    const std::size_t first = used.fetch_add(count, std::memory_order_relaxed);
+    if (first + count > capacity) {
+        used.fetch_sub(count, std::memory_order_relaxed);
+        return NONE;
+    }
+    return static_cast<std::uint32_t>(first);
+}
+
+template <class GameT>
+Mcts<GameT>::Mcts(std::size_t nodeCapacity, double exploration)
+    : exploration_(exploration) {
+    for (auto& arena : arenas_) {
+        arena.capacity = nodeCapacity > 1 ? nodeCapacity : 2;
+        arena.nodes.reset(new Node[arena.capacity]);
+    }
+}
+
+template <class GameT>
+void Mcts<GameT>::reset() {
+    hasRoot_ = false;
+    arenas_[0].used = 0;
+    arenas_[1].used = 0;
+}
+
+/**
+ * @brief Начинает новое дерево: корень — узел 0 активного пула.
+ */
+template <class GameT>
+void Mcts<GameT>::newRoot(const GameT& game, Cell player) {
+    Arena& arena = arenas_[active_];
+    arena.used = 0;
+    Node& root = arena.nodes[arena.allocate(1)];
+    root.visits = 0;
+    root.score = 0;
+    root.state = Leaf;
+    root.firstChild = NONE;
+    root.childCount = 0;
+    root.move = -1;
+    rootGame_ = game;
+    rootPlayer_ = player;
+    hasRoot_ = true;
+}
+
+/**
+ * @brief Проверяет, получается ли позиция из корня ходами, записанными в path.
+ *
+ * Допускаются только добавленные фигуры, чередующиеся начиная с ходящего в корне.
+ */
+template <class GameT>
+bool Mcts<GameT>::matchesRoot(const GameT& game, Cell player, std::vector<int>& path) const {
+    if (!hasRoot_ || game.size() != rootGame_->size())
+        return false;
+    const int size = game.size();
+    int ours = -1, theirs = -1, oursCount = 0, theirsCount = 0;
+    for (int cell = 0; cell < size * size; ++cell) {
+        const Cell before = rootGame_->getCell(cell / size, cell % size);
+        const Cell after = game.getCell(cell / size, cell % size);
+        if (before == after)
+            continue;
+        if (before != GameBase::Empty)
+            return false;
+        if (after == rootPlayer_) {
+            ours = cell;
+            ++oursCount;
+        }
+        else {
+            theirs = cell;
+            ++theirsCount;
+        }
+    }
+    path.clear();
+    if (oursCount == 0 && theirsCount == 0)
+        return player == rootPlayer_;
+    if (oursCount != 1 || theirsCount > 1)
+        return false;
+    path.push_back(ours);
+    if (theirsCount == 1)
+        path.push_back(theirs);
+    return player == (theirsCount == 0 ? GameBase::opponent(rootPlayer_) : rootPlayer_);
+}
+
+/**
+ * @brief Копирует поддерево узла в свободный пул и делает его корнем.
+ *
+ * Если свободный пул переполняется, у последних скопированных узлов
+ * отбрасываются дети — они будут раскрыты заново.
+ */
+template <class GameT>
+void Mcts<GameT>::reroot(std::uint32_t node) {
+    Arena& from = arenas_[active_];
+    Arena& to = arenas_[1 - active_];
+    to.used = 0;
+
+    auto copy = [&](const Node& src, Node& dst) {
+        dst.visits = src.visits.load(std::memory_order_relaxed);
+        dst.score = src.score.load(std::memory_order_relaxed);
+        dst.state = Leaf;
+        dst.firstChild = NONE;
+        dst.childCount = 0;
+        dst.move = src.move;
+    };
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> queue;   // (старый индекс, новый индекс)
+    const std::uint32_t root = to.allocate(1);
+    copy(from.nodes[node], to.nodes[root]);
+    queue.emplace_back(node, root);
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const Node& src = from.nodes[queue[head].first];
+        Node& dst = to.nodes[queue[head].second];
+        if (src.state.load(std::memory_order_acquire) != Expanded)
+            continue;
+        const std::uint32_t block = to.allocate(src.childCount);
+        if (block == NONE)
+            continue;
+        for (std::uint16_t i = 0; i < src.childCount; ++i) {
+            copy(from.nodes[src.firstChild + i], to.nodes[block + i]);
+            queue.emplace_back(src.firstChild + i, block + i);
+        }
+        dst.firstChild = block;
+        dst.childCount = src.childCount;
+        dst.state.store(Expanded, std::memory_order_release);
+    }
+    from.used = 0;
+    active_ = 1 - active_;
+}
+
+template <class GameT>
+bool Mcts<GameT>::advance(int move) {
+    if (!hasRoot_)
+        return false;
+    const int size = rootGame_->size();
+    GameT next = *rootGame_;
+    if (!next.makeMove(move / size, move % size, rootPlayer_)) {
+        reset();
+        return false;
+    }
+
+    const Node& root = arenas_[active_].nodes[0];
+    std::uint32_t child = NONE;
+    if (root.state.load(std::memory_order_acquire) == Expanded)
+        for (std::uint16_t i = 0; i < root.childCount && child == NONE; ++i)
+            if (arenas_[active_].nodes[root.firstChild + i].move == move)
+                child = root.firstChild + i;
+
+    const Cell player = GameBase::opponent(rootPlayer_);
+    if (child == NONE) {
+        newRoot(next, player);
+        return false;
+    }
+    reroot(child);
+    rootGame_ = next;
+    rootPlayer_ = player;
+    return true;
+}
+
+/**
+ * @brief Раскрывает узел: создаёт детей для всех допустимых ходов.
+ * @return false, если узел раскрывает другой поток или пул переполнен
+ */
+template <class GameT>
+bool Mcts<GameT>::expand(Node& node, const GameT& game) {
+    std::uint8_t expected = Leaf;
+    if (!node.state.compare_exchange_strong(expected, Expanding, std::memory_order_acq_rel))
+        return false;
+
+    const int size = game.size();
+    int count = 0;
+    for (int cell = 0; cell < size * size; ++cell)
+        if (isLegalMove(game, cell))
+            ++count;
+
+    Arena& arena = arenas_[active_];
+    const std::uint32_t block = arena.allocate(count);
+    if (block == NONE) {
+        node.state.store(Leaf, std::memory_order_release);
+        return false;
+    }
+    std::uint32_t next = block;
+    for (int cell = 0; cell < size * size; ++cell) {
+        if (!isLegalMove(game, cell))
+            continue;
+        Node& child = arena.nodes[next++];
+        child.visits.store(0, std::memory_order_relaxed);
+        child.score.store(0, std::memory_order_relaxed);
+        child.state.store(Leaf, std::memory_order_relaxed);
+        child.firstChild = NONE;
+        child.childCount = 0;
+        child.move = static_cast<std::int16_t>(cell);
+    }
+    node.firstChild = block;
+    node.childCount = static_cast<std::uint16_t>(count);
+    node.state.store(Expanded, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Выбирает ребёнка по формуле UCT; непосещённые дети выбираются первыми.
+ */
+template <class GameT>
+std::uint32_t Mcts<GameT>::select(const Node& node) const {
+    const Arena& arena = arenas_[active_];
+    const double logParent = std::log(static_cast<double>(node.visits.load(std::memory_order_relaxed)) + 1.0);
+    std::uint32_t best = NONE;
+    double bestScore = -1.0;
+    for (std::uint16_t i = 0; i < node.childCount; ++i) {
+        const Node& child = arena.nodes[node.firstChild + i];
+        const std::int32_t visits = child.visits.load(std::memory_order_relaxed);
+        if (visits == 0)
+            return node.firstChild + i;
+        const double mean = child.score.load(std::memory_order_relaxed) / (2.0 * visits);
+        const double uct = mean + exploration_ * std::sqrt(logParent / visits);
+        if (uct > bestScore) {
+            bestScore = uct;
+            best = node.firstChild + i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Одна симуляция: спуск с виртуальной потерей, раскрытие, случайная доигровка и обратное распространение.
+ */
+template <class GameT>
+void Mcts<GameT>::playout(std::mt19937_64& rng, std::vector<std::uint32_t>& path, std::vector<int>& empties) {
+    Arena& arena = arenas_[active_];
+    const int size = rootGame_->size();
+    GameT game = *rootGame_;
+    Cell player = rootPlayer_;
+
+    path.clear();
+    path.push_back(0);
+    arena.nodes[0].visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+
+    Cell winner = game.checkWinner();
+    bool finished = winner != GameBase::Empty || game.isDraw();
+    while (!finished) {
+        Node& node = arena.nodes[path.back()];
+        if (node.state.load(std::memory_order_acquire) != Expanded) {
+            if (node.visits.load(std::memory_order_relaxed) <= VIRTUAL_LOSS || !expand(node, game))
+                break;
+        }
+        const std::uint32_t child = select(node);
+        if (child == NONE)
+            break;
+        Node& next = arena.nodes[child];
+        next.visits.fetch_add(VIRTUAL_LOSS, std::memory_order_relaxed);
+        path.push_back(child);
+        game.makeMove(next.move / size, next.move % size, player);
+        player = GameBase::opponent(player);
+        winner = game.checkWinner();
+        finished = winner != GameBase::Empty || game.isDraw();
+    }
+
+    // Случайная доигровка: свободные клетки выбираются без повторов, игра со своими правилами доигрывает сама
+    if constexpr (HasMoveGenerator<GameT>::value) {
+        if (!finished)
+            winner = game.playRandom(player, rng);
+    }
+    else if (!finished) {
+        empties.clear();
+        for (int cell = 0; cell < size * size; ++cell)
+            if (game.getCell(cell / size, cell % size) == GameBase::Empty)
+                empties.push_back(cell);
+        while (winner == GameBase::Empty && !empties.empty()) {
+            const std::size_t pick = std::uniform_int_distribution<std::size_t>(0, empties.size() - 1)(rng);
+            const int cell = empties[pick];
+            empties[pick] = empties.back();
+            empties.pop_back();
+            game.makeMove(cell / size, cell % size, player);
+            player = GameBase::opponent(player);
+            winner = game.checkWinner();
+        }
+    }
+
+    // Очки узла считаются для игрока, сделавшего ход в этот узел
+    Cell mover = GameBase::opponent(rootPlayer_);
+    for (std::uint32_t index : path) {
+        Node& node = arena.nodes[index];
+        node.visits.fetch_add(1 - VIRTUAL_LOSS, std::memory_order_relaxed);
+        const int points = winner == GameBase::Empty ? 1 : (winner == mover ? 2 : 0);
+        node.score.fetch_add(points, std::memory_order_relaxed);
+        mover = GameBase::opponent(mover);
+    }
+}
+
+template <class GameT>
+MctsResult Mcts<GameT>::search(const GameT& game, Cell player, const MctsLimits& limits) {
+    TICTACTOE_LATENCY_SCOPE(MoveSelection);
+    TICTACTOE_TRACE_SCOPE("Mcts::search");
+    MctsResult result;
+    std::vector<int> path;
+    if (matchesRoot(game, player, path)) {
+        result.reused = true;
+        for (int move : path)
+            result.reused = advance(move) && result.reused;
+    }
+    else {
+        newRoot(game, player);
+    }
+
+    ++searches_;
+    const TaskScheduler scheduler(limits.threads);
+    const int threads = scheduler.threadCount();
+    const std::uint64_t budget = (limits.playouts == 0 && limits.seconds <= 0.0) ? 10000 : limits.playouts;
+    const auto started = std::chrono::steady_clock::now();
+    const auto deadline = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(limits.seconds));
+
+    std::atomic<std::uint64_t> done{ 0 };
+    result.threadPlayouts.assign(threads, 0);
+    scheduler.parallelFor(threads, [&](int task, int) {
+        TICTACTOE_TRACE_SCOPE("Mcts::worker");
+        std::uint64_t seed = (searches_ << 16) + task;
+        std::mt19937_64 rng(detail::splitmix64(seed));
+        std::vector<std::uint32_t> nodes;
+        std::vector<int> empties;
+        std::uint64_t count = 0;
+        for (;;) {
+            if (budget && done.fetch_add(1, std::memory_order_relaxed) >= budget)
+                break;
+            if (limits.seconds > 0.0 && (count & 15) == 0 && std::chrono::steady_clock::now() >= deadline)
+                break;
+            playout(rng, nodes, empties);
+            ++count;
+        }
+        result.threadPlayouts[task] = count;
+        TICTACTOE_COUNT_N(NodesSearched, count);
+    });
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (std::uint64_t count : result.threadPlayouts)
+        result.playouts += count;
+
+    const Arena& arena = arenas_[active_];
+    const Node& root = arena.nodes[0];
+    result.nodesUsed = arena.used.load();
+    if (root.state.load(std::memory_order_acquire) == Expanded) {
+        std::int32_t bestVisits = -1;
+        for (std::uint16_t i = 0; i < root.childCount; ++i) {
+            const Node& child = arena.nodes[root.firstChild + i];
+            const std::int32_t visits = child.visits.load();
+            if (visits > bestVisits) {
+                bestVisits = visits;
+                result.move = child.move;
+                result.winRate = visits ? child.score.load() / (2.0 * visits) : 0.0;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,286 @@
+/**
+ * @file PositionAnalyzer.cpp
+ * @brief Разбор позиций и конвейер анализа потока с ограниченной очередью блоков.
+ */
+
+#include "PositionAnalyzer.h"
+#include "Tablebase.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+bool isTablebaseVariant(const AnalysisConfig& config) {
+    return config.size == Game::BOARD_SIZE && config.winLength == Game::WIN_LENGTH;
+}
+
+/**
+ * @brief Блок входа и результаты его строк; слот кольца конвейера.
+ */
+struct Block {
+    std::string input;
+    std::string output;
+    std::uint64_t positions = 0;
+    std::uint64_t errors = 0;
+    std::uint64_t inexact = 0;
+    bool ready = false;     /**< Рабочий поток закончил блок */
+};
+
+/**
+ * @brief Разбирает, оценивает и форматирует все строки блока.
+ */
+void processBlock(PositionAnalyzer& analyzer, Block& block) {
+    block.output.clear();
+    block.positions = block.errors = block.inexact = 0;
+    const char* data = block.input.data();
+    const char* end = data + block.input.size();
+    while (data < end) {
+        const char* lineEnd = std::find(data, end, '\n');
+        const char* first = data;
+        const char* last = lineEnd;
+        data = lineEnd + (lineEnd < end);
+        while (first < last && (*first == ' ' || *first == '\t'))
+            ++first;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+            --last;
+        if (first == last || *first == '#')
+            continue;
+
+        const PositionAnalysis analysis = analyzer.analyze(first, static_cast<std::size_t>(last - first));
+        PositionAnalyzer::format(first, static_cast<std::size_t>(last - first), analysis, block.output);
+        if (analysis.error) {
+            ++block.errors;
+            continue;
+        }
+        ++block.positions;
+        block.inexact += !analysis.result.exact;
+    }
+}
+
+/**
+ * @brief Читает в блок следующие blockBytes байт и хвост до конца строки.
+ *
+ * Неполная последняя строка переносится в carry и начинает следующий блок.
+ * @return false, если вход закончился и блок пуст
+ */
+bool readBlock(std::istream& in, std::size_t blockBytes, std::string& carry, std::string& block) {
+    block.swap(carry);
+    carry.clear();
+    for (std::size_t want = blockBytes; in;) {
+        const std::size_t start = block.size();
+        block.resize(start + want);
+        in.read(&block[start], static_cast<std::streamsize>(want));
+        block.resize(start + static_cast<std::size_t>(in.gcount()));
+        // Строка длиннее блока дочитывается целиком
+        const std::size_t newline = block.rfind('\n');
+        if (newline != std::string::npos && newline >= start) {
+            carry.assign(block, newline + 1, std::string::npos);
+            block.resize(newline + 1);
+            break;
+        }
+        want = blockBytes;
+    }
+    return !block.empty();
+}
+
+} // namespace
+
+PositionAnalyzer::PositionAnalyzer(const AnalysisConfig& config, TranspositionTable& table)
+    : config_(config), solver_(table), game_(config.size, config.winLength) {
+    limits_.maxNodes = config.maxNodes;
+    solver_.setCache(config.cache);
+}
+
+PositionAnalysis PositionAnalyzer::analyze(const char* text, std::size_t length) {
+    PositionAnalysis analysis;
+    const int size = config_.size;
+    const int cellCount = size * size;
+    if (length != static_cast<std::size_t>(cellCount)) {
+        analysis.error = "wrong number of cells";
+        return analysis;
+    }
+    cells_.resize(cellCount);
+    int xs = 0, os = 0;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        switch (text[cell]) {
+        case 'X': case 'x': cells_[cell] = GameBase::X; ++xs; break;
+        case 'O': case 'o': cells_[cell] = GameBase::O; ++os; break;
+        case '.': case '-': cells_[cell] = GameBase::Empty; break;
+        default:
+            analysis.error = "unexpected character";
+            return analysis;
+        }
+    }
+    if (xs != os && xs != os + 1) {
+        analysis.error = "piece counts do not alternate";
+        return analysis;
+    }
+    analysis.player = xs == os ? GameBase::X : GameBase::O;
+    if (isTablebaseVariant(config_))
+        return analyzeTablebase(cells_.data(), analysis.player);
+
+    bool xLine = false, oLine = false;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (cells_[cell] == GameBase::Empty || (cells_[cell] == GameBase::X ? xLine : oLine))
+            continue;
+        if (detail::completesLine(cells_.data(), size, config_.winLength, cell / size, cell % size))
+            (cells_[cell] == GameBase::X ? xLine : oLine) = true;
+    }
+    // Линию должен был собрать последний ход: X — при лишнем крестике, O — при равенстве
+    if ((xLine && oLine) || (xLine && analysis.player == GameBase::X) || (oLine && analysis.player == GameBase::O)) {
+        analysis.error = "unreachable position";
+        return analysis;
+    }
+    if (xLine || oLine || xs + os == cellCount) {
+        analysis.result.value = xLine || oLine ? -1 : 0;
+        analysis.result.distance = 0;
+        analysis.result.exact = true;
+        return analysis;
+    }
+
+    // Фигуры ставятся поочерёдно, чтобы история и хеш соответствовали обычной партии
+    game_.reset();
+    int xCell = 0, oCell = 0;
+    for (GameBase::Cell player = GameBase::X;; player = GameBase::opponent(player)) {
+        int& next = player == GameBase::X ? xCell : oCell;
+        while (next < cellCount && cells_[next] != player)
+            ++next;
+        if (next == cellCount)
+            break;
+        game_.makeMove(next / size, next % size, player);
+        ++next;
+    }
+    analysis.result = solver_.solve(game_, analysis.player, limits_);
+    return analysis;
+}
+
+PositionAnalysis PositionAnalyzer::analyzeTablebase(const std::uint8_t* cells, GameBase::Cell player) const {
+    PositionAnalysis analysis;
+    analysis.player = player;
+    int index = 0;
+    for (int cell = Game::CELL_COUNT - 1; cell >= 0; --cell)
+        index = index * 3 + cells[cell];
+    const Tablebase::Entry entry = Tablebase::lookup(index);
+    if (!entry.reachable) {
+        analysis.error = "unreachable position";
+        return analysis;
+    }
+    analysis.result.move = entry.move;
+    analysis.result.value = entry.value;
+    analysis.result.distance = entry.distance;
+    analysis.result.exact = true;
+    return analysis;
+}
+
+void PositionAnalyzer::format(const char* text, std::size_t length, const PositionAnalysis& analysis,
+                              std::string& out) {
+    out.append(text, length);
+    if (analysis.error) {
+        out.append(" ERR ");
+        out.append(analysis.error);
+        out.push_back('\n');
+        return;
+    }
+    char buffer[64];
+    const SolverResult& result = analysis.result;
+    const char side = analysis.player == GameBase::X ? 'X' : 'O';
+    const int written = result.exact
+        ? std::snprintf(buffer, sizeof(buffer), " %c %d %d %d\n", side, result.move, result.value, result.distance)
+        : std::snprintf(buffer, sizeof(buffer), " %c %d ? ?\n", side, result.move);
+    out.append(buffer, static_cast<std::size_t>(written));
+}
+
+bool analyzeStream(std::istream& in, std::ostream& out, const AnalysisConfig& config, AnalysisStats* stats) {
+    const auto started = std::chrono::steady_clock::now();
+    const int threads = config.threads > 0 ? config.threads
+                                           : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const std::uint64_t depth = static_cast<std::uint64_t>(config.queueDepth > 0 ? config.queueDepth : 4 * threads);
+    const std::size_t blockBytes = std::max<std::size_t>(config.blockBytes, 1);
+    TranspositionTable table(isTablebaseVariant(config) ? 1 : config.ttMegabytes);
+    std::vector<Block> ring(depth);
+
+    // Номера блоков: read — прочитано, taken — взято потоками, written — выведено
+    std::mutex mutex;
+    std::condition_variable workAvailable, blockDone;
+    std::uint64_t read = 0, taken = 0, written = 0;
+    bool endOfInput = false;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+            PositionAnalyzer analyzer(config, table);
+            for (;;) {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&] { return taken < read || endOfInput; });
+                if (taken == read)
+                    return;
+                Block& block = ring[taken++ % depth];
+                lock.unlock();
+                processBlock(analyzer, block);
+                lock.lock();
+                block.ready = true;
+                lock.unlock();
+                blockDone.notify_all();
+            }
+        });
+    }
+
+    AnalysisStats totals;
+    bool ok = true;
+    // Выводит готовые блоки по порядку; вызывается под замком, вывод идёт без него
+    auto flush = [&](std::unique_lock<std::mutex>& lock) {
+        while (written < read && ring[written % depth].ready) {
+            Block& block = ring[written % depth];
+            lock.unlock();
+            out.write(block.output.data(), static_cast<std::streamsize>(block.output.size()));
+            ok = ok && static_cast<bool>(out);
+            totals.positions += block.positions;
+            totals.errors += block.errors;
+            totals.inexact += block.inexact;
+            lock.lock();
+            block.ready = false;
+            ++written;
+        }
+    };
+
+    std::string carry;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (flush(lock); ok && read - written == depth; flush(lock))
+            blockDone.wait(lock, [&] { return ring[written % depth].ready; });
+        lock.unlock();
+        // Слот свободен: его прошлый блок выведен, а новый ещё не виден рабочим потокам
+        if (!ok || !readBlock(in, blockBytes, carry, ring[read % depth].input))
+            break;
+        lock.lock();
+        ++read;
+        lock.unlock();
+        workAvailable.notify_one();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        endOfInput = true;
+        workAvailable.notify_all();
+        for (flush(lock); written < read; flush(lock))
+            blockDone.wait(lock, [&] { return ring[written % depth].ready; });
+    }
+    for (auto& worker : workers)
+        worker.join();
+    out.flush();
+    ok = ok && static_cast<bool>(out);
+
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (stats)
+        *stats = totals;
+    return ok;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file PositionAnalyzer.h
+ * @brief Потоковый анализ позиций из текста: лучший ход, оценка и расстояние до конца партии.
+ */
+
+#pragma once
+#include "Game.h"
+#include "PositionCache.h"
+#include "Solver.h"
+#include "TranspositionTable.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Параметры анализа.
+ */
+struct AnalysisConfig {
+    int size = 3;                       /**< Размер стороны поля */
+    int winLength = 3;                  /**< Длина выигрышной линии */
+    int threads = 0;                    /**< Потоки анализа; 0 — по числу аппаратных ядер */
+    std::size_t blockBytes = 64 * 1024; /**< Размер блока входа, который получает один поток */
+    int queueDepth = 0;                 /**< Блоков в работе одновременно; 0 — четыре на поток */
+    std::size_t ttMegabytes = 64;       /**< Общая таблица транспозиций (не используется для 3x3) */
+    std::uint64_t maxNodes = 0;         /**< Предел узлов на позицию; 0 — без предела */
+    const PositionCache* cache = nullptr;   /**< Кэш решённых позиций либо nullptr */
+};
+
+/**
+ * @brief Итоги анализа потока.
+ */
+struct AnalysisStats {
+    std::uint64_t positions = 0;    /**< Проанализированные позиции */
+    std::uint64_t errors = 0;       /**< Строки, которые не удалось разобрать */
+    std::uint64_t inexact = 0;      /**< Позиции, не решённые до конца из-за maxNodes */
+    double seconds = 0.0;
+
+    double positionsPerSecond() const { return seconds > 0.0 ? positions / seconds : 0.0; }
+};
+
+/**
+ * @brief Результат анализа одной позиции.
+ */
+struct PositionAnalysis {
+    const char* error = nullptr;            /**< Причина, если позиция не разобрана; иначе nullptr */
+    GameBase::Cell player = GameBase::X;    /**< Ходящий игрок */
+    SolverResult result;                    /**< Ход, оценка для ходящего и расстояние */
+};
+
+/**
+ * @brief Анализ позиций, заданных строкой клеток, без интерфейса.
+ *
+ * Позиция записывается строкой из size * size символов по строкам поля:
+ * "X"/"x" — крестик, "O"/"o" — нолик, "." или "-" — пустая клетка,
+ * например "X.O.X....". Ходящий определяется по числу фигур (X ходит
+ * первым). Позиция отвергается, если числа фигур не соответствуют
+ * очерёдности, линии есть у обоих игроков или линию собрал не тот, кто
+ * ходил последним; для 3x3 недостижимые позиции отвергаются точно.
+ *
+ * Поле 3x3 оценивается таблицей Tablebase, остальные — решателем Solver
+ * с общей для всех анализаторов таблицей транспозиций. Экземпляр
+ * используется одним потоком.
+ */
+class PositionAnalyzer {
+public:
+    /**
+     * @brief Конструктор.
+     * @param config Параметры (размер поля, предел узлов, кэш)
+     * @param table Таблица транспозиций, общая для анализаторов разных потоков
+     */
+    PositionAnalyzer(const AnalysisConfig& config, TranspositionTable& table);
+
+    /**
+     * @brief Разбирает и оценивает позицию.
+     * @param text Строка клеток без перевода строки
+     * @param length Длина строки
+     */
+    PositionAnalysis analyze(const char* text, std::size_t length);
+
+    /**
+     * @brief Дописывает к out строку результата: "<позиция> <ходящий> <ход> <оценка> <расстояние>"
+     *        либо "<позиция> ERR <причина>". Если позиция не решена до конца, оценка и расстояние — "?".
+     */
+    static void format(const char* text, std::size_t length, const PositionAnalysis& analysis, std::string& out);
+
+private:
+    PositionAnalysis analyzeTablebase(const std::uint8_t* cells, GameBase::Cell player) const;
+
+    AnalysisConfig config_;
+    SolverLimits limits_;
+    Solver<DynamicGame> solver_;
+    DynamicGame game_;
+    std::vector<std::uint8_t> cells_;   /**< Клетки разбираемой строки */
+};
+
+/**
+ * @brief Анализирует позиции из потока, по одной на строку, и пишет результаты в том же порядке.
+ *
+ * Вход читается блоками по blockBytes, разрезанными по границам строк;
+ * блоки разбирают, оценивают и форматируют рабочие потоки, а вызывающий
+ * поток читает следующие блоки и выводит готовые по порядку. Блоки живут
+ * в кольце из queueDepth слотов: чтение ждёт, пока освободится слот
+ * самого старого невыведенного блока, поэтому память не зависит от
+ * размера входа, а буферы слотов переиспользуются. Пустые строки и
+ * строки, начинающиеся с '#', пропускаются.
+ *
+ * @param in Входной поток
+ * @param out Выходной поток
+ * @param config Параметры анализа
+ * @param stats Итоги, если не nullptr
+ * @return false, если выход не удалось записать
+ */
+bool analyzeStream(std::istream& in, std::ostream& out, const AnalysisConfig& config, AnalysisStats* stats = nullptr);
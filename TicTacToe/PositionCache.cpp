@@ -0,0 +1,229 @@
+/**
+ * @file PositionCache.cpp
+ * @brief Чтение, запись и построение файла решённых позиций.
+ */
+
+#include "PositionCache.h"
+#include "Solver.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+std::uint64_t positioncache::rulesFingerprint(int size, int winLength) {
+    std::uint64_t state = VERSION;
+    std::uint64_t fingerprint = detail::splitmix64(state);
+    fingerprint ^= static_cast<std::uint64_t>(size) << 32 | static_cast<std::uint32_t>(winLength);
+    // Ключи Зобриста входят в ключи записей: другая схема ключей делает файл бесполезным
+    state = detail::ZOBRIST_SEED;
+    for (int i = 0; i < 2 * size * size; ++i)
+        fingerprint = (fingerprint ^ detail::splitmix64(state)) * 0x100000001B3ull;
+    return fingerprint;
+}
+
+bool PositionCache::open(const std::string& path, int size, int winLength, std::string* error) {
+    close();
+    if (!file_.open(path, error, MappedFile::Random))
+        return false;
+
+    auto fail = [&](const std::string& reason) {
+        if (error)
+            *error = path + ": " + reason;
+        close();
+        return false;
+    };
+    positioncache::FileHeader header;
+    if (file_.size() < sizeof(header))
+        return fail("not a position cache");
+    std::memcpy(&header, file_.data(), sizeof(header));
+    if (std::memcmp(header.magic, positioncache::MAGIC, sizeof(header.magic)) != 0 ||
+        header.entryBytes != sizeof(Entry))
+        return fail("not a position cache");
+    if (header.version != positioncache::VERSION)
+        return fail("unsupported cache version " + std::to_string(header.version));
+    if (header.boardSize != size || header.winLength != winLength ||
+        header.rules != positioncache::rulesFingerprint(size, winLength))
+        return fail("cache was built for " + std::to_string(header.boardSize) + "x" + std::to_string(header.boardSize) +
+                    " k=" + std::to_string(header.winLength) + " or other rules");
+    if ((file_.size() - sizeof(header)) / sizeof(Entry) < header.entryCount)
+        return fail("truncated cache");
+
+    // Заголовок занимает 64 байта, поэтому записи выровнены и читаются прямо из отображения
+    entries_ = reinterpret_cast<const Entry*>(file_.data() + sizeof(header));
+    count_ = header.entryCount;
+    size_ = size;
+    winLength_ = winLength;
+    maxMoves_ = header.maxMoves;
+    return true;
+}
+
+void PositionCache::close() {
+    file_.close();
+    entries_ = nullptr;
+    count_ = 0;
+    size_ = 0;
+    winLength_ = 0;
+    maxMoves_ = -1;
+}
+
+const PositionCache::Entry* PositionCache::find(std::uint64_t key) const {
+    const Entry* end = entries_ + count_;
+    const Entry* it = std::lower_bound(entries_, end, key, [](const Entry& entry, std::uint64_t k) {
+        return entry.key < k;
+    });
+    return it != end && it->key == key ? it : nullptr;
+}
+
+bool PositionCache::write(const std::string& path, int size, int winLength, int maxMoves,
+                          std::vector<Entry> entries, std::string* error) {
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const Entry& a, const Entry& b) { return a.key == b.key; }),
+                  entries.end());
+
+    positioncache::FileHeader header{};
+    std::memcpy(header.magic, positioncache::MAGIC, sizeof(header.magic));
+    header.version = positioncache::VERSION;
+    header.entryBytes = sizeof(Entry);
+    header.boardSize = size;
+    header.winLength = winLength;
+    header.rules = positioncache::rulesFingerprint(size, winLength);
+    header.entryCount = entries.size();
+    header.maxMoves = maxMoves;
+
+    // Пишем во временный файл и переименовываем: работающий движок держит старый кэш
+    // отображённым, и усечение файла на месте уронило бы его; прерванная запись кэш не портит
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    bool ok = file && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+    if (file)
+        ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());      // rename на Win32 не заменяет существующий файл
+#endif
+        ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(temporary.c_str());
+        if (error)
+            *error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+/**
+ * @brief Позиция для решения: ходы от пустого поля.
+ */
+struct PendingPosition {
+    std::vector<std::int16_t> moves;
+};
+
+/**
+ * @brief Собирает различные с точностью до симметрии позиции не глубже plies ходов.
+ */
+void collectPositions(DynamicGame& game, GameBase::Cell player, int plies, std::vector<std::int16_t>& moves,
+                      std::unordered_set<std::uint64_t>& seen, std::vector<PendingPosition>& positions) {
+    const int cells = game.size() * game.size();
+    if (game.checkWinner() != GameBase::Empty || game.moveCount() == cells)
+        return;
+    if (!seen.insert(PositionCache::keyOf(game, player, nullptr)).second)
+        return;
+    positions.push_back(PendingPosition{ moves });
+    if (static_cast<int>(moves.size()) == plies)
+        return;
+    for (int cell = 0; cell < cells; ++cell) {
+        if (!game.makeMove(cell / game.size(), cell % game.size(), player))
+            continue;
+        moves.push_back(static_cast<std::int16_t>(cell));
+        collectPositions(game, GameBase::opponent(player), plies, moves, seen, positions);
+        moves.pop_back();
+        game.unmakeMove();
+    }
+}
+
+} // namespace
+
+bool buildPositionCache(const PositionCacheBuildOptions& options, const std::string& path,
+                        PositionCacheBuildStats* stats,
+                        const std::function<void(std::uint64_t, std::uint64_t)>& progress,
+                        std::string* error) {
+    TICTACTOE_TRACE_SCOPE("buildPositionCache");
+    const auto started = std::chrono::steady_clock::now();
+    std::vector<PendingPosition> positions;
+    {
+        DynamicGame game(options.size, options.winLength);
+        std::vector<std::int16_t> moves;
+        std::unordered_set<std::uint64_t> seen;
+        collectPositions(game, GameBase::X, options.plies, moves, seen, positions);
+    }
+
+    TranspositionTable table(options.ttMegabytes);
+    const TaskScheduler scheduler(options.threads);
+    std::vector<Solver<DynamicGame>> solvers;
+    solvers.reserve(scheduler.threadCount());
+    for (int i = 0; i < scheduler.threadCount(); ++i)
+        solvers.emplace_back(table);
+
+    std::vector<PositionCache::Entry> entries(positions.size());
+    std::vector<char> solved(positions.size(), 0);
+    std::atomic<std::uint64_t> done{ 0 };
+    std::mutex progressMutex;
+    SolverLimits limits;
+    limits.maxNodes = options.maxNodes;
+
+    scheduler.parallelFor(static_cast<int>(positions.size()), [&](int task, int worker) {
+        DynamicGame game(options.size, options.winLength);
+        GameBase::Cell player = GameBase::X;
+        for (std::int16_t cell : positions[task].moves) {
+            game.makeMove(cell / options.size, cell % options.size, player);
+            player = GameBase::opponent(player);
+        }
+        const SolverResult result = solvers[worker].solve(game, player, limits);
+        if (result.exact) {
+            int symmetry = 0;
+            PositionCache::Entry& entry = entries[task];
+            entry.key = PositionCache::keyOf(game, player, &symmetry);
+            entry.move = static_cast<std::int16_t>(
+                result.move < 0 ? -1 : GameBase::transformCell(result.move, options.size, symmetry));
+            entry.value = static_cast<std::int8_t>(result.value);
+            entry.distance = static_cast<std::int16_t>(result.distance);
+            entry.depth = static_cast<std::int16_t>(options.size * options.size - game.moveCount());
+            solved[task] = 1;
+        }
+        const std::uint64_t count = ++done;
+        if (progress) {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            progress(count, positions.size());
+        }
+    });
+
+    std::vector<PositionCache::Entry> kept;
+    int maxMoves = 0;
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+        if (!solved[i])
+            continue;
+        kept.push_back(entries[i]);
+        maxMoves = std::max(maxMoves, static_cast<int>(positions[i].moves.size()));
+    }
+    if (stats) {
+        stats->positions = positions.size();
+        stats->solved = kept.size();
+        stats->nodes = 0;
+        for (const auto& solver : solvers)
+            stats->nodes += solver.stats().nodes;
+    }
+    const bool ok = PositionCache::write(path, options.size, options.winLength, maxMoves, std::move(kept), error);
+    if (stats)
+        stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return ok;
+}
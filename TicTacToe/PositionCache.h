@@ -0,0 +1,209 @@
+/**
+ * @file PositionCache.h
+ * @brief Файл решённых позиций, который читается через отображение в память.
+ */
+
+#pragma once
+#include "Game.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Формат файла решённых позиций (little-endian).
+ *
+ * За заголовком идут записи, отсортированные по ключу. Ключ — канонический
+ * хеш позиции (минимум по восьми симметриям), для ходящих ноликов —
+ * инвертированный, как в таблице транспозиций решателя. Отпечаток правил
+ * связывает файл с размером поля, длиной линии и ключами Зобриста; файл
+ * с другим отпечатком или версией не открывается.
+ */
+namespace positioncache {
+
+constexpr char MAGIC[8] = { 'T', 'T', 'T', 'P', 'O', 'S', '\0', '\1' };
+constexpr std::uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entryBytes;
+    std::int32_t boardSize;
+    std::int32_t winLength;
+    std::uint64_t rules;        /**< Отпечаток правил, см. rulesFingerprint() */
+    std::uint64_t entryCount;
+    std::int32_t maxMoves;      /**< Наибольшее число сделанных ходов среди позиций файла */
+    std::uint32_t reserved[5];
+};
+
+struct Entry {
+    std::uint64_t key;          /**< Ключ позиции */
+    std::int16_t move;          /**< Лучший ход в канонической ориентации */
+    std::int8_t value;          /**< 1 — выигрыш ходящего, 0 — ничья, -1 — проигрыш */
+    std::uint8_t reserved;
+    std::int16_t distance;      /**< Полуходов до конца партии при лучшей игре */
+    std::int16_t depth;         /**< Глубина, на которую позиция решена */
+};
+
+static_assert(sizeof(FileHeader) == 64 && sizeof(Entry) == 16, "position cache layout");
+
+/**
+ * @brief Отпечаток правил: версия формата, размер поля, длина линии и ключи Зобриста.
+ */
+std::uint64_t rulesFingerprint(int size, int winLength);
+
+} // namespace positioncache
+
+/**
+ * @brief Решённые позиции на диске.
+ *
+ * Файл отображается в память и не загружается в кучу: поиск записи —
+ * двоичный поиск прямо по отображённым страницам, поэтому новый процесс
+ * может обращаться к кэшу сразу после open(). Позиции хранятся с точностью
+ * до симметрии, лучший ход переводится в ориентацию запрошенной позиции.
+ */
+class PositionCache {
+public:
+    using Entry = positioncache::Entry;
+
+    /**
+     * @brief Найденная позиция в ориентации запроса.
+     */
+    struct Hit {
+        int move = -1;          /**< Лучший ход */
+        int value = 0;          /**< Оценка для ходящего */
+        int distance = 0;       /**< Полуходов до конца партии */
+        int depth = 0;          /**< Глубина решения */
+    };
+
+    /**
+     * @brief Открывает файл для поля заданных правил.
+     * @param path Путь к файлу
+     * @param size Размер стороны поля
+     * @param winLength Длина выигрышной линии
+     * @param error Описание ошибки
+     * @return false, если файл не открылся, повреждён или построен для других правил
+     */
+    bool open(const std::string& path, int size, int winLength, std::string* error = nullptr);
+
+    /**
+     * @brief Закрывает файл.
+     */
+    void close();
+
+    /**
+     * @brief true, если файл открыт.
+     */
+    bool isOpen() const { return file_.data() != nullptr; }
+
+    /**
+     * @brief true, если кэш построен для поля с этими правилами.
+     */
+    bool matches(int size, int winLength) const { return isOpen() && size == size_ && winLength == winLength_; }
+
+    /**
+     * @brief Число записей.
+     */
+    std::uint64_t entryCount() const { return count_; }
+
+    /**
+     * @brief Наибольшее число ходов среди позиций файла; более поздние позиции искать бессмысленно.
+     */
+    int maxMoves() const { return maxMoves_; }
+
+    /**
+     * @brief Ищет запись по ключу.
+     * @return Запись в отображении или nullptr
+     */
+    const Entry* find(std::uint64_t key) const;
+
+    /**
+     * @brief Ключ позиции и симметрия, переводящая её в каноническую.
+     */
+    template <class GameT>
+    static std::uint64_t keyOf(const GameT& game, GameBase::Cell player, int* symmetry) {
+        const std::uint64_t hash = game.canonicalHash(symmetry);
+        return player == GameBase::O ? ~hash : hash;
+    }
+
+    /**
+     * @brief Ищет позицию.
+     * @param game Позиция
+     * @param player Игрок, который ходит
+     * @param hit Результат в ориентации позиции
+     * @return true, если позиция есть в кэше
+     */
+    template <class GameT>
+    bool probe(const GameT& game, GameBase::Cell player, Hit& hit) const {
+        if (!matches(game.size(), game.winLength()) || game.moveCount() > maxMoves_)
+            return false;
+        int symmetry = 0;
+        const Entry* entry = find(keyOf(game, player, &symmetry));
+        if (!entry)
+            return false;
+        hit.move = entry->move < 0 ? -1
+                                   : GameBase::transformCell(entry->move, size_, GameBase::inverseSymmetry(symmetry));
+        hit.value = entry->value;
+        hit.distance = entry->distance;
+        hit.depth = entry->depth;
+        return true;
+    }
+
+    /**
+     * @brief Записывает файл: сортирует записи и отбрасывает повторы ключей.
+     * @param path Путь к файлу (перезаписывается)
+     * @param size Размер стороны поля
+     * @param winLength Длина выигрышной линии
+     * @param maxMoves Наибольшее число ходов среди позиций
+     * @param entries Записи
+     * @param error Описание ошибки
+     */
+    static bool write(const std::string& path, int size, int winLength, int maxMoves,
+                      std::vector<Entry> entries, std::string* error = nullptr);
+
+private:
+    MappedFile file_;
+    const Entry* entries_ = nullptr;
+    std::uint64_t count_ = 0;
+    int size_ = 0;
+    int winLength_ = 0;
+    int maxMoves_ = -1;
+};
+
+/**
+ * @brief Параметры построения кэша.
+ */
+struct PositionCacheBuildOptions {
+    int size = 3;                   /**< Размер стороны поля */
+    int winLength = 3;              /**< Длина выигрышной линии */
+    int plies = 2;                  /**< Сохраняются позиции не глубже этого числа ходов */
+    int threads = 1;                /**< Потоки решателей (0 — по числу ядер) */
+    std::size_t ttMegabytes = 64;   /**< Общая таблица транспозиций решателей */
+    std::uint64_t maxNodes = 0;     /**< Ограничение узлов на позицию; недорешённые позиции пропускаются */
+};
+
+/**
+ * @brief Итоги построения.
+ */
+struct PositionCacheBuildStats {
+    std::uint64_t positions = 0;    /**< Различные с точностью до симметрии нетерминальные позиции */
+    std::uint64_t solved = 0;       /**< Доказанные и записанные позиции */
+    std::uint64_t nodes = 0;        /**< Узлы поиска */
+    double seconds = 0.0;           /**< Время построения */
+};
+
+/**
+ * @brief Перебирает позиции до options.plies ходов, решает их и записывает кэш.
+ * @param options Параметры
+ * @param path Путь к файлу
+ * @param stats Итоги (может быть nullptr)
+ * @param progress Вызывается после каждой решённой позиции: (решено, всего)
+ * @param error Описание ошибки
+ * @return false при ошибке записи
+ */
+bool buildPositionCache(const PositionCacheBuildOptions& options, const std::string& path,
+                        PositionCacheBuildStats* stats = nullptr,
+                        const std::function<void(std::uint64_t, std::uint64_t)>& progress = {},
+                        std::string* error = nullptr);
@@ -0,0 +1,201 @@
+/**
+ * @file PositionRank.cpp
+ * @brief Таблицы нумерации позиций 3x3, построенные при компиляции, и комбинаторная нумерация.
+ */
+
+#include "PositionRank.h"
+#include "Tablebase.h"
+
+namespace {
+
+constexpr int INDEX_COUNT = Tablebase::INDEX_COUNT;
+
+/**
+ * @brief Вклад маски клеток одного игрока в троичный индекс: сумма 3^клетка.
+ */
+constexpr std::array<std::uint16_t, 512> makeTernaryDigits() {
+    std::array<std::uint16_t, 512> digits{};
+    for (int mask = 0; mask < 512; ++mask) {
+        int value = 0;
+        for (int cell = Game::CELL_COUNT - 1; cell >= 0; --cell)
+            value = value * 3 + ((mask >> cell) & 1);
+        digits[mask] = static_cast<std::uint16_t>(value);
+    }
+    return digits;
+}
+
+constexpr auto TERNARY_DIGITS = makeTernaryDigits();
+
+/**
+ * @brief Образ маски клеток при каждой симметрии.
+ */
+constexpr std::array<std::array<Game::Bitboard, 512>, GameBase::SYMMETRY_COUNT> makeMaskImages() {
+    std::array<std::array<Game::Bitboard, 512>, GameBase::SYMMETRY_COUNT> images{};
+    for (int s = 0; s < GameBase::SYMMETRY_COUNT; ++s)
+        for (int mask = 0; mask < 512; ++mask)
+            for (int cell = 0; cell < Game::CELL_COUNT; ++cell)
+                if (mask & (1 << cell))
+                    images[s][mask] = static_cast<Game::Bitboard>(
+                        images[s][mask] | (1u << GameBase::transformCell(cell, Game::BOARD_SIZE, s)));
+    return images;
+}
+
+constexpr auto MASK_IMAGES = makeMaskImages();
+
+/**
+ * @brief Таблицы: индекс -> номер и номер класса, номер -> индекс, номер класса -> индекс представителя.
+ */
+struct Tables {
+    std::array<std::int16_t, INDEX_COUNT> rank{};
+    std::array<std::int16_t, INDEX_COUNT> canonicalRank{};
+    std::array<std::uint8_t, INDEX_COUNT> symmetry{};
+    std::array<std::uint16_t, PositionRank::COUNT> index{};
+    std::array<std::uint16_t, PositionRank::CANONICAL_COUNT> canonicalIndex{};
+    int count = 0;
+    int canonicalCount = 0;
+};
+
+/**
+ * @brief Достижима ли расстановка из пустого поля.
+ *
+ * X ходит первым, поэтому крестиков столько же или на один больше;
+ * партия кончается на первой линии, поэтому линии есть не больше чем у
+ * одного игрока, и её собрал сделавший последний ход.
+ */
+constexpr bool reachable(Game::Bitboard xBits, Game::Bitboard oBits) {
+    int xs = 0, os = 0;
+    for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+        xs += (xBits >> cell) & 1;
+        os += (oBits >> cell) & 1;
+    }
+    if (xs != os && xs != os + 1)
+        return false;
+    const bool xLine = Game::hasLine(xBits), oLine = Game::hasLine(oBits);
+    return !(xLine && oLine) && !(xLine && xs == os) && !(oLine && xs != os);
+}
+
+constexpr Tables buildTables() {
+    Tables t{};
+    for (int index = 0; index < INDEX_COUNT; ++index) {
+        Game::Bitboard xBits = 0, oBits = 0;
+        for (int cell = 0, rest = index; cell < Game::CELL_COUNT; ++cell, rest /= 3) {
+            if (rest % 3 == 1)
+                xBits = static_cast<Game::Bitboard>(xBits | (1u << cell));
+            else if (rest % 3 == 2)
+                oBits = static_cast<Game::Bitboard>(oBits | (1u << cell));
+        }
+        t.rank[index] = -1;
+        t.canonicalRank[index] = -1;
+        if (!reachable(xBits, oBits))
+            continue;
+        t.index[t.count] = static_cast<std::uint16_t>(index);
+        t.rank[index] = static_cast<std::int16_t>(t.count++);
+
+        // Представитель класса — образ с наименьшим индексом; он не больше самого индекса и уже пройден
+        int best = index, bestSymmetry = 0;
+        for (int s = 1; s < GameBase::SYMMETRY_COUNT; ++s) {
+            const int image = TERNARY_DIGITS[MASK_IMAGES[s][xBits]] + 2 * TERNARY_DIGITS[MASK_IMAGES[s][oBits]];
+            if (image < best) {
+                best = image;
+                bestSymmetry = s;
+            }
+        }
+        if (best == index) {
+            t.canonicalIndex[t.canonicalCount] = static_cast<std::uint16_t>(index);
+            t.canonicalRank[index] = static_cast<std::int16_t>(t.canonicalCount++);
+        }
+        else {
+            t.canonicalRank[index] = t.canonicalRank[best];
+        }
+        t.symmetry[index] = static_cast<std::uint8_t>(bestSymmetry);
+    }
+    return t;
+}
+
+constexpr Tables TABLES = buildTables();
+
+static_assert(TABLES.count == PositionRank::COUNT, "reachable 3x3 positions");
+static_assert(TABLES.canonicalCount == PositionRank::CANONICAL_COUNT, "3x3 positions up to symmetry");
+
+} // namespace
+
+int PositionRank::ternaryIndex(const Game& game) {
+    return TERNARY_DIGITS[game.getBits(Game::X)] + 2 * TERNARY_DIGITS[game.getBits(Game::O)];
+}
+
+int PositionRank::rank(const Game& game) {
+    return TABLES.rank[ternaryIndex(game)];
+}
+
+Game PositionRank::unrank(int rank) {
+    return Tablebase::position(TABLES.index[rank]);
+}
+
+int PositionRank::canonicalRank(const Game& game, int* symmetry) {
+    const int index = ternaryIndex(game);
+    if (symmetry)
+        *symmetry = TABLES.symmetry[index];
+    return TABLES.canonicalRank[index];
+}
+
+Game PositionRank::canonicalUnrank(int rank) {
+    return Tablebase::position(TABLES.canonicalIndex[rank]);
+}
+
+CombinatorialRank::CombinatorialRank(int cells) : cells_(cells) {
+    for (int n = 0; n <= MAX_CELLS; ++n) {
+        pascal_[n][0] = 1;
+        for (int k = 1; k <= n; ++k)
+            pascal_[n][k] = pascal_[n - 1][k - 1] + (k < n ? pascal_[n - 1][k] : 0);
+    }
+    offsets_[0] = 0;
+    for (int k = 0; k <= cells_; ++k)
+        offsets_[k + 1] = offsets_[k] + binomial(cells_, k) * binomial(k, k - k / 2);
+}
+
+// Клетки случайной позиции заняты непредсказуемо, поэтому оба направления
+// выбирают слагаемые масками, а не ветвлениями.
+
+std::uint64_t CombinatorialRank::rankCells(const std::uint8_t* cells) const {
+    // Номер множества {c1 < c2 < ...} в комбинаторной системе: сумма C(c_i, i)
+    std::uint64_t occupiedRank = 0, xRank = 0;
+    int stones = 0, xs = 0;
+    for (int cell = 0; cell < cells_; ++cell) {
+        const std::uint64_t occupied = cells[cell] != GameBase::Empty;
+        const std::uint64_t isX = cells[cell] == GameBase::X;
+        xRank += pascal_[stones][xs + 1] & (0 - isX);  // крестик — stones-я по счёту занятая клетка
+        xs += static_cast<int>(isX);
+        stones += static_cast<int>(occupied);
+        occupiedRank += pascal_[cell][stones] & (0 - occupied);
+    }
+    if (xs != stones - stones / 2)
+        return count();
+    return offsets_[stones] + occupiedRank * binomial(stones, xs) + xRank;
+}
+
+void CombinatorialRank::unrankCells(std::uint64_t rank, std::uint8_t* cells) const {
+    int stones = 0;
+    while (offsets_[stones + 1] <= rank)
+        ++stones;
+    rank -= offsets_[stones];
+    const int xs = stones - stones / 2;
+    std::uint64_t occupiedRank = rank / binomial(stones, xs);
+    std::uint64_t xRank = rank % binomial(stones, xs);
+
+    // Элементы множества восстанавливаются от старших: c_i — наибольшее c с C(c, i) <= остатка.
+    // Кандидат пишется в слот i заранее; если он не взят, слот перепишет следующий.
+    std::uint8_t occupied[MAX_CELLS + 1];
+    for (int cell = cells_ - 1, i = stones; cell >= 0; --cell) {
+        const std::uint64_t take = pascal_[cell][i] <= occupiedRank;   // C(c, 0) = 1 > 0: лишнего не берём
+        occupiedRank -= pascal_[cell][i] & (0 - take);
+        occupied[i] = static_cast<std::uint8_t>(cell);
+        i -= static_cast<int>(take);
+        cells[cell] = GameBase::Empty;
+    }
+    for (int p = stones - 1, i = xs; p >= 0; --p) {
+        const std::uint64_t take = pascal_[p][i] <= xRank;
+        xRank -= pascal_[p][i] & (0 - take);
+        i -= static_cast<int>(take);
+        cells[occupied[p + 1]] = static_cast<std::uint8_t>(GameBase::O - take);
+    }
+}
@@ -0,0 +1,153 @@
+/**
+ * @file PositionRank.h
+ * @brief Плотная нумерация позиций: номер позиции и позиция по номеру.
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief Нумерация позиций 3x3, достижимых из пустого поля, числами [0, COUNT).
+ *
+ * Номер по позиции и позиция по номеру — чтения из таблиц, построенных
+ * при компиляции по троичному индексу Tablebase, поэтому таблицы,
+ * ключ которых — позиция, могут быть плоскими массивами из COUNT
+ * (или CANONICAL_COUNT с учётом симметрий) элементов без хеширования.
+ * Номера упорядочены так же, как троичные индексы.
+ */
+class PositionRank {
+public:
+    /**
+     * @brief Число достижимых позиций.
+     */
+    static constexpr int COUNT = 5478;
+
+    /**
+     * @brief Число классов достижимых позиций с точностью до 8 симметрий.
+     */
+    static constexpr int CANONICAL_COUNT = 765;
+
+    /**
+     * @brief Номер позиции.
+     * @return Номер в [0, COUNT) либо -1 для недостижимой позиции
+     */
+    static int rank(const Game& game);
+
+    /**
+     * @brief Позиция по номеру; фигуры ставятся по возрастанию клеток, как в Tablebase::position().
+     * @param rank Номер в [0, COUNT)
+     */
+    static Game unrank(int rank);
+
+    /**
+     * @brief Номер класса симметричных позиций.
+     * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в представителя класса
+     * @return Номер в [0, CANONICAL_COUNT) либо -1 для недостижимой позиции
+     */
+    static int canonicalRank(const Game& game, int* symmetry = nullptr);
+
+    /**
+     * @brief Представитель класса: позиция с наименьшим троичным индексом среди симметричных.
+     * @param rank Номер в [0, CANONICAL_COUNT)
+     */
+    static Game canonicalUnrank(int rank);
+
+    /**
+     * @brief Троичный индекс позиции (как Tablebase::index()), посчитанный по битбордам таблицей.
+     */
+    static int ternaryIndex(const Game& game);
+};
+
+/**
+ * @brief Нумерация позиций поля из n клеток комбинаторной системой счисления.
+ *
+ * Для полей, где таблица троичных индексов слишком велика. Нумеруются
+ * все расстановки с k фигурами, в которых X на одну больше или столько
+ * же, сколько O (X ходит первым): слоями по k, внутри слоя — номер
+ * множества занятых клеток среди C(n, k), умноженный на C(k, k - k/2),
+ * плюс номер множества крестиков среди занятых клеток. Номер считается
+ * за O(n) без таблиц размером с пространство позиций. Недостижимые
+ * расстановки (например, с линиями обоих игроков) тоже получают номера,
+ * поэтому count() чуть больше числа достижимых позиций.
+ */
+class CombinatorialRank {
+public:
+    /**
+     * @brief Наибольшее число клеток: при 40 клетках все номера помещаются в 64 бита.
+     */
+    static constexpr int MAX_CELLS = 40;
+
+    /**
+     * @brief Конструктор.
+     * @param cells Число клеток поля (size * size), не больше MAX_CELLS
+     */
+    explicit CombinatorialRank(int cells);
+
+    /**
+     * @brief Число номеров.
+     */
+    std::uint64_t count() const { return offsets_[cells_ + 1]; }
+
+    /**
+     * @brief Номер расстановки.
+     * @param cells Клетки поля по порядку: Empty, X или O
+     * @return Номер в [0, count()) либо count(), если число фигур не соответствует очерёдности
+     */
+    std::uint64_t rankCells(const std::uint8_t* cells) const;
+
+    /**
+     * @brief Расстановка по номеру.
+     * @param rank Номер в [0, count())
+     * @param cells Буфер из cells клеток для результата
+     */
+    void unrankCells(std::uint64_t rank, std::uint8_t* cells) const;
+
+    /**
+     * @brief Номер позиции игры с полем из cells клеток.
+     */
+    template <class GameT>
+    std::uint64_t rank(const GameT& game) const;
+
+    /**
+     * @brief Ставит на пустое поле игры расстановку по номеру (X и O поочерёдно).
+     */
+    template <class GameT>
+    void unrank(std::uint64_t rank, GameT& game) const;
+
+private:
+    std::uint64_t binomial(int n, int k) const { return k < 0 || k > n ? 0 : pascal_[n][k]; }
+
+    int cells_;
+    std::array<std::array<std::uint64_t, MAX_CELLS + 1>, MAX_CELLS + 1> pascal_{};
+    std::array<std::uint64_t, MAX_CELLS + 2> offsets_{};   /**< Первый номер слоя с k фигурами */
+};
+
+template <class GameT>
+std::uint64_t CombinatorialRank::rank(const GameT& game) const {
+    std::uint8_t cells[MAX_CELLS];
+    const int size = game.size();
+    for (int cell = 0; cell < cells_; ++cell)
+        cells[cell] = static_cast<std::uint8_t>(game.getCell(cell / size, cell % size));
+    return rankCells(cells);
+}
+
+template <class GameT>
+void CombinatorialRank::unrank(std::uint64_t rank, GameT& game) const {
+    std::uint8_t cells[MAX_CELLS];
+    unrankCells(rank, cells);
+    const int size = game.size();
+    int xCell = 0, oCell = 0;
+    // Чередование ходов сохраняет очерёдность в истории игры
+    for (GameBase::Cell player = GameBase::X;; player = GameBase::opponent(player)) {
+        int& next = player == GameBase::X ? xCell : oCell;
+        while (next < cells_ && cells[next] != player)
+            ++next;
+        if (next == cells_)
+            break;
+        game.makeMove(next / size, next % size, player);
+        ++next;
+    }
+}
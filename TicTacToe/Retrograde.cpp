@@ -0,0 +1,490 @@
+/**
+ * @file Retrograde.cpp
+ * @brief Построение слоёв ретроградного анализа и чтение готовых таблиц.
+ */
+
+#include "Retrograde.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr int MAX_FREE = RetrogradeTable::MAX_FREE_CELLS;
+constexpr std::size_t HEADER_BYTES = sizeof(retrograde::FileHeader);
+
+std::uint64_t layerWords(std::uint64_t entries) { return (entries + 31) / 32; }
+
+bool hasLine(std::uint64_t stones, const std::vector<std::uint64_t>& lines) {
+    for (std::uint64_t mask : lines)
+        if ((stones & mask) == mask)
+            return true;
+    return false;
+}
+
+int popCount(std::uint64_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1)
+        ++count;
+    return count;
+}
+
+} // namespace
+
+/**
+ * @brief Нумерация позиций слоёв и решение одной позиции.
+ */
+class RetrogradeTable::Indexer {
+public:
+    Indexer(const RetrogradeRules& rules, std::uint64_t baseX, std::uint64_t baseO)
+        : rules_(rules), baseX_(baseX), baseO_(baseO) {
+        for (int n = 0; n < static_cast<int>(pascal_.size()); ++n) {
+            pascal_[n][0] = 1;
+            for (int k = 1; k <= n && k < static_cast<int>(pascal_[n].size()); ++k)
+                pascal_[n][k] = pascal_[n - 1][k - 1] + pascal_[n - 1][k];
+        }
+        const std::uint64_t all = rules.cells >= 64 ? ~0ull : (1ull << rules.cells) - 1;
+        freeMask_ = all & ~(baseX | baseO);
+        for (int cell = 0; cell < rules.cells; ++cell) {
+            if (!((freeMask_ >> cell) & 1))
+                continue;
+            if (count_ < MAX_FREE)
+                free_[count_] = static_cast<std::uint8_t>(cell);
+            ++count_;   // больше MAX_FREE — validate() отвергнет
+        }
+        firstX_ = popCount(baseX) == popCount(baseO);
+
+        // Линии, которые игрок ещё может собрать: без фигур соперника в исходной позиции
+        for (std::uint64_t mask : rules.lines) {
+            if (!(mask & baseO))
+                xLines_.push_back(mask);
+            if (!(mask & baseX))
+                oLines_.push_back(mask);
+        }
+        for (int pos = 0; pos < std::min(count_, MAX_FREE); ++pos) {
+            const std::uint64_t bit = 1ull << free_[pos];
+            for (std::uint64_t mask : xLines_)
+                if (mask & bit)
+                    xThrough_[pos].push_back(mask);
+            for (std::uint64_t mask : oLines_)
+                if (mask & bit)
+                    oThrough_[pos].push_back(mask);
+        }
+    }
+
+    /**
+     * @brief Причина, по которой таблицу нельзя построить, либо nullptr.
+     */
+    const char* validate() const {
+        if (rules_.cells < 1 || rules_.cells > 64)
+            return "rules must have 1 to 64 cells";
+        const std::uint64_t all = rules_.cells >= 64 ? ~0ull : (1ull << rules_.cells) - 1;
+        if ((baseX_ & baseO_) || ((baseX_ | baseO_) & ~all))
+            return "base position does not fit the board";
+        const int xs = popCount(baseX_), os = popCount(baseO_);
+        if (xs != os && xs != os + 1)
+            return "base position piece counts do not alternate";
+        if (hasLine(baseX_, rules_.lines) || hasLine(baseO_, rules_.lines))
+            return "base position is already decided";
+        if (count_ > MAX_FREE)
+            return "too many free cells";
+        return nullptr;
+    }
+
+    int freeCount() const { return count_; }
+    std::uint64_t binomial(int n, int k) const { return k < 0 || k > n ? 0 : pascal_[n][k]; }
+    int xCount(int stones) const { return firstX_ ? stones - stones / 2 : stones / 2; }
+    bool moverIsX(int stones) const { return (stones % 2 == 0) == firstX_; }
+    std::uint64_t layerSize(int stones) const { return binomial(count_, stones) * binomial(stones, xCount(stones)); }
+
+    /**
+     * @brief Слой и номер позиции.
+     * @return false, если позиция не продолжает исходную или нарушена очерёдность
+     */
+    bool rank(std::uint64_t xBits, std::uint64_t oBits, int& stones, std::uint64_t& index) const {
+        if ((xBits & baseX_) != baseX_ || (oBits & baseO_) != baseO_ || (xBits & oBits))
+            return false;
+        const std::uint64_t addedX = xBits & ~baseX_, addedO = oBits & ~baseO_;
+        if ((addedX | addedO) & ~freeMask_)
+            return false;
+        std::uint64_t occupiedRank = 0, xRank = 0;
+        int xs = 0;
+        stones = 0;
+        for (int pos = 0; pos < count_; ++pos) {
+            const std::uint64_t bit = 1ull << free_[pos];
+            if (!((addedX | addedO) & bit))
+                continue;
+            occupiedRank += binomial(pos, ++stones);
+            if (addedX & bit)
+                xRank += binomial(stones - 1, ++xs);
+        }
+        if (xs != xCount(stones))
+            return false;
+        index = occupiedRank * binomial(stones, xs) + xRank;
+        return true;
+    }
+
+    /**
+     * @brief Оценка позиции слоя по следующему слою (next == nullptr для полного поля).
+     */
+    Value solve(int stones, std::uint64_t index, const std::uint64_t* next) const {
+        const int xs = xCount(stones);
+        const std::uint64_t xWays = binomial(stones, xs);
+        std::uint64_t occupiedRank = index / xWays;
+        std::uint64_t xRank = index % xWays;
+
+        // Занятые свободные клетки (слоты с 1) и крестики среди них — обратное к rank()
+        std::array<std::uint8_t, MAX_FREE + 1> slot;
+        for (int pos = count_ - 1, i = stones; pos >= 0; --pos) {
+            const std::uint64_t take = pascal_[pos][i] <= occupiedRank;
+            occupiedRank -= pascal_[pos][i] & (0 - take);
+            slot[i] = static_cast<std::uint8_t>(pos);
+            i -= static_cast<int>(take);
+        }
+        std::array<int, MAX_FREE + 1> occupied;
+        std::array<std::uint8_t, MAX_FREE + 1> isX{};
+        for (int j = 0; j < stones; ++j)
+            occupied[j] = slot[j + 1];
+        occupied[stones] = count_;  // ограничитель для перебора свободных мест
+        for (int j = stones - 1, i = xs; j >= 0; --j) {
+            const std::uint64_t take = pascal_[j][i] <= xRank;
+            xRank -= pascal_[j][i] & (0 - take);
+            i -= static_cast<int>(take);
+            isX[j] = static_cast<std::uint8_t>(take);
+        }
+
+        std::uint64_t xBits = baseX_, oBits = baseO_;
+        for (int j = 0; j < stones; ++j)
+            (isX[j] ? xBits : oBits) |= 1ull << free_[occupied[j]];
+        const bool moverX = moverIsX(stones);
+        const std::uint64_t mover = moverX ? xBits : oBits;
+        if (hasLine(mover, moverX ? xLines_ : oLines_))
+            return Unknown;
+        if (hasLine(moverX ? oBits : xBits, moverX ? oLines_ : xLines_))
+            return Loss;
+        if (stones == count_)
+            return Draw;
+
+        // Номер продолжения с фигурой на месте p среди занятых: суммы по фигурам ниже p
+        // остаются, выше — сдвигаются на одно место (и на один крестик, если ходит X)
+        std::array<std::uint64_t, MAX_FREE + 1> below, above, xBelow, xAbove;
+        std::array<int, MAX_FREE + 1> xCountBelow;
+        below[0] = xBelow[0] = 0;
+        xCountBelow[0] = 0;
+        for (int j = 0; j < stones; ++j) {
+            below[j + 1] = below[j] + pascal_[occupied[j]][j + 1];
+            xBelow[j + 1] = xBelow[j] + (isX[j] ? pascal_[j][xCountBelow[j] + 1] : 0);
+            xCountBelow[j + 1] = xCountBelow[j] + isX[j];
+        }
+        above[stones] = xAbove[stones] = 0;
+        for (int j = stones - 1; j >= 0; --j) {
+            above[j] = above[j + 1] + pascal_[occupied[j]][j + 2];
+            xAbove[j] = xAbove[j + 1] + (isX[j] ? pascal_[j + 1][xCountBelow[j] + 1 + moverX] : 0);
+        }
+        const std::uint64_t childWays = binomial(stones + 1, xs + moverX);
+        const auto& through = moverX ? xThrough_ : oThrough_;
+
+        bool draw = false;
+        for (int pos = 0, p = 0; pos < count_; ++pos) {
+            if (occupied[p] == pos) {
+                ++p;
+                continue;
+            }
+            const std::uint64_t after = mover | (1ull << free_[pos]);
+            for (std::uint64_t mask : through[pos])
+                if ((after & mask) == mask)
+                    return Win;
+            const std::uint64_t childOccupied = below[p] + pascal_[pos][p + 1] + above[p];
+            const std::uint64_t childX = xBelow[p] + (moverX ? pascal_[p][xCountBelow[p] + 1] : 0) + xAbove[p];
+            const std::uint64_t child = childOccupied * childWays + childX;
+            const unsigned value = static_cast<unsigned>(next[child >> 5] >> ((child & 31) * 2)) & 3;
+            if (value == Loss)
+                return Win;
+            draw |= value == Draw;
+        }
+        return draw ? Draw : Loss;
+    }
+
+    /**
+     * @brief Заголовок файла слоя.
+     */
+    retrograde::FileHeader header(int stones) const {
+        retrograde::FileHeader header{};
+        std::memcpy(header.magic, retrograde::MAGIC, sizeof(header.magic));
+        header.version = retrograde::VERSION;
+        header.stones = static_cast<std::uint32_t>(stones);
+        header.rules = rules_.fingerprint();
+        header.baseX = baseX_;
+        header.baseO = baseO_;
+        header.entryCount = layerSize(stones);
+        header.freeCells = static_cast<std::uint32_t>(count_);
+        return header;
+    }
+
+private:
+    RetrogradeRules rules_;
+    std::uint64_t baseX_;
+    std::uint64_t baseO_;
+    std::uint64_t freeMask_ = 0;
+    std::array<std::uint8_t, MAX_FREE> free_{};     /**< Клетки свободных мест по порядку */
+    int count_ = 0;
+    bool firstX_ = true;                            /**< В исходной позиции ходит X */
+    std::vector<std::uint64_t> xLines_;
+    std::vector<std::uint64_t> oLines_;
+    std::array<std::vector<std::uint64_t>, MAX_FREE> xThrough_;     /**< Линии X через свободное место */
+    std::array<std::vector<std::uint64_t>, MAX_FREE> oThrough_;
+    std::array<std::array<std::uint64_t, MAX_FREE + 2>, MAX_FREE + 2> pascal_{};
+};
+
+RetrogradeRules RetrogradeRules::board(int size, int winLength) {
+    RetrogradeRules rules;
+    rules.cells = size * size;
+    static constexpr int DIRECTIONS[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            for (const auto& d : DIRECTIONS) {
+                const int endY = y + d[0] * (winLength - 1), endX = x + d[1] * (winLength - 1);
+                if (endY < 0 || endY >= size || endX < 0 || endX >= size)
+                    continue;
+                std::uint64_t mask = 0;
+                for (int i = 0; i < winLength; ++i)
+                    mask |= 1ull << ((y + d[0] * i) * size + x + d[1] * i);
+                rules.lines.push_back(mask);
+            }
+    return rules;
+}
+
+RetrogradeRules RetrogradeRules::qubic() {
+    RetrogradeRules rules;
+    rules.cells = 64;
+    // 13 направлений (по одному из каждой пары противоположных); линия начинается у края куба
+    for (int dz = -1; dz <= 1; ++dz)
+        for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dz * 9 + dy * 3 + dx <= 0)
+                    continue;
+                for (int cell = 0; cell < 64; ++cell) {
+                    const int z = cell / 16, y = cell / 4 % 4, x = cell % 4;
+                    auto inside = [](int v) { return v >= 0 && v < 4; };
+                    if (inside(z - dz) && inside(y - dy) && inside(x - dx))
+                        continue;
+                    if (!inside(z + 3 * dz) || !inside(y + 3 * dy) || !inside(x + 3 * dx))
+                        continue;
+                    std::uint64_t mask = 0;
+                    for (int i = 0; i < 4; ++i)
+                        mask |= 1ull << ((z + dz * i) * 16 + (y + dy * i) * 4 + x + dx * i);
+                    rules.lines.push_back(mask);
+                }
+            }
+    return rules;
+}
+
+std::uint64_t RetrogradeRules::fingerprint() const {
+    std::uint64_t state = retrograde::VERSION ^ (static_cast<std::uint64_t>(cells) << 32);
+    std::uint64_t result = detail::splitmix64(state);
+    for (std::uint64_t mask : lines) {
+        state ^= mask;
+        result ^= detail::splitmix64(state);
+    }
+    return result;
+}
+
+RetrogradeTable::RetrogradeTable() = default;
+RetrogradeTable::~RetrogradeTable() = default;
+
+std::string RetrogradeTable::layerPath(const std::string& directory, int stones) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "layer%02d.ttr", stones);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+std::uint64_t RetrogradeTable::peakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    rusage usage{};
+    if (::getrusage(RUSAGE_SELF, &usage) < 0)
+        return 0;
+    return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;   // Linux: килобайты
+#endif
+}
+
+bool RetrogradeTable::build(const RetrogradeRules& rules, std::uint64_t baseX, std::uint64_t baseO,
+                            const std::string& directory, const RetrogradeOptions& options, RetrogradeStats* stats,
+                            const std::function<void(int, std::uint64_t, std::uint64_t)>& progress,
+                            std::string* error) {
+    TICTACTOE_TRACE_SCOPE("RetrogradeTable::build");
+    const auto started = std::chrono::steady_clock::now();
+    const auto indexer = std::make_unique<Indexer>(rules, baseX, baseO);
+    if (const char* problem = indexer->validate()) {
+        if (error)
+            *error = problem;
+        return false;
+    }
+    std::error_code code;
+    std::filesystem::create_directories(directory, code);
+    if (code) {
+        if (error)
+            *error = directory + ": " + code.message();
+        return false;
+    }
+
+    const TaskScheduler scheduler(options.threads);
+    const std::uint64_t chunk = std::max<std::uint64_t>(32, (options.chunkEntries + 31) / 32 * 32);
+    RetrogradeStats totals;
+    MappedFile next;
+    for (int stones = indexer->freeCount(); stones >= 0; --stones) {
+        const auto layerStarted = std::chrono::steady_clock::now();
+        const std::uint64_t entries = indexer->layerSize(stones);
+        const std::string path = layerPath(directory, stones);
+        const std::string temporary = path + ".tmp";
+        MappedFile layer;
+        if (!layer.create(temporary, HEADER_BYTES + layerWords(entries) * 8, error))
+            return false;
+        const retrograde::FileHeader header = indexer->header(stones);
+        std::memcpy(layer.writableData(), &header, sizeof(header));
+        auto* out = reinterpret_cast<std::uint64_t*>(layer.writableData() + HEADER_BYTES);
+        const auto* in = next.data() ? reinterpret_cast<const std::uint64_t*>(next.data() + HEADER_BYTES) : nullptr;
+
+        // Задача пишет целые слова, поэтому потоки не делят ни одного байта
+        std::vector<std::array<std::uint64_t, 4>> counts(scheduler.threadCount());
+        std::atomic<std::uint64_t> done{ 0 };
+        std::mutex progressMutex;
+        const int tasks = static_cast<int>((entries + chunk - 1) / chunk);
+        scheduler.parallelFor(tasks, [&](int task, int worker) {
+            const std::uint64_t begin = static_cast<std::uint64_t>(task) * chunk;
+            const std::uint64_t end = std::min(entries, begin + chunk);
+            std::array<std::uint64_t, 4>& count = counts[worker];
+            for (std::uint64_t word = begin; word < end; word += 32) {
+                std::uint64_t packed = 0;
+                for (std::uint64_t i = word; i < std::min(end, word + 32); ++i) {
+                    const Value value = indexer->solve(stones, i, in);
+                    packed |= static_cast<std::uint64_t>(value) << ((i - word) * 2);
+                    ++count[value];
+                }
+                out[word >> 5] = packed;
+            }
+            const std::uint64_t solved = done += end - begin;
+            if (progress) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                progress(stones, solved, entries);
+            }
+        });
+
+        if (!layer.flush(error))
+            return false;
+        layer.close();
+#ifdef _WIN32
+        // На Win32 rename не заменяет существующий файл, а таблицу могут строить заново в тот же каталог
+        std::remove(path.c_str());
+#endif
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+            if (error)
+                *error = "cannot rename " + temporary;
+            return false;
+        }
+        if (!next.open(path, error, MappedFile::Random))
+            return false;
+
+        RetrogradeLayerStats layerStats;
+        layerStats.stones = stones;
+        layerStats.entries = entries;
+        for (const auto& count : counts) {
+            layerStats.invalid += count[Unknown];
+            layerStats.wins += count[Win];
+            layerStats.losses += count[Loss];
+            layerStats.draws += count[Draw];
+        }
+        layerStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - layerStarted).count();
+        layerStats.peakResidentBytes = peakResidentBytes();
+        totals.layers.push_back(layerStats);
+        totals.entries += entries;
+        totals.tableBytes += HEADER_BYTES + layerWords(entries) * 8;
+    }
+    totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    totals.peakResidentBytes = peakResidentBytes();
+    if (stats)
+        *stats = std::move(totals);
+    return true;
+}
+
+bool RetrogradeTable::open(const RetrogradeRules& rules, std::uint64_t baseX, std::uint64_t baseO,
+                           const std::string& directory, std::string* error) {
+    layers_.clear();
+    indexer_ = std::make_unique<Indexer>(rules, baseX, baseO);
+    auto fail = [&](const std::string& what) {
+        indexer_.reset();
+        layers_.clear();
+        if (error)
+            *error = what;
+        return false;
+    };
+    if (const char* problem = indexer_->validate())
+        return fail(problem);
+    for (int stones = 0; stones <= indexer_->freeCount(); ++stones) {
+        const std::string path = layerPath(directory, stones);
+        auto layer = std::make_unique<MappedFile>();
+        if (!layer->open(path, error, MappedFile::Random))
+            return fail(error ? *error : path);
+        const retrograde::FileHeader expected = indexer_->header(stones);
+        retrograde::FileHeader header{};
+        if (layer->size() >= HEADER_BYTES)
+            std::memcpy(&header, layer->data(), HEADER_BYTES);
+        if (layer->size() != HEADER_BYTES + layerWords(expected.entryCount) * 8 ||
+            std::memcmp(&header, &expected, HEADER_BYTES) != 0)
+            return fail(path + ": built for other rules or base position");
+        layers_.push_back(std::move(layer));
+    }
+    return true;
+}
+
+RetrogradeTable::Value RetrogradeTable::probe(std::uint64_t xBits, std::uint64_t oBits) const {
+    int stones = 0;
+    std::uint64_t index = 0;
+    if (!indexer_ || !indexer_->rank(xBits, oBits, stones, index))
+        return Unknown;
+    const auto* words = reinterpret_cast<const std::uint64_t*>(layers_[stones]->data() + HEADER_BYTES);
+    return static_cast<Value>((words[index >> 5] >> ((index & 31) * 2)) & 3);
+}
+
+int RetrogradeTable::bestMove(std::uint64_t xBits, std::uint64_t oBits) const {
+    const Value value = probe(xBits, oBits);
+    if (value == Unknown)
+        return -1;
+    const bool moverX = popCount(xBits) == popCount(oBits);
+    int best = -1;
+    Value bestValue = Unknown;
+    for (int cell = 0; cell < 64; ++cell) {
+        const std::uint64_t bit = 1ull << cell;
+        if ((xBits | oBits) & bit)
+            continue;
+        const Value child = moverX ? probe(xBits | bit, oBits) : probe(xBits, oBits | bit);
+        if (child == Unknown)
+            continue;   // клетка вне поля
+        // Оценка продолжения — для соперника: его проигрыш лучше ничьей, ничья лучше выигрыша
+        const int rank = child == Loss ? 3 : child == Draw ? 2 : 1;
+        const int bestRank = bestValue == Loss ? 3 : bestValue == Draw ? 2 : bestValue == Win ? 1 : 0;
+        if (rank > bestRank) {
+            best = cell;
+            bestValue = child;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file Retrograde.h
+ * @brief Ретроградный анализ по слоям числа фигур: 2-битные таблицы исходов в файлах, отображённых в память.
+ */
+
+#pragma once
+#include "Game.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Формат файла слоя (little-endian).
+ *
+ * За заголовком идут 2-битные оценки позиций слоя, по 32 в 64-битном
+ * слове, в порядке номеров позиций (см. RetrogradeTable). Отпечаток
+ * связывает файл с правилами и исходной позицией.
+ */
+namespace retrograde {
+
+constexpr char MAGIC[8] = { 'T', 'T', 'T', 'R', 'E', 'T', '\0', '\1' };
+constexpr std::uint32_t VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t stones;       /**< Фигуры, поставленные на свободные клетки */
+    std::uint64_t rules;        /**< Отпечаток правил и исходной позиции */
+    std::uint64_t baseX;        /**< Крестики исходной позиции */
+    std::uint64_t baseO;        /**< Нолики исходной позиции */
+    std::uint64_t entryCount;
+    std::uint32_t freeCells;
+    std::uint32_t reserved[3];
+};
+
+static_assert(sizeof(FileHeader) == 64, "retrograde layer layout");
+
+} // namespace retrograde
+
+/**
+ * @brief Правила игры "линия на поле": клетки (не больше 64) и маски выигрышных линий.
+ */
+struct RetrogradeRules {
+    int cells = 0;
+    std::vector<std::uint64_t> lines;
+
+    /**
+     * @brief Плоское поле size x size с линией длины winLength, как BasicGame<N, K>.
+     */
+    static RetrogradeRules board(int size, int winLength);
+
+    /**
+     * @brief Qubic: куб 4x4x4, клетка z * 16 + y * 4 + x, 76 линий по четыре клетки.
+     */
+    static RetrogradeRules qubic();
+
+    /**
+     * @brief Отпечаток: число клеток и маски линий.
+     */
+    std::uint64_t fingerprint() const;
+};
+
+/**
+ * @brief Параметры построения таблицы.
+ */
+struct RetrogradeOptions {
+    int threads = 0;                        /**< Потоки; 0 — по числу аппаратных ядер */
+    std::uint64_t chunkEntries = 1 << 16;   /**< Позиций в одной задаче (округляется до 32) */
+};
+
+/**
+ * @brief Итоги построения одного слоя.
+ */
+struct RetrogradeLayerStats {
+    int stones = 0;
+    std::uint64_t entries = 0;
+    std::uint64_t wins = 0;         /**< Выигрыш ходящего */
+    std::uint64_t losses = 0;       /**< Проигрыш ходящего, в том числе законченные партии */
+    std::uint64_t draws = 0;
+    std::uint64_t invalid = 0;      /**< Недопустимые позиции: линия у ходящего */
+    double seconds = 0.0;
+    std::uint64_t peakResidentBytes = 0;    /**< Пиковая резидентная память процесса после слоя */
+};
+
+/**
+ * @brief Итоги построения таблицы.
+ */
+struct RetrogradeStats {
+    std::vector<RetrogradeLayerStats> layers;   /**< В порядке построения: от полного поля к исходной позиции */
+    std::uint64_t entries = 0;
+    std::uint64_t tableBytes = 0;               /**< Суммарный размер файлов слоёв */
+    double seconds = 0.0;
+    std::uint64_t peakResidentBytes = 0;
+};
+
+/**
+ * @brief Сильное решение всех продолжений исходной позиции ретроградным анализом.
+ *
+ * Позиции — все расстановки фигур на свободных клетках исходной позиции с
+ * соблюдением очерёдности. Ход добавляет фигуру, поэтому граф игры
+ * разбивается на слои по числу поставленных фигур, и оценки слоя зависят
+ * только от следующего. Построение идёт от полного поля (заключительные
+ * позиции) к исходной: позиция с линией у сделавшего последний ход —
+ * проигрыш ходящего, полное поле без линий — ничья, иначе оценка берётся
+ * по продолжениям из уже построенного слоя. Позиции слоя независимы,
+ * поэтому слой делится на задачи TaskScheduler по целым 64-битным словам.
+ *
+ * Номер позиции в слое с k фигурами — номер множества занятых свободных
+ * клеток среди C(n, k), умноженный на C(k, x), плюс номер множества
+ * крестиков среди занятых (как CombinatorialRank), где x — число
+ * крестиков, определяемое очерёдностью. Номера продолжений считаются
+ * по префиксным и суффиксным суммам биномиальных коэффициентов за O(1)
+ * на ход. Каждый слой — отдельный файл, отображённый в память; при
+ * построении отображены только два соседних слоя, а изменённые страницы
+ * ядро записывает в файл само, поэтому таблица может быть больше памяти.
+ *
+ * Поле 4x4 с линией из четырёх строится целиком (10 млн позиций, 2,4 МБ);
+ * для Qubic — эндшпили из позиций примерно с 20 свободными клетками.
+ */
+class RetrogradeTable {
+public:
+    /**
+     * @brief Оценка позиции для ходящего.
+     */
+    enum Value : std::uint8_t {
+        Unknown = 0,    /**< Позиция недопустима или не входит в таблицу */
+        Win = 1,
+        Loss = 2,
+        Draw = 3
+    };
+
+    /**
+     * @brief Наибольшее число свободных клеток: номера всех слоёв помещаются в 64 бита.
+     */
+    static constexpr int MAX_FREE_CELLS = 40;
+
+    RetrogradeTable();
+    ~RetrogradeTable();
+
+    RetrogradeTable(const RetrogradeTable&) = delete;
+    RetrogradeTable& operator=(const RetrogradeTable&) = delete;
+
+    /**
+     * @brief Строит файлы слоёв в каталоге.
+     * @param rules Правила
+     * @param baseX Крестики исходной позиции
+     * @param baseO Нолики исходной позиции; линий в исходной позиции быть не должно
+     * @param directory Каталог для файлов слоёв (создаётся при необходимости)
+     * @param options Параметры построения
+     * @param stats Итоги, если не nullptr
+     * @param progress Вызывается по мере решения: (фигур в слое, решено позиций слоя, всего в слое)
+     * @param error Описание ошибки
+     * @return true при успехе
+     */
+    static bool build(const RetrogradeRules& rules, std::uint64_t baseX, std::uint64_t baseO,
+                      const std::string& directory, const RetrogradeOptions& options, RetrogradeStats* stats,
+                      const std::function<void(int, std::uint64_t, std::uint64_t)>& progress,
+                      std::string* error = nullptr);
+
+    /**
+     * @brief Отображает готовые файлы слоёв для чтения.
+     * @return false, если файлов нет или они построены для других правил или исходной позиции
+     */
+    bool open(const RetrogradeRules& rules, std::uint64_t baseX, std::uint64_t baseO, const std::string& directory,
+              std::string* error = nullptr);
+
+    /**
+     * @brief Оценка позиции для ходящего (ходящий определяется по числу фигур).
+     */
+    Value probe(std::uint64_t xBits, std::uint64_t oBits) const;
+
+    /**
+     * @brief Лучший ход: в проигрышную для соперника позицию, иначе в ничейную, иначе любой.
+     * @return Клетка либо -1, если позиции нет в таблице или партия окончена
+     */
+    int bestMove(std::uint64_t xBits, std::uint64_t oBits) const;
+
+    /**
+     * @brief Оценка позиции плоской игры (Game, BasicGame<N, K>, DynamicGame).
+     */
+    template <class GameT>
+    Value probe(const GameT& game) const;
+
+    /**
+     * @brief Лучший ход в позиции плоской игры (клетка y * size + x) либо -1.
+     */
+    template <class GameT>
+    int bestMove(const GameT& game) const;
+
+    /**
+     * @brief Пиковая резидентная память процесса в байтах (0, если недоступна).
+     */
+    static std::uint64_t peakResidentBytes();
+
+    /**
+     * @brief Путь файла слоя с заданным числом фигур.
+     */
+    static std::string layerPath(const std::string& directory, int stones);
+
+private:
+    class Indexer;
+
+    template <class GameT>
+    static void bitsOf(const GameT& game, std::uint64_t& xBits, std::uint64_t& oBits);
+
+    std::unique_ptr<Indexer> indexer_;
+    std::vector<std::unique_ptr<MappedFile>> layers_;
+};
+
+template <class GameT>
+void RetrogradeTable::bitsOf(const GameT& game, std::uint64_t& xBits, std::uint64_t& oBits) {
+    xBits = oBits = 0;
+    const int size = game.size();
+    for (int cell = 0; cell < size * size && cell < 64; ++cell) {
+        const GameBase::Cell c = game.getCell(cell / size, cell % size);
+        if (c == GameBase::X)
+            xBits |= 1ull << cell;
+        else if (c == GameBase::O)
+            oBits |= 1ull << cell;
+    }
+}
+
+template <class GameT>
+RetrogradeTable::Value RetrogradeTable::probe(const GameT& game) const {
+    std::uint64_t xBits, oBits;
+    bitsOf(game, xBits, oBits);
+    return probe(xBits, oBits);
+}
+
+template <class GameT>
+int RetrogradeTable::bestMove(const GameT& game) const {
+    std::uint64_t xBits, oBits;
+    bitsOf(game, xBits, oBits);
+    return bestMove(xBits, oBits);
+}
@@ -0,0 +1,418 @@
+/**
+ * @file Simulator.h
+ * @brief Пакетное моделирование партий между стратегиями без интерфейса.
+ */
+
+#pragma once
+#include "Game.h"
+#include "GameRecord.h"
+#include "Mcts.h"
+#include "Solver.h"
+#include "TaskScheduler.h"
+#include "ValueTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Стратегия выбора хода.
+ *
+ * Экземпляр стратегии используется только одним потоком, поэтому может
+ * хранить внутреннее состояние (буферы, таблицу транспозиций).
+ *
+ * @tparam GameT Вариант игры
+ */
+template <class GameT>
+class Policy {
+public:
+    virtual ~Policy() = default;
+
+    /**
+     * @brief Выбирает ход.
+     * @param game Позиция
+     * @param player Игрок, который ходит
+     * @param rng Генератор случайных чисел потока
+     * @return Индекс клетки y * size + x либо -1, если ходов нет
+     */
+    virtual int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) = 0;
+};
+
+/**
+ * @brief Случайный ход среди свободных клеток.
+ */
+template <class GameT>
+class RandomPolicy : public Policy<GameT> {
+public:
+    int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) override;
+
+private:
+    std::vector<int> moves_;
+};
+
+/**
+ * @brief Фиксированный порядок: центр, затем углы, затем остальные клетки.
+ *
+ * На поле 3x3 совпадает с прежним ИИ из computerMove().
+ */
+template <class GameT>
+class HeuristicPolicy : public Policy<GameT> {
+public:
+    int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) override;
+
+private:
+    std::vector<int> order_;
+};
+
+/**
+ * @brief Ход, найденный решателем Solver.
+ */
+template <class GameT>
+class SearchPolicy : public Policy<GameT> {
+public:
+    /**
+     * @brief Конструктор.
+     * @param limits Ограничения поиска (по умолчанию — полный перебор)
+     */
+    explicit SearchPolicy(const SolverLimits& limits = {}) : limits_(limits) {}
+
+    int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) override;
+
+private:
+    Solver<GameT> solver_;
+    SolverLimits limits_;
+};
+
+/**
+ * @brief Ход, найденный итеративным углублением за фиксированное время.
+ */
+template <class GameT>
+class TimedSearchPolicy : public Policy<GameT> {
+public:
+    /**
+     * @brief Конструктор.
+     * @param seconds Время на ход
+     */
+    explicit TimedSearchPolicy(double seconds) : seconds_(seconds) {}
+
+    int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) override;
+
+private:
+    Solver<GameT> solver_;
+    double seconds_;
+};
+
+/**
+ * @brief Ход, найденный поиском Монте-Карло по дереву.
+ *
+ * Дерево сохраняется между ходами одной партии.
+ */
+template <class GameT>
+class MctsPolicy : public Policy<GameT> {
+public:
+    /**
+     * @brief Конструктор.
+     * @param playouts Число симуляций на ход
+     * @param nodeCapacity Ёмкость пула узлов
+     */
+    MctsPolicy(std::uint64_t playouts, std::size_t nodeCapacity)
+        : mcts_(nodeCapacity) {
+        limits_.playouts = playouts;
+    }
+
+    int chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64& rng) override;
+
+private:
+    Mcts<GameT> mcts_;
+    MctsLimits limits_;
+};
+
+/**
+ * @brief Жадный ход по таблице ценности, выученной самоигрой (только поле 3x3).
+ */
+class LearnedPolicy : public Policy<Game> {
+public:
+    explicit LearnedPolicy(std::shared_ptr<const ValueTable> table) : table_(std::move(table)) {}
+
+    int chooseMove(const Game& game, GameBase::Cell player, std::mt19937_64&) override {
+        return table_->bestMove(game, player);
+    }
+
+private:
+    std::shared_ptr<const ValueTable> table_;
+};
+
+/**
+ * @brief Создаёт стратегию по имени.
+ * @param spec "random", "heuristic", "search", "search:<глубина>", "timed:<мс>", "mcts:<симуляций>"
+ *             или "learned:<файл таблицы ценности>" (только Game)
+ * @return Стратегия либо nullptr для неизвестного имени
+ */
+template <class GameT>
+std::unique_ptr<Policy<GameT>> makePolicy(const std::string& spec);
+
+/**
+ * @brief Параметры моделирования.
+ */
+struct SimulationConfig {
+    std::uint64_t games = 100000;        /**< Число партий */
+    int threads = 0;                     /**< Число потоков; 0 — по числу ядер */
+    std::uint64_t seed = 1;              /**< Базовое зерно генераторов */
+    std::string xPolicy = "random";      /**< Стратегия крестиков */
+    std::string oPolicy = "random";      /**< Стратегия ноликов */
+    int chunkSize = 1024;                /**< Партий в одной задаче планировщика */
+    std::string recordPath;              /**< Файл записей партий (только для Game); пусто — не записывать */
+};
+
+/**
+ * @brief Сводная статистика моделирования.
+ */
+struct SimulationStats {
+    std::uint64_t games = 0;    /**< Сыгранные партии */
+    std::uint64_t xWins = 0;    /**< Победы крестиков */
+    std::uint64_t oWins = 0;    /**< Победы ноликов */
+    std::uint64_t draws = 0;    /**< Ничьи */
+    std::uint64_t moves = 0;    /**< Сумма длин партий в полуходах */
+    double seconds = 0.0;       /**< Время моделирования */
+
+    /**
+     * @brief Добавляет статистику другого потока.
+     */
+    void merge(const SimulationStats& other) {
+        games += other.games;
+        xWins += other.xWins;
+        oWins += other.oWins;
+        draws += other.draws;
+        moves += other.moves;
+    }
+
+    /**
+     * @brief Партий в секунду.
+     */
+    double gamesPerSecond() const { return seconds > 0.0 ? games / seconds : 0.0; }
+
+    /**
+     * @brief Средняя длина партии в полуходах.
+     */
+    double averageLength() const { return games ? static_cast<double>(moves) / games : 0.0; }
+};
+
+/**
+ * @brief Моделирует партии между двумя стратегиями на всех ядрах.
+ *
+ * Партии разбиваются на задачи по chunkSize штук и распределяются
+ * TaskScheduler. Генератор каждой задачи инициализируется зерном,
+ * выведенным из базового зерна и номера задачи, поэтому для стратегий
+ * без памяти между партиями итоговая статистика не зависит от числа
+ * потоков и порядка перехвата задач.
+ * Каждый поток пишет в собственный блок статистики, блоки суммируются
+ * после завершения всех потоков без блокировок. Записи партий копятся
+ * в буфере задачи и дописываются в файл одной порцией под мьютексом.
+ *
+ * @tparam GameT Вариант игры
+ */
+template <class GameT>
+class Simulator {
+public:
+    /**
+     * @brief Конструктор.
+     * @param config Параметры моделирования
+     * @param start Начальная позиция каждой партии
+     */
+    explicit Simulator(const SimulationConfig& config, const GameT& start = GameT())
+        : config_(config), start_(start) {}
+
+    /**
+     * @brief Запускает моделирование.
+     * @return Статистика; games == 0, если имя стратегии не распознано или файл записей не открылся
+     */
+    SimulationStats run();
+
+    /**
+     * @brief Играет одну партию до конца.
+     * @param game Позиция (изменяется)
+     * @param x Стратегия крестиков
+     * @param o Стратегия ноликов
+     * @param rng Генератор случайных чисел
+     * @param moves Число сделанных полуходов (увеличивается)
+     * @return Победитель либо Empty при ничьей
+     */
+    static GameBase::Cell playGame(GameT& game, Policy<GameT>& x, Policy<GameT>& o,
+                                   std::mt19937_64& rng, std::uint64_t& moves);
+
+private:
+    struct alignas(64) WorkerState {
+        std::unique_ptr<Policy<GameT>> x;
+        std::unique_ptr<Policy<GameT>> o;
+        SimulationStats stats;
+        std::vector<std::uint32_t> records;
+    };
+
+    SimulationConfig config_;
+    GameT start_;
+};
+
+template <class GameT>
+int RandomPolicy<GameT>::chooseMove(const GameT& game, GameBase::Cell, std::mt19937_64& rng) {
+    const int size = game.size();
+    moves_.clear();
+    for (int cell = 0; cell < size * size; ++cell)
+        if (isLegalMove(game, cell))
+            moves_.push_back(cell);
+    if (moves_.empty())
+        return -1;
+    return moves_[std::uniform_int_distribution<std::size_t>(0, moves_.size() - 1)(rng)];
+}
+
+template <class GameT>
+int HeuristicPolicy<GameT>::chooseMove(const GameT& game, GameBase::Cell, std::mt19937_64&) {
+    const int size = game.size();
+    if (static_cast<int>(order_.size()) != size * size) {
+        const int last = size - 1;
+        order_ = { (size / 2) * size + size / 2, 0, last, last * size, last * size + last };
+        for (int cell = 0; cell < size * size; ++cell)
+            if (std::find(order_.begin(), order_.end(), cell) == order_.end())
+                order_.push_back(cell);
+    }
+    for (int cell : order_)
+        if (isLegalMove(game, cell))
+            return cell;
+    return -1;
+}
+
+template <class GameT>
+int SearchPolicy<GameT>::chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64&) {
+    return solver_.solve(game, player, limits_).move;
+}
+
+template <class GameT>
+int TimedSearchPolicy<GameT>::chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64&) {
+    return solver_.bestMove(game, player, seconds_).result.move;
+}
+
+template <class GameT>
+int MctsPolicy<GameT>::chooseMove(const GameT& game, GameBase::Cell player, std::mt19937_64&) {
+    return mcts_.search(game, player, limits_).move;
+}
+
+template <class GameT>
+std::unique_ptr<Policy<GameT>> makePolicy(const std::string& spec) {
+    if (spec == "random")
+        return std::make_unique<RandomPolicy<GameT>>();
+    if (spec == "heuristic")
+        return std::make_unique<HeuristicPolicy<GameT>>();
+    if (spec == "search")
+        return std::make_unique<SearchPolicy<GameT>>();
+    if (spec.compare(0, 7, "search:") == 0) {
+        SolverLimits limits;
+        limits.maxDepth = std::atoi(spec.c_str() + 7);
+        return std::make_unique<SearchPolicy<GameT>>(limits);
+    }
+    if (spec.compare(0, 6, "timed:") == 0) {
+        const double milliseconds = std::atof(spec.c_str() + 6);
+        if (milliseconds <= 0.0)
+            return nullptr;
+        return std::make_unique<TimedSearchPolicy<GameT>>(milliseconds / 1000.0);
+    }
+    if (spec.compare(0, 5, "mcts:") == 0) {
+        const std::uint64_t playouts = std::strtoull(spec.c_str() + 5, nullptr, 10);
+        if (playouts == 0)
+            return nullptr;
+        return std::make_unique<MctsPolicy<GameT>>(playouts, std::min<std::uint64_t>(playouts * 64 + 1, 1 << 20));
+    }
+    if constexpr (std::is_same<GameT, Game>::value) {
+        if (spec.compare(0, 8, "learned:") == 0) {
+            auto table = std::make_shared<ValueTable>();
+            if (!table->load(spec.substr(8)))
+                return nullptr;
+            return std::make_unique<LearnedPolicy>(std::move(table));
+        }
+    }
+    return nullptr;
+}
+
+template <class GameT>
+GameBase::Cell Simulator<GameT>::playGame(GameT& game, Policy<GameT>& x, Policy<GameT>& o,
+                                          std::mt19937_64& rng, std::uint64_t& moves) {
+    TICTACTOE_TRACE_SCOPE("Simulator::playGame");
+    const int size = game.size();
+    // Начальная позиция может быть с нечётным числом ходов
+    GameBase::Cell player = game.moveCount() % 2 ? GameBase::O : GameBase::X;
+    for (;;) {
+        const GameBase::Cell winner = game.checkWinner();
+        if (winner != GameBase::Empty)
+            return winner;
+        if (game.isDraw())
+            return GameBase::Empty;
+        const int move = (player == GameBase::X ? x : o).chooseMove(game, player, rng);
+        if (move < 0 || !game.makeMove(move / size, move % size, player))
+            return GameBase::Empty;
+        ++moves;
+        player = GameBase::opponent(player);
+    }
+}
+
+template <class GameT>
+SimulationStats Simulator<GameT>::run() {
+    const TaskScheduler scheduler(config_.threads);
+    std::vector<WorkerState> workers(scheduler.threadCount());
+    for (auto& worker : workers) {
+        worker.x = makePolicy<GameT>(config_.xPolicy);
+        worker.o = makePolicy<GameT>(config_.oPolicy);
+        if (!worker.x || !worker.o)
+            return SimulationStats();
+    }
+
+    constexpr bool recordable = std::is_same<GameT, Game>::value;
+    GameRecordWriter recorder;
+    std::mutex recorderMutex;
+    if (!config_.recordPath.empty() && (!recordable || !recorder.open(config_.recordPath)))
+        return SimulationStats();
+
+    const std::uint64_t chunkSize = config_.chunkSize > 0 ? config_.chunkSize : 1;
+    const int chunks = static_cast<int>((config_.games + chunkSize - 1) / chunkSize);
+
+    const auto started = std::chrono::steady_clock::now();
+    scheduler.parallelFor(chunks, [&](int chunk, int worker) {
+        WorkerState& state = workers[worker];
+        std::uint64_t seed = config_.seed ^ (static_cast<std::uint64_t>(chunk) * 0xD1B54A32D192ED03ull);
+        std::mt19937_64 rng(detail::splitmix64(seed));
+
+        const std::uint64_t first = chunk * chunkSize;
+        const std::uint64_t last = std::min(first + chunkSize, config_.games);
+        for (std::uint64_t i = first; i < last; ++i) {
+            GameT game = start_;
+            const GameBase::Cell winner = playGame(game, *state.x, *state.o, rng, state.stats.moves);
+            ++state.stats.games;
+            if (winner == GameBase::X)
+                ++state.stats.xWins;
+            else if (winner == GameBase::O)
+                ++state.stats.oWins;
+            else
+                ++state.stats.draws;
+            if constexpr (recordable) {
+                if (recorder.isOpen())
+                    state.records.push_back(GameRecord::encode(game));
+            }
+        }
+        if (!state.records.empty()) {
+            std::lock_guard<std::mutex> lock(recorderMutex);
+            recorder.append(state.records.data(), state.records.size());
+            state.records.clear();
+        }
+    });
+    recorder.close();
+
+    SimulationStats total;
+    for (const auto& worker : workers)
+        total.merge(worker.stats);
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return total;
+}
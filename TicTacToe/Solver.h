@@ -0,0 +1,670 @@
+/**
+ * @file Solver.h
+ * @brief Поиск лучшего хода методом negamax с альфа-бета отсечением.
+ */
+
+#pragma once
+#include "Game.h"
+#include "PositionCache.h"
+#include "ThreatEvaluator.h"
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Ограничения поиска. Нулевое значение означает отсутствие ограничения.
+ */
+struct SolverLimits {
+    int maxDepth = 0;             /**< Максимальная глубина в полуходах */
+    std::uint64_t maxNodes = 0;   /**< Максимальное число посещённых позиций */
+};
+
+/**
+ * @brief Результат анализа позиции.
+ */
+struct SolverResult {
+    int move = -1;        /**< Лучший ход (индекс клетки y * size + x) либо -1, если ходов нет */
+    int value = 0;        /**< Теоретическая оценка для ходящего: 1 — выигрыш, 0 — ничья, -1 — проигрыш */
+    int distance = -1;    /**< Число полуходов до конца партии при лучшей игре (-1, если не доказано) */
+    bool exact = false;   /**< true, если результат доказан без срабатывания ограничений */
+};
+
+/**
+ * @brief Сведения о завершённой итерации поиска с ограничением времени.
+ */
+struct SearchIteration {
+    int depth = 0;                /**< Глубина итерации в полуходах */
+    int score = 0;                /**< Оценка для ходящего; выигрыш — больше 9000, проигрыш — меньше -9000 */
+    std::uint64_t nodes = 0;      /**< Узлы с начала поиска */
+    double seconds = 0.0;         /**< Время с начала поиска */
+    double nodesPerSecond = 0.0;  /**< Скорость поиска */
+    std::vector<int> pv;          /**< Главный вариант: ожидаемые ходы обеих сторон */
+};
+
+/**
+ * @brief Результат поиска с ограничением времени.
+ */
+struct TimedSearchResult {
+    SolverResult result;                    /**< Ход и теоретическая оценка, если она доказана */
+    int depth = 0;                          /**< Глубина последней завершённой итерации */
+    int score = 0;                          /**< Оценка последней завершённой итерации */
+    std::vector<int> pv;                    /**< Главный вариант последней завершённой итерации */
+    std::uint64_t nodes = 0;                /**< Все узлы поиска */
+    double seconds = 0.0;                   /**< Затраченное время */
+    std::vector<SearchIteration> iterations; /**< Все завершённые итерации */
+};
+
+/**
+ * @brief Счётчики поиска для настройки движка.
+ */
+struct SolverStats {
+    std::uint64_t nodes = 0;      /**< Посещённые позиции */
+    std::uint64_t ttProbes = 0;   /**< Обращения к таблице транспозиций */
+    std::uint64_t ttHits = 0;     /**< Найденные в таблице позиции */
+    std::uint64_t cacheHits = 0;  /**< Позиции, взятые из кэша решённых позиций */
+};
+
+/**
+ * @brief Решатель позиций "k в ряд", независимый от интерфейса.
+ *
+ * Negamax с альфа-бета отсечением, таблицей транспозиций по хешу Зобриста
+ * и упорядочиванием ходов (ход из таблицы, затем клетки ближе к центру).
+ * Поиск идёт по одной рабочей копии позиции через makeMove()/unmakeMove(),
+ * ключ позиции берётся из инкрементального хеша игры.
+ * Таблица сохраняется между запросами, поэтому повторный анализ уже
+ * решённой позиции сводится к одному обращению к таблице. Несколько
+ * решателей в разных потоках могут работать с одной TranspositionTable,
+ * если анализируют поле одного размера. Подключённый PositionCache
+ * проверяется до таблицы: найденная в нём позиция не перебирается.
+ *
+ * Для полей, которые нельзя решить полностью, bestMove() ищет с
+ * итеративным углублением до заданного срока. Режим отличается от solve():
+ * на горизонте позиция оценивается по образцам ThreatEvaluator, который
+ * обновляется вместе с рабочей копией позиции (поля, которые он не
+ * поддерживает, оцениваются просмотром открытых линий), порядок ходов
+ * берёт главный вариант предыдущей итерации и историю отсечений, а на
+ * полях больше 5x5 рассматриваются только клетки рядом с камнями.
+ * Записи этого режима хранятся в таблице под отдельными ключами и не
+ * смешиваются с точными результатами solve().
+ *
+ * Для игр с собственными правилами ходов (HasMoveGenerator, например
+ * UltimateGame) перебираются только допустимые ходы, на горизонте
+ * используется оценка самой игры, а кэш и отбор клеток рядом с камнями
+ * отключены.
+ *
+ * @tparam GameT Вариант игры: Game, BasicGame<N, K>, DynamicGame или UltimateGame
+ */
+template <class GameT>
+class Solver {
+public:
+    using Cell = GameBase::Cell;
+
+    /**
+     * @brief Конструктор с собственной таблицей транспозиций.
+     * @param ttMegabytes Бюджет памяти таблицы
+     */
+    explicit Solver(std::size_t ttMegabytes = 1);
+
+    /**
+     * @brief Конструктор с общей таблицей транспозиций.
+     *
+     * Решатель не очищает общую таблицу и не продвигает её поколение — это
+     * делает владелец между пачками поисков (TranspositionTable::newSearch()).
+     * Поэтому все позиции решателя должны быть одного размера: позиция другого
+     * размера отвергается, solve() и bestMove() возвращают результат без хода.
+     * @param table Таблица; должна жить дольше решателя
+     */
+    explicit Solver(TranspositionTable& table) : table_(&table) {}
+
+    /**
+     * @brief Находит лучший ход в позиции.
+     * @param game Позиция
+     * @param player Игрок, который ходит
+     * @param limits Ограничения глубины и числа узлов
+     * @return Лучший ход, его оценка и расстояние до результата
+     */
+    SolverResult solve(const GameT& game, Cell player, const SolverLimits& limits = {});
+
+    /**
+     * @brief Ищет лучший ход с итеративным углублением и всегда укладывается в срок.
+     *
+     * Каждая итерация начинается с главного варианта предыдущей; если
+     * срок истёк посреди итерации, используется результат последней
+     * завершённой. Новая итерация не начинается, если прошло больше
+     * половины срока: она почти наверняка не успеет закончиться.
+     *
+     * @param game Позиция
+     * @param player Игрок, который ходит
+     * @param seconds Бюджет времени
+     * @param onIteration Вызывается после каждой завершённой итерации
+     * @return Ход (всегда допустимый, если свободные клетки есть), оценка и главный вариант
+     */
+    TimedSearchResult bestMove(const GameT& game, Cell player, double seconds,
+                               const std::function<void(const SearchIteration&)>& onIteration = {});
+
+    /**
+     * @brief Очищает таблицу транспозиций.
+     */
+    void clear() { table_->clear(); }
+
+    /**
+     * @brief Подключает кэш решённых позиций.
+     * @param cache Кэш; должен жить дольше решателя, nullptr отключает кэш.
+     *              Кэш для других правил игнорируется.
+     */
+    void setCache(const PositionCache* cache) { cache_ = cache; }
+
+    /**
+     * @brief Подключает флаг остановки, который может выставить другой поток.
+     *
+     * Поиск проверяет флаг раз в STOP_CHECK_INTERVAL узлов и прерывается так же,
+     * как при исчерпании limits.maxNodes: результат не помечается точным.
+     * @param stop Флаг; должен жить дольше решателя, nullptr отключает проверку
+     */
+    void setStopFlag(const std::atomic<bool>* stop) { stop_ = stop; }
+
+    /**
+     * @brief Таблица транспозиций решателя.
+     */
+    TranspositionTable& table() { return *table_; }
+
+    /**
+     * @brief Текущие значения счётчиков.
+     */
+    const SolverStats& stats() const { return stats_; }
+
+    /**
+     * @brief Обнуляет счётчики.
+     */
+    void resetStats() { stats_ = SolverStats(); }
+
+private:
+    static constexpr int WIN_SCORE = 10000;
+    static constexpr int MATE_BOUND = WIN_SCORE - 1000;
+    static constexpr std::uint64_t STOP_CHECK_INTERVAL = 1024;
+    static constexpr std::uint64_t TIME_CHECK_INTERVAL = 256;
+    static constexpr int EVAL_LIMIT = 4000;
+    static constexpr int NEIGHBOUR_RADIUS = 2;
+    static constexpr std::uint64_t TIMED_KEY_SALT = 0x5EA5C4D1E9B7A3F1ull;
+
+    bool prepare(int size);
+    int search(GameT& game, Cell player, int depth, int ply, int alpha, int beta, int* bestMove);
+    int evaluate(const GameT& game, Cell player) const;
+    const std::vector<int>& orderMoves(const GameT& game, Cell player, int ply, int ttMove);
+    std::vector<int> principalVariation(GameT game, Cell player, int firstMove, int maxLength) const;
+    int drawDistance(GameT game, Cell player, int move);
+
+    static std::uint64_t keyOf(const GameT& game, Cell player) {
+        return player == GameBase::O ? ~game.hash() : game.hash();
+    }
+
+    static int toTable(int score, int ply);
+    static int fromTable(int score, int ply);
+
+    std::unique_ptr<TranspositionTable> ownTable_;
+    TranspositionTable* table_;
+    const PositionCache* cache_ = nullptr;
+    const std::atomic<bool>* stop_ = nullptr;
+    int cacheMoves_ = -1;
+    std::vector<int> order_;
+    int size_ = 0;
+    int empties_ = 0;
+    SolverLimits limits_;
+    bool limitHit_ = false;
+    bool aborted_ = false;
+    std::uint64_t searchNodes_ = 0;
+    SolverStats stats_;
+
+    // Состояние bestMove()
+    bool timed_ = false;
+    bool pruneFar_ = false;
+    bool onPv_ = false;
+    std::chrono::steady_clock::time_point deadline_;
+    std::vector<int> pv_;
+    std::vector<std::vector<int>> moveLists_;
+    std::vector<std::uint32_t> history_;        /**< Счётчики отсечений: [игрок][клетка] */
+    std::vector<std::uint8_t> near_;
+    std::unique_ptr<ThreatEvaluator> threats_;  /**< Оценка образцов рабочей позиции */
+};
+
+template <class GameT>
+Solver<GameT>::Solver(std::size_t ttMegabytes)
+    : ownTable_(std::make_unique<TranspositionTable>(ttMegabytes)), table_(ownTable_.get()) {}
+
+/**
+ * @brief Готовит порядок ходов для поля заданного размера.
+ * @return false, если размер сменился, а таблица общая
+ */
+template <class GameT>
+bool Solver<GameT>::prepare(int size) {
+    if (size == size_)
+        return true;
+    // Ключи полей разного размера несовместимы; общую таблицу в это время читают другие решатели
+    if (size_ != 0) {
+        if (!ownTable_)
+            return false;
+        clear();
+    }
+    size_ = size;
+    const int cells = size * size;
+
+    // Клетки ближе к центру участвуют в большем числе линий — проверяем их первыми
+    order_.resize(cells);
+    for (int i = 0; i < cells; ++i)
+        order_[i] = i;
+    const int centre = size - 1;
+    std::stable_sort(order_.begin(), order_.end(), [&](int a, int b) {
+        const int da = std::abs(2 * (a / size) - centre) + std::abs(2 * (a % size) - centre);
+        const int db = std::abs(2 * (b / size) - centre) + std::abs(2 * (b % size) - centre);
+        return da < db;
+    });
+    return true;
+}
+
+template <class GameT>
+SolverResult Solver<GameT>::solve(const GameT& game, Cell player, const SolverLimits& limits) {
+    TICTACTOE_LATENCY_SCOPE(MoveSelection);
+    TICTACTOE_TRACE_SCOPE("Solver::solve");
+    if (!prepare(game.size()))
+        return SolverResult();
+
+    empties_ = size_ * size_ - game.moveCount();
+    // Позиции позже самых глубоких позиций кэша в нём не ищем
+    cacheMoves_ = cache_ && !HasMoveGenerator<GameT>::value && cache_->matches(size_, game.winLength())
+                      ? cache_->maxMoves() : -1;
+
+    if (ownTable_)
+        table_->newSearch();
+    limits_ = limits;
+    limitHit_ = false;
+    aborted_ = false;
+    searchNodes_ = 0;
+    const int depth = (limits.maxDepth > 0 && limits.maxDepth < empties_) ? limits.maxDepth : empties_;
+
+    SolverResult result;
+    GameT work = game;
+    const int score = search(work, player, depth, 0, -WIN_SCORE, WIN_SCORE, &result.move);
+    result.exact = !limitHit_;
+    if (score > MATE_BOUND) {
+        result.value = 1;
+        result.distance = WIN_SCORE - score;
+    }
+    else if (score < -MATE_BOUND) {
+        result.value = -1;
+        result.distance = WIN_SCORE + score;
+    }
+    else if (result.exact) {
+        result.distance = drawDistance(game, player, result.move);
+        result.exact = result.distance >= 0;
+    }
+    return result;
+}
+
+template <class GameT>
+TimedSearchResult Solver<GameT>::bestMove(const GameT& game, Cell player, double seconds,
+                                          const std::function<void(const SearchIteration&)>& onIteration) {
+    TICTACTOE_LATENCY_SCOPE(MoveSelection);
+    TICTACTOE_TRACE_SCOPE("Solver::bestMove");
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point started = Clock::now();
+    if (!prepare(game.size()))
+        return TimedSearchResult();
+    const int cells = size_ * size_;
+    empties_ = cells - game.moveCount();
+    cacheMoves_ = cache_ && !HasMoveGenerator<GameT>::value && cache_->matches(size_, game.winLength())
+                      ? cache_->maxMoves() : -1;
+
+    if (ownTable_)
+        table_->newSearch();
+    limits_ = SolverLimits();
+    searchNodes_ = 0;
+    timed_ = true;
+    pruneFar_ = !HasMoveGenerator<GameT>::value && size_ > 2 * NEIGHBOUR_RADIUS + 1;
+    deadline_ = started + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    history_.assign(2 * cells, 0);
+    near_.resize(cells);
+    moveLists_.resize(empties_ + 1);
+    pv_.clear();
+    if (HasMoveGenerator<GameT>::value || !ThreatEvaluator::supports(size_, game.winLength()))
+        threats_.reset();
+    else if (!threats_ || threats_->size() != size_ || threats_->winLength() != game.winLength())
+        threats_ = std::make_unique<ThreatEvaluator>(size_, game.winLength());
+    if (threats_)
+        threats_->reset(game);
+
+    TimedSearchResult timed;
+    GameT work = game;
+    for (int depth = 1; depth <= empties_; ++depth) {
+        limitHit_ = false;
+        aborted_ = false;
+        onPv_ = true;
+        int move = -1;
+        const int score = search(work, player, depth, 0, -WIN_SCORE, WIN_SCORE, &move);
+        const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        if (aborted_) {
+            // Незавершённой итерации доверяем, только если других нет
+            if (timed.iterations.empty())
+                timed.result.move = move;
+            break;
+        }
+
+        pv_ = principalVariation(game, player, move, depth);
+        SearchIteration iteration;
+        iteration.depth = depth;
+        iteration.score = score;
+        iteration.nodes = searchNodes_;
+        iteration.seconds = elapsed;
+        iteration.nodesPerSecond = elapsed > 0.0 ? searchNodes_ / elapsed : 0.0;
+        iteration.pv = pv_;
+        timed.iterations.push_back(iteration);
+        if (onIteration)
+            onIteration(iteration);
+
+        timed.depth = depth;
+        timed.score = score;
+        timed.pv = pv_;
+        timed.result.move = move;
+        timed.result.exact = !limitHit_ && !pruneFar_;
+        timed.result.value = score > MATE_BOUND ? 1 : (score < -MATE_BOUND ? -1 : 0);
+        timed.result.distance = score > MATE_BOUND ? WIN_SCORE - score : (score < -MATE_BOUND ? WIN_SCORE + score : -1);
+        if (timed.result.exact && timed.result.value == 0) {
+            // Ничейный вариант доигрывается по заполненной таблице, срок на это не распространяется
+            onPv_ = false;
+            deadline_ = Clock::time_point::max();
+            timed.result.distance = drawDistance(game, player, move);
+            timed.result.exact = timed.result.distance >= 0;
+            break;
+        }
+        if (timed.result.exact || elapsed * 2 > seconds)
+            break;
+    }
+    timed_ = false;
+    onPv_ = false;
+
+    // Срок истёк до первой итерации: любой свободный ход лучше отсутствия ответа
+    if (timed.result.move < 0)
+        for (int cell : order_)
+            if (isLegalMove(game, cell)) {
+                timed.result.move = cell;
+                break;
+            }
+    timed.nodes = searchNodes_;
+    timed.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    return timed;
+}
+
+/**
+ * @brief Оценка на горизонте: образцы ThreatEvaluator, а без него каждое окно из k клеток,
+ *        занятое только одним игроком, даёт 4^(камней).
+ */
+template <class GameT>
+int Solver<GameT>::evaluate(const GameT& game, Cell player) const {
+    if constexpr (HasMoveGenerator<GameT>::value)
+        return std::max(-EVAL_LIMIT, std::min(EVAL_LIMIT, game.evaluate(player)));
+    if (threats_)
+        return std::max(-EVAL_LIMIT, std::min(EVAL_LIMIT, threats_->evaluate(player)));
+    static constexpr int DIRECTIONS[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    const int k = game.winLength();
+    int score = 0;
+    for (const auto& direction : DIRECTIONS) {
+        const int dy = direction[0], dx = direction[1];
+        for (int y = 0; y < size_; ++y) {
+            for (int x = 0; x < size_; ++x) {
+                const int endY = y + dy * (k - 1), endX = x + dx * (k - 1);
+                if (endY >= size_ || endX < 0 || endX >= size_)
+                    continue;
+                int xs = 0, os = 0;
+                for (int i = 0; i < k; ++i) {
+                    const Cell cell = game.getCell(y + dy * i, x + dx * i);
+                    xs += cell == GameBase::X;
+                    os += cell == GameBase::O;
+                }
+                if (os == 0 && xs > 0)
+                    score += 1 << (2 * std::min(xs, 7));
+                else if (xs == 0 && os > 0)
+                    score -= 1 << (2 * std::min(os, 7));
+            }
+        }
+    }
+    if (player == GameBase::O)
+        score = -score;
+    return std::max(-EVAL_LIMIT, std::min(EVAL_LIMIT, score));
+}
+
+/**
+ * @brief Ходы узла в порядке проверки: главный вариант, ход из таблицы, затем по истории отсечений.
+ *
+ * Равные по истории ходы остаются в порядке близости к центру.
+ */
+template <class GameT>
+const std::vector<int>& Solver<GameT>::orderMoves(const GameT& game, Cell player, int ply, int ttMove) {
+    std::vector<int>& moves = moveLists_[ply];
+    moves.clear();
+    const int cells = size_ * size_;
+    if (pruneFar_ && game.moveCount() > 0) {
+        std::fill(near_.begin(), near_.end(), std::uint8_t(0));
+        for (int i = 0; i < game.moveCount(); ++i) {
+            const int stone = game.moveAt(i);
+            const int sy = stone / size_, sx = stone % size_;
+            for (int y = std::max(0, sy - NEIGHBOUR_RADIUS); y <= std::min(size_ - 1, sy + NEIGHBOUR_RADIUS); ++y)
+                for (int x = std::max(0, sx - NEIGHBOUR_RADIUS); x <= std::min(size_ - 1, sx + NEIGHBOUR_RADIUS); ++x)
+                    near_[y * size_ + x] = 1;
+        }
+        for (int cell : order_)
+            if (near_[cell] && isLegalMove(game, cell))
+                moves.push_back(cell);
+    }
+    else {
+        for (int cell : order_)
+            if (isLegalMove(game, cell))
+                moves.push_back(cell);
+        if (pruneFar_)
+            moves.resize(1);    // пустое большое поле: достаточно центра
+    }
+    if (moves.empty())
+        for (int cell : order_)
+            if (isLegalMove(game, cell))
+                moves.push_back(cell);
+
+    const int pvMove = onPv_ && ply < static_cast<int>(pv_.size()) ? pv_[ply] : -1;
+    const std::uint32_t* history = history_.data() + (player == GameBase::O) * cells;
+    auto rank = [&](int cell) -> std::uint64_t {
+        if (cell == pvMove)
+            return ~std::uint64_t(0);
+        if (cell == ttMove)
+            return ~std::uint64_t(0) - 1;
+        return history[cell];
+    };
+    std::stable_sort(moves.begin(), moves.end(), [&](int a, int b) { return rank(a) > rank(b); });
+    return moves;
+}
+
+/**
+ * @brief Главный вариант: лучший ход корня и далее ходы из таблицы, пока они допустимы.
+ */
+template <class GameT>
+std::vector<int> Solver<GameT>::principalVariation(GameT game, Cell player, int firstMove, int maxLength) const {
+    std::vector<int> pv;
+    int move = firstMove;
+    while (move >= 0 && static_cast<int>(pv.size()) < maxLength &&
+           game.checkWinner() == GameBase::Empty && game.makeMove(move / size_, move % size_, player)) {
+        pv.push_back(move);
+        player = GameBase::opponent(player);
+        TranspositionTable::Entry entry;
+        move = table_->probe(keyOf(game, player) ^ TIMED_KEY_SALT, entry) ? entry.move : -1;
+    }
+    return pv;
+}
+
+/**
+ * @brief Длина ничейной партии: решатель доигрывает из позиции свои лучшие ходы до ничейного листа.
+ *
+ * Оценка ничьи не зависит от глубины, поэтому, в отличие от побед, её лист по оценке
+ * не восстановить. В вариантах со своим генератором ходов (UltimateGame) ничья
+ * наступает до заполнения поля, и число пустых клеток её не измеряет; после точного
+ * поиска узлы ничейного варианта уже в таблице, и каждый шаг — короткий поиск с окном
+ * вокруг ничьей. В остальных вариантах ничья — только полное поле.
+ * @return Полуходов до ничейного листа либо -1, если поиск прерван
+ */
+template <class GameT>
+int Solver<GameT>::drawDistance(GameT game, Cell player, int move) {
+    if constexpr (!HasMoveGenerator<GameT>::value)
+        return empties_;
+    int ply = 0;
+    while (!game.isDraw()) {
+        if (move < 0 || !game.makeMove(move / size_, move % size_, player))
+            return -1;
+        player = GameBase::opponent(player);
+        ++ply;
+        move = -1;
+        if (!game.isDraw() && (search(game, player, empties_ - ply, ply, -1, 1, &move) != 0 || aborted_))
+            return -1;
+    }
+    return ply;
+}
+
+/**
+ * @brief Рекурсивный negamax. Оценка возвращается с точки зрения ходящего.
+ *
+ * Победы оцениваются как WIN_SCORE - ply, чтобы предпочитать быстрые выигрыши
+ * и как можно дольше откладывать проигрыш.
+ */
+template <class GameT>
+int Solver<GameT>::search(GameT& game, Cell player, int depth, int ply,
+                          int alpha, int beta, int* bestMove) {
+    ++stats_.nodes;
+    ++searchNodes_;
+    TICTACTOE_COUNT(NodesSearched);
+    if (game.checkWinner() != GameBase::Empty)
+        return -(WIN_SCORE - ply);
+    if (empties_ == ply || (HasMoveGenerator<GameT>::value && game.isDraw()))
+        return 0;
+    PositionCache::Hit hit;
+    if (size_ * size_ - empties_ + ply <= cacheMoves_ && cache_->probe(game, player, hit) &&
+        hit.depth >= empties_ - ply) {
+        ++stats_.cacheHits;
+        TICTACTOE_COUNT(CacheHits);
+        if (bestMove)
+            *bestMove = hit.move;
+        return hit.value == 0 ? 0 : hit.value * (WIN_SCORE - ply - hit.distance);
+    }
+    // Проверяется в каждом узле, включая листья, иначе редкие проверки попадали бы только на листья
+    if ((limits_.maxNodes && searchNodes_ >= limits_.maxNodes) ||
+        (stop_ && searchNodes_ % STOP_CHECK_INTERVAL == 0 && stop_->load(std::memory_order_relaxed)) ||
+        (timed_ && searchNodes_ % TIME_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline_))
+        aborted_ = true;
+    if (depth == 0 || aborted_) {
+        limitHit_ = true;
+        return timed_ && !aborted_ ? evaluate(game, player) : 0;
+    }
+
+    const std::uint64_t key = keyOf(game, player) ^ (timed_ ? TIMED_KEY_SALT : 0);
+    TranspositionTable::Entry entry;
+    int ttMove = -1;
+    ++stats_.ttProbes;
+    if (table_->probe(key, entry)) {
+        ++stats_.ttHits;
+        TICTACTOE_COUNT(TtHits);
+        ttMove = entry.move;
+        if (entry.depth >= depth) {
+            const int score = fromTable(entry.score, ply);
+            if (entry.depth < empties_ - ply)
+                limitHit_ = true;
+            if (entry.bound == TranspositionTable::Exact || (entry.bound == TranspositionTable::Lower && score >= beta) ||
+                (entry.bound == TranspositionTable::Upper && score <= alpha)) {
+                if (bestMove)
+                    *bestMove = ttMove;
+                return score;
+            }
+        }
+    }
+
+    const int alphaOrig = alpha;
+    const Cell next = GameBase::opponent(player);
+    int best = -WIN_SCORE - 1;
+    int bestCell = -1;
+
+    const int pvMove = onPv_ && ply < static_cast<int>(pv_.size()) ? pv_[ply] : -1;
+    auto tryMove = [&](int cell) {
+        const bool onPv = onPv_;
+        onPv_ = onPv && cell == pvMove;
+        game.makeMove(cell / size_, cell % size_, player);
+        if (timed_ && threats_)
+            threats_->makeMove(cell, player);
+        const int score = -search(game, next, depth - 1, ply + 1, -beta, -alpha, nullptr);
+        if (timed_ && threats_)
+            threats_->unmakeMove(cell);
+        game.unmakeMove();
+        onPv_ = onPv;
+        if (score > best) {
+            best = score;
+            bestCell = cell;
+        }
+        if (score > alpha)
+            alpha = score;
+        return alpha >= beta || aborted_;
+    };
+
+    bool cutoff = false;
+    if (timed_) {
+        for (int cell : orderMoves(game, player, ply, ttMove))
+            if ((cutoff = tryMove(cell)))
+                break;
+        // Ход, вызвавший отсечение, вероятно хорош и в соседних ветвях
+        if (cutoff && !aborted_ && alpha >= beta)
+            history_[(player == GameBase::O) * size_ * size_ + bestCell] += depth * depth;
+    }
+    else {
+        if (ttMove >= 0 && isLegalMove(game, ttMove))
+            cutoff = tryMove(ttMove);
+        for (int i = 0; i < static_cast<int>(order_.size()) && !cutoff; ++i) {
+            const int cell = order_[i];
+            if (cell == ttMove || !isLegalMove(game, cell))
+                continue;
+            cutoff = tryMove(cell);
+        }
+    }
+
+    if (!aborted_) {
+        entry.score = static_cast<std::int16_t>(toTable(best, ply));
+        entry.move = static_cast<std::int16_t>(bestCell);
+        entry.depth = static_cast<std::int16_t>(depth);
+        entry.bound = best <= alphaOrig ? TranspositionTable::Upper
+                                        : (best >= beta ? TranspositionTable::Lower : TranspositionTable::Exact);
+        table_->store(key, entry);
+    }
+    if (bestMove)
+        *bestMove = bestCell;
+    return best;
+}
+
+/**
+ * @brief Переводит оценку выигрыша в форму, не зависящую от глубины узла.
+ */
+template <class GameT>
+int Solver<GameT>::toTable(int score, int ply) {
+    if (score > MATE_BOUND)
+        return score + ply;
+    if (score < -MATE_BOUND)
+        return score - ply;
+    return score;
+}
+
+/**
+ * @brief Обратное преобразование к toTable().
+ */
+template <class GameT>
+int Solver<GameT>::fromTable(int score, int ply) {
+    if (score > MATE_BOUND)
+        return score - ply;
+    if (score < -MATE_BOUND)
+        return score + ply;
+    return score;
+}
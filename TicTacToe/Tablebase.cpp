@@ -0,0 +1,121 @@
+/**
+ * @file Tablebase.cpp
+ * @brief Построение таблицы идеальной игры 3x3 на этапе компиляции.
+ */
+
+#include "Tablebase.h"
+
+#include <array>
+#include <bitset>
+
+namespace {
+
+// Упакованная запись: биты 0–3 — ход (15 — нет хода), 4–5 — оценка + 1,
+// 6–9 — расстояние до конца партии, бит 10 — позиция достижима.
+using Packed = std::uint16_t;
+using Table = std::array<Packed, Tablebase::INDEX_COUNT>;
+
+constexpr Packed NO_MOVE = 0xF;
+constexpr Packed REACHED = 1u << 10;
+
+constexpr std::array<int, Game::CELL_COUNT> POW3 = { 1, 3, 9, 27, 81, 243, 729, 2187, 6561 };
+
+constexpr Packed pack(int move, int value, int distance) {
+    return static_cast<Packed>((move < 0 ? NO_MOVE : move) | ((value + 1) << 4) | (distance << 6) | REACHED);
+}
+
+constexpr int packedMove(Packed p) { return (p & 0xF) == NO_MOVE ? -1 : (p & 0xF); }
+constexpr int packedValue(Packed p) { return ((p >> 4) & 0x3) - 1; }
+constexpr int packedDistance(Packed p) { return (p >> 6) & 0xF; }
+
+/**
+ * @brief Рекурсивно решает позицию с запоминанием в таблице.
+ *
+ * Из выигрышных продолжений выбирается самое быстрое, из проигрышных — самое долгое.
+ */
+constexpr Packed solve(Table& table, int index, Game::Bitboard xBits, Game::Bitboard oBits, bool xToMove) {
+    if (table[index] & REACHED)
+        return table[index];
+
+    Packed result = 0;
+    if (Game::hasLine(xBits) || Game::hasLine(oBits)) {
+        result = pack(-1, -1, 0);   // последний ход соперника собрал линию
+    }
+    else if ((xBits | oBits) == Game::FULL_BOARD) {
+        result = pack(-1, 0, 0);
+    }
+    else {
+        int bestMove = -1, bestValue = -2, bestDistance = 0;
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            const Game::Bitboard bit = static_cast<Game::Bitboard>(1u << cell);
+            if ((xBits | oBits) & bit)
+                continue;
+            const Packed child = xToMove
+                ? solve(table, index + POW3[cell], static_cast<Game::Bitboard>(xBits | bit), oBits, false)
+                : solve(table, index + 2 * POW3[cell], xBits, static_cast<Game::Bitboard>(oBits | bit), true);
+            const int value = -packedValue(child);
+            const int distance = packedDistance(child) + 1;
+            const bool better = value > bestValue ||
+                (value == bestValue && value > 0 && distance < bestDistance) ||
+                (value == bestValue && value < 0 && distance > bestDistance);
+            if (better) {
+                bestMove = cell;
+                bestValue = value;
+                bestDistance = distance;
+            }
+        }
+        result = pack(bestMove, bestValue, bestDistance);
+    }
+    table[index] = result;
+    return result;
+}
+
+constexpr Table buildTable() {
+    Table table{};
+    solve(table, 0, 0, 0, true);
+    return table;
+}
+
+constexpr Table TABLE = buildTable();
+
+} // namespace
+
+int Tablebase::index(const Game& game) {
+    const Game::Bitboard xBits = game.getBits(Game::X);
+    const Game::Bitboard oBits = game.getBits(Game::O);
+    int index = 0;
+    for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+        if (xBits & (1u << cell))
+            index += POW3[cell];
+        else if (oBits & (1u << cell))
+            index += 2 * POW3[cell];
+    }
+    return index;
+}
+
+Game Tablebase::position(int index) {
+    Game game;
+    for (int cell = 0; cell < Game::CELL_COUNT && index > 0; ++cell, index /= 3) {
+        if (index % 3 != 0)
+            game.makeMove(cell / Game::BOARD_SIZE, cell % Game::BOARD_SIZE, index % 3 == 1 ? Game::X : Game::O);
+    }
+    return game;
+}
+
+Tablebase::Entry Tablebase::lookup(int index) {
+    if (index < 0 || index >= INDEX_COUNT || !(TABLE[index] & REACHED))
+        return Entry{ -1, 0, 0, false };
+    const Packed packed = TABLE[index];
+    return Entry{ packedMove(packed), packedValue(packed), packedDistance(packed), true };
+}
+
+int Tablebase::bestMove(const Game& game) {
+    const Packed packed = TABLE[index(game)];
+    return (packed & REACHED) ? packedMove(packed) : -1;
+}
+
+Game::Cell Tablebase::sideToMove(const Game& game) {
+    const auto xCount = std::bitset<Game::CELL_COUNT>(game.getBits(Game::X)).count();
+    const auto oCount = std::bitset<Game::CELL_COUNT>(game.getBits(Game::O)).count();
+    return xCount == oCount ? Game::X : Game::O;
+}
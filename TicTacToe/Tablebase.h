@@ -0,0 +1,74 @@
+/**
+ * @file Tablebase.h
+ * @brief Таблица лучших ходов для всех позиций 3x3, вычисленная при компиляции.
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <cstdint>
+
+/**
+ * @brief Готовая таблица идеальной игры для классического поля 3x3.
+ *
+ * Позиция кодируется каноническим индексом в троичной системе:
+ * клетка y * 3 + x даёт разряд 3^(y * 3 + x) со значением 0 (пусто), 1 (X) или 2 (O).
+ * Ходящий игрок определяется по числу фигур (X ходит первым).
+ * Таблица строится constexpr-функцией по правилам Game, поэтому выбор хода —
+ * одно чтение из статического массива без поиска и без затрат при запуске.
+ */
+class Tablebase {
+public:
+    /**
+     * @brief Количество возможных индексов (3^9).
+     */
+    static constexpr int INDEX_COUNT = 19683;
+
+    /**
+     * @brief Количество позиций, достижимых из пустого поля.
+     */
+    static constexpr int REACHABLE_COUNT = 5478;
+
+    /**
+     * @brief Запись таблицы для одной позиции.
+     */
+    struct Entry {
+        int move;        /**< Лучший ход (индекс клетки) либо -1 для завершённой партии */
+        int value;       /**< Оценка для ходящего: 1 — выигрыш, 0 — ничья, -1 — проигрыш */
+        int distance;    /**< Число полуходов до конца партии при лучшей игре */
+        bool reachable;  /**< true, если позиция достижима из пустого поля */
+    };
+
+    /**
+     * @brief Вычисляет канонический индекс позиции.
+     * @param game Позиция
+     * @return Индекс в диапазоне [0, INDEX_COUNT)
+     */
+    static int index(const Game& game);
+
+    /**
+     * @brief Восстанавливает позицию по индексу.
+     * @param index Индекс в диапазоне [0, INDEX_COUNT)
+     * @return Позиция
+     */
+    static Game position(int index);
+
+    /**
+     * @brief Возвращает запись таблицы по индексу.
+     * @param index Индекс в диапазоне [0, INDEX_COUNT)
+     * @return Запись; для некорректного индекса reachable == false
+     */
+    static Entry lookup(int index);
+
+    /**
+     * @brief Лучший ход в позиции.
+     * @param game Позиция
+     * @return Индекс клетки либо -1, если партия завершена или позиция недостижима
+     */
+    static int bestMove(const Game& game);
+
+    /**
+     * @brief Игрок, который ходит в позиции (X ходит первым).
+     */
+    static Game::Cell sideToMove(const Game& game);
+};
@@ -0,0 +1,86 @@
+/**
+ * @file TaskScheduler.cpp
+ * @brief Реализация планировщика с перехватом работы.
+ */
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Очередь задач одного потока. Выравнивание исключает ложное разделение кэш-линий.
+ */
+struct alignas(64) WorkerQueue {
+    std::mutex mutex;
+    std::deque<int> tasks;
+
+    bool popBack(int& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+            return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    bool stealFront(int& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+            return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+} // namespace
+
+TaskScheduler::TaskScheduler(int threads)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {
+}
+
+void TaskScheduler::parallelFor(int tasks, const std::function<void(int task, int worker)>& body) const {
+    if (tasks <= 0)
+        return;
+    const int workers = std::min(threads_, tasks);
+
+    std::unique_ptr<WorkerQueue[]> queues(new WorkerQueue[workers]);
+    for (int w = 0; w < workers; ++w) {
+        const int begin = static_cast<int>(static_cast<long long>(tasks) * w / workers);
+        const int end = static_cast<int>(static_cast<long long>(tasks) * (w + 1) / workers);
+        for (int task = begin; task < end; ++task)
+            queues[w].tasks.push_back(task);
+    }
+
+    // Задачи не порождают новых, поэтому поток завершается, когда пусты все очереди
+    auto run = [&](int worker) {
+        int task;
+        for (;;) {
+            if (queues[worker].popBack(task)) {
+                body(task, worker);
+                continue;
+            }
+            bool stolen = false;
+            for (int i = 1; i < workers && !stolen; ++i)
+                stolen = queues[(worker + i) % workers].stealFront(task);
+            if (!stolen)
+                return;
+            body(task, worker);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (int w = 1; w < workers; ++w)
+        threads.emplace_back(run, w);
+    run(0);
+    for (auto& thread : threads)
+        thread.join();
+}
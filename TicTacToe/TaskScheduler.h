@@ -0,0 +1,38 @@
+/**
+ * @file TaskScheduler.h
+ * @brief Планировщик параллельных задач с перехватом работы (work stealing).
+ */
+
+#pragma once
+#include <functional>
+
+/**
+ * @brief Распределяет независимые задачи по потокам.
+ *
+ * Каждый поток получает собственную очередь с непрерывным диапазоном задач,
+ * берёт задачи с её конца, а опустев — перехватывает задачи из начала
+ * очередей других потоков. Вызывающий поток участвует в работе как поток 0.
+ */
+class TaskScheduler {
+public:
+    /**
+     * @brief Конструктор.
+     * @param threads Число потоков; 0 — по числу аппаратных ядер
+     */
+    explicit TaskScheduler(int threads = 0);
+
+    /**
+     * @brief Число потоков, на которых выполняются задачи.
+     */
+    int threadCount() const { return threads_; }
+
+    /**
+     * @brief Выполняет body(task, worker) для каждой задачи из [0, tasks) и ждёт завершения.
+     * @param tasks Количество задач
+     * @param body Функция задачи; worker — номер потока в диапазоне [0, threadCount())
+     */
+    void parallelFor(int tasks, const std::function<void(int task, int worker)>& body) const;
+
+private:
+    int threads_;
+};
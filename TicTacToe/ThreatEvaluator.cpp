@@ -0,0 +1,275 @@
+/**
+ * @file ThreatEvaluator.cpp
+ * @brief Таблицы образцов, инкрементальное обновление линий и поиск выигрыша четвёрками.
+ */
+
+#include "ThreatEvaluator.h"
+
+#include <algorithm>
+#include <bitset>
+
+namespace {
+
+int popcount(std::uint64_t bits) {
+    return static_cast<int>(std::bitset<64>(bits).count());
+}
+
+int lowestBit(std::uint64_t bits) {
+    int index = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief Образец окна из k + 1 клеток для игрока.
+ * @param stones Камни игрока
+ * @param blocked Клетки соперника и стенки
+ * @param k Длина выигрышной линии
+ */
+ThreatEvaluator::Pattern classify(std::uint64_t stones, std::uint64_t blocked, int k) {
+    const std::uint64_t first = (std::uint64_t(1) << k) - 1;     // клетки 0..k-1
+    const std::uint64_t second = first << 1;                      // клетки 1..k
+    const int inFirst = (blocked & first) ? -1 : popcount(stones & first);
+    const int inSecond = (blocked & second) ? -1 : popcount(stones & second);
+    const int best = std::max(inFirst, inSecond);
+
+    if (best == k)
+        return ThreatEvaluator::Five;
+    if (best == k - 1) {
+        const bool open = inFirst == k - 1 && inSecond == k - 1 && (first & ~stones) != (second & ~stones);
+        return open ? ThreatEvaluator::OpenFour : ThreatEvaluator::Four;
+    }
+    if (best == k - 2) {
+        // Оба конца окна свободны, а k - 2 камня стоят в середине
+        const std::uint64_t ends = 1 | (std::uint64_t(1) << k);
+        const bool open = inFirst == k - 2 && inSecond == k - 2 && !((stones | blocked) & ends);
+        return open ? ThreatEvaluator::OpenThree : ThreatEvaluator::Three;
+    }
+    if (best == k - 3 && best > 0)
+        return ThreatEvaluator::Two;
+    return ThreatEvaluator::NoPattern;
+}
+
+} // namespace
+
+ThreatEvaluator::ThreatEvaluator(int size, int winLength) : size_(size), k_(winLength), window_(winLength + 1) {
+    // Таблица образцов: индекс — биты X окна, затем биты O; стенка помечена в обеих масках
+    const int codes = 1 << window_;
+    scoreTable_.assign(std::size_t(codes) * codes, 0);
+    patternTable_.assign(std::size_t(codes) * codes, 0);
+    for (int x = 0; x < codes; ++x) {
+        for (int o = 0; o < codes; ++o) {
+            const std::uint64_t wall = std::uint64_t(x & o);
+            const std::uint64_t xs = std::uint64_t(x) & ~wall, os = std::uint64_t(o) & ~wall;
+            const Pattern forX = classify(xs, os | wall, k_);
+            const Pattern forO = classify(os, xs | wall, k_);
+            const std::size_t index = std::size_t(x) << window_ | std::size_t(o);
+            scoreTable_[index] = PATTERN_SCORES[forX] - PATTERN_SCORES[forO];
+            patternTable_[index] = static_cast<std::uint8_t>(forX | forO << 4);
+        }
+    }
+
+    // Линии четырёх направлений; короче k не участвуют
+    static constexpr int DIRECTIONS[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    places_.assign(std::size_t(size) * size, {});
+    for (auto& place : places_)
+        place.fill({ -1, 0 });
+    for (int d = 0; d < 4; ++d) {
+        const int dy = DIRECTIONS[d][0], dx = DIRECTIONS[d][1];
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                // Начало линии: предыдущая клетка вне поля
+                const int py = y - dy, px = x - dx;
+                if (py >= 0 && px >= 0 && px < size)
+                    continue;
+                std::vector<int> cells;
+                for (int cy = y, cx = x; cy < size && cx >= 0 && cx < size; cy += dy, cx += dx)
+                    cells.push_back(cy * size + cx);
+                if (static_cast<int>(cells.size()) < k_)
+                    continue;
+                const int line = static_cast<int>(lines_.size());
+                for (int pos = 0; pos < static_cast<int>(cells.size()); ++pos)
+                    places_[cells[pos]][d] = { line, pos };
+                lines_.push_back({ 0, 0, static_cast<int>(cells.size()) });
+                lineCells_.push_back(std::move(cells));
+            }
+        }
+    }
+    clear();
+}
+
+void ThreatEvaluator::clear() {
+    cells_.assign(std::size_t(size_) * size_, GameBase::Empty);
+    for (Line& line : lines_) {
+        const std::uint64_t walls = 1 | std::uint64_t(1) << (line.length + 1);
+        line.x = walls;
+        line.o = walls;
+    }
+    score_ = 0;
+    for (auto& counts : counts_)
+        counts.fill(0);
+    for (const Line& line : lines_)
+        for (int start = 0; start + k_ <= line.length + 1; ++start) {
+            score_ += windowValue(line, start);
+            countWindow(line, start, 1);
+        }
+}
+
+int ThreatEvaluator::windowValue(const Line& line, int start) const {
+    const std::uint64_t mask = (std::uint64_t(1) << window_) - 1;
+    return scoreTable_[((line.x >> start) & mask) << window_ | ((line.o >> start) & mask)];
+}
+
+void ThreatEvaluator::countWindow(const Line& line, int start, int sign) {
+    const std::uint64_t mask = (std::uint64_t(1) << window_) - 1;
+    const std::uint8_t patterns = patternTable_[((line.x >> start) & mask) << window_ | ((line.o >> start) & mask)];
+    counts_[0][patterns & 0xF] += sign;
+    counts_[1][patterns >> 4] += sign;
+}
+
+/**
+ * @brief Меняет клетку и пересчитывает только окна, которые её содержат.
+ */
+void ThreatEvaluator::updateCell(int cell, Cell player, bool place) {
+    for (const Place& at : places_[cell]) {
+        if (at.line < 0)
+            continue;
+        Line& line = lines_[at.line];
+        const int bit = at.pos + 1;
+        const int first = std::max(0, bit - k_);
+        const int last = std::min(bit, line.length + 1 - k_);
+        for (int start = first; start <= last; ++start) {
+            score_ -= windowValue(line, start);
+            countWindow(line, start, -1);
+        }
+        std::uint64_t& mask = player == GameBase::X ? line.x : line.o;
+        if (place)
+            mask |= std::uint64_t(1) << bit;
+        else
+            mask &= ~(std::uint64_t(1) << bit);
+        for (int start = first; start <= last; ++start) {
+            score_ += windowValue(line, start);
+            countWindow(line, start, 1);
+        }
+    }
+    cells_[cell] = static_cast<std::uint8_t>(place ? player : GameBase::Empty);
+}
+
+void ThreatEvaluator::makeMove(int cell, Cell player) {
+    updateCell(cell, player, true);
+}
+
+void ThreatEvaluator::unmakeMove(int cell) {
+    updateCell(cell, at(cell), false);
+}
+
+int ThreatEvaluator::evaluateFull(Cell player) const {
+    int score = 0;
+    for (const Line& line : lines_)
+        for (int start = 0; start + k_ <= line.length + 1; ++start)
+            score += windowValue(line, start);
+    return player == GameBase::X ? score : -score;
+}
+
+void ThreatEvaluator::winningCells(Cell player, std::vector<int>& cells, int limit) const {
+    cells.clear();
+    const std::uint64_t window = (std::uint64_t(1) << k_) - 1;
+    for (std::size_t l = 0; l < lines_.size(); ++l) {
+        const Line& line = lines_[l];
+        const std::uint64_t stones = player == GameBase::X ? line.x : line.o;
+        const std::uint64_t blocked = player == GameBase::X ? line.o : line.x;
+        // Окна из k клеток внутри поля: биты 1..length
+        for (int start = 1; start + k_ <= line.length + 1; ++start) {
+            const std::uint64_t mask = window << start;
+            if ((blocked & mask) || popcount(stones & mask) != k_ - 1)
+                continue;
+            const int cell = lineCells_[l][lowestBit(mask & ~stones) - 1];
+            if (std::find(cells.begin(), cells.end(), cell) == cells.end()) {
+                cells.push_back(cell);
+                if (static_cast<int>(cells.size()) >= limit)
+                    return;
+            }
+        }
+    }
+}
+
+ThreatEvaluator::VcfResult ThreatEvaluator::findVcf(Cell attacker, int maxDepth, std::uint64_t maxNodes) {
+    VcfResult result;
+    result.win = vcf(attacker, maxDepth, maxNodes, result);
+    if (!result.win)
+        result.line.clear();
+    return result;
+}
+
+/**
+ * @brief Рекурсия поиска: ход атакующего с угрозой пятёрки, затем единственная защита.
+ *
+ * Ветвь засчитывается, только если защита не может выиграть сама: у соперника
+ * нет готовой четвёрки, а вынужденный ответ не собирает его линию.
+ */
+bool ThreatEvaluator::vcf(Cell attacker, int depth, std::uint64_t maxNodes, VcfResult& result) {
+    const Cell defender = GameBase::opponent(attacker);
+    std::vector<int> threats;
+    winningCells(attacker, threats, 1);
+    if (!threats.empty()) {
+        result.line.push_back(threats.front());
+        return true;
+    }
+    if (depth == 0)
+        return false;
+    winningCells(defender, threats, 1);
+    if (!threats.empty())
+        return false;
+
+    // Кандидаты: пустые клетки окон, где не хватает двух камней атакующего
+    std::vector<int> candidates;
+    const std::uint64_t window = (std::uint64_t(1) << k_) - 1;
+    for (std::size_t l = 0; l < lines_.size(); ++l) {
+        const Line& line = lines_[l];
+        const std::uint64_t stones = attacker == GameBase::X ? line.x : line.o;
+        const std::uint64_t blocked = attacker == GameBase::X ? line.o : line.x;
+        for (int start = 1; start + k_ <= line.length + 1; ++start) {
+            const std::uint64_t mask = window << start;
+            if ((blocked & mask) || popcount(stones & mask) != k_ - 2)
+                continue;
+            for (std::uint64_t empty = mask & ~stones; empty; empty &= empty - 1) {
+                const int cell = lineCells_[l][lowestBit(empty) - 1];
+                if (std::find(candidates.begin(), candidates.end(), cell) == candidates.end())
+                    candidates.push_back(cell);
+            }
+        }
+    }
+
+    const int defenderSide = defender == GameBase::O;
+    for (int cell : candidates) {
+        if (maxNodes && result.nodes >= maxNodes)
+            return false;
+        ++result.nodes;
+        makeMove(cell, attacker);
+        winningCells(attacker, threats, 2);
+        bool win = false;
+        if (threats.size() >= 2) {
+            // Две клетки до пятёрки: защита закроет одну, атакующий займёт другую
+            result.line.insert(result.line.end(), { cell, threats[0], threats[1] });
+            win = true;
+        }
+        else if (threats.size() == 1) {
+            const int reply = threats.front();
+            makeMove(reply, defender);
+            const std::size_t mark = result.line.size();
+            result.line.push_back(cell);
+            result.line.push_back(reply);
+            win = counts_[defenderSide][Five] == 0 && vcf(attacker, depth - 1, maxNodes, result);
+            if (!win)
+                result.line.resize(mark);
+            unmakeMove(reply);
+        }
+        unmakeMove(cell);
+        if (win)
+            return true;
+    }
+    return false;
+}
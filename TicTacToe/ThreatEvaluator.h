@@ -0,0 +1,195 @@
+/**
+ * @file ThreatEvaluator.h
+ * @brief Инкрементальная оценка позиции по образцам на линиях и поиск выигрыша сериями четвёрок.
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Оценка позиции "k в ряд" по образцам в окнах вдоль линий.
+ *
+ * Каждая линия поля (строка, столбец, диагональ длиной не меньше k) хранится
+ * двумя битовыми масками — камни X и камни O; края линии помечены
+ * стенкой, которая закрывает образцы обоим игрокам. Окно из k + 1 клеток
+ * кодируется парой масок и по заранее построенной таблице сразу даёт
+ * образец для каждого игрока (пятёрка, открытая и закрытая четвёрка,
+ * открытая и закрытая тройка с разрывами, двойка) и вклад в оценку.
+ *
+ * makeMove()/unmakeMove() меняют только окна, содержащие изменённую
+ * клетку, на четырёх линиях через неё: не больше 4 * (k + 1) обращений
+ * к таблице вместо просмотра всего поля. Счётчики образцов считают окна,
+ * поэтому одна фигура может попасть в несколько соседних окон.
+ *
+ * findVcf() ищет выигрыш непрерывными четвёрками: каждый ход атакующего
+ * создаёт угрозу пятёрки, у защиты единственный ответ.
+ */
+class ThreatEvaluator {
+public:
+    using Cell = GameBase::Cell;
+
+    /**
+     * @brief Образец в окне с точки зрения одного игрока (по возрастанию силы).
+     */
+    enum Pattern : std::uint8_t {
+        NoPattern,
+        Two,            /**< k - 3 камня без помех */
+        Three,          /**< k - 2 камня, окно закрыто с одной стороны */
+        OpenThree,      /**< k - 2 камня, оба конца окна свободны */
+        Four,           /**< k - 1 камень: одна клетка до пятёрки */
+        OpenFour,       /**< Две разные клетки до пятёрки */
+        Five,           /**< Собранная линия */
+        PATTERN_COUNT
+    };
+
+    /**
+     * @brief Наибольшая поддерживаемая длина линии (таблица на 4^(k+1) окон).
+     */
+    static constexpr int MAX_WIN_LENGTH = 8;
+
+    /**
+     * @brief Наибольшая поддерживаемая сторона поля (линия с двумя стенками в 64 битах).
+     */
+    static constexpr int MAX_SIZE = 62;
+
+    /**
+     * @brief Проверяет, поддерживается ли поле.
+     */
+    static bool supports(int size, int winLength) {
+        return size >= 1 && size <= MAX_SIZE && winLength >= 3 && winLength <= MAX_WIN_LENGTH && winLength <= size;
+    }
+
+    /**
+     * @brief Результат поиска выигрыша четвёрками.
+     */
+    struct VcfResult {
+        bool win = false;               /**< Выигрыш найден */
+        std::vector<int> line;          /**< Ходы атакующего и вынужденные ответы; последний ход выигрывает */
+        std::uint64_t nodes = 0;        /**< Просмотренные ходы атакующего */
+    };
+
+    /**
+     * @brief Конструктор для пустого поля.
+     * @param size Сторона поля
+     * @param winLength Длина выигрышной линии; supports(size, winLength) должно быть true
+     */
+    ThreatEvaluator(int size, int winLength);
+
+    /**
+     * @brief Сторона поля.
+     */
+    int size() const { return size_; }
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    int winLength() const { return k_; }
+
+    /**
+     * @brief Очищает поле.
+     */
+    void clear();
+
+    /**
+     * @brief Переносит позицию игры (поле того же размера).
+     */
+    template <class GameT>
+    void reset(const GameT& game) {
+        clear();
+        for (int y = 0; y < size_; ++y)
+            for (int x = 0; x < size_; ++x)
+                if (game.getCell(y, x) != GameBase::Empty)
+                    makeMove(y * size_ + x, game.getCell(y, x));
+    }
+
+    /**
+     * @brief Ставит камень в свободную клетку.
+     */
+    void makeMove(int cell, Cell player);
+
+    /**
+     * @brief Убирает камень из клетки.
+     */
+    void unmakeMove(int cell);
+
+    /**
+     * @brief Содержимое клетки.
+     */
+    Cell at(int cell) const { return static_cast<Cell>(cells_[cell]); }
+
+    /**
+     * @brief Оценка позиции для игрока; положительная — в его пользу.
+     */
+    int evaluate(Cell player) const { return player == GameBase::X ? score_ : -score_; }
+
+    /**
+     * @brief Та же оценка полным просмотром всех окон (для проверки и сравнения скорости).
+     */
+    int evaluateFull(Cell player) const;
+
+    /**
+     * @brief Число окон с образцом у игрока.
+     */
+    int patternCount(Cell player, Pattern pattern) const { return counts_[player == GameBase::O][pattern]; }
+
+    /**
+     * @brief Клетки, которые немедленно дают игроку линию.
+     * @param player Игрок
+     * @param cells Найденные клетки без повторов
+     * @param limit Поиск прекращается после стольких клеток
+     */
+    void winningCells(Cell player, std::vector<int>& cells, int limit = 2) const;
+
+    /**
+     * @brief Ищет выигрыш непрерывными четвёрками.
+     * @param attacker Игрок, который ходит и атакует
+     * @param maxDepth Наибольшее число ходов атакующего
+     * @param maxNodes Ограничение числа узлов (0 — без ограничения)
+     * @return Найденная выигрывающая последовательность
+     */
+    VcfResult findVcf(Cell attacker, int maxDepth = 12, std::uint64_t maxNodes = 200000);
+
+    /**
+     * @brief Вклад образцов в оценку.
+     */
+    static constexpr std::array<int, PATTERN_COUNT> PATTERN_SCORES = { 0, 10, 40, 300, 500, 5000, 100000 };
+
+private:
+    /**
+     * @brief Линия поля: маски с битом p + 1 для клетки p, биты 0 и length + 1 — стенки.
+     */
+    struct Line {
+        std::uint64_t x;
+        std::uint64_t o;
+        int length;
+    };
+
+    /**
+     * @brief Положение клетки на линии одного направления (line < 0 — линия короче k).
+     */
+    struct Place {
+        int line;
+        int pos;
+    };
+
+    int windowValue(const Line& line, int start) const;
+    void countWindow(const Line& line, int start, int sign);
+    void updateCell(int cell, Cell player, bool place);
+    bool vcf(Cell attacker, int depth, std::uint64_t maxNodes, VcfResult& result);
+
+    int size_;
+    int k_;
+    int window_;                                /**< k + 1 */
+    std::vector<std::uint8_t> cells_;
+    std::vector<Line> lines_;
+    std::vector<std::array<Place, 4>> places_;  /**< [клетка][направление] */
+    std::vector<std::vector<int>> lineCells_;   /**< Клетки каждой линии по порядку */
+    std::vector<int> scoreTable_;               /**< Оценка окна для X минус оценка для O */
+    std::vector<std::uint8_t> patternTable_;    /**< Образец X в младших 4 битах, O — в старших */
+    std::array<std::array<int, PATTERN_COUNT>, 2> counts_{};
+    int score_ = 0;
+};
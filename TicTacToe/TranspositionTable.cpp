@@ -0,0 +1,175 @@
+/**
+ * @file TranspositionTable.cpp
+ * @brief Реализация общей таблицы транспозиций.
+ */
+
+#include "TranspositionTable.h"
+
+namespace {
+
+// Раскладка упакованной записи: оценка, ход, глубина, тип оценки, поколение
+constexpr int MOVE_SHIFT = 16;
+constexpr int DEPTH_SHIFT = 32;
+constexpr int BOUND_SHIFT = 48;
+constexpr int GENERATION_SHIFT = 56;
+
+std::uint8_t boundOf(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> BOUND_SHIFT);
+}
+
+std::uint8_t generationOf(std::uint64_t data) {
+    return static_cast<std::uint8_t>(data >> GENERATION_SHIFT);
+}
+
+std::int16_t depthOf(std::uint64_t data) {
+    return static_cast<std::int16_t>(data >> DEPTH_SHIFT);
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(std::size_t megabytes)
+    : stats_(new StatStripe[STAT_STRIPES]) {
+    resize(megabytes);
+}
+
+/**
+ * @brief Выделяет наибольшую степень двойки корзин, помещающуюся в бюджет (не меньше одной).
+ */
+void TranspositionTable::resize(std::size_t megabytes) {
+    const std::size_t budget = megabytes * 1024 * 1024;
+    std::size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= budget)
+        count *= 2;
+    buckets_.reset(new Bucket[count]);
+    mask_ = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+        for (Slot& slot : buckets_[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (int i = 0; i < STAT_STRIPES; ++i) {
+        StatStripe& stripe = stats_[i];
+        stripe.probes.store(0, std::memory_order_relaxed);
+        stripe.hits.store(0, std::memory_order_relaxed);
+        stripe.stores.store(0, std::memory_order_relaxed);
+        stripe.collisions.store(0, std::memory_order_relaxed);
+        stripe.overwrites.store(0, std::memory_order_relaxed);
+    }
+    generation_.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t TranspositionTable::pack(const Entry& entry, std::uint8_t generation) {
+    return static_cast<std::uint16_t>(entry.score) |
+           static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.move)) << MOVE_SHIFT |
+           static_cast<std::uint64_t>(static_cast<std::uint16_t>(entry.depth)) << DEPTH_SHIFT |
+           static_cast<std::uint64_t>(entry.bound) << BOUND_SHIFT |
+           static_cast<std::uint64_t>(generation) << GENERATION_SHIFT;
+}
+
+TranspositionTable::Entry TranspositionTable::unpack(std::uint64_t data) {
+    Entry entry;
+    entry.score = static_cast<std::int16_t>(data);
+    entry.move = static_cast<std::int16_t>(data >> MOVE_SHIFT);
+    entry.depth = depthOf(data);
+    entry.bound = static_cast<Bound>(boundOf(data));
+    return entry;
+}
+
+/**
+ * @brief Номер блока счётчиков для текущего потока: потоки получают блоки по очереди.
+ */
+int TranspositionTable::stripeIndex() {
+    static std::atomic<int> next{ 0 };
+    thread_local const int index = next.fetch_add(1, std::memory_order_relaxed) % STAT_STRIPES;
+    return index;
+}
+
+/**
+ * @brief Чтение слота принимается, только если key ^ data совпадает с сохранённой проверкой.
+ */
+bool TranspositionTable::probe(std::uint64_t key, Entry& entry) const {
+    StatStripe& stats = stats_[stripeIndex()];
+    stats.probes.fetch_add(1, std::memory_order_relaxed);
+    const Bucket& bucket = buckets_[key & mask_];
+    for (const Slot& slot : bucket.slots) {
+        const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && boundOf(data) != NoBound) {
+            entry = unpack(data);
+            stats.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Записывает позицию в её слот, в свободный слот, в самый слабый слот
+ *        с приоритетом глубины либо в слот постоянной замены.
+ */
+void TranspositionTable::store(std::uint64_t key, const Entry& entry) {
+    StatStripe& stats = stats_[stripeIndex()];
+    stats.stores.fetch_add(1, std::memory_order_relaxed);
+    Bucket& bucket = buckets_[key & mask_];
+    const std::uint8_t generation = generation_.load(std::memory_order_relaxed);
+
+    Slot* target = nullptr;
+    Slot* empty = nullptr;
+    int victim = -1;
+    int victimWeight = 0;
+    for (int i = 0; i < BUCKET_SLOTS; ++i) {
+        const std::uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+        const std::uint64_t check = bucket.slots[i].check.load(std::memory_order_relaxed);
+        if (boundOf(data) == NoBound) {
+            if (!empty)
+                empty = &bucket.slots[i];
+            continue;
+        }
+        if ((check ^ data) == key) {
+            target = &bucket.slots[i];
+            stats.overwrites.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+        if (i == BUCKET_SLOTS - 1)
+            continue;
+        // Записи прошлых поисков слабее любой записи текущего
+        const int weight = depthOf(data) + (generationOf(data) == generation ? 0x10000 : 0);
+        if (victim < 0 || weight < victimWeight) {
+            victim = i;
+            victimWeight = weight;
+        }
+    }
+
+    // Свой слот ищется по всей корзине, и только потом занимается свободный
+    if (!target && empty)
+        target = empty;
+    if (!target) {
+        if (victim >= 0 && (victimWeight < 0x10000 || entry.depth + 0x10000 >= victimWeight))
+            target = &bucket.slots[victim];
+        else
+            target = &bucket.slots[BUCKET_SLOTS - 1];
+        stats.collisions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const std::uint64_t data = pack(entry, generation);
+    target->data.store(data, std::memory_order_relaxed);
+    target->check.store(key ^ data, std::memory_order_relaxed);
+}
+
+TranspositionStats TranspositionTable::stats() const {
+    TranspositionStats total;
+    for (int i = 0; i < STAT_STRIPES; ++i) {
+        const StatStripe& stripe = stats_[i];
+        total.probes += stripe.probes.load(std::memory_order_relaxed);
+        total.hits += stripe.hits.load(std::memory_order_relaxed);
+        total.stores += stripe.stores.load(std::memory_order_relaxed);
+        total.collisions += stripe.collisions.load(std::memory_order_relaxed);
+        total.overwrites += stripe.overwrites.load(std::memory_order_relaxed);
+    }
+    return total;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file TranspositionTable.h
+ * @brief Общая таблица транспозиций без блокировок для многопоточного поиска.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief Счётчики таблицы транспозиций.
+ */
+struct TranspositionStats {
+    std::uint64_t probes = 0;       /**< Обращения на чтение */
+    std::uint64_t hits = 0;         /**< Найденные позиции */
+    std::uint64_t stores = 0;       /**< Записи */
+    std::uint64_t collisions = 0;   /**< Записи, вытеснившие другую позицию */
+    std::uint64_t overwrites = 0;   /**< Записи поверх той же позиции */
+
+    /**
+     * @brief Доля успешных обращений.
+     */
+    double hitRate() const { return probes ? static_cast<double>(hits) / probes : 0.0; }
+};
+
+/**
+ * @brief Таблица транспозиций фиксированного размера, общая для всех потоков поиска.
+ *
+ * Таблица разбита на корзины по 64 байта (одна кэш-линия), в каждой корзине
+ * четыре слота. Слот — два атомарных 64-битных слова: упакованные данные и
+ * ключ, сложенный с данными по XOR. Запись и чтение выполняются без
+ * блокировок; если два потока одновременно пишут один слот и слова
+ * перемешались, проверка key ^ data не сходится и чтение считается промахом,
+ * поэтому разорванная запись никогда не возвращается.
+ *
+ * Замещение: первые три слота корзины хранят самые глубокие результаты
+ * (вытесняется самый мелкий или оставшийся от прошлого поиска), последний
+ * слот перезаписывается всегда.
+ *
+ * clear() и resize() нельзя вызывать одновременно с поиском.
+ */
+class TranspositionTable {
+public:
+    /**
+     * @brief Тип оценки в записи.
+     */
+    enum Bound : std::uint8_t { NoBound, Exact, Lower, Upper };
+
+    /**
+     * @brief Распакованная запись.
+     */
+    struct Entry {
+        std::int16_t score = 0;     /**< Оценка */
+        std::int16_t move = -1;     /**< Лучший ход либо -1 */
+        std::int16_t depth = -1;    /**< Глубина, на которой получена оценка */
+        Bound bound = NoBound;      /**< Тип оценки */
+    };
+
+    /**
+     * @brief Число слотов в корзине.
+     */
+    static constexpr int BUCKET_SLOTS = 4;
+
+    /**
+     * @brief Конструктор.
+     * @param megabytes Бюджет памяти; число корзин округляется вниз до степени двойки
+     */
+    explicit TranspositionTable(std::size_t megabytes = 16);
+
+    /**
+     * @brief Перевыделяет таблицу под новый бюджет памяти и очищает её.
+     */
+    void resize(std::size_t megabytes);
+
+    /**
+     * @brief Очищает таблицу и счётчики.
+     */
+    void clear();
+
+    /**
+     * @brief Начинает новый поиск: записи прошлых поисков вытесняются в первую очередь.
+     *
+     * Общую таблицу продвигает её владелец между пачками поисков, а не каждый
+     * решатель: иначе параллельные поиски старили бы записи друг друга.
+     */
+    void newSearch() { generation_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Ищет позицию.
+     * @param key Ключ позиции
+     * @param entry Найденная запись (изменяется только при успехе)
+     * @return true, если позиция найдена
+     */
+    bool probe(std::uint64_t key, Entry& entry) const;
+
+    /**
+     * @brief Сохраняет позицию.
+     * @param key Ключ позиции
+     * @param entry Запись
+     */
+    void store(std::uint64_t key, const Entry& entry);
+
+    /**
+     * @brief Число корзин.
+     */
+    std::size_t bucketCount() const { return mask_ + 1; }
+
+    /**
+     * @brief Занимаемая память в байтах.
+     */
+    std::size_t bytes() const { return bucketCount() * sizeof(Bucket); }
+
+    /**
+     * @brief Сумма счётчиков всех потоков.
+     */
+    TranspositionStats stats() const;
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> check;   // key ^ data
+        std::atomic<std::uint64_t> data;
+    };
+
+    struct alignas(64) Bucket {
+        Slot slots[BUCKET_SLOTS];
+    };
+
+    // Счётчики разнесены по кэш-линиям, чтобы потоки не делили одну линию
+    static constexpr int STAT_STRIPES = 64;
+
+    struct alignas(64) StatStripe {
+        std::atomic<std::uint64_t> probes{ 0 };
+        std::atomic<std::uint64_t> hits{ 0 };
+        std::atomic<std::uint64_t> stores{ 0 };
+        std::atomic<std::uint64_t> collisions{ 0 };
+        std::atomic<std::uint64_t> overwrites{ 0 };
+    };
+
+    static std::uint64_t pack(const Entry& entry, std::uint8_t generation);
+    static Entry unpack(std::uint64_t data);
+    static int stripeIndex();
+
+    std::unique_ptr<Bucket[]> buckets_;
+    std::size_t mask_ = 0;
+    std::atomic<std::uint8_t> generation_{ 0 };
+    mutable std::unique_ptr<StatStripe[]> stats_;
+};
@@ -0,0 +1,167 @@
+/**
+ * @file UltimateGame.cpp
+ * @brief Реализация правил Ultimate tic-tac-toe.
+ */
+
+#include "UltimateGame.h"
+
+namespace {
+
+const auto& TABLES = detail::ULTIMATE_TABLES;
+
+} // namespace
+
+bool UltimateGame::makeMove(int y, int x, Cell player) {
+    if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE || (player != X && player != O))
+        return false;
+    const int cell = y * BOARD_SIZE + x;
+    if (!isLegal(cell))
+        return false;
+    apply(cell, player);
+    TICTACTOE_COUNT(MovesApplied);
+    return true;
+}
+
+bool UltimateGame::unmakeMove() {
+    if (count_ == 0)
+        return false;
+    const MoveRecord& record = history_[--count_];
+    const int board = TABLES.board[record.cell];
+    const Bitboard bit = static_cast<Bitboard>(1u << TABLES.local[record.cell]);
+    const Cell player = static_cast<Cell>(record.player);
+    if (player == X)
+        xBits_[board] &= static_cast<Bitboard>(~bit);
+    else
+        oBits_[board] &= static_cast<Bitboard>(~bit);
+    if (record.closedBoard) {
+        const Bitboard boardBit = static_cast<Bitboard>(~(1u << board));
+        closed_ &= boardBit;
+        metaX_ &= boardBit;
+        metaO_ &= boardBit;
+        winner_ = Empty;    // партия кончается на первой линии большого поля, значит, её собрал этот ход
+    }
+    hash_ ^= ZOBRIST[2 * record.cell + (player == O)] ^ activeKey(active_) ^ activeKey(record.active);
+    active_ = record.active;
+    return true;
+}
+
+void UltimateGame::reset() {
+    xBits_.fill(0);
+    oBits_.fill(0);
+    metaX_ = 0;
+    metaO_ = 0;
+    closed_ = 0;
+    active_ = ANY_BOARD;
+    count_ = 0;
+    winner_ = Empty;
+    hash_ = 0;
+}
+
+GameBase::Cell UltimateGame::getCell(int y, int x) const {
+    if (x < 0 || x >= BOARD_SIZE || y < 0 || y >= BOARD_SIZE)
+        return Empty;
+    const int cell = y * BOARD_SIZE + x;
+    const int board = TABLES.board[cell];
+    const Bitboard bit = static_cast<Bitboard>(1u << TABLES.local[cell]);
+    if (xBits_[board] & bit)
+        return X;
+    return (oBits_[board] & bit) ? O : Empty;
+}
+
+GameBase::Cell UltimateGame::boardWinner(int board) const {
+    if ((metaX_ >> board) & 1)
+        return X;
+    return ((metaO_ >> board) & 1) ? O : Empty;
+}
+
+bool UltimateGame::isLegal(int cell) const {
+    if (cell < 0 || cell >= CELL_COUNT || winner_ != Empty)
+        return false;
+    const int board = TABLES.board[cell];
+    if ((active_ != ANY_BOARD && active_ != board) || ((closed_ >> board) & 1))
+        return false;
+    return !((xBits_[board] | oBits_[board]) & (1u << TABLES.local[cell]));
+}
+
+int UltimateGame::legalMoves(int* moves) const {
+    if (winner_ != Empty)
+        return 0;
+    int count = 0;
+    const int first = active_ == ANY_BOARD ? 0 : active_;
+    const int last = active_ == ANY_BOARD ? BOARD_COUNT - 1 : active_;
+    for (int board = first; board <= last; ++board) {
+        if ((closed_ >> board) & 1)
+            continue;
+        unsigned free = ~(xBits_[board] | oBits_[board]) & FULL_BOARD;
+        if (!moves) {
+            count += TABLES.count[free];
+            continue;
+        }
+        for (; free; free &= free - 1)
+            moves[count++] = TABLES.cell[board][TABLES.lowest[free]];
+    }
+    return count;
+}
+
+int UltimateGame::evaluate(Cell player) const {
+    // Веса: выигранное поле, две выигранные клетки линии большого поля, две и одна фигура в линии малого
+    static constexpr int BOARD_WON = 40;
+    static constexpr int CENTRE_BONUS = 10;
+    static constexpr int META_TWO = 150;
+    static constexpr int LOCAL_TWO = 6;
+    static constexpr int LOCAL_ONE = 1;
+
+    int score = 0;
+    for (int board = 0; board < BOARD_COUNT; ++board) {
+        const int weight = board == 4 ? 2 : 1;
+        if ((metaX_ >> board) & 1) {
+            score += BOARD_WON + (board == 4) * CENTRE_BONUS;
+            continue;
+        }
+        if ((metaO_ >> board) & 1) {
+            score -= BOARD_WON + (board == 4) * CENTRE_BONUS;
+            continue;
+        }
+        if ((closed_ >> board) & 1)
+            continue;
+        for (Bitboard mask : Game::WIN_MASKS) {
+            const int xs = TABLES.count[xBits_[board] & mask];
+            const int os = TABLES.count[oBits_[board] & mask];
+            if (os == 0 && xs > 0)
+                score += weight * (xs == 2 ? LOCAL_TWO : LOCAL_ONE);
+            else if (xs == 0 && os > 0)
+                score -= weight * (os == 2 ? LOCAL_TWO : LOCAL_ONE);
+        }
+    }
+    // Линии большого поля, которые ещё можно собрать
+    const Bitboard drawn = static_cast<Bitboard>(closed_ & ~(metaX_ | metaO_));
+    for (Bitboard mask : Game::WIN_MASKS) {
+        if (mask & drawn)
+            continue;
+        const int xs = TABLES.count[metaX_ & mask];
+        const int os = TABLES.count[metaO_ & mask];
+        if (os == 0 && xs == 2)
+            score += META_TWO;
+        else if (xs == 0 && os == 2)
+            score -= META_TWO;
+    }
+    return player == O ? -score : score;
+}
+
+std::uint64_t UltimateGame::canonicalHash(int* symmetry) const {
+    std::uint64_t best = 0;
+    int bestSymmetry = 0;
+    for (int s = 0; s < SYMMETRY_COUNT; ++s) {
+        // Симметрия большого поля переводит малые поля в малые поля, а клетки поля — в клетки образа
+        std::uint64_t hash = active_ == ANY_BOARD ? 0 : activeKey(transformCell(active_, 3, s));
+        for (int i = 0; i < count_; ++i)
+            hash ^= ZOBRIST[2 * transformCell(history_[i].cell, BOARD_SIZE, s) + (history_[i].player == O)];
+        if (s == 0 || hash < best) {
+            best = hash;
+            bestSymmetry = s;
+        }
+    }
+    if (symmetry)
+        *symmetry = bestSymmetry;
+    return best;
+}
@@ -0,0 +1,317 @@
+/**
+ * @file UltimateGame.h
+ * @brief Ultimate tic-tac-toe: поле 3x3 из малых полей 3x3.
+ */
+
+#pragma once
+#include "Game.h"
+
+#include <array>
+#include <cstdint>
+
+namespace detail {
+
+/**
+ * @brief Таблицы масок 3x3 и нумерации клеток UltimateGame.
+ */
+struct UltimateTables {
+    std::array<bool, 512> line{};               /**< Маска содержит линию (Game::hasLine) */
+    std::array<std::uint8_t, 512> count{};      /**< Число единичных битов */
+    std::array<std::uint8_t, 512> lowest{};     /**< Номер младшего бита */
+    std::array<std::array<std::uint8_t, 9>, 512> select{};  /**< Номер i-го по старшинству единичного бита */
+    std::array<std::uint8_t, 81> board{};       /**< Малое поле клетки */
+    std::array<std::uint8_t, 81> local{};       /**< Клетка внутри малого поля */
+    std::array<std::array<std::uint8_t, 9>, 9> cell{};   /**< Клетка большого поля по (поле, клетка) */
+};
+
+constexpr UltimateTables makeUltimateTables() {
+    UltimateTables t{};
+    for (int mask = 0; mask < 512; ++mask) {
+        t.line[mask] = Game::hasLine(static_cast<Game::Bitboard>(mask));
+        for (int bit = 8; bit >= 0; --bit)
+            if (mask & (1 << bit))
+                t.lowest[mask] = static_cast<std::uint8_t>(bit);
+        for (int bit = 0; bit < 9; ++bit)
+            if (mask & (1 << bit))
+                t.select[mask][t.count[mask]++] = static_cast<std::uint8_t>(bit);
+    }
+    for (int cell = 0; cell < 81; ++cell) {
+        const int y = cell / 9, x = cell % 9;
+        t.board[cell] = static_cast<std::uint8_t>((y / 3) * 3 + x / 3);
+        t.local[cell] = static_cast<std::uint8_t>((y % 3) * 3 + x % 3);
+        t.cell[t.board[cell]][t.local[cell]] = static_cast<std::uint8_t>(cell);
+    }
+    return t;
+}
+
+inline constexpr UltimateTables ULTIMATE_TABLES = makeUltimateTables();
+
+} // namespace detail
+
+/**
+ * @brief Ultimate tic-tac-toe.
+ *
+ * Поле 9x9 состоит из девяти малых полей 3x3. Клетка, в которую сделан
+ * ход, внутри своего малого поля указывает малое поле для следующего
+ * хода соперника; если оно уже закрыто (выиграно или заполнено), можно
+ * ходить в любое открытое поле. Собравший линию в малом поле выигрывает
+ * его; партию выигрывает тот, кто собрал линию из выигранных малых полей
+ * на большом поле. Если все малые поля закрыты, а линии нет — ничья.
+ *
+ * Каждое малое поле хранится парой 9-битных масок, как Game; выигранные
+ * и закрытые малые поля образуют такие же маски большого поля. Линии в
+ * масках проверяются таблицей, построенной по Game::hasLine(), так что
+ * правила 3x3 у обеих игр общие. Клетки нумеруются по большому полю
+ * (y * 9 + x), поэтому игра подходит к Solver, Mcts, Simulator и perft;
+ * допустимые ходы она перечисляет сама (см. HasMoveGenerator) без
+ * выделения памяти. Хеш Зобриста учитывает малое поле следующего хода.
+ */
+class UltimateGame : public GameBase {
+public:
+    using Bitboard = Game::Bitboard;
+
+    /**
+     * @brief Размер стороны большого поля в клетках.
+     */
+    static constexpr int BOARD_SIZE = 9;
+
+    /**
+     * @brief Длина выигрышной линии малого и большого полей.
+     */
+    static constexpr int WIN_LENGTH = 3;
+
+    /**
+     * @brief Количество клеток.
+     */
+    static constexpr int CELL_COUNT = 81;
+
+    /**
+     * @brief Количество малых полей.
+     */
+    static constexpr int BOARD_COUNT = 9;
+
+    /**
+     * @brief Значение activeBoard(), когда можно ходить в любое открытое поле.
+     */
+    static constexpr int ANY_BOARD = -1;
+
+    /**
+     * @brief Ключи Зобриста: 2 * клетка + (игрок == O) для фигур, 2 * CELL_COUNT + поле для малого поля следующего хода.
+     */
+    static constexpr std::array<std::uint64_t, 2 * CELL_COUNT + BOARD_COUNT> ZOBRIST =
+        detail::makeZobristKeys<2 * CELL_COUNT + BOARD_COUNT>();
+
+    /**
+     * @brief Конструктор. Инициализирует пустое поле.
+     */
+    UltimateGame() { reset(); }
+
+    /**
+     * @brief Сделать ход игроком в указанную клетку большого поля.
+     * @param y Строка (0..8)
+     * @param x Столбец (0..8)
+     * @param player Символ игрока (X или O)
+     * @return true, если ход был сделан; false — если ход не допускается правилами
+     */
+    bool makeMove(int y, int x, Cell player);
+
+    /**
+     * @brief Отменить последний ход (для поиска).
+     * @return false, если ходов нет
+     */
+    bool unmakeMove();
+
+    /**
+     * @brief Проверка победителя.
+     * @return Символ игрока, собравшего линию на большом поле, либо Empty
+     */
+    Cell checkWinner() const {
+        TICTACTOE_COUNT(WinnerChecks);
+        return winner_;
+    }
+
+    /**
+     * @brief Проверка на ничью.
+     * @return true, если все малые поля закрыты и победителя нет
+     */
+    bool isDraw() const { return closed_ == FULL_BOARD && winner_ == Empty; }
+
+    /**
+     * @brief Сброс игры.
+     */
+    void reset();
+
+    /**
+     * @brief Получить состояние клетки большого поля.
+     * @return Символ в клетке либо Empty (в том числе для координат вне поля)
+     */
+    Cell getCell(int y, int x) const;
+
+    /**
+     * @brief Маска клеток игрока в малом поле (бит — клетка y * 3 + x малого поля).
+     */
+    Bitboard getBits(int board, Cell player) const { return player == X ? xBits_[board] : oBits_[board]; }
+
+    /**
+     * @brief Победитель малого поля либо Empty.
+     */
+    Cell boardWinner(int board) const;
+
+    /**
+     * @brief Малое поле, в которое нужно ходить, либо ANY_BOARD.
+     */
+    int activeBoard() const { return active_; }
+
+    /**
+     * @brief Допустим ли ход в клетку.
+     * @param cell Индекс клетки y * 9 + x
+     */
+    bool isLegal(int cell) const;
+
+    /**
+     * @brief Перечисляет допустимые ходы: по малым полям, внутри поля — по клеткам малого поля.
+     * @param moves Буфер не меньше CELL_COUNT элементов; nullptr — только посчитать
+     * @return Число ходов (0, если партия окончена)
+     */
+    int legalMoves(int* moves) const;
+
+    /**
+     * @brief Доигрывает партию случайными допустимыми ходами.
+     * @param player Игрок, который ходит
+     * @param rng Генератор с operator(), возвращающим 64-битное число
+     * @return Победитель либо Empty при ничьей
+     */
+    template <class Rng>
+    Cell playRandom(Cell player, Rng& rng);
+
+    /**
+     * @brief Оценка позиции на горизонте поиска для игрока.
+     *
+     * Выигранные малые поля и незаблокированные линии большого поля,
+     * а внутри открытых малых полей — линии без фигур соперника.
+     */
+    int evaluate(Cell player) const;
+
+    /**
+     * @brief Хеш Зобриста текущей позиции.
+     */
+    std::uint64_t hash() const { return hash_; }
+
+    /**
+     * @brief Хеш, одинаковый для всех симметричных позиций (минимум по 8 симметриям).
+     * @param symmetry Если не nullptr, сюда записывается симметрия, переводящая позицию в каноническую
+     */
+    std::uint64_t canonicalHash(int* symmetry = nullptr) const;
+
+    /**
+     * @brief Число сделанных ходов.
+     */
+    int moveCount() const { return count_; }
+
+    /**
+     * @brief Клетка хода с номером ply (с нуля) либо -1.
+     */
+    int moveAt(int ply) const { return ply >= 0 && ply < count_ ? history_[ply].cell : -1; }
+
+    /**
+     * @brief Размер стороны большого поля.
+     */
+    int size() const { return BOARD_SIZE; }
+
+    /**
+     * @brief Длина выигрышной линии.
+     */
+    int winLength() const { return WIN_LENGTH; }
+
+private:
+    static constexpr Bitboard FULL_BOARD = Game::FULL_BOARD;
+
+    /**
+     * @brief Запись истории: ход и состояние, которое он изменил.
+     */
+    struct MoveRecord {
+        std::uint8_t cell;
+        std::uint8_t player;
+        std::int8_t active;         /**< Малое поле до хода */
+        std::uint8_t closedBoard;   /**< 1, если ход закрыл своё малое поле */
+    };
+
+    static std::uint64_t activeKey(int board) { return board == ANY_BOARD ? 0 : ZOBRIST[2 * CELL_COUNT + board]; }
+
+    void apply(int cell, Cell player);
+
+    std::array<Bitboard, BOARD_COUNT> xBits_;
+    std::array<Bitboard, BOARD_COUNT> oBits_;
+    Bitboard metaX_;            /**< Малые поля, выигранные X */
+    Bitboard metaO_;            /**< Малые поля, выигранные O */
+    Bitboard closed_;           /**< Выигранные и заполненные малые поля */
+    std::int8_t active_;
+    std::uint8_t count_;
+    Cell winner_;
+    std::uint64_t hash_;
+    std::array<MoveRecord, CELL_COUNT> history_;
+};
+
+/**
+ * @brief Ставит фигуру без проверок, обновляет малое и большое поля, хеш и историю.
+ */
+inline void UltimateGame::apply(int cell, Cell player) {
+    const int board = detail::ULTIMATE_TABLES.board[cell];
+    const int local = detail::ULTIMATE_TABLES.local[cell];
+    Bitboard& bits = player == X ? xBits_[board] : oBits_[board];
+    bits |= static_cast<Bitboard>(1u << local);
+
+    MoveRecord& record = history_[count_++];
+    record.cell = static_cast<std::uint8_t>(cell);
+    record.player = static_cast<std::uint8_t>(player);
+    record.active = active_;
+    record.closedBoard = 0;
+    if (detail::ULTIMATE_TABLES.line[bits]) {
+        Bitboard& meta = player == X ? metaX_ : metaO_;
+        meta |= static_cast<Bitboard>(1u << board);
+        closed_ |= static_cast<Bitboard>(1u << board);
+        record.closedBoard = 1;
+        if (detail::ULTIMATE_TABLES.line[meta])
+            winner_ = player;
+    }
+    else if ((xBits_[board] | oBits_[board]) == FULL_BOARD) {
+        closed_ |= static_cast<Bitboard>(1u << board);
+        record.closedBoard = 1;
+    }
+
+    const int next = (closed_ >> local) & 1 ? ANY_BOARD : local;
+    hash_ ^= ZOBRIST[2 * cell + (player == O)] ^ activeKey(active_) ^ activeKey(next);
+    active_ = static_cast<std::int8_t>(next);
+}
+
+template <class Rng>
+GameBase::Cell UltimateGame::playRandom(Cell player, Rng& rng) {
+    const auto& tables = detail::ULTIMATE_TABLES;
+    [[maybe_unused]] const int start = count_;    // только для счётчика ходов
+    while (winner_ == Empty && closed_ != FULL_BOARD) {
+        int board = active_;
+        Bitboard free = 0;
+        int pick;
+        if (board != ANY_BOARD) {
+            free = static_cast<Bitboard>(~(xBits_[board] | oBits_[board]) & FULL_BOARD);
+            pick = static_cast<int>(((rng() >> 32) * tables.count[free]) >> 32);
+        }
+        else {
+            // Номер хода среди всех открытых полей, затем поиск его поля; у закрытых полей свободных клеток нет
+            std::array<Bitboard, BOARD_COUNT> open;
+            int total = 0;
+            for (int b = 0; b < BOARD_COUNT; ++b) {
+                open[b] = static_cast<Bitboard>(~(xBits_[b] | oBits_[b]) & (((closed_ >> b) & 1) - 1u) & FULL_BOARD);
+                total += tables.count[open[b]];
+            }
+            pick = static_cast<int>(((rng() >> 32) * static_cast<std::uint64_t>(total)) >> 32);
+            for (board = 0; pick >= tables.count[open[board]]; ++board)
+                pick -= tables.count[open[board]];
+            free = open[board];
+        }
+        apply(tables.cell[board][tables.select[free][pick]], player);
+        player = opponent(player);
+    }
+    TICTACTOE_COUNT_N(MovesApplied, count_ - start);
+    return winner_;
+}
@@ -0,0 +1,334 @@
+/**
+ * @file ValueTable.cpp
+ * @brief Канонические индексы, файл таблицы ценности, обучение самоигрой и проверка по Tablebase.
+ */
+
+#include "ValueTable.h"
+#include "GameRecord.h"
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+/**
+ * @brief Вклад клетки в троичный индекс при каждой симметрии: 3^(образ клетки).
+ */
+constexpr std::array<std::array<int, Game::CELL_COUNT>, GameBase::SYMMETRY_COUNT> makeSymmetryPowers() {
+    std::array<std::array<int, Game::CELL_COUNT>, GameBase::SYMMETRY_COUNT> powers{};
+    for (int s = 0; s < GameBase::SYMMETRY_COUNT; ++s)
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            int power = 1;
+            for (int i = GameBase::transformCell(cell, Game::BOARD_SIZE, s); i > 0; --i)
+                power *= 3;
+            powers[s][cell] = power;
+        }
+    return powers;
+}
+
+constexpr auto SYMMETRY_POWERS = makeSymmetryPowers();
+
+/**
+ * @brief Итог партии для сделавшего последний ход: 1 — линия собрана, 0 — ничья, -2 — партия продолжается.
+ */
+int outcome(const Game& game) {
+    if (game.checkWinner() != GameBase::Empty)
+        return 1;
+    return game.isDraw() ? 0 : -2;
+}
+
+} // namespace
+
+ValueTable::ValueTable() : values_(INDEX_COUNT) {
+    clear();
+}
+
+int ValueTable::canonicalIndex(const Game& game) {
+    const Game::Bitboard xBits = game.getBits(GameBase::X);
+    const Game::Bitboard oBits = game.getBits(GameBase::O);
+    int best = INDEX_COUNT;
+    for (const auto& powers : SYMMETRY_POWERS) {
+        int index = 0;
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            if (xBits & (1u << cell))
+                index += powers[cell];
+            else if (oBits & (1u << cell))
+                index += 2 * powers[cell];
+        }
+        best = std::min(best, index);
+    }
+    return best;
+}
+
+float ValueTable::moveValue(Game& game, int cell, Cell player) const {
+    game.makeMove(cell / Game::BOARD_SIZE, cell % Game::BOARD_SIZE, player);
+    const int result = outcome(game);
+    const float v = result != -2 ? static_cast<float>(result) : value(canonicalIndex(game));
+    game.unmakeMove();
+    return v;
+}
+
+int ValueTable::bestMove(const Game& game, Cell player) const {
+    Game work = game;
+    int best = -1;
+    float bestValue = -2.0f;
+    for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+        if (work.getCell(cell / Game::BOARD_SIZE, cell % Game::BOARD_SIZE) != GameBase::Empty)
+            continue;
+        const float v = moveValue(work, cell, player);
+        if (v > bestValue) {
+            bestValue = v;
+            best = cell;
+        }
+    }
+    return best;
+}
+
+void ValueTable::clear() {
+    for (auto& value : values_)
+        value.store(0.0f, std::memory_order_relaxed);
+    games_ = 0;
+}
+
+bool ValueTable::save(const std::string& path, float lambda, float alpha, std::string* error) const {
+    std::vector<valuefile::Entry> entries;
+    for (int index = 0; index < INDEX_COUNT; ++index) {
+        const float v = std::max(-1.0f, std::min(1.0f, value(index)));
+        const auto quantized = static_cast<std::int16_t>(std::lround(v * valuefile::SCALE));
+        if (quantized != 0)
+            entries.push_back({ static_cast<std::uint16_t>(index), quantized });
+    }
+
+    valuefile::FileHeader header{};
+    std::memcpy(header.magic, valuefile::MAGIC, sizeof(header.magic));
+    header.version = valuefile::VERSION;
+    header.entryBytes = sizeof(valuefile::Entry);
+    header.entryCount = static_cast<std::uint32_t>(entries.size());
+    header.crc = recordfile::crc32(entries.data(), entries.size() * sizeof(valuefile::Entry));
+    header.games = games();
+    header.lambda = lambda;
+    header.alpha = alpha;
+
+    // Пишем во временный файл и переименовываем: прерванная запись не портит прошлую контрольную точку
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    bool ok = file && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(entries.data(), sizeof(valuefile::Entry), entries.size(), file) == entries.size();
+    if (file)
+        ok = std::fclose(file) == 0 && ok;
+    if (ok) {
+#ifdef _WIN32
+        std::remove(path.c_str());      // rename на Win32 не заменяет существующий файл
+#endif
+        ok = std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+    if (!ok) {
+        std::remove(temporary.c_str());
+        if (error)
+            *error = "cannot write " + path;
+    }
+    return ok;
+}
+
+bool ValueTable::load(const std::string& path, std::string* error) {
+    auto fail = [&](const char* reason) {
+        if (error)
+            *error = path + ": " + reason;
+        return false;
+    };
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file)
+        return fail("cannot open");
+    valuefile::FileHeader header{};
+    std::vector<valuefile::Entry> entries;
+    bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+              !std::memcmp(header.magic, valuefile::MAGIC, sizeof(header.magic)) &&
+              header.version == valuefile::VERSION && header.entryBytes == sizeof(valuefile::Entry) &&
+              header.entryCount <= INDEX_COUNT;
+    if (ok) {
+        entries.resize(header.entryCount);
+        ok = std::fread(entries.data(), sizeof(valuefile::Entry), entries.size(), file) == entries.size();
+    }
+    std::fclose(file);
+    if (!ok)
+        return fail("not a value table");
+    if (recordfile::crc32(entries.data(), entries.size() * sizeof(valuefile::Entry)) != header.crc)
+        return fail("checksum mismatch");
+    for (const valuefile::Entry& entry : entries)
+        if (entry.index >= INDEX_COUNT)
+            return fail("index out of range");
+
+    clear();
+    for (const valuefile::Entry& entry : entries)
+        values_[entry.index].store(entry.value / valuefile::SCALE, std::memory_order_relaxed);
+    games_ = header.games;
+    return true;
+}
+
+SelfPlayStats trainSelfPlay(ValueTable& table, const SelfPlayOptions& options,
+                            const std::function<void(const SelfPlayStats&)>& progress, std::string* error) {
+    const auto started = std::chrono::steady_clock::now();
+    const TaskScheduler scheduler(options.threads);
+    const int threads = scheduler.threadCount();
+    const float lambda = static_cast<float>(options.lambda);
+    const float alpha = static_cast<float>(options.alpha);
+    const std::uint64_t every = options.checkpointEvery ? options.checkpointEvery : options.games;
+
+    // Партии раздаются пачками, чтобы общий счётчик не становился узким местом
+    constexpr std::uint64_t CHUNK = 256;
+    std::atomic<std::uint64_t> next{ 0 };
+    std::atomic<std::uint64_t> finished{ 0 };
+    std::atomic<std::uint64_t> xWins{ 0 }, oWins{ 0 }, draws{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex checkpointMutex;
+    SelfPlayStats stats;
+
+    auto snapshot = [&] {
+        SelfPlayStats current = stats;
+        current.games = finished.load();
+        current.xWins = xWins.load();
+        current.oWins = oWins.load();
+        current.draws = draws.load();
+        current.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        return current;
+    };
+    auto checkpoint = [&] {
+        std::lock_guard<std::mutex> lock(checkpointMutex);
+        if (!options.checkpointPath.empty() && !table.save(options.checkpointPath, lambda, alpha, error))
+            failed = true;
+        ++stats.checkpoints;
+        if (progress)
+            progress(snapshot());
+    };
+
+    scheduler.parallelFor(threads, [&](int task, int) {
+        std::uint64_t seed = options.seed * 0x9E3779B97F4A7C15ull + task;
+        std::mt19937_64 rng(detail::splitmix64(seed));
+        std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+        std::vector<int> states;
+        std::vector<std::uint8_t> explored;
+        std::vector<int> ties;
+        Game game;
+
+        while (!failed) {
+            const std::uint64_t begin = next.fetch_add(CHUNK);
+            if (begin >= options.games)
+                break;
+            const std::uint64_t end = std::min(options.games, begin + CHUNK);
+            std::uint64_t localX = 0, localO = 0, localDraws = 0;
+            for (std::uint64_t g = begin; g < end; ++g) {
+                game.reset();
+                states.clear();
+                explored.clear();
+                GameBase::Cell player = GameBase::X;
+                int result;
+                for (;;) {
+                    // epsilon-жадный ход; равные по ценности ходы выбираются случайно
+                    ties.clear();
+                    float bestValue = -2.0f;
+                    const bool explore = coin(rng) < options.epsilon;
+                    for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+                        if (game.getCell(cell / Game::BOARD_SIZE, cell % Game::BOARD_SIZE) != GameBase::Empty)
+                            continue;
+                        const float v = explore ? 0.0f : table.moveValue(game, cell, player);
+                        if (v > bestValue) {
+                            bestValue = v;
+                            ties.clear();
+                        }
+                        if (v == bestValue)
+                            ties.push_back(cell);
+                    }
+                    const int move = ties[rng() % ties.size()];
+                    game.makeMove(move / Game::BOARD_SIZE, move % Game::BOARD_SIZE, player);
+                    explored.push_back(explore);
+                    result = outcome(game);
+                    if (result != -2)
+                        break;
+                    states.push_back(ValueTable::canonicalIndex(game));
+                    player = GameBase::opponent(player);
+                }
+                if (result == 0)
+                    ++localDraws;
+                else if (player == GameBase::X)
+                    ++localX;
+                else
+                    ++localO;
+
+                // lambda-возвраты от конца партии; ценности чередуют знак, так как ходящие чередуются.
+                // После случайного хода соперника цель не отражает его лучшую игру: позицию не учим,
+                // а возврат обрезаем до текущей оценки.
+                float nextReturn = static_cast<float>(result);
+                float nextValue = nextReturn;
+                for (int t = static_cast<int>(states.size()) - 1; t >= 0; --t) {
+                    const float current = table.value(states[t]);
+                    if (explored[t + 1]) {
+                        nextReturn = current;
+                    }
+                    else {
+                        nextReturn = (1.0f - lambda) * -nextValue + lambda * -nextReturn;
+                        table.update(states[t], nextReturn, alpha);
+                    }
+                    nextValue = current;
+                }
+            }
+            xWins += localX;
+            oWins += localO;
+            draws += localDraws;
+            table.addGames(end - begin);
+            const std::uint64_t done = finished.fetch_add(end - begin) + (end - begin);
+            if (done / every != (done - (end - begin)) / every && done < options.games)
+                checkpoint();
+        }
+    });
+
+    if (!failed)
+        checkpoint();
+    SelfPlayStats result = snapshot();
+    result.checkpoints = stats.checkpoints;
+    if (failed)
+        result.games = 0;
+    return result;
+}
+
+PolicyQuality evaluatePolicy(const ValueTable& table) {
+    PolicyQuality quality;
+    int valued = 0;
+    for (int index = 0; index < Tablebase::INDEX_COUNT; ++index) {
+        const Tablebase::Entry entry = Tablebase::lookup(index);
+        if (!entry.reachable)
+            continue;
+        Game position = Tablebase::position(index);
+        // Ценность таблицы относится к сделавшему последний ход — теоретически это -оценка ходящего
+        if (entry.move >= 0 && position.moveCount() > 0) {
+            quality.valueError += std::fabs(table.value(ValueTable::canonicalIndex(position)) + entry.value);
+            ++valued;
+        }
+        if (entry.move < 0)
+            continue;
+        const GameBase::Cell side = Tablebase::sideToMove(position);
+        const int move = table.bestMove(position, side);
+        position.makeMove(move / Game::BOARD_SIZE, move % Game::BOARD_SIZE, side);
+        const int result = outcome(position);
+        const int achieved = result != -2 ? result : -Tablebase::lookup(Tablebase::index(position)).value;
+        ++quality.positions;
+        quality.optimalMoves += achieved == entry.value;
+    }
+    quality.valueError = valued ? quality.valueError / valued : 0.0;
+
+    Game game;
+    GameBase::Cell player = GameBase::X;
+    while (outcome(game) == -2) {
+        const int move = table.bestMove(game, player);
+        game.makeMove(move / Game::BOARD_SIZE, move % Game::BOARD_SIZE, player);
+        player = GameBase::opponent(player);
+    }
+    const GameBase::Cell winner = game.checkWinner();
+    quality.selfPlayResult = winner == GameBase::X ? 1 : (winner == GameBase::O ? -1 : 0);
+    return quality;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file ValueTable.h
+ * @brief Таблица ценности позиций 3x3, обучаемая самоигрой, и её файл.
+ */
+
+#pragma once
+#include "Game.h"
+#include "Tablebase.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Формат файла таблицы ценности (little-endian).
+ *
+ * За заголовком идут записи только для позиций с ненулевой ценностью,
+ * по возрастанию индекса. Ценность хранится в 16 битах с шагом 1/32767.
+ * CRC-32 покрывает записи.
+ */
+namespace valuefile {
+
+constexpr char MAGIC[8] = { 'T', 'T', 'T', 'V', 'A', 'L', '\0', '\1' };
+constexpr std::uint32_t VERSION = 1;
+constexpr float SCALE = 32767.0f;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t entryBytes;
+    std::uint32_t entryCount;
+    std::uint32_t crc;
+    std::uint64_t games;        /**< Сыгранные при обучении партии */
+    float lambda;               /**< Параметры последнего обучения */
+    float alpha;
+    std::uint32_t reserved[2];
+};
+
+struct Entry {
+    std::uint16_t index;        /**< Канонический индекс позиции */
+    std::int16_t value;         /**< Ценность * SCALE */
+};
+
+static_assert(sizeof(FileHeader) == 48 && sizeof(Entry) == 4, "value file layout");
+
+} // namespace valuefile
+
+/**
+ * @brief Ценность позиций 3x3 для игрока, сделавшего последний ход.
+ *
+ * Ключ — канонический индекс позиции: наименьший троичный индекс
+ * (как у Tablebase) среди восьми симметрий, поэтому симметричные позиции
+ * учатся вместе. Значения хранятся в атомарных float и обновляются без
+ * блокировок в духе Hogwild: потоки читают и пишут значения с
+ * memory_order_relaxed, редкие потерянные обновления не мешают сходимости,
+ * а разорванных значений не бывает.
+ *
+ * Завершённые позиции не хранятся: их ценность известна (1 за собранную
+ * линию, 0 за ничью).
+ */
+class ValueTable {
+public:
+    using Cell = GameBase::Cell;
+
+    static constexpr int INDEX_COUNT = Tablebase::INDEX_COUNT;
+
+    ValueTable();
+
+    /**
+     * @brief Канонический индекс позиции.
+     */
+    static int canonicalIndex(const Game& game);
+
+    /**
+     * @brief Ценность для игрока, сделавшего последний ход, в диапазоне [-1, 1].
+     */
+    float value(int canonical) const { return values_[canonical].load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Сдвигает ценность к цели: v += alpha * (target - v).
+     */
+    void update(int canonical, float target, float alpha) {
+        std::atomic<float>& slot = values_[canonical];
+        const float current = slot.load(std::memory_order_relaxed);
+        slot.store(current + alpha * (target - current), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Ценность хода для ходящего: 1 за выигрыш, 0 за ничью, иначе значение таблицы.
+     * @param game Позиция; ход делается и снимается
+     */
+    float moveValue(Game& game, int cell, Cell player) const;
+
+    /**
+     * @brief Лучший по таблице ход; при равенстве — клетка с меньшим индексом.
+     * @return Индекс клетки либо -1, если ходов нет
+     */
+    int bestMove(const Game& game, Cell player) const;
+
+    /**
+     * @brief Обнуляет все значения.
+     */
+    void clear();
+
+    /**
+     * @brief Сыгранные при обучении партии.
+     */
+    std::uint64_t games() const { return games_.load(std::memory_order_relaxed); }
+    void addGames(std::uint64_t games) { games_.fetch_add(games, std::memory_order_relaxed); }
+
+    /**
+     * @brief Записывает таблицу в файл.
+     */
+    bool save(const std::string& path, float lambda, float alpha, std::string* error = nullptr) const;
+
+    /**
+     * @brief Загружает таблицу из файла.
+     * @return false, если файла нет, он повреждён или другой версии
+     */
+    bool load(const std::string& path, std::string* error = nullptr);
+
+private:
+    std::vector<std::atomic<float>> values_;
+    std::atomic<std::uint64_t> games_{ 0 };
+};
+
+/**
+ * @brief Параметры обучения самоигрой.
+ */
+struct SelfPlayOptions {
+    std::uint64_t games = 200000;       /**< Партии обучения */
+    int threads = 0;                    /**< 0 — по числу ядер */
+    double lambda = 0.8;                /**< Параметр TD(lambda); 1 — цели Монте-Карло */
+    double alpha = 0.1;                 /**< Шаг обучения */
+    double epsilon = 0.1;               /**< Доля случайных ходов */
+    std::uint64_t seed = 1;
+    std::uint64_t checkpointEvery = 0;  /**< Партий между контрольными точками (0 — только в конце) */
+    std::string checkpointPath;         /**< Файл контрольных точек (пустой — не сохранять) */
+};
+
+/**
+ * @brief Итоги обучения.
+ */
+struct SelfPlayStats {
+    std::uint64_t games = 0;
+    std::uint64_t xWins = 0;
+    std::uint64_t oWins = 0;
+    std::uint64_t draws = 0;
+    std::uint64_t checkpoints = 0;
+    double seconds = 0.0;
+
+    double gamesPerSecond() const { return seconds > 0.0 ? games / seconds : 0.0; }
+};
+
+/**
+ * @brief Качество выученной стратегии относительно идеальной игры (Tablebase).
+ */
+struct PolicyQuality {
+    int positions = 0;          /**< Достижимые незавершённые позиции */
+    int optimalMoves = 0;       /**< Позиции, где выбранный ход сохраняет теоретический результат */
+    double valueError = 0.0;    /**< Средняя |ценность - теоретическая оценка| по достижимым позициям */
+    int selfPlayResult = 0;     /**< Партия стратегии против себя: 1 — победа X, -1 — O, 0 — ничья */
+
+    double optimalRate() const { return positions ? static_cast<double>(optimalMoves) / positions : 0.0; }
+};
+
+/**
+ * @brief Обучает таблицу самоигрой на всех ядрах.
+ *
+ * Каждый поток играет партии epsilon-жадной стратегией по общей таблице и
+ * после партии обновляет ценности всех её позиций к lambda-возвратам
+ * (прямой взгляд на TD(lambda)): цель позиции — смесь ценности следующей
+ * позиции, взятой с обратным знаком, и возврата, пришедшего от конца партии.
+ * Контрольные точки пишет поток, перешедший их границу.
+ *
+ * @param progress Вызывается после каждой контрольной точки
+ * @return Итоги; games == 0 при ошибке записи (текст — в error)
+ */
+SelfPlayStats trainSelfPlay(ValueTable& table, const SelfPlayOptions& options,
+                            const std::function<void(const SelfPlayStats&)>& progress = {},
+                            std::string* error = nullptr);
+
+/**
+ * @brief Сравнивает выученную стратегию с идеальной игрой.
+ */
+PolicyQuality evaluatePolicy(const ValueTable& table);
@@ -0,0 +1,561 @@
+/**
+ * @file bench.cpp
+ * @brief Бенчмарки игровой логики.
+ *
+ * Пример: TicTacToeBench --reps 50 --json bench.json
+ * Только выбранные бенчмарки: TicTacToeBench --filter 3x3
+ * Цена инструментирования: сборка без TICTACTOE_INSTRUMENTATION записывает базу
+ *   TicTacToeBench --filter instrumentation --json base.json,
+ * а сборка с ним сравнивает с ней: TicTacToeBench --filter instrumentation --baseline base.json
+ */
+
+#include "Benchmark.h"
+#include "BoardBatch.h"
+#include "Game.h"
+#include "Instrumentation.h"
+#include "Mcts.h"
+#include "Perft.h"
+#include "PositionRank.h"
+#include "Solver.h"
+#include "ThreatEvaluator.h"
+#include "UltimateGame.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s [--warmup N] [--reps N] [--sample-ms MS] [--filter TEXT] [--json FILE]\n"
+                "          [--baseline FILE] [--max-overhead PERCENT]\n"
+                "--baseline takes --json output of a build without instrumentation.\n", program);
+}
+
+/**
+ * @brief Поле 15x15 с размером, заданным во время выполнения (для сравнения с BasicGame).
+ */
+struct DynamicGame15 : DynamicGame {
+    DynamicGame15() : DynamicGame(15, 5) {}
+};
+
+/**
+ * @brief Случайная свободная клетка либо -1.
+ */
+template <class GameT>
+int randomEmptyCell(const GameT& game, std::uint64_t& rng, std::vector<int>& buffer) {
+    const int size = game.size();
+    buffer.clear();
+    for (int cell = 0; cell < size * size; ++cell)
+        if (game.getCell(cell / size, cell % size) == GameBase::Empty)
+            buffer.push_back(cell);
+    if (buffer.empty())
+        return -1;
+    return buffer[detail::splitmix64(rng) % buffer.size()];
+}
+
+/**
+ * @brief Играет случайную партию до конца и возвращает число ходов.
+ */
+template <class GameT>
+int playRandomGame(GameT& game, std::uint64_t& rng, std::vector<int>& buffer) {
+    GameBase::Cell player = GameBase::X;
+    while (game.checkWinner() == GameBase::Empty && !game.isDraw()) {
+        const int cell = randomEmptyCell(game, rng, buffer);
+        game.makeMove(cell / game.size(), cell % game.size(), player);
+        player = GameBase::opponent(player);
+    }
+    return game.moveCount();
+}
+
+/**
+ * @brief Набор случайных позиций разной длины (в том числе завершённых).
+ */
+template <class GameT>
+std::vector<GameT> randomPositions(int count, std::uint64_t seed) {
+    std::vector<GameT> positions;
+    std::vector<int> buffer;
+    std::uint64_t rng = seed;
+    const int cells = GameT().size() * GameT().size();
+    for (int i = 0; i < count; ++i) {
+        GameT game;
+        const int moves = static_cast<int>(detail::splitmix64(rng) % (cells + 1));
+        GameBase::Cell player = GameBase::X;
+        for (int m = 0; m < moves && game.checkWinner() == GameBase::Empty && !game.isDraw(); ++m) {
+            const int cell = randomEmptyCell(game, rng, buffer);
+            game.makeMove(cell / game.size(), cell % game.size(), player);
+            player = GameBase::opponent(player);
+        }
+        positions.push_back(game);
+    }
+    return positions;
+}
+
+/**
+ * @brief Бенчмарки одного варианта поля.
+ */
+template <class GameT>
+void runGameBenchmarks(BenchmarkRunner& runner, const std::string& prefix) {
+    const int size = GameT().size();
+    const int cells = size * size;
+
+    // Перестановка клеток, по которой заполняется поле
+    std::vector<int> order(cells);
+    std::uint64_t rng = 12345;
+    for (int i = 0; i < cells; ++i)
+        order[i] = i;
+    for (int i = cells - 1; i > 0; --i)
+        std::swap(order[i], order[detail::splitmix64(rng) % (i + 1)]);
+
+    GameT game;
+    runner.run(prefix + "makeMove (full board + reset)", cells, [&] {
+        GameBase::Cell player = GameBase::X;
+        for (int cell : order) {
+            doNotOptimize(game.makeMove(cell / size, cell % size, player));
+            player = GameBase::opponent(player);
+        }
+        game.reset();
+    });
+
+    const int centre = (size / 2) * size + size / 2;
+    runner.run(prefix + "makeMove+unmakeMove", 1, [&] {
+        game.makeMove(centre / size, centre % size, GameBase::X);
+        doNotOptimize(game.unmakeMove());
+    });
+
+    const std::vector<GameT> positions = randomPositions<GameT>(1024, 99);
+    std::size_t next = 0;
+    runner.run(prefix + "checkWinner", 1, [&] {
+        doNotOptimize(positions[next].checkWinner());
+        next = (next + 1) & 1023;
+    });
+    runner.run(prefix + "isDraw", 1, [&] {
+        doNotOptimize(positions[next].isDraw());
+        next = (next + 1) & 1023;
+    });
+    runner.run(prefix + "reset", 1, [&] {
+        game.reset();
+        doNotOptimize(game);
+    });
+
+    std::vector<int> buffer;
+    rng = 777;
+    runner.run(prefix + "random game", 1, [&] {
+        game.reset();
+        doNotOptimize(playRandomGame(game, rng, buffer));
+    });
+}
+
+/**
+ * @brief Пакетные проверки BoardBatch всеми доступными реализациями против цикла по Game.
+ */
+void runBatchBenchmarks(BenchmarkRunner& runner) {
+    constexpr int BOARDS = 4096;
+    const std::vector<Game> positions = randomPositions<Game>(BOARDS, 4242);
+    runner.run("3x3 Game checkWinner loop (per board)", BOARDS, [&] {
+        int wins = 0;
+        for (const Game& game : positions)
+            wins += game.checkWinner() != GameBase::Empty;
+        doNotOptimize(wins);
+    });
+
+    BoardBatch batch(BOARDS);
+    for (int i = 0; i < BOARDS; ++i)
+        batch.set(i, positions[i]);
+    std::vector<std::uint64_t> xWins(batch.maskWords()), oWins(batch.maskWords()), draws(batch.maskWords());
+    std::vector<std::int8_t> cells(BOARDS, -1);
+    for (int kernel = BoardBatch::Scalar; kernel <= BoardBatch::bestKernel(); ++kernel) {
+        batch.setKernel(static_cast<BoardBatch::Kernel>(kernel));
+        const std::string name = std::string("3x3 batch ") + BoardBatch::kernelName(batch.kernel());
+        runner.run(name + " checkWinner (per board)", BOARDS, [&] {
+            batch.checkWinner(xWins.data(), oWins.data());
+            doNotOptimize(xWins.data());
+            doNotOptimize(oWins.data());
+        });
+        runner.run(name + " isDraw (per board)", BOARDS, [&] {
+            batch.isDraw(draws.data());
+            doNotOptimize(draws.data());
+        });
+        // Ход в несуществующую клетку не меняет поля, поэтому замер повторяем на тех же данных
+        runner.run(name + " makeMove (per board)", BOARDS, [&] {
+            batch.makeMove(cells.data(), GameBase::X);
+            doNotOptimize(batch);
+        });
+    }
+}
+
+/**
+ * @brief Оценка просмотром всего поля: каждое окно из k клеток, занятое одним игроком, даёт 4^(камней).
+ */
+template <class GameT>
+int naiveEvaluate(const GameT& game) {
+    static constexpr int DIRECTIONS[4][2] = { {0, 1}, {1, 0}, {1, 1}, {1, -1} };
+    const int size = game.size(), k = game.winLength();
+    int score = 0;
+    for (const auto& direction : DIRECTIONS) {
+        const int dy = direction[0], dx = direction[1];
+        for (int y = 0; y + dy * (k - 1) < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                const int endX = x + dx * (k - 1);
+                if (endX < 0 || endX >= size)
+                    continue;
+                int xs = 0, os = 0;
+                for (int i = 0; i < k; ++i) {
+                    const GameBase::Cell cell = game.getCell(y + dy * i, x + dx * i);
+                    xs += cell == GameBase::X;
+                    os += cell == GameBase::O;
+                }
+                if (os == 0 && xs > 0)
+                    score += 1 << (2 * xs);
+                else if (xs == 0 && os > 0)
+                    score -= 1 << (2 * os);
+            }
+        }
+    }
+    return score;
+}
+
+/**
+ * @brief Оценка позиции 15x15 после хода: инкрементальные образцы против полного просмотра.
+ */
+void runThreatBenchmarks(BenchmarkRunner& runner) {
+    using Board = BasicGame<15, 5>;
+    constexpr int POSITIONS = 64;
+    constexpr int STONES = 40;
+    std::vector<Board> positions(POSITIONS);
+    std::vector<ThreatEvaluator> evaluators(POSITIONS, ThreatEvaluator(15, 5));
+    std::vector<int> buffer;
+    std::uint64_t rng = 31337;
+    for (int i = 0; i < POSITIONS; ++i) {
+        GameBase::Cell player = GameBase::X;
+        for (int m = 0; m < STONES; ++m) {
+            const int cell = randomEmptyCell(positions[i], rng, buffer);
+            positions[i].makeMove(cell / 15, cell % 15, player);
+            player = GameBase::opponent(player);
+        }
+        evaluators[i].reset(positions[i]);
+    }
+    // Ход в свободную клетку каждой позиции, как в узле поиска
+    std::vector<int> moves(POSITIONS);
+    for (int i = 0; i < POSITIONS; ++i)
+        moves[i] = randomEmptyCell(positions[i], rng, buffer);
+
+    std::size_t next = 0;
+    runner.run("15x15 k5 eval incremental (move+eval+undo)", 1, [&] {
+        ThreatEvaluator& evaluator = evaluators[next];
+        evaluator.makeMove(moves[next], GameBase::X);
+        doNotOptimize(evaluator.evaluate(GameBase::X));
+        evaluator.unmakeMove(moves[next]);
+        next = (next + 1) % POSITIONS;
+    });
+    runner.run("15x15 k5 eval pattern full scan (move+eval+undo)", 1, [&] {
+        ThreatEvaluator& evaluator = evaluators[next];
+        evaluator.makeMove(moves[next], GameBase::X);
+        doNotOptimize(evaluator.evaluateFull(GameBase::X));
+        evaluator.unmakeMove(moves[next]);
+        next = (next + 1) % POSITIONS;
+    });
+    runner.run("15x15 k5 eval naive board scan (move+eval+undo)", 1, [&] {
+        Board& game = positions[next];
+        game.makeMove(moves[next] / 15, moves[next] % 15, GameBase::X);
+        doNotOptimize(naiveEvaluate(game));
+        game.unmakeMove();
+        next = (next + 1) % POSITIONS;
+    });
+
+    // Две закрытые тройки X, пересекающиеся в свободной клетке: выигрыш двойной четвёркой
+    ThreatEvaluator vcf(15, 5);
+    for (int cell : { 7 * 15 + 4, 7 * 15 + 5, 7 * 15 + 6, 4 * 15 + 8, 5 * 15 + 8, 6 * 15 + 8 })
+        vcf.makeMove(cell, GameBase::X);
+    for (int cell : { 7 * 15 + 3, 3 * 15 + 8, 0, 14 * 15 + 14, 10 * 15 + 2, 2 * 15 + 12 })
+        vcf.makeMove(cell, GameBase::O);
+    runner.run("15x15 k5 VCF search", 1, [&] {
+        doNotOptimize(vcf.findVcf(GameBase::X).win);
+    });
+}
+
+/**
+ * @brief Ultimate tic-tac-toe: генерация ходов, ход с отменой, случайные доигровки и MCTS.
+ */
+void runUltimateBenchmarks(BenchmarkRunner& runner) {
+    // Генератор доигровок: splitmix64 быстрее mt19937_64 и не хранит большого состояния
+    struct SplitMix {
+        std::uint64_t state;
+        std::uint64_t operator()() { return detail::splitmix64(state); }
+    };
+    SplitMix rng{ 2024 };
+
+    // Позиции середины партии: 20 случайных ходов от пустого поля
+    constexpr int POSITIONS = 64;
+    std::vector<UltimateGame> positions(POSITIONS);
+    int moves[UltimateGame::CELL_COUNT];
+    for (UltimateGame& position : positions) {
+        GameBase::Cell player = GameBase::X;
+        for (int m = 0; m < 20 && position.checkWinner() == GameBase::Empty; ++m) {
+            const int count = position.legalMoves(moves);
+            if (count == 0)
+                break;
+            const int cell = moves[rng() % count];
+            position.makeMove(cell / 9, cell % 9, player);
+            player = GameBase::opponent(player);
+        }
+    }
+
+    std::size_t next = 0;
+    runner.run("ultimate legal move generation", 1, [&] {
+        doNotOptimize(positions[next].legalMoves(moves));
+        next = (next + 1) % POSITIONS;
+    });
+    runner.run("ultimate make+unmake (per legal move)", 1, [&] {
+        UltimateGame& position = positions[next];
+        const int count = position.legalMoves(moves);
+        if (count > 0) {
+            const int cell = moves[count / 2];
+            position.makeMove(cell / 9, cell % 9, GameBase::X);
+            doNotOptimize(position.hash());
+            position.unmakeMove();
+        }
+        next = (next + 1) % POSITIONS;
+    });
+
+    // Длина случайной партии почти постоянна, поэтому ходы в секунду = доигровки * средняя длина
+    std::uint64_t playoutMoves = 0, playouts = 0;
+    runner.run("ultimate random playout (per playout)", 1, [&] {
+        UltimateGame game;
+        doNotOptimize(game.playRandom(GameBase::X, rng));
+        playoutMoves += game.moveCount();
+        ++playouts;
+    });
+    if (playouts)
+        std::printf("ultimate random playout: %.1f moves on average\n", static_cast<double>(playoutMoves) / playouts);
+
+    Mcts<UltimateGame> mcts(1 << 16);
+    MctsLimits limits;
+    limits.playouts = 1000;
+    runner.run("ultimate MCTS 1000 playouts (per playout)", 1000, [&] {
+        mcts.reset();
+        doNotOptimize(mcts.search(UltimateGame(), GameBase::X, limits).move);
+    });
+}
+
+/**
+ * @brief Плотная нумерация позиций: номер и позиция по номеру против поиска в хеш-таблице.
+ */
+void runRankBenchmarks(BenchmarkRunner& runner) {
+    std::vector<Game> positions;
+    for (int rank = 0; rank < PositionRank::COUNT; ++rank)
+        positions.push_back(PositionRank::unrank(rank));
+    std::size_t next = 0;
+    runner.run("3x3 position rank", 1, [&] {
+        doNotOptimize(PositionRank::rank(positions[next]));
+        next = (next + 1) % positions.size();
+    });
+    int rank = 0;
+    runner.run("3x3 position unrank", 1, [&] {
+        doNotOptimize(PositionRank::unrank(rank).hash());
+        rank = (rank + 1) % PositionRank::COUNT;
+    });
+    runner.run("3x3 canonical rank", 1, [&] {
+        doNotOptimize(PositionRank::canonicalRank(positions[next]));
+        next = (next + 1) % positions.size();
+    });
+    runner.run("3x3 canonical unrank", 1, [&] {
+        doNotOptimize(PositionRank::canonicalUnrank(rank % PositionRank::CANONICAL_COUNT).hash());
+        rank = (rank + 1) % PositionRank::COUNT;
+    });
+
+    // То, что заменяет номер: ключ — хеш Зобриста, значение — номер
+    std::unordered_map<std::uint64_t, int> byHash;
+    for (std::size_t i = 0; i < positions.size(); ++i)
+        byHash.emplace(positions[i].hash(), static_cast<int>(i));
+    runner.run("3x3 hash map lookup (for comparison)", 1, [&] {
+        doNotOptimize(byHash.find(positions[next].hash())->second);
+        next = (next + 1) % positions.size();
+    });
+
+    // 4x4: комбинаторная система счисления, позиции по случайным номерам
+    const CombinatorialRank large(16);
+    std::vector<std::uint64_t> ranks;
+    std::uint64_t state = 2024;
+    for (int i = 0; i < 1024; ++i)
+        ranks.push_back(detail::splitmix64(state) % large.count());
+    std::vector<BasicGame<4, 4>> boards(ranks.size());
+    for (std::size_t i = 0; i < ranks.size(); ++i)
+        large.unrank(ranks[i], boards[i]);
+    std::size_t board = 0;
+    runner.run("4x4 combinatorial rank", 1, [&] {
+        doNotOptimize(large.rank(boards[board]));
+        board = (board + 1) % boards.size();
+    });
+    std::uint8_t cells[16];
+    runner.run("4x4 combinatorial unrank", 1, [&] {
+        large.unrankCells(ranks[board], cells);
+        doNotOptimize(cells[board % 16]);
+        board = (board + 1) % ranks.size();
+    });
+}
+
+/**
+ * @brief Замедление при включённом сборе в процентах для одного бенчмарка.
+ */
+struct Overhead {
+    bool measured = false;      /**< Бенчмарк не отфильтрован */
+    bool compared = false;      /**< В базе есть тот же бенчмарк */
+    double inBuild = 0.0;       /**< Против сбора, выключенного в этой же сборке */
+    double baseline = 0.0;      /**< Против сборки без инструментирования */
+};
+
+struct InstrumentationOverhead {
+    Overhead perft;
+    Overhead solver;
+};
+
+/**
+ * @brief Цена точек измерения: отдельные операции и замедление поиска при включённом сборе.
+ *
+ * Выключение сбора через instrumentation::setActive() оставляет проверку
+ * флага и обращения к thread_local, поэтому настоящее замедление считается
+ * против тех же бенчмарков сборки без TICTACTOE_INSTRUMENTATION из baseline.
+ * @param baseline Медианы сборки без инструментирования (пусто, если базы нет)
+ */
+InstrumentationOverhead runInstrumentationBenchmarks(BenchmarkRunner& runner,
+                                                     const std::unordered_map<std::string, double>& baseline) {
+    runner.run("instrumentation counter add", 1, [] {
+        instrumentation::add(instrumentation::NodesSearched);
+    });
+    std::uint64_t latency = 1;
+    runner.run("instrumentation latency record", 1, [&] {
+        instrumentation::recordLatency(instrumentation::MoveSelection, latency);
+        latency = latency * 3 % 1000003;
+    });
+    instrumentation::setTracing(true);
+    runner.run("instrumentation trace span", 1, [] {
+        instrumentation::ScopedSpan span("bench");
+    });
+    instrumentation::setTracing(false);
+
+    // Худший случай — узлы perft по 1-2 нс с двумя счётчиками на узел; типичный — поиск решателя
+    auto pair = [&](const std::string& name, std::uint64_t ops, const std::function<void()>& body) {
+        Overhead overhead;
+        instrumentation::setActive(false);
+        overhead.measured = runner.run(name + " (collection off)", ops, body);
+        instrumentation::setActive(true);
+        runner.run(name + " (collection on)", ops, body);
+        if (!overhead.measured)
+            return overhead;
+        const std::vector<BenchmarkResult>& results = runner.results();
+        const double off = results[results.size() - 2].p50Ns, on = results.back().p50Ns;
+        overhead.inBuild = 100.0 * (on - off) / off;
+        const auto base = baseline.find(name + " (collection on)");
+        overhead.compared = base != baseline.end() && base->second > 0.0;
+        if (overhead.compared)
+            overhead.baseline = 100.0 * (on - base->second) / base->second;
+        return overhead;
+    };
+    InstrumentationOverhead result;
+    result.perft = pair("instrumentation 3x3 perft (per node)", 549946, [] {
+        doNotOptimize(perft(Game(), GameBase::X).games);
+    });
+    Solver<BasicGame<4, 4>> solver(16);
+    SolverLimits limits;
+    limits.maxDepth = 6;
+    result.solver = pair("instrumentation 4x4 solver depth 6", 1, [&] {
+        solver.clear();
+        doNotOptimize(solver.solve(BasicGame<4, 4>(), GameBase::X, limits).move);
+    });
+    instrumentation::reset();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchmarkConfig config;
+    std::string jsonPath, baselinePath;
+    double maxOverhead = 10.0;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--warmup") && hasValue)
+            config.warmup = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--reps") && hasValue)
+            config.repetitions = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--sample-ms") && hasValue)
+            config.sampleSeconds = std::atof(argv[++i]) / 1000.0;
+        else if (!std::strcmp(argv[i], "--filter") && hasValue)
+            config.filter = argv[++i];
+        else if (!std::strcmp(argv[i], "--json") && hasValue)
+            jsonPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--baseline") && hasValue)
+            baselinePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--max-overhead") && hasValue)
+            maxOverhead = std::atof(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::unordered_map<std::string, double> baseline;
+    if (!baselinePath.empty() && !BenchmarkRunner::readJsonMedians(baselinePath, baseline)) {
+        std::fprintf(stderr, "Cannot read %s\n", baselinePath.c_str());
+        return 1;
+    }
+
+    BenchmarkRunner runner(config);
+    runGameBenchmarks<Game>(runner, "3x3 ");
+    runGameBenchmarks<BasicGame<15, 5>>(runner, "15x15 k5 ");
+    runGameBenchmarks<DynamicGame15>(runner, "dynamic 15x15 k5 ");
+
+    runBatchBenchmarks(runner);
+    runThreatBenchmarks(runner);
+    runUltimateBenchmarks(runner);
+    runRankBenchmarks(runner);
+
+    // Полное дерево игры 3x3: 549946 узлов, 255168 партий; операция — один узел
+    runner.run("3x3 perft (per node)", 549946, [] {
+        doNotOptimize(perft(Game(), GameBase::X).games);
+    });
+    PerftOptions unique;
+    unique.unique = true;
+    runner.run("3x3 perft unique (per position)", 5478, [&] {
+        doNotOptimize(perft(Game(), GameBase::X, unique).games);
+    });
+
+    const InstrumentationOverhead overhead = runInstrumentationBenchmarks(runner, baseline);
+
+    runner.print(stdout);
+    if (!jsonPath.empty() && !runner.writeJson(jsonPath)) {
+        std::fprintf(stderr, "Cannot write %s\n", jsonPath.c_str());
+        return 1;
+    }
+    auto report = [](const char* name, const Overhead& overhead, bool baseline) {
+        if (overhead.measured && (!baseline || overhead.compared))
+            std::printf(" %s %.1f%%", name, baseline ? overhead.baseline : overhead.inBuild);
+    };
+    if (!overhead.perft.measured && !overhead.solver.measured)
+        return 0;
+    std::printf("\ninstrumentation %s, collection on vs off in this build:",
+                instrumentation::ENABLED ? "enabled" : "compiled out");
+    report("perft", overhead.perft, false);
+    report("solver", overhead.solver, false);
+    std::printf("\n");
+    // Граница сравнивает сборку с инструментированием со сборкой без него
+    if (!instrumentation::ENABLED || !overhead.solver.measured)
+        return 0;
+    if (!overhead.solver.compared) {
+        std::printf("no --baseline from a build without instrumentation: bound %.1f%% not applied\n", maxOverhead);
+        return 0;
+    }
+    std::printf("against %s:", baselinePath.c_str());
+    report("perft", overhead.perft, true);
+    report("solver", overhead.solver, true);
+    std::printf(" (bound %.1f%%)\n", maxOverhead);
+    if (overhead.solver.baseline > maxOverhead) {
+        std::fprintf(stderr, "Instrumentation overhead exceeds the bound\n");
+        return 1;
+    }
+    return 0;
+}
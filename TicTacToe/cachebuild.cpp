@@ -0,0 +1,103 @@
+/**
+ * @file cachebuild.cpp
+ * @brief Построение файла решённых позиций перебором.
+ *
+ * Пример: TicTacToeCacheBuild --size 4 --k 4 --plies 3 --threads 8 --out openings4x4.tpc
+ * Проверка файла: TicTacToeCacheBuild --size 4 --k 4 --check openings4x4.tpc
+ */
+
+#include "PositionCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s --out FILE [--size N] [--k K] [--plies N] [--threads N] [--tt MB] [--max-nodes N]\n"
+                "       %s --check FILE [--size N] [--k K]\n", program, program);
+}
+
+/**
+ * @brief Открывает готовый файл и сообщает оценку пустого поля.
+ */
+int check(const std::string& path, int size, int winLength) {
+    const auto started = std::chrono::steady_clock::now();
+    PositionCache cache;
+    std::string error;
+    if (!cache.open(path, size, winLength, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    PositionCache::Hit hit;
+    const bool found = cache.probe(DynamicGame(size, winLength), GameBase::X, hit);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    std::printf("entries: %llu  max moves: %d  open+probe: %.3f ms\n",
+                static_cast<unsigned long long>(cache.entryCount()), cache.maxMoves(), seconds * 1e3);
+    if (found)
+        std::printf("empty board: value %d, move %d, distance %d\n", hit.value, hit.move, hit.distance);
+    else
+        std::printf("empty board: not in cache\n");
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    PositionCacheBuildOptions options;
+    std::string output, checkPath;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--out") && hasValue)
+            output = argv[++i];
+        else if (!std::strcmp(argv[i], "--check") && hasValue)
+            checkPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--size") && hasValue)
+            options.size = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--k") && hasValue)
+            options.winLength = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--plies") && hasValue)
+            options.plies = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue)
+            options.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--tt") && hasValue)
+            options.ttMegabytes = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--max-nodes") && hasValue)
+            options.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.size < 1 || options.winLength < 1 || options.winLength > options.size || options.plies < 0 ||
+        output.empty() == checkPath.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!checkPath.empty())
+        return check(checkPath, options.size, options.winLength);
+
+    PositionCacheBuildStats stats;
+    std::string error;
+    std::uint64_t reported = 0;
+    const bool ok = buildPositionCache(options, output, &stats, [&](std::uint64_t done, std::uint64_t total) {
+        // Не чаще одного сообщения на процент
+        if (done == total || (done - reported) * 100 >= total) {
+            reported = done;
+            std::fprintf(stderr, "\rsolved %llu/%llu", static_cast<unsigned long long>(done),
+                         static_cast<unsigned long long>(total));
+        }
+    }, &error);
+    std::fprintf(stderr, "\n");
+    if (!ok) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("positions: %llu  solved: %llu  nodes: %llu  time: %.3f s\n",
+                static_cast<unsigned long long>(stats.positions), static_cast<unsigned long long>(stats.solved),
+                static_cast<unsigned long long>(stats.nodes), stats.seconds);
+    return 0;
+}
@@ -0,0 +1,295 @@
+/**
+ * @file loadgen.cpp
+ * @brief Нагрузочный клиент для TicTacToeServer: задержка хода и партии в секунду.
+ *
+ * Пример: TicTacToeLoadGen --port 7777 --connections 8 --sessions 512 --games 200000
+ *
+ * Каждое подключение обслуживается своим потоком и держит --sessions партий
+ * одновременно. Клиент играет крестиками случайными допустимыми ходами;
+ * задержка — время от отправки MOVE до получения ответа с ходом компьютера.
+ */
+
+#include "Game.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig {
+    std::string host = "127.0.0.1";
+    std::uint16_t port = 7777;
+    std::string unixPath;
+    int connections = 4;
+    int sessions = 256;
+    std::uint64_t games = 100000;
+    std::uint64_t seed = 1;
+};
+
+struct ClientStats {
+    std::uint64_t games = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t errors = 0;
+    std::vector<double> latencies;   // микросекунды
+};
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s [--host ADDR] [--port N | --unix PATH] [--connections N] [--sessions N] [--games N] [--seed N]\n",
+                program);
+}
+
+int connectTo(const LoadConfig& config) {
+    if (!config.unixPath.empty()) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, config.unixPath.c_str(), sizeof(address.sun_path) - 1);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+            return -1;
+        return fd;
+    }
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config.port);
+    if (fd < 0 || ::inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+        return -1;
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+bool sendAll(int fd, std::string& output) {
+    std::size_t sent = 0;
+    while (sent < output.size()) {
+        const ssize_t n = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    output.clear();
+    return true;
+}
+
+/**
+ * @brief Одно подключение: держит несколько партий и играет их до исчерпания общего бюджета.
+ */
+class Client {
+public:
+    Client(const LoadConfig& config, std::atomic<std::uint64_t>& budget, std::uint64_t seed)
+        : config_(config), budget_(budget), rng_(seed) {}
+
+    bool run(ClientStats& stats) {
+        fd_ = connectTo(config_);
+        if (fd_ < 0)
+            return false;
+        slots_.resize(config_.sessions);
+        for (int i = 0; i < config_.sessions; ++i)
+            startGame(i);
+        if (!sendAll(fd_, output_))
+            return false;
+
+        std::vector<char> input(1 << 16);
+        std::size_t size = 0;
+        while (active_ > 0) {
+            const ssize_t got = ::recv(fd_, input.data() + size, input.size() - size, 0);
+            if (got <= 0)
+                break;
+            size += static_cast<std::size_t>(got);
+            std::size_t start = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                if (input[i] != '\n')
+                    continue;
+                input[i] = '\0';
+                handle(input.data() + start, stats);
+                start = i + 1;
+            }
+            std::memmove(input.data(), input.data() + start, size - start);
+            size -= start;
+            if (!output_.empty() && !sendAll(fd_, output_))
+                break;
+        }
+        ::close(fd_);
+        return active_ == 0;
+    }
+
+private:
+    struct Slot {
+        Game game;
+        std::uint64_t id = 0;
+        Clock::time_point sent;
+    };
+
+    void startGame(int slot) {
+        std::uint64_t left = budget_.load();
+        while (left > 0 && !budget_.compare_exchange_weak(left, left - 1))
+            ;
+        if (left == 0)
+            return;
+        slots_[slot].game.reset();
+        pendingNew_.push_back(slot);
+        ++active_;
+        output_ += "NEW x\n";
+    }
+
+    void sendMove(int slot) {
+        Slot& s = slots_[slot];
+        int free[Game::CELL_COUNT];
+        int count = 0;
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell)
+            if (s.game.getCell(cell / 3, cell % 3) == GameBase::Empty)
+                free[count++] = cell;
+        const int cell = free[detail::splitmix64(rng_) % count];
+        s.game.makeMove(cell / 3, cell % 3, GameBase::X);
+        s.sent = Clock::now();
+        output_ += "MOVE " + std::to_string(s.id) + " " + std::to_string(cell) + "\n";
+    }
+
+    void handle(char* line, ClientStats& stats) {
+        char* rest = std::strchr(line, ' ');
+        if (rest)
+            *rest++ = '\0';
+        if (!std::strcmp(line, "NEW") && rest && !pendingNew_.empty()) {
+            const int slot = pendingNew_[pendingHead_++];
+            if (pendingHead_ == pendingNew_.size()) {
+                pendingNew_.clear();
+                pendingHead_ = 0;
+            }
+            slots_[slot].id = std::strtoull(rest, nullptr, 10);
+            bySession_[slots_[slot].id] = slot;
+            sendMove(slot);
+        }
+        else if (!std::strcmp(line, "MOVE") && rest) {
+            char* end = rest;
+            const std::uint64_t id = std::strtoull(rest, &end, 10);
+            const int aiMove = static_cast<int>(std::strtol(end, &end, 10));
+            while (*end == ' ')
+                ++end;
+            const auto found = bySession_.find(id);
+            if (found == bySession_.end())
+                return;
+            Slot& slot = slots_[found->second];
+            stats.latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - slot.sent).count());
+            ++stats.moves;
+            if (aiMove >= 0)
+                slot.game.makeMove(aiMove / 3, aiMove % 3, GameBase::O);
+            if (std::strcmp(end, "PLAY") != 0)
+                output_ += "END " + std::to_string(id) + "\n";
+            else
+                sendMove(found->second);
+        }
+        else if (!std::strcmp(line, "END") && rest) {
+            const auto found = bySession_.find(std::strtoull(rest, nullptr, 10));
+            if (found == bySession_.end())
+                return;
+            const int slot = found->second;
+            bySession_.erase(found);
+            ++stats.games;
+            --active_;
+            startGame(slot);
+        }
+        else {
+            ++stats.errors;
+        }
+    }
+
+    const LoadConfig& config_;
+    std::atomic<std::uint64_t>& budget_;
+    std::uint64_t rng_;
+    int fd_ = -1;
+    int active_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<int> pendingNew_;
+    std::size_t pendingHead_ = 0;
+    std::unordered_map<std::uint64_t, int> bySession_;
+    std::string output_;
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty())
+        return 0.0;
+    const std::size_t rank = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    LoadConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--host") && hasValue)
+            config.host = argv[++i];
+        else if (!std::strcmp(argv[i], "--port") && hasValue)
+            config.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--unix") && hasValue)
+            config.unixPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--connections") && hasValue)
+            config.connections = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--sessions") && hasValue)
+            config.sessions = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--games") && hasValue)
+            config.games = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--seed") && hasValue)
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::atomic<std::uint64_t> budget{ config.games };
+    std::vector<ClientStats> stats(config.connections);
+    std::vector<char> ok(config.connections, 0);
+    std::vector<std::thread> threads;
+    const auto started = Clock::now();
+    for (int i = 0; i < config.connections; ++i) {
+        threads.emplace_back([&, i] {
+            std::uint64_t seed = config.seed + static_cast<std::uint64_t>(i);
+            Client client(config, budget, detail::splitmix64(seed));
+            ok[i] = client.run(stats[i]);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    ClientStats total;
+    for (ClientStats& s : stats) {
+        total.games += s.games;
+        total.moves += s.moves;
+        total.errors += s.errors;
+        total.latencies.insert(total.latencies.end(), s.latencies.begin(), s.latencies.end());
+    }
+    std::sort(total.latencies.begin(), total.latencies.end());
+    std::printf("games: %llu  moves: %llu  errors: %llu  seconds: %.3f\n",
+                static_cast<unsigned long long>(total.games), static_cast<unsigned long long>(total.moves),
+                static_cast<unsigned long long>(total.errors), seconds);
+    std::printf("sessions/sec: %.0f  moves/sec: %.0f\n", total.games / seconds, total.moves / seconds);
+    std::printf("move latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                percentile(total.latencies, 0.50), percentile(total.latencies, 0.99),
+                percentile(total.latencies, 0.999), total.latencies.empty() ? 0.0 : total.latencies.back());
+    if (std::count(ok.begin(), ok.end(), 0) > 0) {
+        std::fprintf(stderr, "Some connections failed\n");
+        return 1;
+    }
+    return 0;
+}
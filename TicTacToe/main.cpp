@@ -1,7 +1,12 @@
 #include <windows.h>
+#include <memory>
 #include <vector>
 #include <random>
-#include "game.h"
+#include "AsyncEngine.h"
+#include "Game.h"
+#include "GameRecord.h"
+#include "Tablebase.h"
+#include "ValueTable.h"
 
 enum class GameMode {
     TwoPlayers,
@@ -9,17 +14,29 @@ enum class GameMode {
 };
 
 constexpr int CELL_SIZE = 100;
-bool playerIsX = true; //      (   )
-bool computerIsX = false; //   
+constexpr UINT WM_ENGINE_MOVE = WM_APP + 1;   // wParam — номер запроса, lParam — ход компьютера или -1
+bool playerIsX = true; // игрок — крестики или нолики (для игры с компьютером)
+bool computerIsX = false; // автоматически противоположно игроку
 
 void endGame(HWND hwnd, Game::Cell winner);
 bool AskResetStatistics(HWND hwnd);
 void ShowPlayerChoiceDialog(HWND hwnd);
+void applyComputerMove(HWND hwnd, int move);
 
 GameMode currentMode = GameMode::TwoPlayers;
 Game game;
+GameRecordWriter recorder;  // все сыгранные партии дописываются в games.ttr
 
-bool currentPlayer = true; // true  , false  ;         ,  
+// Поиск хода для позиций вне таблицы идёт в фоновом потоке; ответы на устаревшие запросы отбрасываются
+std::unique_ptr<AsyncEngine<Game>> engine;
+std::uint64_t expectedTicket = 0;
+
+// Таблица ценности, выученная самоигрой (TicTacToeTrain --out values.ttv); ходы по ней мгновенные
+ValueTable learned;
+bool learnedLoaded = false;
+bool useLearned = false;
+
+bool currentPlayer = true; // true — крестики, false — нолики; в игре с компом — может быть и игрок, и комп
 bool gameOver = false;
 
 int winsX = 0;
@@ -31,32 +48,32 @@ constexpr int OFFSET_Y = 30;
 void drawBoard(HDC hdc) {
     wchar_t stats[200];
 
-    //        
-    swprintf_s(stats, L"X: %d   O: %d   : %d", winsX, winsO, draws);
+    // Статистика с обозначением кто крестики и кто нолики
+    swprintf_s(stats, L"X: %d   O: %d   Ничья: %d", winsX, winsO, draws);
 
     TextOut(hdc, 10, 10, stats, wcslen(stats));
 
-    //         
+    // Отображаем текущий ход — упрощённо в режиме с компьютером
     const wchar_t* turnText = nullptr;
     if (gameOver) {
-        turnText = L" ";
+        turnText = L"Игра окончена";
     }
     else {
         if (currentMode == GameMode::VsComputer) {
             if ((currentPlayer == playerIsX)) {
-                turnText = L" ";
+                turnText = L"Ваш ход";
             }
             else {
-                turnText = L" ...";
+                turnText = L"Ход компьютера...";
             }
         }
         else {
-            //  
+            // Два игрока
             if (currentPlayer) {
-                turnText = L"   (X)";
+                turnText = L"Сейчас ходит игрок (X)";
             }
             else {
-                turnText = L"   (O)";
+                turnText = L"Сейчас ходит игрок (O)";
             }
         }
     }
@@ -90,44 +107,52 @@ void drawBoard(HDC hdc) {
     }
 }
 
+/**
+ * @brief Отменяет поиск компьютера: при сбросе партии, смене режима и отмене ходов.
+ */
+void cancelComputerMove() {
+    if (engine)
+        engine->cancel();
+    expectedTicket = 0;
+}
+
+/**
+ * @brief Делает ход компьютера: из таблицы сразу, иначе ответ придёт сообщением WM_ENGINE_MOVE.
+ */
 void computerMove(HWND hwnd) {
     if (gameOver) return;
 
-    //     
+    // Компьютер всегда ходит своим символом
     Game::Cell compCell = computerIsX ? Game::Cell::X : Game::Cell::O;
 
-    const auto& board = game.getBoard();
-
-    //  : ,  ,  
-
-    if (board[1][1] == Game::Cell::Empty) {
-        game.makeMove(1, 1, compCell);
+    if (useLearned) {
+        applyComputerMove(hwnd, learned.bestMove(game, compCell));
+        return;
     }
-    else {
-        std::vector<std::pair<int, int>> corners = {
-            {0, 0}, {0, 2}, {2, 0}, {2, 2}
-        };
-        bool moved = false;
-        for (const auto& [y, x] : corners) {
-            if (board[y][x] == Game::Cell::Empty) {
-                game.makeMove(y, x, compCell);
-                moved = true;
-                break;
-            }
-        }
-        if (!moved) {
-            std::vector<std::pair<int, int>> sides = {
-                {0, 1}, {1, 0}, {1, 2}, {2, 1}
-            };
-            for (const auto& [y, x] : sides) {
-                if (board[y][x] == Game::Cell::Empty) {
-                    game.makeMove(y, x, compCell);
-                    break;
-                }
-            }
-        }
+
+    // Идеальная игра: лучший ход берётся из таблицы, построенной при компиляции, без поиска
+    const int move = Tablebase::bestMove(game);
+    if (move >= 0 || !engine) {
+        applyComputerMove(hwnd, move);
+        return;
     }
 
+    // Позиции нет в таблице: поиск идёт в потоке движка, окно продолжает обрабатывать сообщения
+    engine->start(game, compCell, {}, [hwnd](const EngineResult& result) {
+        PostMessage(hwnd, WM_ENGINE_MOVE, static_cast<WPARAM>(result.ticket),
+                    static_cast<LPARAM>(result.cancelled ? -1 : result.result.move));
+    });
+    expectedTicket = engine->lastTicket();
+}
+
+/**
+ * @brief Делает ход компьютера и возвращает ход игроку, если партия продолжается.
+ */
+void applyComputerMove(HWND hwnd, int move) {
+    Game::Cell compCell = computerIsX ? Game::Cell::X : Game::Cell::O;
+    if (move >= 0)
+        game.makeMove(move / Game::BOARD_SIZE, move % Game::BOARD_SIZE, compCell);
+
     auto winner = game.checkWinner();
     if (winner != Game::Cell::Empty) {
         endGame(hwnd, winner);
@@ -138,18 +163,30 @@ void computerMove(HWND hwnd) {
         return;
     }
 
-    currentPlayer = playerIsX;  //   
+    currentPlayer = playerIsX;  // ход возвращается игроку
     RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
     InvalidateRect(hwnd, nullptr, TRUE);
 }
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
+    case WM_ENGINE_MOVE: {
+        // Ход мог устареть: партию сбросили, режим сменили или ход отменили
+        const int move = static_cast<int>(lParam);
+        if (static_cast<std::uint64_t>(wParam) != expectedTicket || move < 0 || gameOver ||
+            currentMode != GameMode::VsComputer || currentPlayer != computerIsX)
+            return 0;
+        expectedTicket = 0;
+        applyComputerMove(hwnd, move);
+        return 0;
+    }
+
     case WM_LBUTTONDOWN: {
         if (gameOver) {
+            cancelComputerMove();
             game.reset();
             gameOver = false;
-            currentPlayer = playerIsX; //     
+            currentPlayer = playerIsX; // при сбросе игры ходит игрок
             RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
             InvalidateRect(hwnd, nullptr, TRUE);
             return 0;
@@ -171,8 +208,8 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                         return 0;
                     }
                     else {
-                        currentPlayer = computerIsX; //  
-                        computerMove(hwnd);          //    
+                        currentPlayer = computerIsX; // ход компьютера
+                        computerMove(hwnd);          // из таблицы сразу, поиск — сообщением WM_ENGINE_MOVE
                     }
                     RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
                     InvalidateRect(hwnd, nullptr, TRUE);
@@ -199,18 +236,19 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
     }
 
     case WM_RBUTTONDOWN: {
+        cancelComputerMove();
         winsX = winsO = draws = 0;
         int result = MessageBox(hwnd,
-            L"  :\n   \n   ",
-            L" ", MB_YESNO | MB_ICONQUESTION);
+            L"Выберите режим игры:\nДа — два игрока\nНет — против компьютера",
+            L"Выбор режима", MB_YESNO | MB_ICONQUESTION);
         currentMode = (result == IDYES) ? GameMode::TwoPlayers : GameMode::VsComputer;
 
         if (currentMode == GameMode::TwoPlayers) {
-            //   :     
+            // Для двух игроков: крестики ходят первыми по умолчанию
             currentPlayer = true;
         }
         else {
-            //            
+            // Для игры с компьютером вызываем диалог выбора фигуры и кто ходит первым
             ShowPlayerChoiceDialog(hwnd);
         }
 
@@ -221,15 +259,36 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         return 0;
     }
 
+    case WM_KEYDOWN: {
+        // Ctrl+Z — отменить ход, Ctrl+Y — повторить отменённый ход
+        if (gameOver || !(GetKeyState(VK_CONTROL) & 0x8000) || (wParam != 'Z' && wParam != 'Y'))
+            break;
+        const bool isUndo = (wParam == 'Z');
+        cancelComputerMove();
+        if (!(isUndo ? game.undo() : game.redo()))
+            return 0;
+        if (currentMode == GameMode::VsComputer) {
+            // Против компьютера откатываем и его ответ: ход должен вернуться игроку
+            while (((game.moveCount() % 2 == 0) != playerIsX) && (isUndo ? game.undo() : game.redo()))
+                ;
+        }
+        currentPlayer = (game.moveCount() % 2 == 0);
+        if (currentMode == GameMode::VsComputer && currentPlayer == computerIsX)
+            computerMove(hwnd);
+        RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
+        InvalidateRect(hwnd, nullptr, TRUE);
+        return 0;
+    }
+
     case WM_PAINT: {
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
 
         RECT rect;
         GetClientRect(hwnd, &rect);
-        FillRect(hdc, &rect, (HBRUSH)(COLOR_WINDOW + 1));  //  
+        FillRect(hdc, &rect, (HBRUSH)(COLOR_WINDOW + 1));  // очистка фона
 
-        drawBoard(hdc);  //   
+        drawBoard(hdc);  // рисуем игровое поле
 
         EndPaint(hwnd, &ps);
         return 0;
@@ -246,6 +305,10 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     const wchar_t CLASS_NAME[] = L"TicTacToeClass";
 
+    recorder.open("games.ttr");
+    learnedLoaded = learned.load("values.ttv");
+    engine = std::make_unique<AsyncEngine<Game>>();
+
     WNDCLASS wc = {};
     wc.lpfnWndProc = WindowProc;
     wc.hInstance = hInstance;
@@ -256,7 +319,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     AdjustWindowRect(&rect, WS_OVERLAPPEDWINDOW & ~WS_THICKFRAME & ~WS_MAXIMIZEBOX, FALSE);
 
     HWND hwnd = CreateWindowEx(
-        0, CLASS_NAME, L"-",
+        0, CLASS_NAME, L"Крестики-нолики",
         WS_OVERLAPPEDWINDOW & ~WS_THICKFRAME & ~WS_MAXIMIZEBOX,
         CW_USEDEFAULT, CW_USEDEFAULT,
         rect.right - rect.left, rect.bottom - rect.top,
@@ -267,8 +330,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
     ShowWindow(hwnd, nCmdShow);
 
     int result = MessageBox(hwnd,
-        L" :\n   \n   ",
-        L" ", MB_YESNO | MB_ICONQUESTION);
+        L"Выберите режим:\nДа — два игрока\nНет — против компьютера",
+        L"Режим игры", MB_YESNO | MB_ICONQUESTION);
 
     currentMode = (result == IDYES) ? GameMode::TwoPlayers : GameMode::VsComputer;
 
@@ -280,30 +343,37 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
         DispatchMessage(&msg);
     }
 
+    engine.reset();
     return 0;
 }
 
 void endGame(HWND hwnd, Game::Cell winner) {
     gameOver = true;
 
+    // Партия сохраняется сразу, чтобы не потерять её при закрытии окна
+    if (recorder.isOpen()) {
+        recorder.append(game);
+        recorder.flush();
+    }
+
     if (winner == Game::Cell::X) ++winsX;
     else if (winner == Game::Cell::O) ++winsO;
     else ++draws;
 
-    const wchar_t* message = (winner == Game::Cell::Empty) ? L"!" :
-        (winner == Game::Cell::X ? L" !" : L" !");
+    const wchar_t* message = (winner == Game::Cell::Empty) ? L"Ничья!" :
+        (winner == Game::Cell::X ? L"Победили крестики!" : L"Победили нолики!");
 
-    MessageBox(hwnd, message, L" ", MB_OK);
+    MessageBox(hwnd, message, L"Игра окончена", MB_OK);
 
     int newGame = MessageBox(hwnd,
-        L"  ?\n   \n  ",
-        L" ", MB_YESNO | MB_ICONQUESTION);
+        L"Начать новую игру?\nДа — выбрать режим\nНет — выйти",
+        L"Новая игра", MB_YESNO | MB_ICONQUESTION);
 
     if (newGame == IDYES) {
-        //   ,   
+        // Запросить режим игры, как при ПКМ
         int result = MessageBox(hwnd,
-            L" :\n   \n   ",
-            L" ", MB_YESNO | MB_ICONQUESTION);
+            L"Выберите режим:\nДа — два игрока\nНет — против компьютера",
+            L"Режим игры", MB_YESNO | MB_ICONQUESTION);
 
         currentMode = (result == IDYES) ? GameMode::TwoPlayers : GameMode::VsComputer;
 
@@ -322,55 +392,63 @@ void endGame(HWND hwnd, Game::Cell winner) {
 
 void ShowPlayerChoiceDialog(HWND hwnd) {
     if (currentMode == GameMode::TwoPlayers) {
-        //  1  
+        // Игрок 1 выбирает символ
         int result1 = MessageBox(hwnd,
-            L" 1: ,  \n"
-            L"   (X)\n"
-            L"   (O)",
-            L"  1", MB_YESNO | MB_ICONQUESTION);
+            L"Игрок 1: Выберите, кем играть\n"
+            L"Да — Крестики (X)\n"
+            L"Нет — Нолики (O)",
+            L"Выбор игрока 1", MB_YESNO | MB_ICONQUESTION);
 
         playerIsX = (result1 == IDYES);
-        computerIsX = !playerIsX; //  ,     
+        computerIsX = !playerIsX; // не используется, но пусть будет для порядка
 
         wchar_t msg[256];
-        swprintf_s(msg, L" 1  %s\n 2  %s",
-            playerIsX ? L" (X)" : L" (O)",
-            playerIsX ? L" (O)" : L" (X)");
+        swprintf_s(msg, L"Игрок 1 играет %s\nИгрок 2 играет %s",
+            playerIsX ? L"Крестики (X)" : L"Нолики (O)",
+            playerIsX ? L"Нолики (O)" : L"Крестики (X)");
 
-        MessageBox(hwnd, msg, L" ", MB_OK | MB_ICONINFORMATION);
+        MessageBox(hwnd, msg, L"Распределение символов", MB_OK | MB_ICONINFORMATION);
 
-        currentPlayer = true; //   
+        currentPlayer = true; // крестики ходят первыми
     }
     else {
-        //       
+        // Игра против компьютера — игрок выбирает фигуру
         int whoFirst = MessageBox(hwnd,
-            L"  :\n"
-            L"   (X)\n"
-            L"   (O)",
-            L" ", MB_YESNO | MB_ICONQUESTION);
+            L"Выберите свою фигуру:\n"
+            L"Да — Крестики (X)\n"
+            L"Нет — Нолики (O)",
+            L"Выбор фигуры", MB_YESNO | MB_ICONQUESTION);
 
         playerIsX = (whoFirst == IDYES);
         computerIsX = !playerIsX;
 
-        //  ,   
-        currentPlayer = true; //  
+        // Ходит тот, кто играет крестиками
+        currentPlayer = true; // крестики начинают
 
         wchar_t msg[256];
-        swprintf_s(msg, L"  %s\n  %s",
-            playerIsX ? L" (X)" : L" (O)",
-            computerIsX ? L" (X)" : L" (O)");
-
-        MessageBox(hwnd, msg, L" ", MB_OK | MB_ICONINFORMATION);
+        swprintf_s(msg, L"Вы играете %s\nКомпьютер играет %s",
+            playerIsX ? L"Крестики (X)" : L"Нолики (O)",
+            computerIsX ? L"Крестики (X)" : L"Нолики (O)");
+
+        MessageBox(hwnd, msg, L"Распределение символов", MB_OK | MB_ICONINFORMATION);
+
+        // Выученная стратегия предлагается, только если рядом лежит файл таблицы
+        useLearned = learnedLoaded && MessageBox(hwnd,
+            L"Использовать стратегию, выученную самоигрой?\n"
+            L"Да — выученная стратегия\n"
+            L"Нет — поиск",
+            L"Стратегия компьютера", MB_YESNO | MB_ICONQUESTION) == IDYES;
     }
 
-    //    
+    // Сброс игры и отрисовка
+    cancelComputerMove();
     game.reset();
     gameOver = false;
 
     RedrawWindow(hwnd, nullptr, nullptr, RDW_INVALIDATE | RDW_UPDATENOW);
     InvalidateRect(hwnd, nullptr, TRUE);
 
-    //      (  ),   
+    // Если после сброса ход компьютера (он играет крестиками), то пусть ходит
     if (currentMode == GameMode::VsComputer && currentPlayer == computerIsX) {
         computerMove(hwnd);
     }
@@ -379,6 +457,6 @@ void ShowPlayerChoiceDialog(HWND hwnd) {
 
 bool AskResetStatistics(HWND hwnd)
 {
-    int result = MessageBox(hwnd, L" ?", L"", MB_YESNO | MB_ICONQUESTION);
+    int result = MessageBox(hwnd, L"Сбросить статистику?", L"Статистика", MB_YESNO | MB_ICONQUESTION);
     return (result == IDYES);
 }
@@ -0,0 +1,137 @@
+/**
+ * @file records.cpp
+ * @brief Работа с файлами записей партий: преобразование в текст и обратно, статистика.
+ *
+ * Примеры:
+ *   TicTacToeRecords to-text games.ttr games.txt
+ *   TicTacToeRecords from-text games.txt games.ttr
+ *   TicTacToeRecords stats games.ttr
+ */
+
+#include "GameRecord.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s to-text FILE.ttr [FILE.txt]\n"
+                "       %s from-text FILE.txt FILE.ttr\n"
+                "       %s stats FILE.ttr\n", program, program, program);
+}
+
+bool openReader(GameRecordReader& reader, const char* path) {
+    std::string error;
+    if (!reader.open(path, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+    std::size_t bad = 0;
+    if (!reader.verify(&bad)) {
+        std::fprintf(stderr, "%s: checksum mismatch in block %zu\n", path, bad);
+        return false;
+    }
+    if (reader.truncated())
+        std::fprintf(stderr, "%s: incomplete trailing block ignored\n", path);
+    return true;
+}
+
+int toText(const char* input, const char* output) {
+    GameRecordReader reader;
+    if (!openReader(reader, input))
+        return 1;
+    std::FILE* out = output ? std::fopen(output, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+    reader.forEach([&](std::uint32_t record) {
+        std::fprintf(out, "%s\n", GameRecord::toText(record).c_str());
+    });
+    if (output)
+        std::fclose(out);
+    return 0;
+}
+
+int fromText(const char* input, const char* output) {
+    std::ifstream in(input);
+    if (!in) {
+        std::fprintf(stderr, "Cannot read %s\n", input);
+        return 1;
+    }
+    GameRecordWriter writer;
+    std::string error;
+    if (!writer.open(output, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::string line;
+    std::uint64_t lineNumber = 0, written = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#')
+            continue;
+        std::uint32_t record;
+        if (!GameRecord::fromText(line, record)) {
+            std::fprintf(stderr, "%s:%llu: invalid game record\n", input, static_cast<unsigned long long>(lineNumber));
+            return 1;
+        }
+        writer.append(record);
+        ++written;
+    }
+    if (!writer.flush()) {
+        std::fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+    std::printf("%llu games written\n", static_cast<unsigned long long>(written));
+    return 0;
+}
+
+/**
+ * @brief Считает исходы и длины партий прямо по отображённому файлу.
+ */
+int stats(const char* input) {
+    GameRecordReader reader;
+    if (!openReader(reader, input))
+        return 1;
+    std::uint64_t outcomes[4] = {};
+    std::uint64_t lengths[Game::CELL_COUNT + 1] = {};
+    const auto started = std::chrono::steady_clock::now();
+    reader.forEach([&](std::uint32_t record) {
+        ++outcomes[GameRecord::outcome(record)];
+        ++lengths[GameRecord::length(record)];
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    const std::uint64_t total = reader.recordCount();
+    std::printf("games: %llu  blocks: %zu\n", static_cast<unsigned long long>(total), reader.blocks().size());
+    std::printf("X wins: %llu  O wins: %llu  draws: %llu  unfinished: %llu\n",
+                static_cast<unsigned long long>(outcomes[GameRecord::XWin]),
+                static_cast<unsigned long long>(outcomes[GameRecord::OWin]),
+                static_cast<unsigned long long>(outcomes[GameRecord::Draw]),
+                static_cast<unsigned long long>(outcomes[GameRecord::Unfinished]));
+    for (int length = 0; length <= Game::CELL_COUNT; ++length)
+        if (lengths[length])
+            std::printf("  length %d: %llu\n", length, static_cast<unsigned long long>(lengths[length]));
+    if (seconds > 0.0)
+        std::printf("scan: %.3f s, %.0f games/sec, %.2f GB/s\n", seconds, total / seconds,
+                    total * sizeof(std::uint32_t) / seconds / 1e9);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && !std::strcmp(argv[1], "to-text"))
+        return toText(argv[2], argc >= 4 ? argv[3] : nullptr);
+    if (argc == 4 && !std::strcmp(argv[1], "from-text"))
+        return fromText(argv[2], argv[3]);
+    if (argc == 3 && !std::strcmp(argv[1], "stats"))
+        return stats(argv[2]);
+    printUsage(argv[0]);
+    return 1;
+}
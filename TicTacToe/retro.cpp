@@ -0,0 +1,140 @@
+/**
+ * @file retro.cpp
+ * @brief Построение и проверка таблиц ретроградного анализа.
+ *
+ * Пример: TicTacToeRetro --size 4 --k 4 --dir tables4x4 --threads 8
+ * Эндшпиль Qubic: TicTacToeRetro --qubic --base <64 клетки X/O/.> --dir qubic1
+ * Запрос к готовой таблице: TicTacToeRetro --size 4 --k 4 --dir tables4x4 --probe X....O..........
+ */
+
+#include "Retrograde.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s --dir DIR [--size N] [--k K] [--qubic] [--base CELLS] [--threads N] [--chunk N]\n"
+                "       %s --dir DIR [--size N] [--k K] [--qubic] [--base CELLS] --probe CELLS\n"
+                "CELLS lists every cell as X, O or '.' (z * 16 + y * 4 + x for --qubic).\n", program, program);
+}
+
+/**
+ * @brief Разбирает строку клеток в битовые маски.
+ */
+bool parseCells(const std::string& text, int cells, std::uint64_t& xBits, std::uint64_t& oBits) {
+    xBits = oBits = 0;
+    if (static_cast<int>(text.size()) != cells)
+        return false;
+    for (int cell = 0; cell < cells; ++cell) {
+        const char c = text[cell];
+        if (c == 'X' || c == 'x')
+            xBits |= 1ull << cell;
+        else if (c == 'O' || c == 'o')
+            oBits |= 1ull << cell;
+        else if (c != '.' && c != '-')
+            return false;
+    }
+    return true;
+}
+
+const char* valueName(RetrogradeTable::Value value) {
+    switch (value) {
+    case RetrogradeTable::Win: return "win";
+    case RetrogradeTable::Loss: return "loss";
+    case RetrogradeTable::Draw: return "draw";
+    default: return "unknown";
+    }
+}
+
+double megabytes(std::uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int size = 4, winLength = 4;
+    bool qubic = false;
+    std::string directory, baseText, probeText;
+    RetrogradeOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--dir") && hasValue)
+            directory = argv[++i];
+        else if (!std::strcmp(argv[i], "--size") && hasValue)
+            size = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--k") && hasValue)
+            winLength = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--qubic"))
+            qubic = true;
+        else if (!std::strcmp(argv[i], "--base") && hasValue)
+            baseText = argv[++i];
+        else if (!std::strcmp(argv[i], "--probe") && hasValue)
+            probeText = argv[++i];
+        else if (!std::strcmp(argv[i], "--threads") && hasValue)
+            options.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--chunk") && hasValue)
+            options.chunkEntries = std::strtoull(argv[++i], nullptr, 10);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (directory.empty() || (!qubic && (size < 1 || size > 8 || winLength < 1 || winLength > size))) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const RetrogradeRules rules = qubic ? RetrogradeRules::qubic() : RetrogradeRules::board(size, winLength);
+    std::uint64_t baseX = 0, baseO = 0;
+    if (!baseText.empty() && !parseCells(baseText, rules.cells, baseX, baseO)) {
+        std::fprintf(stderr, "--base needs %d cells of X, O or '.'\n", rules.cells);
+        return 1;
+    }
+
+    std::string error;
+    if (probeText.empty()) {
+        RetrogradeStats stats;
+        int reportedLayer = -1;
+        std::uint64_t reported = 0;
+        const bool ok = RetrogradeTable::build(rules, baseX, baseO, directory, options, &stats,
+            [&](int stones, std::uint64_t done, std::uint64_t total) {
+                // Не чаще одного сообщения на процент слоя
+                if (stones != reportedLayer || done == total || (done - reported) * 100 >= total) {
+                    reportedLayer = stones;
+                    reported = done;
+                    std::fprintf(stderr, "\rlayer %2d: %llu/%llu", stones, static_cast<unsigned long long>(done),
+                                 static_cast<unsigned long long>(total));
+                }
+            }, &error);
+        std::fprintf(stderr, "\n");
+        if (!ok) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        for (const RetrogradeLayerStats& layer : stats.layers)
+            std::printf("layer %2d: %12llu positions  win %llu  loss %llu  draw %llu  invalid %llu  %.3f s  peak RSS %.1f MB\n",
+                        layer.stones, static_cast<unsigned long long>(layer.entries),
+                        static_cast<unsigned long long>(layer.wins), static_cast<unsigned long long>(layer.losses),
+                        static_cast<unsigned long long>(layer.draws), static_cast<unsigned long long>(layer.invalid),
+                        layer.seconds, megabytes(layer.peakResidentBytes));
+        std::printf("positions: %llu  table: %.1f MB  time: %.3f s  positions/s: %.0f  peak RSS: %.1f MB\n",
+                    static_cast<unsigned long long>(stats.entries), megabytes(stats.tableBytes), stats.seconds,
+                    stats.seconds > 0.0 ? stats.entries / stats.seconds : 0.0, megabytes(stats.peakResidentBytes));
+    }
+
+    RetrogradeTable table;
+    if (!table.open(rules, baseX, baseO, directory, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::uint64_t xBits = baseX, oBits = baseO;
+    if (!probeText.empty() && !parseCells(probeText, rules.cells, xBits, oBits)) {
+        std::fprintf(stderr, "--probe needs %d cells of X, O or '.'\n", rules.cells);
+        return 1;
+    }
+    std::printf("%s: %s for the side to move, best move %d\n", probeText.empty() ? "base position" : "position",
+                valueName(table.probe(xBits, oBits)), table.bestMove(xBits, oBits));
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file server.cpp
+ * @brief Консольный сервер партий против компьютера.
+ *
+ * Пример: TicTacToeServer --port 7777 --workers 4
+ * Через Unix-сокет: TicTacToeServer --unix /tmp/tictactoe.sock
+ */
+
+#include "GameServer.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+GameServer* activeServer = nullptr;
+
+void onSignal(int) {
+    if (activeServer)
+        activeServer->stop();
+}
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s [--port N | --unix PATH] [--workers N] [--sessions N] [--connections N]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    ServerConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--port") && hasValue)
+            config.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--unix") && hasValue)
+            config.unixPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--workers") && hasValue)
+            config.workers = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--sessions") && hasValue)
+            config.sessionCapacity = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (!std::strcmp(argv[i], "--connections") && hasValue)
+            config.connectionCapacity = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    GameServer server(config);
+    std::string error;
+    if (!server.start(&error)) {
+        std::fprintf(stderr, "Cannot start server: %s\n", error.c_str());
+        return 1;
+    }
+    activeServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    if (config.unixPath.empty())
+        std::printf("Listening on 127.0.0.1:%u\n", server.port());
+    else
+        std::printf("Listening on %s\n", config.unixPath.c_str());
+    std::fflush(stdout);
+    server.run();
+    activeServer = nullptr;
+
+    const ServerStats& stats = server.stats();
+    std::printf("connections: %llu  sessions: %llu  moves: %llu  ai moves: %llu  errors: %llu\n",
+                static_cast<unsigned long long>(stats.connections),
+                static_cast<unsigned long long>(stats.sessionsOpened),
+                static_cast<unsigned long long>(stats.moves),
+                static_cast<unsigned long long>(stats.aiMoves),
+                static_cast<unsigned long long>(stats.errors));
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file simulate.cpp
+ * @brief Консольное моделирование партий между стратегиями.
+ *
+ * Пример: TicTacToeSim --games 1000000 --x random --o heuristic --threads 8 --seed 42
+ * Запись партий в файл: TicTacToeSim --games 1000000 --record games.ttr
+ * Масштабирование MCTS на поле 15x15: TicTacToeSim --mcts-scaling 2
+ * Счётчики и трасса (сборка с TICTACTOE_INSTRUMENTATION):
+ *   TicTacToeSim --x search --metrics metrics.json --trace trace.json
+ * Ultimate tic-tac-toe: TicTacToeSim --ultimate --x mcts:1000 --o random
+ * Стратегия, выученная самоигрой (TicTacToeTrain): TicTacToeSim --x learned:values.ttv --o search
+ */
+
+#include "Instrumentation.h"
+#include "Simulator.h"
+#include "UltimateGame.h"
+
+#include <algorithm>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s [--games N] [--x POLICY] [--o POLICY] [--threads N] [--seed N] [--record FILE]\n"
+                "          [--ultimate] [--metrics FILE] [--trace FILE]\n"
+                "       %s --mcts-scaling SECONDS [--threads N]\n"
+                "Policies: random, heuristic, search, search:<depth>, timed:<ms>, mcts:<playouts>, learned:<file>\n", program, program);
+}
+
+/**
+ * @brief Измеряет скорость MCTS на пустом поле 15x15 для 1, 2, 4, ... потоков.
+ */
+int runMctsScaling(double seconds, int maxThreads) {
+    if (maxThreads <= 0)
+        maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    using Gomoku = BasicGame<15, 5>;
+    double baseline = 0.0;
+    for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        Mcts<Gomoku> mcts(1 << 22);
+        MctsLimits limits;
+        limits.seconds = seconds;
+        limits.threads = threads;
+        const MctsResult result = mcts.search(Gomoku(), Game::X, limits);
+        if (threads == 1)
+            baseline = result.playoutsPerSecond();
+        std::printf("threads: %2d  playouts: %9llu  playouts/sec: %10.0f  speedup: %5.2fx  nodes: %zu\n",
+                    threads, static_cast<unsigned long long>(result.playouts), result.playoutsPerSecond(),
+                    baseline > 0.0 ? result.playoutsPerSecond() / baseline : 0.0, result.nodesUsed);
+        for (std::size_t i = 0; i < result.threadPlayouts.size(); ++i)
+            std::printf("    thread %2zu: %llu playouts\n", i, static_cast<unsigned long long>(result.threadPlayouts[i]));
+        if (threads == maxThreads)
+            return 0;
+    }
+}
+
+double percent(std::uint64_t part, std::uint64_t total) {
+    return total ? 100.0 * part / total : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SimulationConfig config;
+    double scalingSeconds = 0.0;
+    bool ultimate = false;
+    std::string metricsPath;
+    std::string tracePath;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--games") && hasValue)
+            config.games = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--x") && hasValue)
+            config.xPolicy = argv[++i];
+        else if (!std::strcmp(argv[i], "--o") && hasValue)
+            config.oPolicy = argv[++i];
+        else if (!std::strcmp(argv[i], "--threads") && hasValue)
+            config.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && hasValue)
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--record") && hasValue)
+            config.recordPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--ultimate"))
+            ultimate = true;
+        else if (!std::strcmp(argv[i], "--metrics") && hasValue)
+            metricsPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--trace") && hasValue)
+            tracePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--mcts-scaling") && hasValue)
+            scalingSeconds = std::atof(argv[++i]);
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!instrumentation::ENABLED && (!metricsPath.empty() || !tracePath.empty()))
+        std::fprintf(stderr, "Built without TICTACTOE_INSTRUMENTATION: metrics and trace will be empty\n");
+    instrumentation::setTracing(!tracePath.empty());
+    if (scalingSeconds > 0.0)
+        return runMctsScaling(scalingSeconds, config.threads);
+
+    const SimulationStats stats = ultimate ? Simulator<UltimateGame>(config).run() : Simulator<Game>(config).run();
+    if (stats.games == 0) {
+        std::fprintf(stderr, "Unknown policy, unwritable record file or no games to play\n");
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::printf("games:          %llu (threads: %d, seed: %llu)\n",
+                static_cast<unsigned long long>(stats.games), TaskScheduler(config.threads).threadCount(),
+                static_cast<unsigned long long>(config.seed));
+    std::printf("X (%s) wins:  %llu (%.2f%%)\n", config.xPolicy.c_str(),
+                static_cast<unsigned long long>(stats.xWins), percent(stats.xWins, stats.games));
+    std::printf("O (%s) wins:  %llu (%.2f%%)\n", config.oPolicy.c_str(),
+                static_cast<unsigned long long>(stats.oWins), percent(stats.oWins, stats.games));
+    std::printf("draws:          %llu (%.2f%%)\n",
+                static_cast<unsigned long long>(stats.draws), percent(stats.draws, stats.games));
+    std::printf("average length: %.3f moves\n", stats.averageLength());
+    std::printf("time:           %.3f s (%.0f games/sec)\n", stats.seconds, stats.gamesPerSecond());
+
+    if (!metricsPath.empty() && !instrumentation::writeJson(metricsPath, instrumentation::snapshot())) {
+        std::fprintf(stderr, "Cannot write %s\n", metricsPath.c_str());
+        return 1;
+    }
+    if (!tracePath.empty() && !instrumentation::writeChromeTrace(tracePath)) {
+        std::fprintf(stderr, "Cannot write %s\n", tracePath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -1,29 +1,67 @@
 /**
  * @file test_game.cpp
- * @brief    Game (-).
+ * @brief Тесты для класса Game (крестики-нолики).
  */
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest.h"
+#include "AsyncEngine.h"
+#include "BoardBatch.h"
 #include "Game.h"
+#include "GameRecord.h"
+#include "Instrumentation.h"
+#include "Mcts.h"
+#include "Perft.h"
+#include "PositionAnalyzer.h"
+#include "PositionCache.h"
+#include "PositionRank.h"
+#include "Retrograde.h"
+#include "Solver.h"
+#include "Simulator.h"
+#include "Tablebase.h"
+#include "ThreatEvaluator.h"
+#include "TranspositionTable.h"
+#include "UltimateGame.h"
+#include "ValueTable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include "GameServer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
  /**
-  * @brief   makeMove    .
+  * @brief Тестирует функцию makeMove и состояние игрового поля.
   */
 TEST_CASE("Test makeMove and board state") {
     Game game;
-    CHECK(game.makeMove(0, 0, Game::Cell::X) == true);      /**<     */
-    CHECK(game.makeMove(0, 0, Game::Cell::O) == false);     /**<      */
-    CHECK(game.makeMove(3, 3, Game::Cell::X) == false);     /**<     */
+    CHECK(game.makeMove(0, 0, Game::Cell::X) == true);      /**< Ход в пустую ячейку */
+    CHECK(game.makeMove(0, 0, Game::Cell::O) == false);     /**< Ход в уже занятое поле */
+    CHECK(game.makeMove(3, 3, Game::Cell::X) == false);     /**< Ход вне игрового поля */
 }
 
 /**
- * @brief   .
+ * @brief Тестирует определение победителя.
  */
 TEST_CASE("Test winner detection") {
     Game game;
 
-    //   X
+    // Горизонтальная линия X
     game.makeMove(0, 0, Game::Cell::X);
     game.makeMove(1, 0, Game::Cell::X);
     game.makeMove(2, 0, Game::Cell::X);
@@ -31,7 +69,7 @@ TEST_CASE("Test winner detection") {
 
     game.reset();
 
-    //  O
+    // Диагональ O
     game.makeMove(0, 0, Game::Cell::O);
     game.makeMove(1, 1, Game::Cell::O);
     game.makeMove(2, 2, Game::Cell::O);
@@ -39,7 +77,7 @@ TEST_CASE("Test winner detection") {
 }
 
 /**
- * @brief   .
+ * @brief Тестирует ситуацию ничьей.
  */
 TEST_CASE("Test draw") {
     Game game;
@@ -55,3 +93,1947 @@ TEST_CASE("Test draw") {
     CHECK(game.isDraw() == true);
     CHECK(game.checkWinner() == Game::Cell::Empty);
 }
+
+/**
+ * @brief Проверяет согласованность битбордов и представления getBoard().
+ */
+TEST_CASE("Test bitboard view") {
+    Game game;
+    game.makeMove(1, 1, Game::Cell::X);
+    game.makeMove(0, 2, Game::Cell::O);
+    CHECK(game.getBits(Game::Cell::X) == (1 << 4));
+    CHECK(game.getBits(Game::Cell::O) == (1 << 2));
+    CHECK(game.getBits(Game::Cell::Empty) == (Game::FULL_BOARD & ~((1 << 4) | (1 << 2))));
+
+    const auto board = game.getBoard();
+    CHECK(board[1][1] == Game::Cell::X);
+    CHECK(board[0][2] == Game::Cell::O);
+    CHECK(board[2][0] == Game::Cell::Empty);
+    CHECK(game.getCell(0, 2) == Game::Cell::O);
+}
+
+/**
+ * @brief Проверяет инкрементальное определение победителя на поле 15x15 (5 в ряд).
+ */
+TEST_CASE("Test gomoku winner detection") {
+    BasicGame<15, 5> game;
+    for (int i = 0; i < 4; ++i)
+        CHECK(game.makeMove(7, 3 + i, Game::Cell::X));
+    CHECK(game.checkWinner() == Game::Cell::Empty);   /**< Четыре в ряд — ещё не победа */
+    CHECK(game.makeMove(7, 8, Game::Cell::X));
+    CHECK(game.checkWinner() == Game::Cell::Empty);   /**< Разрыв в линии */
+    CHECK(game.makeMove(7, 7, Game::Cell::X));
+    CHECK(game.checkWinner() == Game::Cell::X);       /**< Ход в середину замыкает линию */
+
+    game.reset();
+    for (int i = 0; i < 5; ++i)
+        game.makeMove(4 + i, 10 - i, Game::Cell::O);
+    CHECK(game.checkWinner() == Game::Cell::O);       /**< Побочная диагональ */
+    CHECK(game.makeMove(15, 0, Game::Cell::X) == false);
+}
+
+/**
+ * @brief Сравнивает специализацию 3x3 с полем, размер которого задан во время выполнения.
+ */
+TEST_CASE("Test runtime-sized board matches 3x3 specialization") {
+    std::mt19937 rng(42);
+    for (int gameIndex = 0; gameIndex < 1000; ++gameIndex) {
+        Game fixed;
+        DynamicGame dynamic(3, 3);
+        Game::Cell player = Game::Cell::X;
+        while (fixed.checkWinner() == Game::Cell::Empty && !fixed.isDraw()) {
+            const int y = static_cast<int>(rng() % 3), x = static_cast<int>(rng() % 3);
+            const bool moved = fixed.makeMove(y, x, player);
+            REQUIRE(dynamic.makeMove(y, x, player) == moved);
+            if (moved)
+                player = Game::opponent(player);
+            CHECK(dynamic.checkWinner() == fixed.checkWinner());
+            CHECK(dynamic.isDraw() == fixed.isDraw());
+        }
+    }
+}
+
+/**
+ * @brief Проверяет пакетные проверки BoardBatch во всех доступных реализациях против Game.
+ */
+TEST_CASE("Test board batch") {
+    // Нечётное число полей проверяет дополнение до 64 и скалярный хвост ходов
+    constexpr int BOARDS = 1000;
+    std::mt19937 rng(5);
+    std::vector<Game> games(BOARDS);
+    for (Game& game : games) {
+        const int moves = static_cast<int>(rng() % 10);
+        Game::Cell player = Game::Cell::X;
+        for (int m = 0; m < moves && game.checkWinner() == Game::Cell::Empty && !game.isDraw();) {
+            const int cell = static_cast<int>(rng() % 9);
+            if (game.makeMove(cell / 3, cell % 3, player)) {
+                player = Game::opponent(player);
+                ++m;
+            }
+        }
+    }
+
+    for (int kernel = BoardBatch::Scalar; kernel <= BoardBatch::bestKernel(); ++kernel) {
+        BoardBatch batch(BOARDS);
+        CHECK(batch.setKernel(static_cast<BoardBatch::Kernel>(kernel)) == kernel);
+        CHECK(batch.maskWords() == 16);
+        for (int i = 0; i < BOARDS; ++i)
+            batch.set(i, games[i]);
+
+        std::vector<std::uint64_t> xWins(batch.maskWords()), oWins(batch.maskWords()), draws(batch.maskWords());
+        auto bit = [](const std::vector<std::uint64_t>& mask, int i) { return (mask[i / 64] >> (i % 64)) & 1; };
+        batch.checkWinner(xWins.data(), oWins.data());
+        batch.isDraw(draws.data());
+        int mismatches = 0;
+        for (int i = 0; i < BOARDS; ++i) {
+            mismatches += bit(xWins, i) != (games[i].checkWinner() == Game::Cell::X);
+            mismatches += bit(oWins, i) != (games[i].checkWinner() == Game::Cell::O);
+            mismatches += bit(draws, i) != games[i].isDraw();
+        }
+        CHECK(mismatches == 0);
+        CHECK((xWins[15] >> (BOARDS % 64)) == 0);     /**< Пустые поля дополнения не дают побед */
+
+        // Пакетный ход совпадает с ходом на каждом поле; отрицательная клетка пропускает поле
+        std::vector<Game> moved = games;
+        std::vector<std::int8_t> cells(BOARDS, -1);
+        for (int i = 0; i < BOARDS; i += 3) {
+            for (int cell = 0; cell < 9; ++cell) {
+                if (moved[i].getCell(cell / 3, cell % 3) == Game::Cell::Empty) {
+                    moved[i].makeMove(cell / 3, cell % 3, Game::Cell::O);
+                    cells[i] = static_cast<std::int8_t>(cell);
+                    break;
+                }
+            }
+        }
+        batch.makeMove(cells.data(), Game::Cell::O);
+        mismatches = 0;
+        for (int i = 0; i < BOARDS; ++i)
+            mismatches += batch.bits(i, Game::Cell::O) != moved[i].getBits(Game::Cell::O) ||
+                          batch.bits(i, Game::Cell::X) != moved[i].getBits(Game::Cell::X);
+        CHECK(mismatches == 0);
+    }
+}
+
+/**
+ * @brief Проверяет, что unmakeMove() восстанавливает поле, победителя и хеш.
+ */
+TEST_CASE("Test make/unmake restores position") {
+    std::mt19937 rng(7);
+    BasicGame<7, 4> game;
+    DynamicGame dynamic(7, 4);
+    std::vector<std::uint64_t> hashes{ game.hash() };
+    std::vector<Game::Cell> winners{ game.checkWinner() };
+    Game::Cell player = Game::Cell::X;
+    while (game.moveCount() < 49) {
+        const int y = static_cast<int>(rng() % 7), x = static_cast<int>(rng() % 7);
+        if (!game.makeMove(y, x, player))
+            continue;
+        REQUIRE(dynamic.makeMove(y, x, player));
+        CHECK(dynamic.hash() == game.hash());
+        hashes.push_back(game.hash());
+        winners.push_back(game.checkWinner());
+        player = Game::opponent(player);
+    }
+    CHECK(game.isDraw() == (game.checkWinner() == Game::Cell::Empty));
+    while (game.moveCount() > 0) {
+        REQUIRE(game.unmakeMove());
+        REQUIRE(dynamic.unmakeMove());
+        hashes.pop_back();
+        winners.pop_back();
+        CHECK(game.hash() == hashes.back());
+        CHECK(dynamic.hash() == hashes.back());
+        CHECK(game.checkWinner() == winners.back());
+        CHECK(dynamic.checkWinner() == winners.back());
+    }
+    CHECK(game.hash() == 0);
+    CHECK(game.unmakeMove() == false);
+    CHECK(game.redo() == false);                            /**< unmakeMove() не оставляет ходов для повтора */
+}
+
+/**
+ * @brief Тестирует отмену и повтор ходов.
+ */
+TEST_CASE("Test undo and redo") {
+    Game game;
+    game.makeMove(1, 1, Game::Cell::X);
+    game.makeMove(0, 0, Game::Cell::O);
+    game.makeMove(0, 2, Game::Cell::X);
+    const std::uint64_t full = game.hash();
+
+    CHECK(game.undo());
+    CHECK(game.undo());
+    CHECK(game.moveCount() == 1);
+    CHECK(game.getCell(0, 0) == Game::Cell::Empty);
+    CHECK(game.redo());
+    CHECK(game.redo());
+    CHECK(game.redo() == false);
+    CHECK(game.hash() == full);
+    CHECK(game.getCell(0, 2) == Game::Cell::X);
+    CHECK(game.moveAt(1) == 0);
+
+    // Новый ход после отмены забывает отменённые ходы
+    CHECK(game.undo());
+    CHECK(game.makeMove(2, 2, Game::Cell::X));
+    CHECK(game.redo() == false);
+
+    // Отмена выигрышного хода снимает победителя
+    game.reset();
+    game.makeMove(0, 0, Game::Cell::X);
+    game.makeMove(0, 1, Game::Cell::X);
+    game.makeMove(0, 2, Game::Cell::X);
+    CHECK(game.checkWinner() == Game::Cell::X);
+    CHECK(game.undo());
+    CHECK(game.checkWinner() == Game::Cell::Empty);
+    CHECK(game.redo());
+    CHECK(game.checkWinner() == Game::Cell::X);
+}
+
+/**
+ * @brief Проверяет, что симметричные позиции имеют одинаковый канонический хеш.
+ */
+TEST_CASE("Test canonical hash under symmetry") {
+    std::mt19937 rng(3);
+    for (int gameIndex = 0; gameIndex < 200; ++gameIndex) {
+        BasicGame<5, 4> game;
+        std::array<BasicGame<5, 4>, Game::SYMMETRY_COUNT> images;
+        Game::Cell player = Game::Cell::X;
+        const int moves = static_cast<int>(rng() % 12);
+        for (int i = 0; i < moves; ++i) {
+            const int cell = static_cast<int>(rng() % 25);
+            if (!game.makeMove(cell / 5, cell % 5, player))
+                continue;
+            for (int s = 0; s < Game::SYMMETRY_COUNT; ++s) {
+                const int image = Game::transformCell(cell, 5, s);
+                images[s].makeMove(image / 5, image % 5, player);
+            }
+            player = Game::opponent(player);
+        }
+        int symmetry = -1;
+        const std::uint64_t canonical = game.canonicalHash(&symmetry);
+        for (const auto& image : images)
+            CHECK(image.canonicalHash() == canonical);
+        CHECK(images[symmetry].hash() == canonical);
+    }
+
+    for (int s = 0; s < Game::SYMMETRY_COUNT; ++s)
+        for (int cell = 0; cell < 9; ++cell)
+            CHECK(Game::transformCell(Game::transformCell(cell, 3, s), 3, Game::inverseSymmetry(s)) == cell);
+
+    // Угловые дебюты эквивалентны, центр и край — нет
+    Game corner, otherCorner, edge;
+    corner.makeMove(0, 0, Game::Cell::X);
+    otherCorner.makeMove(2, 2, Game::Cell::X);
+    edge.makeMove(0, 1, Game::Cell::X);
+    CHECK(corner.canonicalHash() == otherCorner.canonicalHash());
+    CHECK(corner.canonicalHash() != edge.canonicalHash());
+}
+
+/**
+ * @brief Сверяет полный перебор дерева 3x3 с известными значениями.
+ */
+TEST_CASE("Test perft") {
+    const std::vector<std::uint64_t> expectedNodes = { 1, 9, 72, 504, 3024, 15120, 54720, 148176, 200448, 127872 };
+
+    PerftResult serial = perft(Game(), Game::Cell::X);
+    CHECK(serial.nodes == expectedNodes);
+    CHECK(serial.games == 255168);
+    CHECK(serial.xWins == 131184);
+    CHECK(serial.oWins == 77904);
+    CHECK(serial.draws == 46080);
+
+    PerftOptions options;
+    options.threads = 4;
+    const PerftResult parallel = perft(Game(), Game::Cell::X, options);
+    CHECK(parallel.nodes == serial.nodes);
+    CHECK(parallel.games == serial.games);
+    CHECK(parallel.xWins == serial.xWins);
+
+    // Поле с размером во время выполнения даёт те же числа
+    CHECK(perft(DynamicGame(3, 3), Game::Cell::X, options).games == 255168);
+
+    options.depth = 4;
+    const PerftResult shallow = perft(Game(), Game::Cell::X, options);
+    CHECK(shallow.nodes.size() == 5);
+    CHECK(shallow.nodes[4] == 3024);
+    CHECK(shallow.games == 0);
+
+    options.depth = 0;
+    options.unique = true;
+    for (int threads : { 1, 4 }) {
+        options.threads = threads;
+        const PerftResult unique = perft(Game(), Game::Cell::X, options);
+        CHECK(unique.totalNodes() == 5478);
+        CHECK(unique.games == 958);
+        CHECK(unique.xWins == 626);
+        CHECK(unique.oWins == 316);
+        CHECK(unique.draws == 16);
+    }
+}
+
+/**
+ * @brief Проверяет решатель на известных позициях 3x3.
+ */
+TEST_CASE("Test solver perfect play") {
+    Solver<Game> solver;
+    Game game;
+
+    // Пустое поле — ничья, партия длится все 9 ходов
+    SolverResult result = solver.solve(game, Game::Cell::X);
+    CHECK(result.exact);
+    CHECK(result.value == 0);
+    CHECK(result.distance == 9);
+
+    // Повторный запрос решается одним обращением к таблице
+    solver.resetStats();
+    CHECK(solver.solve(game, Game::Cell::X).move == result.move);
+    CHECK(solver.stats().nodes == 1);
+    CHECK(solver.stats().ttHits == 1);
+
+    // X выигрывает за один ход
+    game.makeMove(0, 0, Game::Cell::X);
+    game.makeMove(1, 1, Game::Cell::O);
+    game.makeMove(0, 1, Game::Cell::X);
+    game.makeMove(2, 2, Game::Cell::O);
+    result = solver.solve(game, Game::Cell::X);
+    CHECK(result.value == 1);
+    CHECK(result.distance == 1);
+    CHECK(result.move == 2);
+
+    // O обязан закрыть линию, иначе проигрывает
+    game.reset();
+    game.makeMove(0, 0, Game::Cell::X);
+    game.makeMove(1, 1, Game::Cell::O);
+    game.makeMove(0, 1, Game::Cell::X);
+    result = solver.solve(game, Game::Cell::O);
+    CHECK(result.move == 2);
+    CHECK(result.value == 0);
+}
+
+/**
+ * @brief Проверяет работу решателя на большом поле с ограничениями.
+ */
+TEST_CASE("Test solver limits on large board") {
+    Solver<BasicGame<15, 5>> solver;
+    BasicGame<15, 5> game;
+    for (int i = 0; i < 4; ++i) {
+        game.makeMove(7, 5 + i, Game::Cell::X);
+        game.makeMove(0, 2 * i, Game::Cell::O);
+    }
+
+    SolverLimits limits;
+    limits.maxDepth = 2;
+    SolverResult result = solver.solve(game, Game::Cell::X, limits);
+    CHECK(result.value == 1);                       /**< Выигрыш найден в пределах горизонта */
+    CHECK(result.distance == 1);
+    CHECK((result.move == 7 * 15 + 4 || result.move == 7 * 15 + 9));
+
+    limits.maxDepth = 0;
+    limits.maxNodes = 1000;
+    solver.resetStats();
+    result = solver.solve(game, Game::Cell::O, limits);
+    CHECK(result.exact == false);
+    CHECK(solver.stats().nodes <= 1000);
+}
+
+/**
+ * @brief Проверяет поиск с итеративным углублением: срок, итерации, главный вариант и доказанный результат.
+ */
+TEST_CASE("Test iterative deepening with deadline") {
+    using Board = BasicGame<15, 5>;
+    Solver<Board> solver(16);
+    Board game;
+    game.makeMove(7, 7, Game::Cell::X);
+    game.makeMove(6, 8, Game::Cell::O);
+    game.makeMove(8, 7, Game::Cell::X);
+
+    std::vector<SearchIteration> reported;
+    const double budget = 0.1;
+    TimedSearchResult timed = solver.bestMove(game, Game::Cell::O, budget,
+                                              [&](const SearchIteration& iteration) { reported.push_back(iteration); });
+    CHECK(timed.seconds < budget + 0.05);
+    REQUIRE_FALSE(timed.iterations.empty());
+    CHECK(reported.size() == timed.iterations.size());
+    for (std::size_t i = 0; i < timed.iterations.size(); ++i) {
+        CHECK(timed.iterations[i].depth == static_cast<int>(i) + 1);
+        CHECK_FALSE(timed.iterations[i].pv.empty());
+        if (i > 0)
+            CHECK(timed.iterations[i].nodes > timed.iterations[i - 1].nodes);
+    }
+    CHECK(timed.depth == timed.iterations.back().depth);
+    CHECK(timed.pv.front() == timed.result.move);
+    CHECK(game.getCell(timed.result.move / 15, timed.result.move % 15) == Game::Cell::Empty);
+    CHECK_FALSE(timed.result.exact);    /**< Большое поле не решается полностью */
+
+    // Открытая четвёрка замыкается за один ход
+    for (int i = 0; i < 2; ++i) {
+        game.makeMove(6, 2 * i, Game::Cell::O);
+        game.makeMove(9 + i, 7, Game::Cell::X);
+    }
+    timed = solver.bestMove(game, Game::Cell::X, budget);
+    CHECK((timed.result.move == 6 * 15 + 7 || timed.result.move == 11 * 15 + 7));
+    CHECK(timed.result.value == 1);
+    CHECK(timed.result.distance == 1);
+
+    // Нулевой срок: ход всё равно допустим
+    timed = solver.bestMove(game, Game::Cell::O, 0.0);
+    CHECK(timed.result.move >= 0);
+    CHECK(game.getCell(timed.result.move / 15, timed.result.move % 15) == Game::Cell::Empty);
+
+    // Поле 3x3 решается полностью и даёт тот же результат, что solve()
+    Solver<Game> small;
+    const TimedSearchResult solved = small.bestMove(Game(), Game::Cell::X, 10.0);
+    CHECK(solved.result.exact);
+    CHECK(solved.result.value == 0);
+    CHECK(solved.result.distance == 9);
+    CHECK(small.solve(Game(), Game::Cell::X).value == 0);
+}
+
+/**
+ * @brief Проверяет, что инкрементальная оценка образцов совпадает с пересчётом с нуля.
+ */
+TEST_CASE("Test threat evaluator incremental updates") {
+    const int variants[][2] = { {3, 3}, {7, 4}, {15, 5} };
+    for (const auto& variant : variants) {
+        const int size = variant[0], k = variant[1];
+        ThreatEvaluator evaluator(size, k);
+        DynamicGame game(size, k);
+        std::mt19937 rng(size);
+        std::vector<int> placed;
+        GameBase::Cell player = GameBase::X;
+        for (int step = 0; step < 400; ++step) {
+            // Чаще ставим, чем убираем, чтобы доходить до плотных позиций
+            if (!placed.empty() && (rng() % 3 == 0 || static_cast<int>(placed.size()) == size * size)) {
+                evaluator.unmakeMove(placed.back());
+                game.unmakeMove();
+                placed.pop_back();
+                player = GameBase::opponent(player);
+            }
+            else {
+                int cell;
+                do {
+                    cell = static_cast<int>(rng() % (size * size));
+                } while (evaluator.at(cell) != GameBase::Empty);
+                evaluator.makeMove(cell, player);
+                game.makeMove(cell / size, cell % size, player);
+                placed.push_back(cell);
+                player = GameBase::opponent(player);
+            }
+            ThreatEvaluator fresh(size, k);
+            fresh.reset(game);
+            REQUIRE(evaluator.evaluate(GameBase::X) == evaluator.evaluateFull(GameBase::X));
+            REQUIRE(evaluator.evaluate(GameBase::X) == fresh.evaluate(GameBase::X));
+            REQUIRE(evaluator.evaluate(GameBase::O) == -evaluator.evaluate(GameBase::X));
+            for (int pattern = ThreatEvaluator::NoPattern; pattern < ThreatEvaluator::PATTERN_COUNT; ++pattern)
+                for (GameBase::Cell side : { GameBase::X, GameBase::O })
+                    REQUIRE(evaluator.patternCount(side, static_cast<ThreatEvaluator::Pattern>(pattern)) ==
+                            fresh.patternCount(side, static_cast<ThreatEvaluator::Pattern>(pattern)));
+        }
+        while (!placed.empty()) {
+            evaluator.unmakeMove(placed.back());
+            placed.pop_back();
+        }
+        CHECK(evaluator.evaluate(GameBase::X) == 0);
+        CHECK(evaluator.patternCount(GameBase::X, ThreatEvaluator::Two) == 0);
+    }
+}
+
+/**
+ * @brief Проверяет распознавание образцов и поиск выигрыша непрерывными четвёрками.
+ */
+TEST_CASE("Test threat patterns and VCF search") {
+    using Board = BasicGame<15, 5>;
+    auto at = [](int y, int x) { return y * 15 + x; };
+
+    // Открытая тройка становится закрытой, если соперник встаёт рядом
+    ThreatEvaluator evaluator(15, 5);
+    for (int x = 6; x <= 8; ++x)
+        evaluator.makeMove(at(7, x), GameBase::X);
+    CHECK(evaluator.patternCount(GameBase::X, ThreatEvaluator::OpenThree) > 0);
+    CHECK(evaluator.evaluate(GameBase::X) > 0);
+    evaluator.makeMove(at(7, 5), GameBase::O);
+    CHECK(evaluator.patternCount(GameBase::X, ThreatEvaluator::OpenThree) == 0);
+    CHECK(evaluator.patternCount(GameBase::X, ThreatEvaluator::Three) > 0);
+
+    // Открытая четвёрка: две клетки до пятёрки
+    evaluator.clear();
+    for (int x = 5; x <= 8; ++x)
+        evaluator.makeMove(at(7, x), GameBase::X);
+    CHECK(evaluator.patternCount(GameBase::X, ThreatEvaluator::OpenFour) > 0);
+    std::vector<int> wins;
+    evaluator.winningCells(GameBase::X, wins);
+    std::sort(wins.begin(), wins.end());
+    CHECK(wins == std::vector<int>{ at(7, 4), at(7, 9) });
+
+    // Выигрывающая последовательность должна приводить к собранной линии на настоящем поле
+    auto replay = [](const Board& start, const std::vector<int>& line) {
+        Board game = start;
+        GameBase::Cell player = GameBase::X;
+        for (int cell : line) {
+            if (game.checkWinner() != GameBase::Empty || !game.makeMove(cell / 15, cell % 15, player))
+                return false;
+            player = GameBase::opponent(player);
+        }
+        return game.checkWinner() == GameBase::X;
+    };
+
+    // Две закрытые тройки пересекаются в свободной клетке: двойная четвёрка за один ход
+    Board game;
+    for (int cell : { at(7, 4), at(7, 5), at(7, 6), at(4, 8), at(5, 8), at(6, 8) })
+        game.makeMove(cell / 15, cell % 15, GameBase::X);
+    for (int cell : { at(7, 3), at(3, 8) })
+        game.makeMove(cell / 15, cell % 15, GameBase::O);
+    evaluator.reset(game);
+    ThreatEvaluator::VcfResult vcf = evaluator.findVcf(GameBase::X);
+    REQUIRE(vcf.win);
+    CHECK(vcf.line.front() == at(7, 8));
+    CHECK(replay(game, vcf.line));
+    CHECK(evaluator.evaluate(GameBase::X) == evaluator.evaluateFull(GameBase::X));    /**< Поиск вернул позицию */
+
+    // Четвёрка заставляет закрыть строку, после чего столбец становится открытой четвёркой
+    game.reset();
+    for (int cell : { at(7, 4), at(7, 5), at(7, 6), at(5, 7), at(6, 7) })
+        game.makeMove(cell / 15, cell % 15, GameBase::X);
+    for (int cell : { at(7, 3), at(0, 0) })
+        game.makeMove(cell / 15, cell % 15, GameBase::O);
+    evaluator.reset(game);
+    CHECK_FALSE(evaluator.findVcf(GameBase::X, 1).win);
+    vcf = evaluator.findVcf(GameBase::X);
+    REQUIRE(vcf.win);
+    CHECK(vcf.line.size() == 5);
+    CHECK(replay(game, vcf.line));
+
+    // Готовая четвёрка соперника: атака четвёрками не успевает
+    game.makeMove(2, 0, GameBase::O);
+    game.makeMove(2, 1, GameBase::O);
+    game.makeMove(2, 2, GameBase::O);
+    game.makeMove(2, 3, GameBase::O);
+    evaluator.reset(game);
+    CHECK_FALSE(evaluator.findVcf(GameBase::X).win);
+    CHECK(evaluator.findVcf(GameBase::O).line == std::vector<int>{ at(2, 4) });
+}
+
+/**
+ * @brief Проверяет гистограмму задержек, снимки счётчиков из нескольких потоков и выгрузку трассы.
+ */
+TEST_CASE("Test instrumentation") {
+    using instrumentation::LatencyHistogram;
+
+    // Каждое значение попадает в свою корзину, ширина корзины — не больше 1/16 значения
+    for (std::uint64_t value : { 0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, ~0ull }) {
+        const int bucket = LatencyHistogram::bucketOf(value);
+        REQUIRE(bucket < LatencyHistogram::BUCKET_COUNT);
+        CHECK(LatencyHistogram::bucketLow(bucket) <= value);
+        CHECK(value <= LatencyHistogram::bucketHigh(bucket));
+        if (value >= LatencyHistogram::SUB_BUCKETS)
+            CHECK(LatencyHistogram::bucketHigh(bucket) - LatencyHistogram::bucketLow(bucket) <= value / 16);
+    }
+    CHECK(LatencyHistogram::bucketOf(~0ull) == LatencyHistogram::BUCKET_COUNT - 1);
+    LatencyHistogram histogram;
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+        histogram.record(value);
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.min() == 1);
+    CHECK(histogram.max() == 1000);
+    CHECK(histogram.mean() == doctest::Approx(500.5));
+    CHECK(histogram.percentile(0.5) >= 500);
+    CHECK(histogram.percentile(0.5) <= 500 + 500 / 16);
+    CHECK(histogram.percentile(1.0) == 1000);
+
+    instrumentation::reset();
+    {
+        Game game;
+        game.makeMove(0, 0, Game::Cell::X);
+        game.makeMove(1, 1, Game::Cell::O);
+        std::thread worker([] {
+            Game other;
+            for (int cell = 0; cell < 3; ++cell)
+                other.makeMove(0, cell, Game::Cell::X);
+        });
+        worker.join();
+    }
+    CHECK(instrumentation::snapshot().counters[instrumentation::MovesApplied] == (instrumentation::ENABLED ? 5 : 0));
+    instrumentation::reset();
+    Solver<Game> solver;
+    solver.solve(Game(), Game::Cell::X);
+    instrumentation::Snapshot snapshot = instrumentation::snapshot();
+    if (instrumentation::ENABLED) {
+        CHECK(snapshot.counters[instrumentation::NodesSearched] == solver.stats().nodes);
+        CHECK(snapshot.counters[instrumentation::TtHits] == solver.stats().ttHits);
+        CHECK(snapshot.counters[instrumentation::WinnerChecks] >= solver.stats().nodes);
+        CHECK(snapshot.histograms[instrumentation::MoveSelection].count() == 1);
+        CHECK(snapshot.histograms[instrumentation::MoveSelection].min() > 0);
+    }
+    else {
+        CHECK(snapshot.counters[instrumentation::NodesSearched] == 0);
+        CHECK(snapshot.histograms[instrumentation::MoveSelection].count() == 0);
+    }
+
+    // Сбор можно приостановить во время работы
+    instrumentation::setActive(false);
+    instrumentation::add(instrumentation::CacheHits);
+    instrumentation::setActive(true);
+    instrumentation::add(instrumentation::CacheHits, 2);
+    CHECK(instrumentation::snapshot().counters[instrumentation::CacheHits] == 2);
+
+    // Участки пишутся только при включённой трассировке
+    { instrumentation::ScopedSpan ignored("ignored span"); }
+    instrumentation::setTracing(true);
+    {
+        instrumentation::ScopedSpan outer("outer span");
+        instrumentation::ScopedSpan inner("inner \"quoted\" span");
+    }
+    instrumentation::setTracing(false);
+    const std::vector<instrumentation::TraceEvent> events = instrumentation::traceEvents();
+    REQUIRE(events.size() == 2);
+    CHECK(std::string(events[0].name) == "outer span");
+    CHECK(events[0].startNs <= events[1].startNs);
+    CHECK(events[0].durationNs >= events[1].durationNs);
+
+    auto readFile = [](const std::string& path) {
+        std::ifstream in(path);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    };
+    const std::string jsonPath = (std::filesystem::temp_directory_path() / "tictactoe_metrics.json").string();
+    const std::string tracePath = (std::filesystem::temp_directory_path() / "tictactoe_trace.json").string();
+    REQUIRE(instrumentation::writeJson(jsonPath, instrumentation::snapshot()));
+    REQUIRE(instrumentation::writeChromeTrace(tracePath));
+    const std::string json = readFile(jsonPath);
+    CHECK(json.find("\"cache_hits\": 2") != std::string::npos);
+    CHECK(json.find("\"move_selection\"") != std::string::npos);
+    const std::string trace = readFile(tracePath);
+    CHECK(trace.find("\"traceEvents\"") != std::string::npos);
+    CHECK(trace.find("\"ph\": \"X\"") != std::string::npos);
+    CHECK(trace.find("inner \\\"quoted\\\" span") != std::string::npos);
+    std::filesystem::remove(jsonPath);
+    std::filesystem::remove(tracePath);
+
+    instrumentation::reset();
+    CHECK(instrumentation::traceEvents().empty());
+    CHECK(instrumentation::snapshot().counters[instrumentation::CacheHits] == 0);
+}
+
+/**
+ * @brief Нагружает общую таблицу транспозиций из многих потоков.
+ *
+ * Данные записи выводятся из ключа, поэтому любая разорванная запись,
+ * прошедшая проверку, была бы замечена при сравнении.
+ */
+TEST_CASE("Test transposition table under concurrent access") {
+    auto entryFor = [](std::uint64_t key) {
+        TranspositionTable::Entry entry;
+        entry.score = static_cast<std::int16_t>(key);
+        entry.move = static_cast<std::int16_t>(key >> 16);
+        entry.depth = static_cast<std::int16_t>((key >> 32) & 0x3FFF);
+        entry.bound = static_cast<TranspositionTable::Bound>(1 + (key >> 62) % 3);
+        return entry;
+    };
+
+    TranspositionTable table(0);                            /**< Одна корзина: все потоки пишут в одну кэш-линию */
+    REQUIRE(table.bucketCount() == 1);
+    std::atomic<int> torn{ 0 };
+    std::atomic<std::uint64_t> hits{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t] {
+            std::uint64_t state = static_cast<std::uint64_t>(t) + 1;
+            for (int i = 0; i < 200000; ++i) {
+                // Небольшой набор ключей, чтобы чтения часто попадали в записи других потоков
+                std::uint64_t keyState = detail::splitmix64(state) % 16;
+                const std::uint64_t key = detail::splitmix64(keyState);
+                TranspositionTable::Entry entry;
+                if (table.probe(key, entry)) {
+                    const TranspositionTable::Entry expected = entryFor(key);
+                    if (entry.score != expected.score || entry.move != expected.move ||
+                        entry.depth != expected.depth || entry.bound != expected.bound)
+                        ++torn;
+                    ++hits;
+                }
+                table.store(key, entryFor(key));
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(torn == 0);
+    CHECK(hits > 0);
+    const TranspositionStats stats = table.stats();
+    CHECK(stats.probes == 8 * 200000);
+    CHECK(stats.stores == 8 * 200000);
+    CHECK(stats.hits == hits);
+    CHECK(stats.collisions > 0);
+    CHECK(stats.overwrites > 0);
+
+    // Корзина вмещает столько разных позиций, сколько в ней слотов
+    table.clear();
+    for (std::uint64_t key = 1; key <= TranspositionTable::BUCKET_SLOTS; ++key) {
+        TranspositionTable::Entry entry = entryFor(key);
+        entry.depth = 5;
+        table.store(key, entry);
+    }
+    for (std::uint64_t key = 1; key <= TranspositionTable::BUCKET_SLOTS; ++key) {
+        TranspositionTable::Entry entry;
+        REQUIRE(table.probe(key, entry));
+        CHECK(entry.score == entryFor(key).score);
+        CHECK(entry.depth == 5);
+    }
+    CHECK(table.stats().collisions == 0);
+
+    // Бюджет памяти: число корзин — наибольшая степень двойки в пределах бюджета
+    table.resize(1);
+    CHECK(table.bytes() == 1024 * 1024);
+    CHECK(table.stats().probes == 0);
+}
+
+/**
+ * @brief Проверяет совместную работу решателей с общей таблицей.
+ */
+TEST_CASE("Test solvers sharing a transposition table") {
+    TranspositionTable table(4);
+    std::vector<SolverResult> results(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            Solver<BasicGame<4, 4>> solver(table);
+            BasicGame<4, 4> game;
+            game.makeMove(1, 1, Game::Cell::X);
+            game.makeMove(2, 2, Game::Cell::O);
+            results[t] = solver.solve(game, Game::Cell::X);
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    // Позиция другого размера отвергается: общую таблицу нельзя очистить во время чужих поисков
+    TranspositionTable small(1);
+    Solver<DynamicGame> dynamic(small);
+    CHECK(dynamic.solve(DynamicGame(3, 3), Game::Cell::X).exact);
+    const std::uint64_t stored = small.stats().stores;
+    const SolverResult rejected = dynamic.solve(DynamicGame(4, 3), Game::Cell::X);
+    CHECK_FALSE(rejected.exact);
+    CHECK(rejected.move == -1);
+    CHECK(small.stats().stores == stored);  /**< Таблица не очищена и не тронута */
+    CHECK(stored > 0);
+
+    Solver<BasicGame<4, 4>> reference;
+    BasicGame<4, 4> game;
+    game.makeMove(1, 1, Game::Cell::X);
+    game.makeMove(2, 2, Game::Cell::O);
+    const SolverResult expected = reference.solve(game, Game::Cell::X);
+    for (const SolverResult& result : results) {
+        CHECK(result.exact);
+        CHECK(result.value == expected.value);
+        CHECK(result.distance == expected.distance);
+    }
+    CHECK(table.stats().hits > 0);
+}
+
+/**
+ * @brief Проверяет файл решённых позиций: построение, симметрии, решатель с кэшем и отказ от чужих правил.
+ */
+TEST_CASE("Test position cache") {
+    const std::string path = (std::filesystem::temp_directory_path() / "tictactoe_cache_test.tpc").string();
+    PositionCacheBuildOptions options;
+    options.plies = 3;
+    options.threads = 2;
+    options.ttMegabytes = 4;
+    PositionCacheBuildStats stats;
+    REQUIRE(buildPositionCache(options, path, &stats));
+    CHECK(stats.positions == 1 + 3 + 12 + 38);     /**< Различные позиции 3x3 после 0..3 ходов */
+    CHECK(stats.solved == stats.positions);
+
+    PositionCache cache;
+    REQUIRE(cache.open(path, 3, 3));
+    CHECK(cache.entryCount() == stats.positions);
+    CHECK(cache.maxMoves() == 3);
+
+    // В любой ориентации найденный ход сохраняет оценку позиции
+    Solver<Game> reference;
+    int checked = 0, wrong = 0;
+    Game game;
+    auto walk = [&](auto&& self, Game::Cell player) -> void {
+        PositionCache::Hit hit;
+        REQUIRE(cache.probe(game, player, hit));
+        const SolverResult exact = reference.solve(game, player);
+        wrong += hit.value != exact.value || hit.distance != exact.distance;
+        game.makeMove(hit.move / 3, hit.move % 3, player);
+        wrong += -reference.solve(game, Game::opponent(player)).value != hit.value;
+        game.unmakeMove();
+        ++checked;
+        if (game.moveCount() == 3)
+            return;
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            if (game.makeMove(cell / 3, cell % 3, player)) {
+                self(self, Game::opponent(player));
+                game.unmakeMove();
+            }
+        }
+    };
+    walk(walk, Game::Cell::X);
+    CHECK(checked == 1 + 9 + 72 + 504);
+    CHECK(wrong == 0);
+
+    // Решатель с кэшем отвечает на пустое поле без перебора
+    Solver<Game> cached;
+    cached.setCache(&cache);
+    const SolverResult result = cached.solve(Game(), Game::Cell::X);
+    CHECK(result.exact);
+    CHECK(result.value == 0);
+    CHECK(cached.stats().nodes == 1);
+    CHECK(cached.stats().cacheHits == 1);
+    Game deep;
+    deep.makeMove(1, 1, Game::Cell::X);
+    deep.makeMove(0, 1, Game::Cell::O);
+    deep.makeMove(0, 0, Game::Cell::X);
+    deep.makeMove(2, 2, Game::Cell::O);
+    const SolverResult win = cached.solve(deep, Game::Cell::X);
+    CHECK(win.value == reference.solve(deep, Game::Cell::X).value);
+    CHECK(win.distance == reference.solve(deep, Game::Cell::X).distance);
+    CHECK(cached.stats().cacheHits == 1);     /**< Позиции после четырёх ходов в кэше нет */
+
+    // Пересборка заменяет файл целиком: открытый кэш продолжает читать прежние данные
+    REQUIRE(buildPositionCache(options, path));
+    CHECK_FALSE(std::filesystem::exists(path + ".tmp"));
+    CHECK(cached.solve(Game(), Game::Cell::X).value == 0);
+    CHECK(cached.stats().cacheHits == 2);
+
+    // Файл для других правил, чужой версии или обрезанный не открывается
+    std::string error;
+    CHECK_FALSE(cache.open(path, 3, 2, &error));
+    CHECK_FALSE(error.empty());
+    CHECK_FALSE(cache.open(path, 4, 3));
+    cache.close();
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        REQUIRE(file);
+        std::fseek(file, 8, SEEK_SET);
+        std::fputc(2, file);
+        std::fclose(file);
+    }
+    CHECK_FALSE(cache.open(path, 3, 3));
+    REQUIRE(buildPositionCache(options, path));
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    CHECK_FALSE(cache.open(path, 3, 3));
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Проверяет фоновый движок: доставку результата, задержку отмены, вытеснение и обдумывание.
+ */
+TEST_CASE("Test async engine") {
+    AsyncEngine<Game> engine(1);
+    std::atomic<int> callbacks{ 0 };
+    EngineResult result = engine.start(Game(), Game::Cell::X, {}, [&](const EngineResult&) { ++callbacks; }).get();
+    CHECK_FALSE(result.cancelled);
+    CHECK(result.result.exact);
+    CHECK(result.result.value == 0);
+    CHECK(result.ticket == 1);
+    CHECK(callbacks == 1);
+
+    // Решение пустого поля 6x6 заведомо долгое: отмена должна вернуть результат почти сразу
+    using Board = BasicGame<6, 4>;
+    AsyncEngine<Board> big(4);
+    std::future<EngineResult> slow = big.start(Board(), Game::Cell::X);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(slow.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+    const auto cancelledAt = std::chrono::steady_clock::now();
+    big.cancel();
+    result = slow.get();
+    const double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - cancelledAt).count();
+    CHECK(result.cancelled);
+    CHECK(latency < 0.1);
+
+    // Новый запрос вытесняет незаконченный
+    SolverLimits shallow;
+    shallow.maxDepth = 2;
+    std::future<EngineResult> first = big.start(Board(), Game::Cell::X);
+    std::future<EngineResult> second = big.start(Board(), Game::Cell::X, shallow);
+    CHECK(first.get().cancelled);
+    result = second.get();
+    CHECK_FALSE(result.cancelled);
+    CHECK(result.result.move >= 0);
+    CHECK(result.ticket == 3);
+
+    // Обдумывание: после предсказанного ответа результат готов без нового поиска
+    Game game;
+    game.makeMove(1, 1, Game::Cell::X);
+    game.makeMove(0, 0, Game::Cell::O);
+    engine.ponder(game, Game::Cell::O);
+    while (engine.busy())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const int predicted = engine.predictedMove();
+    REQUIRE(predicted >= 0);
+    game.makeMove(predicted / 3, predicted % 3, Game::Cell::X);
+    result = engine.start(game, Game::Cell::O).get();
+    CHECK(result.ponderHit);
+    CHECK(result.result.exact);
+    CHECK(result.result.value == Solver<Game>().solve(game, Game::Cell::O).value);
+
+    // Готовый ответ обдумывания и отменённый запрос тоже приходят в потоке движка:
+    // вызывающий держит свою блокировку вокруг start(), обратный вызов берёт её же
+    game.unmakeMove();
+    engine.ponder(game, Game::Cell::O);
+    while (engine.busy())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(engine.predictedMove() == predicted);
+    game.makeMove(predicted / 3, predicted % 3, Game::Cell::X);
+    std::mutex owner;
+    std::atomic<int> foreign{ 0 };
+    const std::thread::id caller = std::this_thread::get_id();
+    const auto locking = [&](const EngineResult&) {
+        std::lock_guard<std::mutex> lock(owner);
+        foreign += std::this_thread::get_id() != caller;
+    };
+    std::future<EngineResult> hit, dropped, kept;
+    {
+        std::lock_guard<std::mutex> lock(owner);
+        hit = engine.start(game, Game::Cell::O, {}, locking);
+        dropped = big.start(Board(), Game::Cell::X, {}, locking);
+        kept = big.start(Board(), Game::Cell::X, shallow, locking);
+    }
+    CHECK(hit.get().ponderHit);
+    CHECK(dropped.get().cancelled);
+    CHECK_FALSE(kept.get().cancelled);
+    CHECK(foreign == 3);
+
+    // Неугаданный ответ запускает обычный поиск
+    game.unmakeMove();
+    engine.ponder(game, Game::Cell::O);
+    while (engine.busy())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(engine.predictedMove() == predicted);
+    const int other = predicted == 8 ? 7 : 8;   /**< Клетки 7 и 8 свободны после ходов в 4 и 0 */
+    game.makeMove(other / 3, other % 3, Game::Cell::X);
+    result = engine.start(game, Game::Cell::O).get();
+    CHECK_FALSE(result.ponderHit);
+    CHECK_FALSE(result.cancelled);
+    CHECK(result.result.exact);
+}
+
+/**
+ * @brief Сверяет таблицу, построенную при компиляции, с поиском во время выполнения.
+ */
+TEST_CASE("Test tablebase matches runtime search") {
+    Solver<Game> solver;
+    int reachable = 0;
+    for (int index = 0; index < Tablebase::INDEX_COUNT; ++index) {
+        const Tablebase::Entry entry = Tablebase::lookup(index);
+        if (!entry.reachable)
+            continue;
+        ++reachable;
+
+        const Game game = Tablebase::position(index);
+        REQUIRE(Tablebase::index(game) == index);
+        if (game.checkWinner() != Game::Cell::Empty || game.isDraw()) {
+            CHECK(entry.move == -1);
+            continue;
+        }
+
+        const Game::Cell player = Tablebase::sideToMove(game);
+        const SolverResult result = solver.solve(game, player);
+        CHECK(entry.value == result.value);
+        CHECK(entry.distance == result.distance);
+
+        // Ход из таблицы должен сохранять теоретическую оценку
+        Game next = game;
+        REQUIRE(next.makeMove(entry.move / 3, entry.move % 3, player));
+        const Tablebase::Entry reply = Tablebase::lookup(Tablebase::index(next));
+        CHECK(-reply.value == entry.value);
+        CHECK(reply.distance + 1 == entry.distance);
+    }
+    CHECK(reachable == Tablebase::REACHABLE_COUNT);
+}
+
+/**
+ * @brief Проверяет плотную нумерацию: все достижимые позиции 3x3 туда и обратно, классы симметрий, комбинаторные номера.
+ */
+TEST_CASE("Test position ranking") {
+    int next = 0;
+    for (int index = 0; index < Tablebase::INDEX_COUNT; ++index) {
+        const Game game = Tablebase::position(index);
+        const int rank = PositionRank::rank(game);
+        REQUIRE(PositionRank::ternaryIndex(game) == index);
+        if (!Tablebase::lookup(index).reachable) {
+            CHECK(rank == -1);
+            CHECK(PositionRank::canonicalRank(game) == -1);
+            continue;
+        }
+        REQUIRE(rank == next++);    /**< Номера плотные и идут в порядке индексов */
+        CHECK(Tablebase::index(PositionRank::unrank(rank)) == index);
+
+        // Симметрия из canonicalRank переводит позицию в представителя класса
+        int symmetry = -1;
+        const int canonical = PositionRank::canonicalRank(game, &symmetry);
+        REQUIRE(canonical >= 0);
+        REQUIRE(canonical < PositionRank::CANONICAL_COUNT);
+        Game image;
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            const Game::Cell c = game.getCell(cell / 3, cell % 3);
+            const int target = GameBase::transformCell(cell, 3, symmetry);
+            if (c != Game::Empty)
+                image.makeMove(target / 3, target % 3, c);
+        }
+        const Game representative = PositionRank::canonicalUnrank(canonical);
+        CHECK(Tablebase::index(image) == Tablebase::index(representative));
+        CHECK(Tablebase::index(representative) == ValueTable::canonicalIndex(game));
+    }
+    CHECK(next == PositionRank::COUNT);
+    for (int rank = 0; rank < PositionRank::CANONICAL_COUNT; ++rank)
+        CHECK(PositionRank::canonicalRank(PositionRank::canonicalUnrank(rank)) == rank);
+
+    // Комбинаторная нумерация 3x3: все номера туда и обратно, достижимые позиции — среди них
+    const CombinatorialRank small(Game::CELL_COUNT);
+    CHECK(small.count() == 6046);
+    std::uint8_t cells[CombinatorialRank::MAX_CELLS];
+    for (std::uint64_t rank = 0; rank < small.count(); ++rank) {
+        small.unrankCells(rank, cells);
+        REQUIRE(small.rankCells(cells) == rank);
+    }
+    for (int rank = 0; rank < PositionRank::COUNT; ++rank) {
+        const Game game = PositionRank::unrank(rank);
+        const std::uint64_t combinatorial = small.rank(game);
+        REQUIRE(combinatorial < small.count());
+        Game restored;
+        small.unrank(combinatorial, restored);
+        CHECK(Tablebase::index(restored) == Tablebase::index(game));
+    }
+    cells[0] = Game::O;
+    for (int cell = 1; cell < Game::CELL_COUNT; ++cell)
+        cells[cell] = Game::Empty;
+    CHECK(small.rankCells(cells) == small.count());  /**< O не может ходить первым */
+
+    // 4x4: случайные партии
+    const CombinatorialRank large(16);
+    std::mt19937 rng(21);
+    for (int game = 0; game < 2000; ++game) {
+        BasicGame<4, 4> board;
+        GameBase::Cell player = GameBase::X;
+        const int moves = static_cast<int>(rng() % 17);
+        for (int m = 0; m < moves; ++m) {
+            int cell;
+            do {
+                cell = static_cast<int>(rng() % 16);
+            } while (board.getCell(cell / 4, cell % 4) != GameBase::Empty);
+            board.makeMove(cell / 4, cell % 4, player);
+            player = GameBase::opponent(player);
+        }
+        const std::uint64_t rank = large.rank(board);
+        REQUIRE(rank < large.count());
+        BasicGame<4, 4> restored;
+        large.unrank(rank, restored);
+        for (int cell = 0; cell < 16; ++cell)
+            CHECK(restored.getCell(cell / 4, cell % 4) == board.getCell(cell / 4, cell % 4));
+        CHECK(large.rank(restored) == rank);
+    }
+}
+
+/**
+ * @brief Проверяет потоковый анализ позиций: порядок вывода, ошибки разбора и совпадение с таблицей и решателем.
+ */
+TEST_CASE("Test position analyzer stream") {
+    auto toText = [](const auto& game) {
+        std::string text;
+        for (int cell = 0; cell < game.size() * game.size(); ++cell) {
+            const GameBase::Cell c = game.getCell(cell / game.size(), cell % game.size());
+            text += c == GameBase::X ? 'X' : c == GameBase::O ? 'O' : '.';
+        }
+        return text;
+    };
+
+    // Все достижимые позиции 3x3 вперемешку с мусором; маленькие блоки и кольцо из двух слотов
+    std::string input, expected;
+    int junk = 0;
+    for (int rank = 0; rank < PositionRank::COUNT; ++rank) {
+        const Game game = PositionRank::unrank(rank);
+        const std::string text = toText(game);
+        const Tablebase::Entry entry = Tablebase::lookup(Tablebase::index(game));
+        input += rank % 3 ? text + "\n" : "  " + text + "\r\n";
+        expected += text + ' ' + (Tablebase::sideToMove(game) == GameBase::X ? 'X' : 'O') + ' ' +
+                    std::to_string(entry.move) + ' ' + std::to_string(entry.value) + ' ' +
+                    std::to_string(entry.distance) + '\n';
+        if (rank % 500 == 0) {
+            input += "# comment\n\nXXX\nXX.......\nXXXOOO...\nXOZ......\n";
+            expected += "XXX ERR wrong number of cells\nXX....... ERR piece counts do not alternate\n"
+                        "XXXOOO... ERR unreachable position\nXOZ...... ERR unexpected character\n";
+            junk += 4;
+        }
+    }
+    input += "X........";     /**< Последняя строка без перевода строки */
+    expected += "X........ O 4 0 8\n";
+
+    AnalysisConfig config;
+    config.threads = 3;
+    config.blockBytes = 64;
+    config.queueDepth = 2;
+    std::istringstream in(input);
+    std::ostringstream out;
+    AnalysisStats stats;
+    REQUIRE(analyzeStream(in, out, config, &stats));
+    CHECK(out.str() == expected);
+    CHECK(stats.positions == PositionRank::COUNT + 1);
+    CHECK(stats.errors == static_cast<std::uint64_t>(junk));
+    CHECK(stats.inexact == 0);
+
+    // 4x4: результаты совпадают с решателем, вывод — с порядком ввода при любом числе потоков
+    config.size = 4;
+    config.winLength = 4;
+    config.blockBytes = 40;
+    config.ttMegabytes = 4;
+    std::mt19937 rng(22);
+    std::vector<std::pair<BasicGame<4, 4>, GameBase::Cell>> positions;
+    input.clear();
+    while (positions.size() < 24) {
+        BasicGame<4, 4> game;
+        GameBase::Cell player = GameBase::X;
+        for (int m = 0; m < 9; ++m) {
+            int cell;
+            do {
+                cell = static_cast<int>(rng() % 16);
+            } while (game.getCell(cell / 4, cell % 4) != GameBase::Empty);
+            game.makeMove(cell / 4, cell % 4, player);
+            player = GameBase::opponent(player);
+        }
+        if (game.checkWinner() != GameBase::Empty)
+            continue;
+        positions.emplace_back(game, player);
+        input += toText(game) + "\n";
+    }
+    Solver<BasicGame<4, 4>> reference;
+    std::string results[2];
+    for (int threads : { 1, 4 }) {
+        config.threads = threads;
+        std::istringstream in4(input);
+        std::ostringstream out4;
+        REQUIRE(analyzeStream(in4, out4, config, &stats));
+        CHECK(stats.positions == positions.size());
+        results[threads == 4] = out4.str();
+    }
+    CHECK(results[0] == results[1]);
+    std::istringstream lines(results[0]);
+    for (const auto& [game, player] : positions) {
+        std::string text, side, move;
+        int value = 0, distance = 0;
+        lines >> text >> side >> move >> value >> distance;
+        const SolverResult result = reference.solve(game, player);
+        CHECK(text == toText(game));
+        CHECK(side == (player == GameBase::X ? "X" : "O"));
+        CHECK(value == result.value);
+        CHECK(distance == result.distance);
+    }
+
+    // Предел узлов: ход есть, оценка не доказана
+    config.maxNodes = 1;
+    std::istringstream in5(input.substr(0, 17));
+    std::ostringstream out5;
+    REQUIRE(analyzeStream(in5, out5, config, &stats));
+    CHECK(stats.inexact == 1);
+    CHECK(out5.str().find(" ? ?") != std::string::npos);
+}
+
+/**
+ * @brief Проверяет ретроградные таблицы: 3x3 против таблицы, эндшпили 4x4 против решателя, Qubic против перебора.
+ */
+TEST_CASE("Test retrograde tables") {
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "tictactoe_retro_test";
+    std::filesystem::remove_all(root);
+    auto toValue = [](int value) {
+        return value > 0 ? RetrogradeTable::Win : value < 0 ? RetrogradeTable::Loss : RetrogradeTable::Draw;
+    };
+
+    // 3x3 целиком: каждая достижимая позиция совпадает с Tablebase
+    const RetrogradeRules rules3 = RetrogradeRules::board(3, 3);
+    CHECK(rules3.lines.size() == 8);
+    RetrogradeStats stats;
+    REQUIRE(RetrogradeTable::build(rules3, 0, 0, (root / "3x3").string(), RetrogradeOptions(), &stats, nullptr));
+    CHECK(stats.layers.size() == 10);
+    CHECK(stats.entries == CombinatorialRank(Game::CELL_COUNT).count());
+    REQUIRE(RetrogradeTable::build(rules3, 0, 0, (root / "3x3").string(), RetrogradeOptions(), nullptr, nullptr));
+    RetrogradeTable table3;
+    REQUIRE(table3.open(rules3, 0, 0, (root / "3x3").string()));
+    for (int index = 0; index < Tablebase::INDEX_COUNT; ++index) {
+        const Tablebase::Entry entry = Tablebase::lookup(index);
+        if (!entry.reachable)
+            continue;
+        const Game game = Tablebase::position(index);
+        const bool finished = game.checkWinner() != Game::Cell::Empty || game.isDraw();
+        REQUIRE(table3.probe(game) == (finished && game.checkWinner() != Game::Cell::Empty
+                                           ? RetrogradeTable::Loss : toValue(entry.value)));
+        const int move = table3.bestMove(game);
+        if (finished) {
+            CHECK(move == -1);
+            continue;
+        }
+        Game next = game;
+        REQUIRE(next.makeMove(move / 3, move % 3, Tablebase::sideToMove(game)));
+        CHECK(-Tablebase::lookup(Tablebase::index(next)).value == entry.value);
+    }
+    std::string error;
+    RetrogradeTable other;
+    CHECK_FALSE(other.open(rules3, 1, 0, (root / "3x3").string(), &error));     /**< Другая исходная позиция */
+    CHECK_FALSE(other.open(RetrogradeRules::board(3, 2), 0, 0, (root / "3x3").string(), &error));
+    CHECK_FALSE(RetrogradeTable::build(rules3, 0x7, 0x18, (root / "bad").string(), RetrogradeOptions(), nullptr,
+                                       nullptr, &error));                       /**< Партия уже решена */
+    CHECK(error == "base position is already decided");
+
+    // Эндшпиль 4x4 после шести ходов: одинаковые файлы при любом числе потоков, оценки как у решателя
+    const RetrogradeRules rules4 = RetrogradeRules::board(4, 4);
+    CHECK(rules4.lines.size() == 10);
+    BasicGame<4, 4> base;
+    const int opening[] = { 5, 10, 0, 15, 6, 9 };
+    GameBase::Cell player = GameBase::X;
+    for (int cell : opening) {
+        base.makeMove(cell / 4, cell % 4, player);
+        player = GameBase::opponent(player);
+    }
+    std::uint64_t baseX = 0, baseO = 0;
+    for (int i = 0; i < 6; ++i)
+        (i % 2 ? baseO : baseX) |= 1ull << opening[i];
+    RetrogradeOptions options;
+    options.chunkEntries = 100;     /**< Округляется до 128: много задач на слой */
+    for (int threads : { 1, 3 }) {
+        options.threads = threads;
+        REQUIRE(RetrogradeTable::build(rules4, baseX, baseO, (root / ("4x4t" + std::to_string(threads))).string(),
+                                       options, &stats, nullptr));
+    }
+    for (int stones = 0; stones <= 10; ++stones) {
+        std::ifstream one(RetrogradeTable::layerPath((root / "4x4t1").string(), stones), std::ios::binary);
+        std::ifstream three(RetrogradeTable::layerPath((root / "4x4t3").string(), stones), std::ios::binary);
+        const std::string a((std::istreambuf_iterator<char>(one)), std::istreambuf_iterator<char>());
+        const std::string b((std::istreambuf_iterator<char>(three)), std::istreambuf_iterator<char>());
+        REQUIRE(!a.empty());
+        CHECK(a == b);
+    }
+    RetrogradeTable table4;
+    REQUIRE(table4.open(rules4, baseX, baseO, (root / "4x4t3").string()));
+    Solver<BasicGame<4, 4>> solver;
+    std::mt19937 rng(23);
+    for (int sample = 0; sample < 100; ++sample) {
+        BasicGame<4, 4> game = base;
+        GameBase::Cell side = player;
+        const int moves = static_cast<int>(rng() % 8);
+        for (int m = 0; m < moves && game.checkWinner() == GameBase::Empty; ++m) {
+            int cell;
+            do {
+                cell = static_cast<int>(rng() % 16);
+            } while (game.getCell(cell / 4, cell % 4) != GameBase::Empty);
+            game.makeMove(cell / 4, cell % 4, side);
+            side = GameBase::opponent(side);
+        }
+        if (game.checkWinner() != GameBase::Empty) {
+            CHECK(table4.probe(game) == RetrogradeTable::Loss);
+            continue;
+        }
+        const SolverResult result = solver.solve(game, side);
+        REQUIRE(result.exact);
+        CHECK(table4.probe(game) == toValue(result.value));
+        const int move = table4.bestMove(game);
+        REQUIRE(move >= 0);
+        BasicGame<4, 4> next = game;
+        REQUIRE(next.makeMove(move / 4, move % 4, side));
+        const SolverResult reply = solver.solve(next, GameBase::opponent(side));
+        CHECK(-reply.value == result.value);
+    }
+    BasicGame<4, 4> outside;
+    outside.makeMove(0, 0, GameBase::X);
+    CHECK(table4.probe(outside) == RetrogradeTable::Unknown);   /**< Не продолжение исходной позиции */
+
+    // Qubic: 76 линий; эндшпиль с девятью свободными клетками против прямого перебора
+    const RetrogradeRules qubic = RetrogradeRules::qubic();
+    CHECK(qubic.lines.size() == 76);
+    const char* text = "XXO.O..XOXOXOOXOX.OO.OOOOXOXX.X.XXX.OXOO.X.OXO.X.OXXOXO.X.XO.X.O";
+    std::uint64_t qx = 0, qo = 0;
+    for (int cell = 0; cell < 64; ++cell) {
+        if (text[cell] == 'X')
+            qx |= 1ull << cell;
+        else if (text[cell] == 'O')
+            qo |= 1ull << cell;
+    }
+    auto xToMove = [](std::uint64_t x, std::uint64_t o) { return std::bitset<64>(x).count() == std::bitset<64>(o).count(); };
+    auto hasLine = [&](std::uint64_t bits) {
+        for (std::uint64_t mask : qubic.lines)
+            if ((bits & mask) == mask)
+                return true;
+        return false;
+    };
+    // Семь ходов, не собирающих линий: остаётся девять свободных клеток
+    for (int placed = 0; placed < 7; ++placed) {
+        const bool moverX = xToMove(qx, qo);
+        for (int cell = 0; cell < 64; ++cell) {
+            const std::uint64_t bit = 1ull << cell;
+            if (((qx | qo) & bit) || hasLine((moverX ? qx : qo) | bit))
+                continue;
+            (moverX ? qx : qo) |= bit;
+            break;
+        }
+    }
+    REQUIRE(std::bitset<64>(qx | qo).count() == 55);
+    std::function<int(std::uint64_t, std::uint64_t)> negamax = [&](std::uint64_t x, std::uint64_t o) {
+        const bool moverX = xToMove(x, o);
+        if (hasLine(moverX ? o : x))
+            return -1;
+        int best = -2;
+        for (int cell = 0; cell < 64 && best < 1; ++cell) {
+            const std::uint64_t bit = 1ull << cell;
+            if (!((x | o) & bit))
+                best = std::max(best, -(moverX ? negamax(x | bit, o) : negamax(x, o | bit)));
+        }
+        return best == -2 ? 0 : best;
+    };
+    REQUIRE(RetrogradeTable::build(qubic, qx, qo, (root / "qubic").string(), RetrogradeOptions(), &stats, nullptr));
+    RetrogradeTable tableQ;
+    REQUIRE(tableQ.open(qubic, qx, qo, (root / "qubic").string()));
+    for (int cell = 0; cell < 64; ++cell) {
+        const std::uint64_t bit = 1ull << cell;
+        if ((qx | qo) & bit)
+            continue;
+        const bool moverX = xToMove(qx, qo);
+        const std::uint64_t x = moverX ? qx | bit : qx, o = moverX ? qo : qo | bit;
+        CHECK(tableQ.probe(x, o) == toValue(negamax(x, o)));
+    }
+    CHECK(tableQ.probe(qx, qo) == toValue(negamax(qx, qo)));
+
+    std::filesystem::remove_all(root);
+}
+
+/**
+ * @brief Проверяет детерминированность и корректность пакетного моделирования.
+ */
+TEST_CASE("Test simulator") {
+    SimulationConfig config;
+    config.games = 5000;
+    config.chunkSize = 128;
+    config.seed = 7;
+
+    config.threads = 1;
+    const SimulationStats single = Simulator<Game>(config).run();
+    config.threads = 4;
+    const SimulationStats parallel = Simulator<Game>(config).run();
+    CHECK(single.games == 5000);
+    CHECK(single.xWins + single.oWins + single.draws == single.games);
+    CHECK(parallel.xWins == single.xWins);     /**< Результат не зависит от числа потоков */
+    CHECK(parallel.oWins == single.oWins);
+    CHECK(parallel.moves == single.moves);
+
+    // Идеальный игрок не проигрывает случайному
+    config.games = 300;
+    config.xPolicy = "random";
+    config.oPolicy = "search";
+    const SimulationStats perfect = Simulator<Game>(config).run();
+    CHECK(perfect.games == 300);
+    CHECK(perfect.xWins == 0);
+
+    // После первого хода X в начальной позиции ходит O: идеальная игра — ничья
+    config.games = 50;
+    config.xPolicy = "search";
+    Game center;
+    center.makeMove(1, 1, Game::X);
+    const SimulationStats fromStart = Simulator<Game>(config, center).run();
+    CHECK(fromStart.draws == 50);
+    CHECK(fromStart.moves == 50 * 8);
+
+    config.oPolicy = "unknown";
+    CHECK(Simulator<Game>(config).run().games == 0);
+}
+
+/**
+ * @brief Проверяет кодирование партий и файлы записей: все партии, текст, контрольные суммы и обрыв файла.
+ */
+TEST_CASE("Test value table learned by self-play") {
+    // Симметричные позиции имеют один ключ: 5478 достижимых позиций дают 765 классов
+    std::vector<bool> seen(ValueTable::INDEX_COUNT, false);
+    int classes = 0;
+    for (int index = 0; index < Tablebase::INDEX_COUNT; ++index) {
+        if (!Tablebase::lookup(index).reachable)
+            continue;
+        const Game position = Tablebase::position(index);
+        const int canonical = ValueTable::canonicalIndex(position);
+        CHECK(canonical <= index);
+        classes += !seen[canonical];
+        seen[canonical] = true;
+    }
+    CHECK(classes == 765);
+
+    Game game;
+    game.makeMove(0, 1, Game::X);
+    game.makeMove(2, 2, Game::O);
+    for (int symmetry = 0; symmetry < Game::SYMMETRY_COUNT; ++symmetry) {
+        Game image;
+        const int x = Game::transformCell(1, 3, symmetry), o = Game::transformCell(8, 3, symmetry);
+        image.makeMove(x / 3, x % 3, Game::X);
+        image.makeMove(o / 3, o % 3, Game::O);
+        CHECK(ValueTable::canonicalIndex(image) == ValueTable::canonicalIndex(game));
+    }
+
+    // Параллельное обучение: все партии учтены ровно один раз
+    ValueTable parallel;
+    SelfPlayOptions options;
+    options.games = 20000;
+    options.threads = 4;
+    SelfPlayStats stats = trainSelfPlay(parallel, options);
+    CHECK(stats.games == options.games);
+    CHECK(stats.xWins + stats.oWins + stats.draws == options.games);
+    CHECK(parallel.games() == options.games);
+
+    // Обучение сходится к идеальной игре; один поток делает результат воспроизводимым
+    ValueTable table;
+    options.games = 100000;
+    options.threads = 1;
+    options.checkpointEvery = 25000;
+    options.checkpointPath = (std::filesystem::temp_directory_path() / "tictactoe_values.ttv").string();
+    std::uint64_t reports = 0;
+    stats = trainSelfPlay(table, options, [&](const SelfPlayStats&) { ++reports; });
+    CHECK(stats.games == options.games);
+    CHECK(stats.xWins + stats.oWins + stats.draws == options.games);
+    CHECK(stats.checkpoints == 4);
+    CHECK(reports == 4);
+    CHECK(table.games() == options.games);
+
+    const PolicyQuality quality = evaluatePolicy(table);
+    CHECK(quality.positions == 4520);
+    CHECK(quality.optimalRate() > 0.98);
+    CHECK(quality.selfPlayResult == 0);
+
+    // Последняя контрольная точка совпадает с таблицей с точностью квантования
+    ValueTable loaded;
+    std::string error;
+    REQUIRE(loaded.load(options.checkpointPath, &error));
+    CHECK(loaded.games() == options.games);
+    float maxDifference = 0.0f;
+    for (int index = 0; index < ValueTable::INDEX_COUNT; ++index)
+        maxDifference = std::max(maxDifference, std::abs(loaded.value(index) - table.value(index)));
+    CHECK(maxDifference <= 1.0f / valuefile::SCALE);
+    CHECK(evaluatePolicy(loaded).optimalRate() > 0.98);
+
+    // Выученная стратегия не проигрывает идеальному решателю
+    SimulationConfig config;
+    config.games = 200;
+    config.threads = 2;
+    config.xPolicy = "learned:" + options.checkpointPath;
+    config.oPolicy = "search";
+    SimulationStats result = Simulator<Game>(config).run();
+    CHECK(result.games == config.games);
+    CHECK(result.oWins == 0);
+    config.xPolicy = "random";
+    config.oPolicy = "learned:" + options.checkpointPath;
+    result = Simulator<Game>(config).run();
+    CHECK(result.xWins == 0);
+
+    // Испорченный файл не загружается
+    {
+        std::fstream file(options.checkpointPath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(sizeof(valuefile::FileHeader) + 1);
+        file.put('\x7F');
+    }
+    CHECK_FALSE(loaded.load(options.checkpointPath, &error));
+    CHECK(error.find("checksum") != std::string::npos);
+    CHECK(makePolicy<Game>("learned:" + options.checkpointPath) == nullptr);
+    std::filesystem::remove(options.checkpointPath);
+}
+
+TEST_CASE("Test ultimate tic-tac-toe rules") {
+    UltimateGame game;
+    CHECK(game.legalMoves(nullptr) == 81);
+    CHECK(game.activeBoard() == UltimateGame::ANY_BOARD);
+
+    // Клетка (0, 4) — центр верхнего ряда малого поля 1: соперник ходит в малое поле 1
+    REQUIRE(game.makeMove(0, 4, Game::Cell::X));
+    CHECK(game.activeBoard() == 1);
+    CHECK(game.legalMoves(nullptr) == 8);
+    CHECK_FALSE(game.makeMove(4, 4, Game::Cell::O));
+    CHECK_FALSE(game.makeMove(0, 4, Game::Cell::O));
+    CHECK(game.makeMove(1, 3, Game::Cell::O));
+    CHECK(game.activeBoard() == 3);
+    game.unmakeMove();
+    game.unmakeMove();
+    CHECK(game.moveCount() == 0);
+    CHECK(game.hash() == 0);
+
+    // X собирает верхнюю строку малого поля 0; O каждый раз отправляет его обратно клеткой 0 своего поля
+    const int script[][3] = { {0, 0, Game::X}, {1, 1, Game::O}, {4, 3, Game::X}, {3, 0, Game::O},
+                              {0, 1, Game::X}, {0, 3, Game::O}, {0, 2, Game::X} };
+    for (const auto& move : script)
+        REQUIRE(game.makeMove(move[0], move[1], static_cast<Game::Cell>(move[2])));
+    CHECK(game.boardWinner(0) == Game::X);
+    CHECK(game.activeBoard() == 2);
+    CHECK(game.checkWinner() == Game::Empty);
+    // Ход, отправляющий в выигранное поле 0, открывает сопернику все открытые поля
+    REQUIRE(game.makeMove(0, 6, Game::O));
+    CHECK(game.activeBoard() == UltimateGame::ANY_BOARD);
+    CHECK_FALSE(game.isLegal(2 * 9 + 2));
+    CHECK(game.legalMoves(nullptr) == 81 - 9 - 4);
+
+    // Случайные партии: ходы по legalMoves() совпадают с isLegal(), хеш — с хешем, собранным заново,
+    // симметричные партии дают один канонический хеш, отмена всех ходов возвращает пустое поле
+    std::mt19937_64 rng(7);
+    int moves[UltimateGame::CELL_COUNT];
+    int decided = 0;
+    for (int round = 0; round < 200; ++round) {
+        UltimateGame random;
+        Game::Cell player = Game::X;
+        std::vector<int> played;
+        bool consistent = true;
+        for (;;) {
+            const int count = random.legalMoves(moves);
+            int legal = 0;
+            for (int cell = 0; cell < UltimateGame::CELL_COUNT; ++cell)
+                legal += random.isLegal(cell);
+            consistent = consistent && legal == count;
+            if (count == 0)
+                break;
+            const int cell = moves[rng() % count];
+            REQUIRE(random.makeMove(cell / 9, cell % 9, player));
+            played.push_back(cell);
+            player = Game::opponent(player);
+        }
+        CHECK(consistent);
+        CHECK((random.checkWinner() != Game::Empty || random.isDraw()));
+        decided += random.checkWinner() != Game::Empty;
+
+        const int symmetry = round % Game::SYMMETRY_COUNT;
+        UltimateGame image;
+        Game::Cell mover = Game::X;
+        for (int cell : played) {
+            const int target = Game::transformCell(cell, 9, symmetry);
+            REQUIRE(image.makeMove(target / 9, target % 9, mover));
+            mover = Game::opponent(mover);
+        }
+        CHECK(image.canonicalHash() == random.canonicalHash());
+        CHECK(image.checkWinner() == random.checkWinner());
+
+        const std::uint64_t hash = random.hash();
+        UltimateGame replay;
+        mover = Game::X;
+        for (int cell : played) {
+            replay.makeMove(cell / 9, cell % 9, mover);
+            mover = Game::opponent(mover);
+        }
+        CHECK(replay.hash() == hash);
+        while (random.unmakeMove()) {}
+        CHECK(random.hash() == 0);
+        CHECK(random.legalMoves(nullptr) == 81);
+    }
+    CHECK(decided > 100);
+
+    // Быстрая доигровка приходит к концу партии по правилам
+    UltimateGame playout;
+    const Game::Cell winner = playout.playRandom(Game::X, rng);
+    CHECK(winner == playout.checkWinner());
+    CHECK((winner != Game::Empty || playout.isDraw()));
+    CHECK(playout.legalMoves(nullptr) == 0);
+
+    // perft: 81 первый ход; ответ — в малом поле, заданном клеткой: 9 клеток, а если это поле первого хода — 8
+    PerftOptions options;
+    options.depth = 2;
+    const PerftResult tree = perft(UltimateGame(), Game::X, options);
+    CHECK(tree.nodes[1] == 81);
+    CHECK(tree.nodes[2] == 72 * 9 + 9 * 8);
+}
+
+TEST_CASE("Test ultimate tic-tac-toe with search engines") {
+    // Позиция, где X выигрывает одним ходом: ищется перебором случайных партий
+    std::mt19937_64 rng(11);
+    int moves[UltimateGame::CELL_COUNT];
+    UltimateGame game;
+    int winning = -1;
+    while (winning < 0) {
+        game.reset();
+        Game::Cell player = Game::X;
+        for (;;) {
+            const int count = game.legalMoves(moves);
+            if (count == 0)
+                break;
+            if (player == Game::X)
+                for (int i = 0; i < count && winning < 0; ++i) {
+                    game.makeMove(moves[i] / 9, moves[i] % 9, Game::X);
+                    if (game.checkWinner() == Game::X)
+                        winning = moves[i];
+                    game.unmakeMove();
+                }
+            if (winning >= 0)
+                break;
+            const int cell = moves[rng() % count];
+            game.makeMove(cell / 9, cell % 9, player);
+            player = Game::opponent(player);
+        }
+    }
+
+    Solver<UltimateGame> solver;
+    SolverLimits limits;
+    limits.maxDepth = 3;
+    const SolverResult solved = solver.solve(game, Game::X, limits);
+    CHECK(solved.value == 1);
+    CHECK(solved.distance == 1);
+    UltimateGame after = game;
+    REQUIRE(after.makeMove(solved.move / 9, solved.move % 9, Game::X));
+    CHECK(after.checkWinner() == Game::X);
+
+    // Ничья наступает, когда закрыты все малые поля, а не когда заполнено поле:
+    // расстояние до ничьей — число полуходов до реального ничейного листа
+    UltimateGame drawn;
+    Game::Cell side = Game::X;
+    SolverResult draw;
+    for (int attempt = 0; attempt < 1000 && !(draw.exact && draw.value == 0); ++attempt) {
+        drawn.reset();
+        side = Game::X;
+        for (int count; (count = drawn.legalMoves(moves)) > 0; side = Game::opponent(side)) {
+            const int cell = moves[rng() % count];
+            drawn.makeMove(cell / 9, cell % 9, side);
+        }
+        if (!drawn.isDraw() || UltimateGame::CELL_COUNT - drawn.moveCount() < 6)
+            continue;
+        CHECK(solver.solve(drawn, side).distance == 0);
+        for (int i = 0; i < 4; ++i) {
+            drawn.unmakeMove();
+            side = Game::opponent(side);
+        }
+        draw = solver.solve(drawn, side);
+    }
+    REQUIRE(draw.exact);
+    REQUIRE(draw.value == 0);
+    CHECK(draw.distance > 0);
+    CHECK(draw.distance < UltimateGame::CELL_COUNT - drawn.moveCount());
+    // Ходы решателя доводят партию до ничьей ровно за найденное число полуходов
+    int plies = 0;
+    for (SolverResult step = draw; !drawn.isDraw(); step = solver.solve(drawn, side)) {
+        REQUIRE(step.value == 0);
+        REQUIRE(drawn.makeMove(step.move / 9, step.move % 9, side));
+        side = Game::opponent(side);
+        ++plies;
+    }
+    CHECK(plies == draw.distance);
+
+    const TimedSearchResult timed = solver.bestMove(UltimateGame(), Game::X, 0.05);
+    CHECK(UltimateGame().isLegal(timed.result.move));
+    CHECK(timed.depth >= 2);
+
+    Mcts<UltimateGame> mcts(1 << 16);
+    MctsLimits mctsLimits;
+    mctsLimits.playouts = 2000;
+    const MctsResult searched = mcts.search(game, Game::X, mctsLimits);
+    CHECK(searched.move == solved.move);
+
+    // Моделирование: MCTS уверенно обыгрывает случайные ходы
+    SimulationConfig config;
+    config.games = 20;
+    config.threads = 2;
+    config.xPolicy = "mcts:300";
+    config.oPolicy = "random";
+    const SimulationStats stats = Simulator<UltimateGame>(config).run();
+    CHECK(stats.games == config.games);
+    CHECK(stats.xWins >= 15);
+    config.xPolicy = "learned:values.ttv";
+    CHECK(Simulator<UltimateGame>(config).run().games == 0);
+}
+
+TEST_CASE("Test game records") {
+    // Каждая из 255168 полных партий кодируется и восстанавливается без потерь
+    std::uint64_t games = 0, mismatches = 0;
+    std::vector<std::uint32_t> all;
+    Game game;
+    auto walk = [&](auto&& self, Game::Cell player) -> void {
+        if (game.checkWinner() != Game::Cell::Empty || game.isDraw()) {
+            const std::uint32_t record = GameRecord::encode(game);
+            const Game replayed = GameRecord::replay(record);
+            mismatches += replayed.hash() != game.hash() || GameRecord::outcome(record) != GameRecord::outcomeOf(game) ||
+                          GameRecord::length(record) != game.moveCount();
+            all.push_back(record);
+            ++games;
+            return;
+        }
+        for (int cell = 0; cell < Game::CELL_COUNT; ++cell) {
+            if (game.makeMove(cell / 3, cell % 3, player)) {
+                self(self, Game::opponent(player));
+                game.unmakeMove();
+            }
+        }
+    };
+    walk(walk, Game::Cell::X);
+    CHECK(games == 255168);
+    CHECK(mismatches == 0);
+    std::vector<std::uint32_t> sorted = all;
+    std::sort(sorted.begin(), sorted.end());
+    CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());   /**< Коды различны */
+
+    std::uint32_t parsed = 0;
+    CHECK(GameRecord::fromText("4 0 8 2 6 OPEN", parsed));
+    CHECK(GameRecord::toText(parsed) == "4 0 8 2 6 OPEN");
+    CHECK(GameRecord::fromText(GameRecord::toText(all[12345]), parsed));
+    CHECK(parsed == all[12345]);
+    CHECK_FALSE(GameRecord::fromText("4 4 XWIN", parsed));
+    CHECK_FALSE(GameRecord::fromText("4 0 9 XWIN", parsed));
+    CHECK_FALSE(GameRecord::fromText("4 0", parsed));
+
+    // Запись в файл в два приёма и чтение через отображение
+    const std::string path = (std::filesystem::temp_directory_path() / "tictactoe_records_test.ttr").string();
+    std::filesystem::remove(path);
+    {
+        GameRecordWriter writer;
+        REQUIRE(writer.open(path));
+        writer.append(all.data(), 100000);
+    }
+    {
+        GameRecordWriter writer;
+        REQUIRE(writer.open(path));
+        writer.append(all.data() + 100000, all.size() - 100000);
+    }
+    {
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        CHECK(reader.recordCount() == all.size());
+        CHECK_FALSE(reader.truncated());
+        CHECK(reader.verify());
+        std::size_t index = 0;
+        bool same = true;
+        reader.forEach([&](std::uint32_t record) { same = same && record == all[index++]; });
+        CHECK(same);
+    }
+
+    // Порча байта выявляется контрольной суммой, обрезанный хвост отбрасывается
+    const std::uintmax_t size = std::filesystem::file_size(path);
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        REQUIRE(file);
+        std::fseek(file, 32 + 16 + 5, SEEK_SET);
+        const int byte = std::fgetc(file);
+        std::fseek(file, 32 + 16 + 5, SEEK_SET);
+        std::fputc(byte ^ 0x5A, file);
+        std::fclose(file);
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        std::size_t bad = 99;
+        CHECK_FALSE(reader.verify(&bad));
+        CHECK(bad == 0);
+    }
+    std::filesystem::resize_file(path, size - 7);
+    {
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        CHECK(reader.truncated());
+        CHECK(reader.recordCount() == all.size() - (all.size() - 100000) % recordfile::BLOCK_RECORDS);
+    }
+    std::filesystem::remove(path);
+
+    // Дозапись после оборванного или испорченного последнего блока: писатель
+    // отрезает файл до конца последнего целого блока, и новые записи читаются
+    const std::size_t kept = 2 * recordfile::BLOCK_RECORDS + 10;
+    {
+        GameRecordWriter writer;
+        REQUIRE(writer.open(path));
+        writer.append(all.data(), kept);
+    }
+    {
+        std::FILE* file = std::fopen(path.c_str(), "ab");
+        REQUIRE(file);
+        std::fwrite("TBLK\x07", 1, 5, file);     /**< Начало заголовка блока */
+        std::fclose(file);
+    }
+    {
+        GameRecordWriter writer;
+        REQUIRE(writer.open(path));
+        writer.append(all.data() + kept, 5);
+    }
+    {
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        CHECK_FALSE(reader.truncated());
+        CHECK(reader.recordCount() == kept + 5);
+        CHECK(reader.verify());
+    }
+    {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        REQUIRE(file);
+        std::fseek(file, -1, SEEK_END);
+        const int byte = std::fgetc(file);
+        std::fseek(file, -1, SEEK_END);
+        std::fputc(byte ^ 0x5A, file);
+        std::fclose(file);
+    }
+    {
+        GameRecordWriter writer;
+        REQUIRE(writer.open(path));
+        writer.append(all.data() + kept, 3);
+    }
+    {
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        CHECK_FALSE(reader.truncated());
+        CHECK(reader.recordCount() == kept + 3);
+        CHECK(reader.verify());
+        std::size_t index = 0;
+        bool same = true;
+        reader.forEach([&](std::uint32_t record) { same = same && record == all[index++]; });
+        CHECK(same);
+    }
+    std::filesystem::remove(path);
+
+    // Моделирование пишет по записи на партию
+    SimulationConfig config;
+    config.games = 2000;
+    config.threads = 2;
+    config.recordPath = path;
+    const SimulationStats stats = Simulator<Game>(config).run();
+    {
+        GameRecordReader reader;
+        REQUIRE(reader.open(path));
+        CHECK(reader.recordCount() == 2000);
+        std::uint64_t xWins = 0;
+        reader.forEach([&](std::uint32_t record) { xWins += GameRecord::outcome(record) == GameRecord::XWin; });
+        CHECK(xWins == stats.xWins);
+    }
+    std::filesystem::remove(path);
+}
+
+/**
+ * @brief Проверяет поиск Монте-Карло: выигрыш в один ход, защиту и повторное использование дерева.
+ */
+TEST_CASE("Test MCTS") {
+    using Board = BasicGame<7, 4>;
+    Board game;
+    for (int i = 0; i < 3; ++i) {
+        game.makeMove(3, 1 + i, Game::Cell::X);
+        game.makeMove(6, 2 * i, Game::Cell::O);
+    }
+
+    Mcts<Board> mcts(1 << 16);
+    MctsLimits limits;
+    limits.playouts = 20000;
+    limits.threads = 2;
+    MctsResult result = mcts.search(game, Game::Cell::X, limits);
+    CHECK((result.move == 3 * 7 + 0 || result.move == 3 * 7 + 4));   /**< Открытая тройка замыкается */
+    CHECK(result.playouts == 20000);
+    CHECK(result.threadPlayouts.size() == 2);
+    CHECK(result.nodesUsed <= (1 << 16));
+
+    // После хода и ответа соперника поиск продолжает сохранённое поддерево
+    Board opening;
+    result = mcts.search(opening, Game::Cell::X, limits);
+    opening.makeMove(result.move / 7, result.move % 7, Game::Cell::X);
+    opening.makeMove(result.move == 0 ? 1 : 0, 0, Game::Cell::O);
+    result = mcts.search(opening, Game::Cell::X, limits);
+    CHECK(result.reused);
+    CHECK(result.move >= 0);
+
+    // Нолики обязаны закрыть линию крестиков
+    Game small;
+    small.makeMove(0, 0, Game::Cell::X);
+    small.makeMove(1, 1, Game::Cell::O);
+    small.makeMove(0, 1, Game::Cell::X);
+    Mcts<Game> smallMcts(1 << 12);
+    limits.playouts = 5000;
+    CHECK(smallMcts.search(small, Game::Cell::O, limits).move == 2);
+}
+
+#ifdef __linux__
+/**
+ * @brief Играет партию через сокет сервера и проверяет ответы протокола.
+ */
+TEST_CASE("Test game server") {
+    ServerConfig config;
+    config.port = 0;
+    config.sessionCapacity = 4;
+    config.connectionCapacity = 4;
+    GameServer server(config);
+    std::string error;
+    REQUIRE_MESSAGE(server.start(&error), error);
+    std::thread loop([&] { server.run(); });
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(server.port());
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+    timeval timeout{ 5, 0 };   /**< Потерянный ответ — ошибка теста, а не зависание */
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string buffered;
+    auto sendLines = [&](const std::string& lines) {
+        const std::string data = lines + "\n";
+        REQUIRE(::send(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size()));
+    };
+    auto readLine = [&] {
+        while (buffered.find('\n') == std::string::npos) {
+            char chunk[256];
+            const ssize_t got = ::recv(fd, chunk, sizeof(chunk), 0);
+            REQUIRE(got > 0);
+            buffered.append(chunk, static_cast<std::size_t>(got));
+        }
+        const std::size_t end = buffered.find('\n');
+        const std::string reply = buffered.substr(0, end);
+        buffered.erase(0, end + 1);
+        return reply;
+    };
+    auto request = [&](const std::string& line) {
+        sendLines(line);
+        return readLine();
+    };
+
+    CHECK(request("PING") == "PONG");
+    const std::string created = request("NEW x");
+    REQUIRE(created.compare(0, 4, "NEW ") == 0);
+    const std::string id = created.substr(4);
+
+    // Компьютер отвечает ходом из таблицы: на угол — центр
+    Game expected;
+    expected.makeMove(0, 0, Game::Cell::X);
+    CHECK(request("MOVE " + id + " 0") == "MOVE " + id + " " + std::to_string(Tablebase::bestMove(expected)) + " PLAY");
+    CHECK(request("MOVE " + id + " 0") == "ERR " + id + " illegal");
+    CHECK(request("MOVE 12345 1") == "ERR 12345 nosession");
+    CHECK(request("END " + id) == "END " + id);
+    CHECK(request("MOVE " + id + " 1") == "ERR " + id + " nosession");     /**< Закрытая партия недоступна */
+    CHECK(request("HELLO") == "ERR unknown");
+
+    // Закрытие партий во время хода компьютера при заполненном сервере: слоты
+    // переиспользуются, а ни одно задание новых партий не теряется
+    const std::string reply = " " + std::to_string(Tablebase::bestMove(expected)) + " PLAY";
+    std::uint64_t aiMoves = 1;
+    for (int round = 0; round < 100; ++round) {
+        for (bool stale : { true, false }) {
+            std::vector<std::string> ids;
+            for (int attempt = 0; ids.size() < config.sessionCapacity; ++attempt) {
+                REQUIRE(attempt < 10000);
+                const std::string opened = request("NEW x");
+                if (opened == "ERR full") {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));   /**< Слот ждёт ответа на старое задание */
+                    continue;
+                }
+                REQUIRE(opened.compare(0, 4, "NEW ") == 0);
+                ids.push_back(opened.substr(4));
+            }
+            std::string moves, ends;
+            for (const std::string& session : ids) {
+                moves += (moves.empty() ? "" : "\n") + ("MOVE " + session + " 0");
+                ends += (ends.empty() ? "" : "\n") + ("END " + session);
+            }
+            if (stale) {
+                // Ответы компьютера разбираются только между пачками команд, поэтому
+                // слоты закрытых партий ещё заняты их заданиями
+                sendLines(moves + "\n" + ends + "\nNEW x");
+                for (std::size_t i = 0; i < ids.size(); ++i)
+                    CHECK(readLine() == "END " + ids[i]);
+                CHECK(readLine() == "ERR full");
+                continue;
+            }
+            sendLines(moves);
+            std::vector<std::string> replies;
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                replies.push_back(readLine());
+            std::sort(replies.begin(), replies.end());
+            std::sort(ids.begin(), ids.end());
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                CHECK(replies[i] == "MOVE " + ids[i] + reply);
+            aiMoves += ids.size();
+            sendLines(ends);
+            for (std::size_t i = 0; i < ids.size(); ++i)
+                CHECK(readLine().compare(0, 4, "END ") == 0);
+        }
+    }
+
+    ::close(fd);
+    server.stop();
+    loop.join();
+    CHECK(server.stats().sessionsOpened == 1 + 200 * config.sessionCapacity);
+    CHECK(server.stats().aiMoves >= aiMoves);
+}
+#endif
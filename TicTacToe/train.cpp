@@ -0,0 +1,101 @@
+/**
+ * @file train.cpp
+ * @brief Обучение таблицы ценности 3x3 самоигрой и сравнение с идеальной игрой.
+ *
+ * Пример: TicTacToeTrain --games 500000 --threads 8 --out values.ttv --every 100000
+ * Продолжение обучения: TicTacToeTrain --resume values.ttv --games 200000 --out values.ttv
+ * Проверка файла: TicTacToeTrain --check values.ttv
+ */
+
+#include "ValueTable.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+void printUsage(const char* program) {
+    std::printf("Usage: %s [--games N] [--threads N] [--lambda L] [--alpha A] [--epsilon E] [--seed N]\n"
+                "          [--out FILE] [--every N] [--resume FILE]\n"
+                "       %s --check FILE\n", program, program);
+}
+
+void printQuality(const ValueTable& table) {
+    const PolicyQuality quality = evaluatePolicy(table);
+    static const char* const RESULTS[] = { "O wins", "draw", "X wins" };
+    std::printf("optimal moves: %d/%d (%.2f%%)  mean value error: %.4f  self-play: %s (perfect play: draw)\n",
+                quality.optimalMoves, quality.positions, 100.0 * quality.optimalRate(), quality.valueError,
+                RESULTS[quality.selfPlayResult + 1]);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    SelfPlayOptions options;
+    std::string resumePath, checkPath;
+    for (int i = 1; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--games") && hasValue)
+            options.games = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue)
+            options.threads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--lambda") && hasValue)
+            options.lambda = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--alpha") && hasValue)
+            options.alpha = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--epsilon") && hasValue)
+            options.epsilon = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--seed") && hasValue)
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--out") && hasValue)
+            options.checkpointPath = argv[++i];
+        else if (!std::strcmp(argv[i], "--every") && hasValue)
+            options.checkpointEvery = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--resume") && hasValue)
+            resumePath = argv[++i];
+        else if (!std::strcmp(argv[i], "--check") && hasValue)
+            checkPath = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.lambda < 0.0 || options.lambda > 1.0 || options.alpha <= 0.0 || options.alpha > 1.0 ||
+        options.epsilon < 0.0 || options.epsilon > 1.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ValueTable table;
+    std::string error;
+    const std::string& loadPath = checkPath.empty() ? resumePath : checkPath;
+    if (!loadPath.empty()) {
+        if (!table.load(loadPath, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        std::printf("loaded %s: %llu games\n", loadPath.c_str(), static_cast<unsigned long long>(table.games()));
+    }
+    if (!checkPath.empty()) {
+        printQuality(table);
+        return 0;
+    }
+
+    const SelfPlayStats stats = trainSelfPlay(table, options, [&](const SelfPlayStats& progress) {
+        std::printf("games: %llu  games/sec: %.0f  ", static_cast<unsigned long long>(progress.games),
+                    progress.gamesPerSecond());
+        printQuality(table);
+        std::fflush(stdout);
+    }, &error);
+    if (!stats.games) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("games: %llu  X wins: %llu  O wins: %llu  draws: %llu  time: %.3f s  games/sec: %.0f\n",
+                static_cast<unsigned long long>(stats.games), static_cast<unsigned long long>(stats.xWins),
+                static_cast<unsigned long long>(stats.oWins), static_cast<unsigned long long>(stats.draws),
+                stats.seconds, stats.gamesPerSecond());
+    return 0;
+}